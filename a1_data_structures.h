@@ -1,100 +1,322 @@
-/* a1_data_structures.h */
-#ifndef A1_DATA_STRUCTURES_H
-#define A1_DATA_STRUCTURES_H
-
-#include <stdlib.h>
-#include <stdio.h>
-#include <stdbool.h>
-
-/**
- * ID Manager Structure (Task 5)
- * 
- * This structure manages unique IDs across the entire project to ensure
- * no two activities or milestones share the same ID. Uses dynamic array
- * allocation to grow as needed.
- * 
- * Fields:
- * - used_ids: Dynamic array storing all allocated IDs
- * - num_used: Current number of IDs in use
- * - capacity: Maximum capacity of the used_ids array before reallocation
- */
-typedef struct {
-    unsigned short int* used_ids;  // Dynamic array of used IDs
-    int num_used;                  // Number of currently used IDs
-    int capacity;                  // Current capacity of the array
-} id_manager_t;
-
-/**
- * Activity Structure
- * 
- * Represents the smallest unit of work in a project. Each activity has
- * both planned and actual values for cost and duration to track variance.
- * 
- * Fields:
- * - id: Unique identifier for the activity
- * - name: Human-readable name (max 99 chars + null terminator)
- * - planned_cost/actual_cost: Budget vs reality tracking
- * - planned_duration/actual_duration: Time estimation vs reality (in hours)
- * - completed: Boolean flag indicating if work is done
- */
-typedef struct activity {
-    unsigned short int id;              // Unique ID (0-65535)
-    char name[100];                     // Activity name
-    float planned_cost, actual_cost;    // Financial tracking
-    unsigned short int planned_duration, actual_duration;  // Time in hours
-    bool completed;                     // Completion status
-} activity_t;
-
-/**
- * Milestone Structure
- * 
- * Groups related activities together. A milestone is complete only when
- * ALL its activities are complete. Costs and durations are calculated
- * as the sum of all contained activities.
- * 
- * Fields:
- * - id: Unique identifier for the milestone
- * - name: Human-readable name
- * - activity_list: Dynamically allocated array of activities
- * - num_activities: Size of the activity array
- * - completed: Auto-calculated based on activity completion
- * - actual_cost: Sum of all activity actual costs
- * - actual_duration: Sum of all activity durations converted to days
- */
-typedef struct milestone {
-    unsigned short int id;              // Unique ID
-    char name[100];                     // Milestone name
-    activity_t* activity_list;          // Dynamic array of activities
-    int num_activities;                 // Number of activities in this milestone
-    bool completed;                     // Calculated completion status
-    float actual_cost;                  // Sum of activity costs
-    short int actual_duration;          // Total duration in days
-} milestone_t;
-
-/**
- * Project Structure
- * 
- * Top-level container for the entire project. Contains multiple milestones
- * and manages the unified ID system. Project completion depends on all
- * milestones being complete.
- * 
- * Fields:
- * - name: Project name
- * - planned_cost/actual_cost: Total project budget tracking
- * - planned_duration/actual_duration: Total project timeline
- * - completed: Auto-calculated based on milestone completion
- * - milestone_list: Dynamic array of milestones
- * - num_milestones: Size of the milestone array
- * - id_manager: Unified ID management system for uniqueness
- */
-typedef struct project {
-    char name[100];                     // Project name
-    float planned_cost, actual_cost;    // Total project costs
-    unsigned short int planned_duration, actual_duration;  // Total time in days
-    bool completed;                     // Overall completion status
-    milestone_t* milestone_list;        // Dynamic array of milestones
-    int num_milestones;                 // Number of milestones
-    id_manager_t* id_manager;          // Unified ID manager for uniqueness
-} project_t;
-
+/* a1_data_structures.h */
+#ifndef A1_DATA_STRUCTURES_H
+#define A1_DATA_STRUCTURES_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include "arena.h"
+#include "name_pool.h"
+
+// ID space: every possible unsigned short int ID gets one bit
+#define ID_SPACE_SIZE 65536
+#define ID_WORD_BITS 64
+#define ID_BITMAP_WORDS (ID_SPACE_SIZE / ID_WORD_BITS)
+#define ID_TABLE_MIN_CAPACITY 64  // Initial entries in the ID location/generation tables
+
+/**
+ * NUMERIC MODE
+ * 
+ * Money and the duration totals have two representations, chosen at
+ * compile time:
+ * 
+ *                  default                  -DPM_FIXED_POINT
+ *   money_t        float dollars            int64_t cents
+ *   money_cell_t   float dollars            int32_t cents
+ *   hours_t        int (hour totals)        int64_t
+ *   days_t         unsigned short (days)    int64_t
+ * 
+ * Float sums round at every addition, so a rollup of many costs drifts from
+ * the exact total and depends on the order of the additions. Integer cents
+ * are exact in any order: incremental rollups always equal a recompute, and
+ * the column sums vectorize on integer adds. The activity columns hold each
+ * amount as a money_cell_t, so the cents column is no wider than the float
+ * one; the sum widens it into 64-bit accumulators. An activity amount is
+ * therefore limited to ACTIVITY_MAX_DOLLARS ($21,474,836.47), while totals
+ * are 64-bit. 64-bit totals also remove the overflow of 16-bit day counts
+ * on large programs. Activity hours stay 16-bit in both modes; they are
+ * entered per activity and only their totals overflow.
+ * 
+ * Dollars go in and out through money_from_dollars() and money_to_dollars()
+ * (rounded to the nearest cent in fixed-point builds). Snapshots and
+ * journals of one mode are refused by builds of the other.
+ */
+#ifdef PM_FIXED_POINT
+typedef int64_t money_t;                // Cents
+typedef int32_t money_cell_t;           // Cents of one activity, in the columns
+typedef int64_t hours_t;                // Hour totals
+typedef int64_t days_t;                 // Day totals
+#define MONEY_SCALE 100                 // Money units per dollar
+#define MONEY_MAX_DOLLARS 1e13          // Largest convertible amount (cents stay exact in a double)
+#define ACTIVITY_MAX_DOLLARS 21474836.47 // Largest activity amount (INT32_MAX cents)
+#else
+typedef float money_t;                  // Dollars
+typedef float money_cell_t;
+typedef int hours_t;
+typedef unsigned short int days_t;
+#define MONEY_SCALE 1
+#define MONEY_MAX_DOLLARS HUGE_VAL
+#define ACTIVITY_MAX_DOLLARS HUGE_VAL
+#endif
+
+/**
+ * Convert dollars to money, to the nearest cent in fixed-point builds
+ * Callers keep dollars within +-MONEY_MAX_DOLLARS.
+ */
+static inline money_t money_from_dollars(double dollars) {
+#ifdef PM_FIXED_POINT
+    return (money_t)llround(dollars * MONEY_SCALE);
+#else
+    return (money_t)dollars;
+#endif
+}
+
+/**
+ * Convert money to dollars
+ */
+static inline double money_to_dollars(money_t money) {
+    return (double)money / MONEY_SCALE;
+}
+
+/**
+ * Money in whole cents (rounded in float builds)
+ */
+static inline int64_t money_to_cents(money_t money) {
+#ifdef PM_FIXED_POINT
+    return money;
+#else
+    return llroundf(money * 100);
+#endif
+}
+
+/**
+ * Dollars as a float, the unit of the column bounds and query values
+ */
+static inline float money_to_float(money_t money) {
+    return (float)money_to_dollars(money);
+}
+
+/**
+ * ID Location Structure
+ * 
+ * Position of the item that owns an ID inside the project hierarchy.
+ * Indices rather than pointers are stored so entries survive the arrays
+ * being moved or reallocated.
+ * 
+ * Fields:
+ * - milestone_index: Index into the project's milestone_list (-1 if unplaced)
+ * - activity_index: Index into that milestone's activity_list, or -1 when
+ *   the ID belongs to the milestone itself
+ */
+typedef struct {
+    int milestone_index;                // Owning milestone slot
+    int activity_index;                 // Activity slot, -1 for milestone IDs
+} id_location_t;
+
+/**
+ * ID Manager Structure (Task 5)
+ * 
+ * This structure manages unique IDs across the entire project to ensure
+ * no two activities or milestones share the same ID. The ID space is bounded
+ * by unsigned short int, so a fixed 65,536-bit bitmap (8 KiB) gives O(1)
+ * checks, inserts and releases without any searching or reallocation.
+ * 
+ * Fields:
+ * - used_bits: One bit per ID, set when the ID is in use (ID 0 is reserved)
+ * - num_used: Current number of IDs in use
+ * - next_free_word: Hint for the allocator; no free ID exists below this word
+ * - capacity: Entries in the two ID-indexed tables below; they cover every
+ *   used ID and double from the arena when a higher ID is taken, so a small
+ *   project does not carry tables for all 65,536 IDs
+ * - arena: Arena the tables grow from
+ * - locations: ID-indexed table giving O(1) lookup of milestones and activities
+ * - generations: Per-ID counter bumped on every release, so a handle taken
+ *   before an item was removed no longer matches a later owner of its ID
+ */
+typedef struct {
+    uint64_t used_bits[ID_BITMAP_WORDS];  // Bitmap of used IDs
+    int num_used;                         // Number of currently used IDs
+    int next_free_word;                   // First word that may contain a free ID
+    int capacity;                         // IDs below this have table entries
+    arena_t* arena;                       // Arena the tables grow from
+    id_location_t* locations;             // Where each used ID lives
+    uint16_t* generations;                // Release count of each ID
+} id_manager_t;
+
+/**
+ * Item Handle
+ * 
+ * Stable reference to a milestone or activity. Pointers into the milestone
+ * and activity arrays are only valid until the next item is added or
+ * removed (arrays grow and removals move the last item into the gap); a
+ * handle resolves through the ID location table instead, and its
+ * generation makes it stale once the item is removed, even if the ID is
+ * reused.
+ */
+typedef struct {
+    unsigned short int id;              // Slot in the ID location table
+    uint16_t generation;                // generations[id] when the handle was taken
+} item_handle_t;
+
+/**
+ * Activity Structure
+ * 
+ * Represents the smallest unit of work in a project. Each activity has
+ * both planned and actual values for cost and duration to track variance.
+ * 
+ * Fields:
+ * - id: Unique identifier for the activity
+ * - name: Human-readable name, interned in the project's name pool
+ * - planned_cost/actual_cost: Budget vs reality tracking
+ * - planned_duration/actual_duration: Time estimation vs reality (in hours)
+ * - completed: Boolean flag indicating if work is done
+ */
+typedef struct activity {
+    unsigned short int id;              // Unique ID (0-65535)
+    name_ref_t name;                    // Activity name (pool reference)
+    money_t planned_cost, actual_cost;  // Financial tracking
+    unsigned short int planned_duration, actual_duration;  // Time in hours
+    bool completed;                     // Completion status
+} activity_t;
+
+/**
+ * Numeric columns with per-milestone bounds (see activity_columns_t)
+ */
+typedef enum {
+    BOUND_PLANNED_COST,
+    BOUND_ACTUAL_COST,
+    BOUND_PLANNED_DURATION,
+    BOUND_ACTUAL_DURATION,
+    NUM_COLUMN_BOUNDS
+} column_bound_t;
+
+/**
+ * Activity Column Storage
+ * 
+ * Structure-of-arrays copy of the hot numeric activity fields of one
+ * milestone. Element i mirrors activity_list[i]; names and IDs stay in the
+ * activity records, which act as the cold store. Rollups stream these
+ * contiguous columns instead of pulling ~120-byte activity records through
+ * the cache.
+ * 
+ * Fields:
+ * - planned_cost/actual_cost: Cost columns (money_cell_t)
+ * - planned_duration/actual_duration: Duration columns (hours)
+ * - completed: 0/1 completion flags
+ * - open_bits: Bitmap of incomplete activities (bit i set while activity i
+ *   is open), so open work is found a 64-activity word at a time
+ * - capacity: Number of elements each column can hold
+ * - valid: false until built; rollups fall back to the records meanwhile
+ * - min/max: Bounds of the cost and duration columns (a zone map, indexed by
+ *   column_bound_t; costs in money_t units). Exact after a build, widened by every
+ *   later store and never narrowed, so no activity lies outside them;
+ *   queries skip the whole milestone when a range they look for does not
+ *   overlap.
+ */
+typedef struct {
+    money_cell_t* planned_cost;
+    money_cell_t* actual_cost;
+    uint16_t* planned_duration;
+    uint16_t* actual_duration;
+    uint8_t* completed;
+    uint64_t* open_bits;
+    int capacity;
+    bool valid;
+    double min[NUM_COLUMN_BOUNDS];
+    double max[NUM_COLUMN_BOUNDS];
+} activity_columns_t;
+
+/**
+ * Milestone Structure
+ * 
+ * Groups related activities together. A milestone is complete only when
+ * ALL its activities are complete. Costs and durations are calculated
+ * as the sum of all contained activities.
+ * 
+ * Fields:
+ * - id: Unique identifier for the milestone
+ * - name: Human-readable name, interned in the project's name pool
+ * - activity_list: Dynamically allocated array of activities
+ * - num_activities: Number of activities in use
+ * - activity_capacity: Slots allocated once the array has grown at run time
+ *   (0 while the array still has exactly the size it was created with)
+ * - completed: Auto-calculated based on activity completion
+ * - actual_cost: Sum of all activity actual costs
+ * - actual_duration: Sum of all activity durations converted to days
+ * - num_completed: Number of completed activities (completed when == num_activities)
+ * - actual_hours: Sum of activity actual durations before day conversion
+ * - planned_cost/planned_hours: Sums of activity planned values
+ * - columns: Hot activity fields in structure-of-arrays form
+ */
+typedef struct milestone {
+    unsigned short int id;              // Unique ID
+    name_ref_t name;                    // Milestone name (pool reference)
+    activity_t* activity_list;          // Dynamic array of activities
+    int num_activities;                 // Number of activities in this milestone
+    int activity_capacity;              // Allocated slots (0: exactly num_activities)
+    bool completed;                     // Calculated completion status
+    money_t actual_cost;                // Sum of activity costs
+    days_t actual_duration;             // Total duration in days
+    int num_completed;                  // Completed activity count
+    hours_t actual_hours;               // Total actual duration in hours
+    money_t planned_cost;               // Sum of activity planned costs
+    hours_t planned_hours;              // Total planned duration in hours
+    activity_columns_t columns;         // SoA mirror of hot activity fields
+} milestone_t;
+
+/**
+ * Project Structure
+ * 
+ * Top-level container for the entire project. Contains multiple milestones
+ * and manages the unified ID system. Project completion depends on all
+ * milestones being complete.
+ * 
+ * Fields:
+ * - name: Project name
+ * - planned_cost/actual_cost: Total project budget tracking
+ * - planned_duration/actual_duration: Total project timeline
+ * - completed: Auto-calculated based on milestone completion
+ * - milestone_list: Dynamic array of milestones
+ * - num_milestones: Number of milestones in use
+ * - milestone_capacity: Slots allocated once the array has grown at run time
+ *   (0 while the array still has exactly the size it was created with)
+ * - id_manager: Unified ID management system for uniqueness
+ * - num_completed_milestones: Completed milestone count (completed when == num_milestones)
+ * - num_open_activities: Incomplete activities across all milestones
+ * - names: Interned milestone and activity names with a search index
+ * - arena: Owns all memory of the project, including the project itself
+ *   and any snapshot mapping it was loaded from
+ * - journal_sequence: Sequence number of the last journaled update reflected
+ *   in this state (0 if none); replay skips records at or below it
+ * - schedule: Activity dependencies and critical path (NULL until the first
+ *   dependency is declared or the critical path is requested)
+ * - structure_version: Bumped whenever milestones or activities are added or
+ *   removed, so views that hold positions (scenarios) can tell they are stale
+ * - history: Progress history every milestone rollup change is recorded in
+ *   (NULL unless one was opened)
+ * - watchlist: Activities and milestones over plan, ranked and re-ranked on
+ *   every change (NULL unless one was created)
+ */
+typedef struct project {
+    char name[100];                     // Project name
+    money_t planned_cost, actual_cost;  // Total project costs
+    days_t planned_duration, actual_duration;  // Total time in days
+    bool completed;                     // Overall completion status
+    milestone_t* milestone_list;        // Dynamic array of milestones
+    int num_milestones;                 // Number of milestones
+    int milestone_capacity;             // Allocated slots (0: exactly num_milestones)
+    id_manager_t* id_manager;          // Unified ID manager for uniqueness
+    int num_completed_milestones;       // Completed milestone count
+    int num_open_activities;            // Incomplete activity count
+    name_pool_t* names;                 // Shared name pool
+    arena_t* arena;                     // Project-scoped allocator
+    uint64_t journal_sequence;          // Last applied journal record
+    struct schedule* schedule;          // Dependency graph (heap-allocated, may be NULL)
+    uint32_t structure_version;         // Count of structural changes
+    struct history* history;            // Rollup history (heap-allocated, may be NULL)
+    struct watchlist* watchlist;        // Overrun rankings (heap-allocated, may be NULL)
+} project_t;
+
 #endif
\ No newline at end of file
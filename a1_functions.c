@@ -1,175 +1,976 @@
-/* a1_functions.h */
-#ifndef A1_FUNCTIONS_H
-#define A1_FUNCTIONS_H
-
-#include "a1_data_structures.h"
-
-// System Constants
-#define HOURS_PER_DAY 8          // Standard 8-hour work day for conversion
-#define INITIAL_ID_CAPACITY 100  // Starting capacity for ID manager array
-
-// =============================================================================
-// INPUT VALIDATION FUNCTIONS
-// =============================================================================
-
-/**
- * Get validated unsigned short integer input from user
- * Continuously prompts until valid positive integer is entered
- * @return Valid unsigned short integer (1 to 65535)
- */
-unsigned short int get_input_usi(void);
-
-/**
- * Get validated float input from user
- * Continuously prompts until valid positive float is entered
- * @return Valid positive float value
- */
-float get_input_f(void);
-
-// =============================================================================
-// ID MANAGEMENT FUNCTIONS (Task 5)
-// =============================================================================
-
-/**
- * Initialize ID manager with specified initial capacity
- * @param initial_capacity Starting size of ID array
- * @return Pointer to initialized ID manager, exits on allocation failure
- */
-id_manager_t* init_id_manager(int initial_capacity);
-
-/**
- * Free all memory associated with ID manager
- * @param manager Pointer to ID manager to free
- */
-void free_id_manager(id_manager_t* manager);
-
-/**
- * Check if an ID is unique (not already in use)
- * @param id ID to check for uniqueness
- * @param manager ID manager to search in
- * @return true if ID is unique, false if already used
- */
-bool is_id_unique(unsigned short int id, id_manager_t* manager);
-
-/**
- * Add a new ID to the manager (assumes ID is unique)
- * Automatically grows array capacity if needed
- * @param id ID to add to the manager
- * @param manager ID manager to add ID to
- * @return true on success, false on memory allocation failure
- */
-bool add_id(unsigned short int id, id_manager_t* manager);
-
-// =============================================================================
-// MEMORY MANAGEMENT FUNCTIONS
-// =============================================================================
-
-/**
- * Create and initialize a new project structure
- * Includes ID manager initialization
- * @return Pointer to new project, exits on allocation failure
- */
-project_t* create_project(void);
-
-/**
- * Create dynamic array of milestones
- * @param size Number of milestones to allocate
- * @return Pointer to milestone array, exits on allocation failure
- */
-milestone_t* create_milestone_array(int size);
-
-/**
- * Create dynamic array of activities
- * @param size Number of activities to allocate
- * @return Pointer to activity array, exits on allocation failure
- */
-activity_t* create_activity_array(int size);
-
-/**
- * Free entire project and all associated memory
- * Recursively frees milestones, activities, and ID manager
- * @param project Pointer to project to free
- */
-void free_project(project_t* project);
-
-/**
- * Free milestone's activity array
- * @param milestone Pointer to milestone whose activities to free
- */
-void free_milestone(milestone_t* milestone);
-
-// =============================================================================
-// CORE PROJECT MANAGEMENT FUNCTIONS
-// =============================================================================
-
-/**
- * Initialize activity with user input for planned values
- * Sets actual values to 0 and completed to false
- * @param activity_to_init Pointer to activity to initialize
- */
-void init_activity(activity_t* activity_to_init);
-
-/**
- * Initialize milestone with user input for number of activities
- * Creates activity array and sets initial values
- * @param milestone_to_init Pointer to milestone to initialize
- */
-void init_milestone(milestone_t* milestone_to_init);
-
-/**
- * Create and initialize project with given name
- * Gets number of milestones from user and creates milestone array
- * @param name Project name to set
- * @return Pointer to initialized project
- */
-project_t* init_project(char name[]);
-
-// =============================================================================
-// USER INTERFACE FUNCTIONS
-// =============================================================================
-
-/**
- * Display main menu options to user
- */
-void print_main_menu(void);
-
-/**
- * Print detailed statistics for all milestones in project
- * Shows completion status and progress for each milestone
- * @param project Project containing milestones to display
- */
-void print_milestone_stats(const project_t* project);
-
-/**
- * Print comprehensive project statistics
- * Includes cost/schedule variance analysis if completed
- * @param project Project to display statistics for
- */
-void print_project_stats(const project_t* project);
-
-// =============================================================================
-// UPDATE FUNCTIONS
-// =============================================================================
-
-/**
- * Update activity with actual duration, cost, and completion status
- * Gets input from user for all actual values
- * @param activity_to_update Pointer to activity to update
- */
-void update_activity(activity_t* activity_to_update);
-
-/**
- * Update milestone based on its activities' current status
- * Recalculates completion status, total cost, and duration
- * @param milestone_to_update Pointer to milestone to update
- */
-void update_milestone(milestone_t* milestone_to_update);
-
-/**
- * Update project based on its milestones' current status
- * Recalculates overall completion status, total cost, and duration
- * @param project Pointer to project to update
- */
-void update_project(project_t* project);
-
-#endif
\ No newline at end of file
+/* a1_functions.c */
+#include "a1_functions.h"
+#include "kernels.h"
+#include "instrument.h"
+#include "schedule.h"
+#include "history.h"
+#include "watchlist.h"
+#include "report.h"
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+// =============================================================================
+// INPUT VALIDATION FUNCTIONS
+// =============================================================================
+
+void discard_input_line(void) {
+    int c;
+
+    while ((c = getchar()) != '\n') {
+        if (c == EOF) {
+            printf("\nERROR: Input ended before a valid value was entered. Exiting...\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+unsigned short int get_input_usi(void) {
+    int value;
+
+    // Reject non-numbers and anything outside the unsigned short range
+    while (scanf("%d", &value) != 1 || value < 0 || value > 65535) {
+        discard_input_line(); // Discard the rest of the bad line
+        printf("Invalid input. Please enter a number between 0 and 65535: ");
+    }
+
+    return (unsigned short int)value;
+}
+
+float get_input_f(void) {
+    float value;
+
+    while (scanf("%f", &value) != 1 || value < 0) {
+        discard_input_line(); // Discard the rest of the bad line
+        printf("Invalid input. Please enter a non-negative number: ");
+    }
+
+    return value;
+}
+
+money_t get_input_money(void) {
+    double value;
+
+    while (scanf("%lf", &value) != 1 || !(value >= 0 && value <= ACTIVITY_MAX_DOLLARS)) {
+        discard_input_line(); // Discard the rest of the bad line
+        printf("Invalid input. Please enter a non-negative amount: ");
+    }
+
+    return money_from_dollars(value);
+}
+
+void get_input_line(char buffer[NAME_INPUT_SIZE]) {
+    // Width must match NAME_INPUT_SIZE - 1; the newline stays for the next read
+    while (scanf(" %99[^\n]", buffer) != 1) {
+        discard_input_line(); // Discard the rest of the bad line
+    }
+}
+
+// =============================================================================
+// ID MANAGEMENT FUNCTIONS (Task 5)
+// =============================================================================
+
+/**
+ * Index of the lowest zero bit in a bitmap word
+ * Caller guarantees the word is not all ones
+ */
+static int first_zero_bit(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(~word);
+#else
+    int bit = 0;
+    while (word & 1) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/**
+ * Make the location and generation tables cover an ID about to be used
+ * Capacity doubles, so growth is amortized O(1) per ID; the old tables are
+ * left to the arena.
+ */
+static void reserve_id_tables(id_manager_t* manager, unsigned short int id) {
+    if (id < manager->capacity) {
+        return;
+    }
+
+    int capacity = manager->capacity > 0 ? manager->capacity : ID_TABLE_MIN_CAPACITY;
+    while (capacity <= id) {
+        capacity *= 2;
+    }
+    if (capacity > ID_SPACE_SIZE) {
+        capacity = ID_SPACE_SIZE; // Snapshot tables need not be a power of two
+    }
+    manager->locations = arena_grow(manager->arena, manager->locations,
+                                    (size_t)manager->capacity * sizeof(id_location_t),
+                                    (size_t)capacity * sizeof(id_location_t));
+    manager->generations = arena_grow(manager->arena, manager->generations,
+                                      (size_t)manager->capacity * sizeof(uint16_t),
+                                      (size_t)capacity * sizeof(uint16_t));
+    manager->capacity = capacity;
+}
+
+id_manager_t* init_id_manager(arena_t* arena) {
+    id_manager_t* manager = arena_alloc(arena, sizeof(id_manager_t));
+    manager->arena = arena;
+
+    // ID 0 is reserved so it can never collide with "cancel" in the UI
+    manager->used_bits[0] = 1;
+    reserve_id_tables(manager, 0);
+    set_id_location(manager, 0, NO_INDEX, NO_INDEX);
+    manager->num_used = 0;
+    manager->next_free_word = 0;
+
+    return manager;
+}
+
+int id_table_span(const id_manager_t* manager) {
+    int word = ID_BITMAP_WORDS - 1;
+    while (manager->used_bits[word] == 0) {
+        word--; // Word 0 always holds the reserved ID 0
+    }
+
+    uint64_t bits = manager->used_bits[word];
+    int bit = 0;
+    while (bits >>= 1) {
+        bit++;
+    }
+    return word * ID_WORD_BITS + bit + 1;
+}
+
+bool is_id_unique(unsigned short int id, const id_manager_t* manager) {
+    PROBE_HIT(PROBE_ID_CHECK);
+    return (manager->used_bits[id / ID_WORD_BITS] & (1ULL << (id % ID_WORD_BITS))) == 0;
+}
+
+bool add_id(unsigned short int id, id_manager_t* manager) {
+    if (!is_id_unique(id, manager)) {
+        return false;
+    }
+
+    reserve_id_tables(manager, id);
+    manager->used_bits[id / ID_WORD_BITS] |= 1ULL << (id % ID_WORD_BITS);
+    manager->num_used++;
+    set_id_location(manager, id, NO_INDEX, NO_INDEX);
+    return true;
+}
+
+void release_id(unsigned short int id, id_manager_t* manager) {
+    if (id == 0 || is_id_unique(id, manager)) {
+        return;
+    }
+
+    int word = id / ID_WORD_BITS;
+    manager->used_bits[word] &= ~(1ULL << (id % ID_WORD_BITS));
+    manager->num_used--;
+    manager->generations[id]++;
+    set_id_location(manager, id, NO_INDEX, NO_INDEX);
+
+    // Freed ID sits below the hint; move the hint back so it is found again
+    if (word < manager->next_free_word) {
+        manager->next_free_word = word;
+    }
+}
+
+unsigned short int allocate_id(id_manager_t* manager) {
+    for (int word = manager->next_free_word; word < ID_BITMAP_WORDS; word++) {
+        if (manager->used_bits[word] != UINT64_MAX) {
+            unsigned short int id = (unsigned short int)(word * ID_WORD_BITS +
+                                                         first_zero_bit(manager->used_bits[word]));
+            reserve_id_tables(manager, id);
+            manager->used_bits[word] |= 1ULL << (id % ID_WORD_BITS);
+            manager->num_used++;
+            manager->next_free_word = word;
+            set_id_location(manager, id, NO_INDEX, NO_INDEX);
+            return id;
+        }
+    }
+
+    manager->next_free_word = ID_BITMAP_WORDS;
+    return NO_FREE_ID;
+}
+
+void set_id_location(id_manager_t* manager, unsigned short int id,
+                     int milestone_index, int activity_index) {
+    manager->locations[id].milestone_index = milestone_index;
+    manager->locations[id].activity_index = activity_index;
+}
+
+activity_t* find_activity_by_id(project_t* project, unsigned short int activity_id,
+                                milestone_t** milestone_out) {
+    PROBE_HIT(PROBE_ACTIVITY_LOOKUP);
+    if (is_id_unique(activity_id, project->id_manager)) {
+        return NULL;
+    }
+
+    const id_location_t* location = &project->id_manager->locations[activity_id];
+    if (location->milestone_index == NO_INDEX || location->activity_index == NO_INDEX) {
+        return NULL; // Unplaced ID or a milestone ID
+    }
+
+    milestone_t* milestone = &project->milestone_list[location->milestone_index];
+    if (milestone_out) {
+        *milestone_out = milestone;
+    }
+    return &milestone->activity_list[location->activity_index];
+}
+
+milestone_t* find_milestone_by_id(project_t* project, unsigned short int milestone_id) {
+    if (is_id_unique(milestone_id, project->id_manager)) {
+        return NULL;
+    }
+
+    const id_location_t* location = &project->id_manager->locations[milestone_id];
+    if (location->milestone_index == NO_INDEX || location->activity_index != NO_INDEX) {
+        return NULL; // Unplaced ID or an activity ID
+    }
+    return &project->milestone_list[location->milestone_index];
+}
+
+void set_milestone_name(project_t* project, milestone_t* milestone, const char* name) {
+    name_remove_owner(project->names, milestone->name, milestone->id);
+    milestone->name = name_intern(project->names, name);
+    name_add_owner(project->names, milestone->name, milestone->id);
+}
+
+void set_activity_name(project_t* project, activity_t* activity, const char* name) {
+    name_remove_owner(project->names, activity->name, activity->id);
+    activity->name = name_intern(project->names, name);
+    name_add_owner(project->names, activity->name, activity->id);
+}
+
+const char* get_name(const project_t* project, name_ref_t name) {
+    return name_text(project->names, name);
+}
+
+// =============================================================================
+// MEMORY MANAGEMENT FUNCTIONS
+// =============================================================================
+
+project_t* create_project(void) {
+    arena_t* arena = arena_create(0);
+    project_t* project = arena_alloc(arena, sizeof(project_t));
+
+    project->arena = arena;
+    project->id_manager = init_id_manager(arena);
+    project->names = name_pool_create(arena);
+    return project;
+}
+
+milestone_t* create_milestone_array(arena_t* arena, int size) {
+    PROBE_BEGIN();
+    milestone_t* milestones = arena_alloc(arena, (size_t)size * sizeof(milestone_t));
+    PROBE_END_UNITS(PROBE_ALLOCATION, (size_t)size * sizeof(milestone_t));
+    return milestones;
+}
+
+activity_t* create_activity_array(arena_t* arena, int size) {
+    PROBE_BEGIN();
+    activity_t* activities = arena_alloc(arena, (size_t)size * sizeof(activity_t));
+    PROBE_END_UNITS(PROBE_ALLOCATION, (size_t)size * sizeof(activity_t));
+    return activities;
+}
+
+void free_project(project_t* project) {
+    if (project == NULL) {
+        return;
+    }
+
+    // The project lives in its own arena, so this releases everything but
+    // the schedule, which is rebuilt too often to grow from the arena, the
+    // progress history, which still has rows to write, and the watchlist
+    schedule_free(project->schedule);
+    history_close(project->history);
+    watchlist_free(project->watchlist);
+    arena_destroy(project->arena);
+}
+
+// =============================================================================
+// CORE PROJECT MANAGEMENT FUNCTIONS
+// =============================================================================
+
+void init_activity(const project_t* project, activity_t* activity_to_init) {
+    const char* name = get_name(project, activity_to_init->name);
+
+    printf("  Enter planned duration (in hours) for activity '%s': ", name);
+    activity_to_init->planned_duration = get_input_usi();
+
+    printf("  Enter planned cost ($) for activity '%s': ", name);
+    activity_to_init->planned_cost = get_input_money();
+
+    activity_to_init->actual_cost = 0;
+    activity_to_init->actual_duration = 0;
+    activity_to_init->completed = false;
+}
+
+void init_milestone(project_t* project, milestone_t* milestone_to_init) {
+    printf("Enter number of activities for this milestone: ");
+    milestone_to_init->num_activities = get_input_usi();
+
+    milestone_to_init->activity_list = create_activity_array(project->arena,
+                                                             milestone_to_init->num_activities);
+    milestone_to_init->completed = false;
+    milestone_to_init->actual_cost = 0;
+    milestone_to_init->actual_duration = 0;
+}
+
+project_t* init_project(char name[]) {
+    project_t* project = create_project();
+
+    strncpy(project->name, name, sizeof(project->name) - 1);
+    project->name[sizeof(project->name) - 1] = '\0';
+
+    printf("\nEnter number of milestones: ");
+    project->num_milestones = get_input_usi();
+    project->milestone_list = create_milestone_array(project->arena, project->num_milestones);
+
+    return project;
+}
+
+// =============================================================================
+// USER INTERFACE FUNCTIONS
+// =============================================================================
+
+void print_main_menu(void) {
+    printf("\nPlease select one of the following options:\n");
+    printf("%d. Update activity\n", MENU_UPDATE_ACTIVITY);
+    printf("%d. Print stats\n", MENU_PRINT_STATS);
+    printf("%d. Exit\n", MENU_EXIT);
+    printf("%d. Save snapshot\n", MENU_SAVE_SNAPSHOT);
+    printf("%d. View instrumentation\n", MENU_INSTRUMENTATION);
+    printf("%d. Add or remove milestones/activities\n", MENU_EDIT_STRUCTURE);
+    printf("%d. Show critical path\n", MENU_CRITICAL_PATH);
+    printf("%d. What-if scenarios\n", MENU_SCENARIOS);
+    printf("%d. Show progress history\n", MENU_HISTORY);
+    printf("%d. Run a query\n", MENU_QUERY);
+    printf("%d. Show overrun watchlist\n", MENU_WATCHLIST);
+    printf("Enter your choice: ");
+}
+
+int display_incomplete_activities(const project_t* project) {
+    report_writer_t* writer = report_stdout();
+    int incomplete_count = report_incomplete_activities(writer, project);
+    report_flush(writer);
+    return incomplete_count;
+}
+
+void print_milestone_stats(const project_t* project) {
+    report_writer_t* writer = report_stdout();
+    report_milestone_stats(writer, project);
+    report_flush(writer);
+}
+
+void print_project_stats(const project_t* project) {
+    PROBE_BEGIN();
+    report_writer_t* writer = report_stdout();
+    report_project_stats(writer, project);
+    report_flush(writer);
+    PROBE_END(PROBE_PRINT_STATS);
+}
+
+// =============================================================================
+// UPDATE FUNCTIONS
+// =============================================================================
+
+/**
+ * Convert a number of work hours to whole days, rounding up
+ */
+static days_t hours_to_days(hours_t hours) {
+    return (days_t)((hours + HOURS_PER_DAY - 1) / HOURS_PER_DAY);
+}
+
+void update_activity(activity_t* activity_to_update) {
+    printf("Enter actual duration (in hours): ");
+    activity_to_update->actual_duration = get_input_usi();
+
+    printf("Enter actual cost ($): ");
+    activity_to_update->actual_cost = get_input_money();
+
+    printf("Is the activity completed? (1 = yes, 0 = no): ");
+    activity_to_update->completed = get_input_usi() == 1;
+}
+
+/**
+ * Widen a column's bounds to include a value
+ */
+static void widen_bound(activity_columns_t* columns, column_bound_t bound, double value) {
+    if (value < columns->min[bound]) {
+        columns->min[bound] = value;
+    }
+    if (value > columns->max[bound]) {
+        columns->max[bound] = value;
+    }
+}
+
+/**
+ * Copy one activity's hot fields into its column slot
+ */
+static void store_activity_columns(activity_columns_t* columns, int index, const activity_t* activity) {
+    // Activity amounts are kept within ACTIVITY_MAX_DOLLARS, so they fit a cell
+    columns->planned_cost[index] = (money_cell_t)activity->planned_cost;
+    columns->actual_cost[index] = (money_cell_t)activity->actual_cost;
+    columns->planned_duration[index] = activity->planned_duration;
+    columns->actual_duration[index] = activity->actual_duration;
+    columns->completed[index] = activity->completed ? 1 : 0;
+
+    widen_bound(columns, BOUND_PLANNED_COST, (double)activity->planned_cost);
+    widen_bound(columns, BOUND_ACTUAL_COST, (double)activity->actual_cost);
+    widen_bound(columns, BOUND_PLANNED_DURATION, activity->planned_duration);
+    widen_bound(columns, BOUND_ACTUAL_DURATION, activity->actual_duration);
+
+    uint64_t bit = 1ULL << (index % ID_WORD_BITS);
+    if (activity->completed) {
+        columns->open_bits[index / ID_WORD_BITS] &= ~bit;
+    } else {
+        columns->open_bits[index / ID_WORD_BITS] |= bit;
+    }
+}
+
+void build_activity_columns(arena_t* arena, milestone_t* milestone) {
+    activity_columns_t* columns = &milestone->columns;
+
+    if (columns->capacity < milestone->num_activities) {
+        int capacity = milestone->num_activities;
+        columns->planned_cost = arena_alloc(arena, (size_t)capacity * sizeof(money_cell_t));
+        columns->actual_cost = arena_alloc(arena, (size_t)capacity * sizeof(money_cell_t));
+        columns->planned_duration = arena_alloc(arena, (size_t)capacity * sizeof(uint16_t));
+        columns->actual_duration = arena_alloc(arena, (size_t)capacity * sizeof(uint16_t));
+        columns->completed = arena_alloc(arena, (size_t)capacity * sizeof(uint8_t));
+        columns->open_bits = arena_alloc(arena, (size_t)(capacity + ID_WORD_BITS - 1) / ID_WORD_BITS *
+                                                sizeof(uint64_t));
+        columns->capacity = capacity;
+    }
+
+    // Empty bounds, then exactly the stored values
+    for (int bound = 0; bound < NUM_COLUMN_BOUNDS; bound++) {
+        columns->min[bound] = DBL_MAX;
+        columns->max[bound] = -DBL_MAX;
+    }
+    for (int i = 0; i < milestone->num_activities; i++) {
+        store_activity_columns(columns, i, &milestone->activity_list[i]);
+    }
+    columns->valid = true;
+}
+
+void refresh_activity_columns(milestone_t* milestone, const activity_t* activity) {
+    if (milestone->columns.valid) {
+        store_activity_columns(&milestone->columns, (int)(activity - milestone->activity_list), activity);
+    }
+}
+
+/**
+ * Sum a cost column with the kernel of the numeric mode
+ */
+static money_t sum_money(const money_cell_t* values, int count) {
+#ifdef PM_FIXED_POINT
+    return sum_int32s(values, count);
+#else
+    return sum_floats(values, count);
+#endif
+}
+
+void update_milestone(milestone_t* milestone_to_update) {
+    PROBE_BEGIN();
+    money_t actual_cost = 0, planned_cost = 0;
+    hours_t actual_hours = 0, planned_hours = 0;
+    int num_completed = 0;
+    int count = milestone_to_update->num_activities;
+    const activity_columns_t* columns = &milestone_to_update->columns;
+
+    if (columns->valid) {
+        // Hot path: five contiguous column reductions
+        actual_cost = sum_money(columns->actual_cost, count);
+        planned_cost = sum_money(columns->planned_cost, count);
+        actual_hours = (hours_t)sum_ushorts(columns->actual_duration, count);
+        planned_hours = (hours_t)sum_ushorts(columns->planned_duration, count);
+        num_completed = count_flags(columns->completed, count);
+    } else {
+        for (int i = 0; i < count; i++) {
+            const activity_t* activity = &milestone_to_update->activity_list[i];
+            actual_cost += activity->actual_cost;
+            planned_cost += activity->planned_cost;
+            actual_hours += activity->actual_duration;
+            planned_hours += activity->planned_duration;
+            if (activity->completed) {
+                num_completed++;
+            }
+        }
+    }
+
+    milestone_to_update->actual_cost = actual_cost;
+    milestone_to_update->planned_cost = planned_cost;
+    milestone_to_update->actual_hours = actual_hours;
+    milestone_to_update->planned_hours = planned_hours;
+    milestone_to_update->actual_duration = hours_to_days(actual_hours);
+    milestone_to_update->num_completed = num_completed;
+    milestone_to_update->completed = num_completed == count;
+    PROBE_END(PROBE_MILESTONE_ROLLUP);
+}
+
+void update_project(project_t* project) {
+    PROBE_BEGIN();
+    money_t planned_cost = 0, actual_cost = 0;
+    int64_t planned_days = 0, actual_days = 0;
+    int num_completed = 0, num_open = 0;
+
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        num_open += milestone->num_activities - milestone->num_completed;
+        planned_cost += milestone->planned_cost;
+        planned_days += hours_to_days(milestone->planned_hours);
+        actual_cost += milestone->actual_cost;
+        actual_days += milestone->actual_duration;
+        if (milestone->completed) {
+            num_completed++;
+        }
+    }
+
+    project->planned_cost = planned_cost;
+    project->actual_cost = actual_cost;
+    project->planned_duration = (days_t)planned_days;
+    project->actual_duration = (days_t)actual_days;
+    project->num_completed_milestones = num_completed;
+    project->num_open_activities = num_open;
+    project->completed = num_completed == project->num_milestones;
+    PROBE_END(PROBE_PROJECT_ROLLUP);
+}
+
+/**
+ * Stop with a report if incremental totals drifted from a full recompute
+ * Only active in builds with -DPM_VERIFY_ROLLUPS
+ */
+static void verify_after_change(const project_t* project, const char* change, unsigned short int id) {
+#ifdef PM_VERIFY_ROLLUPS
+    if (!verify_rollups(project)) {
+        fprintf(stderr, "ROLLUP VERIFICATION FAILED after %s %hu\n", change, id);
+        abort();
+    }
+#else
+    (void)project;
+    (void)change;
+    (void)id;
+#endif
+}
+
+/**
+ * Roll one activity leaving and/or joining a milestone up to the milestone
+ * and project; an update is the old values leaving and the new ones joining
+ * The milestone's num_activities must already include the change. The new
+ * milestone totals are added to the progress history and re-ranked in the
+ * watchlist, if those are kept.
+ */
+static void rollup_activity_delta(project_t* project, milestone_t* milestone,
+                                  const activity_t* removed, const activity_t* added) {
+    static const activity_t none;  // Contributes nothing
+    const activity_t* before = removed != NULL ? removed : &none;
+    const activity_t* after = added != NULL ? added : &none;
+
+    money_t cost_delta = after->actual_cost - before->actual_cost;
+    money_t planned_cost_delta = after->planned_cost - before->planned_cost;
+    int completed_delta = (int)after->completed - (int)before->completed;
+    int open_delta = (added != NULL && !added->completed) - (removed != NULL && !removed->completed);
+
+    // Milestone: adjust raw sums, then re-derive the day values from them
+    days_t old_actual_days = milestone->actual_duration;
+    days_t old_planned_days = hours_to_days(milestone->planned_hours);
+    bool was_completed = milestone->completed;
+
+    milestone->actual_cost += cost_delta;
+    milestone->planned_cost += planned_cost_delta;
+    milestone->actual_hours += (hours_t)after->actual_duration - (hours_t)before->actual_duration;
+    milestone->planned_hours += (hours_t)after->planned_duration - (hours_t)before->planned_duration;
+    milestone->num_completed += completed_delta;
+    milestone->actual_duration = hours_to_days(milestone->actual_hours);
+    milestone->completed = milestone->num_completed == milestone->num_activities;
+
+    // Project: only the milestone-level differences travel further up
+    project->actual_cost += cost_delta;
+    project->planned_cost += planned_cost_delta;
+    project->actual_duration = (days_t)(project->actual_duration + milestone->actual_duration -
+                                        old_actual_days);
+    project->planned_duration = (days_t)(project->planned_duration + hours_to_days(milestone->planned_hours) -
+                                         old_planned_days);
+    project->num_completed_milestones += (int)milestone->completed - (int)was_completed;
+    project->num_open_activities += open_delta;
+    project->completed = project->num_completed_milestones == project->num_milestones;
+
+    history_record(project->history, milestone);
+    watch_milestone(project->watchlist, milestone);
+}
+
+void rollup_activity_change(project_t* project, milestone_t* milestone,
+                            const activity_t* before, const activity_t* after) {
+    PROBE_BEGIN();
+    refresh_activity_columns(milestone, after);
+    watch_activity(project->watchlist, after);
+    rollup_activity_delta(project, milestone, before, after);
+    schedule_activity_changed(project->schedule, after);
+    PROBE_END(PROBE_ACTIVITY_UPDATE);
+    verify_after_change(project, "update of activity", after->id);
+}
+
+bool apply_activity_update(project_t* project, unsigned short int activity_id,
+                           unsigned short int actual_duration, money_t actual_cost,
+                           bool completed) {
+    milestone_t* milestone = NULL;
+    activity_t* activity = find_activity_by_id(project, activity_id, &milestone);
+    if (activity == NULL) {
+        return false;
+    }
+
+    activity_t before = *activity;
+    activity->actual_duration = actual_duration;
+    activity->actual_cost = actual_cost;
+    activity->completed = completed;
+    rollup_activity_change(project, milestone, &before, activity);
+    return true;
+}
+
+// =============================================================================
+// DYNAMIC STRUCTURE FUNCTIONS
+// =============================================================================
+
+/**
+ * Next capacity of a growing array (doubling, so appends are amortized O(1))
+ */
+static int grown_capacity(int capacity) {
+    return capacity < 4 ? 4 : capacity * 2;
+}
+
+/**
+ * Take the requested ID, or the next free one for 0
+ */
+static bool claim_id(project_t* project, unsigned short int* id) {
+    if (*id == 0) {
+        *id = allocate_id(project->id_manager);
+        return *id != NO_FREE_ID;
+    }
+    return add_id(*id, project->id_manager);
+}
+
+/**
+ * Grow every column of a milestone to a new capacity, keeping the contents
+ */
+static void grow_activity_columns(arena_t* arena, activity_columns_t* columns, int capacity) {
+    size_t old_count = (size_t)columns->capacity;
+    size_t new_count = (size_t)capacity;
+    size_t old_words = (old_count + ID_WORD_BITS - 1) / ID_WORD_BITS;
+    size_t new_words = (new_count + ID_WORD_BITS - 1) / ID_WORD_BITS;
+
+    columns->planned_cost = arena_grow(arena, columns->planned_cost, old_count * sizeof(money_cell_t),
+                                       new_count * sizeof(money_cell_t));
+    columns->actual_cost = arena_grow(arena, columns->actual_cost, old_count * sizeof(money_cell_t),
+                                      new_count * sizeof(money_cell_t));
+    columns->planned_duration = arena_grow(arena, columns->planned_duration, old_count * sizeof(uint16_t),
+                                           new_count * sizeof(uint16_t));
+    columns->actual_duration = arena_grow(arena, columns->actual_duration, old_count * sizeof(uint16_t),
+                                          new_count * sizeof(uint16_t));
+    columns->completed = arena_grow(arena, columns->completed, old_count * sizeof(uint8_t),
+                                    new_count * sizeof(uint8_t));
+    columns->open_bits = arena_grow(arena, columns->open_bits, old_words * sizeof(uint64_t),
+                                    new_words * sizeof(uint64_t));
+    columns->capacity = capacity;
+}
+
+milestone_t* add_milestone(project_t* project, unsigned short int id, const char* name) {
+    if (!claim_id(project, &id)) {
+        return NULL;
+    }
+
+    if (project->milestone_capacity < project->num_milestones) {
+        project->milestone_capacity = project->num_milestones;
+    }
+    if (project->num_milestones == project->milestone_capacity) {
+        int capacity = grown_capacity(project->milestone_capacity);
+        PROBE_BEGIN();
+        project->milestone_list = arena_grow(project->arena, project->milestone_list,
+                                             (size_t)project->milestone_capacity * sizeof(milestone_t),
+                                             (size_t)capacity * sizeof(milestone_t));
+        PROBE_END_UNITS(PROBE_ALLOCATION, (size_t)capacity * sizeof(milestone_t));
+        project->milestone_capacity = capacity;
+    }
+
+    int index = project->num_milestones++;
+    milestone_t* milestone = &project->milestone_list[index];
+    memset(milestone, 0, sizeof(milestone_t));  // The slot may hold a removed milestone
+    milestone->id = id;
+    set_id_location(project->id_manager, id, index, NO_INDEX);
+    set_milestone_name(project, milestone, name);
+    build_activity_columns(project->arena, milestone);
+    update_milestone(milestone);
+
+    // An empty milestone counts as complete, like any milestone whose activities all are
+    project->num_completed_milestones += milestone->completed;
+    project->completed = project->num_completed_milestones == project->num_milestones;
+    project->structure_version++;
+    verify_after_change(project, "adding milestone", id);
+    return milestone;
+}
+
+activity_t* add_activity(project_t* project, milestone_t* milestone, unsigned short int id,
+                         const char* name, unsigned short int planned_duration, money_t planned_cost) {
+    if (!claim_id(project, &id)) {
+        return NULL;
+    }
+
+    if (milestone->activity_capacity < milestone->num_activities) {
+        milestone->activity_capacity = milestone->num_activities;
+    }
+    if (milestone->num_activities == milestone->activity_capacity) {
+        int capacity = grown_capacity(milestone->activity_capacity);
+        PROBE_BEGIN();
+        milestone->activity_list = arena_grow(project->arena, milestone->activity_list,
+                                              (size_t)milestone->activity_capacity * sizeof(activity_t),
+                                              (size_t)capacity * sizeof(activity_t));
+        PROBE_END_UNITS(PROBE_ALLOCATION, (size_t)capacity * sizeof(activity_t));
+        milestone->activity_capacity = capacity;
+    }
+    if (milestone->columns.valid && milestone->columns.capacity <= milestone->num_activities) {
+        grow_activity_columns(project->arena, &milestone->columns, milestone->activity_capacity);
+    }
+
+    int index = milestone->num_activities++;
+    activity_t* activity = &milestone->activity_list[index];
+    memset(activity, 0, sizeof(activity_t));  // The slot may hold a removed activity
+    activity->id = id;
+    activity->planned_duration = planned_duration;
+    activity->planned_cost = planned_cost;
+    set_id_location(project->id_manager, id, (int)(milestone - project->milestone_list), index);
+    set_activity_name(project, activity, name);
+
+    refresh_activity_columns(milestone, activity);
+    rollup_activity_delta(project, milestone, NULL, activity);
+    schedule_invalidate(project->schedule);
+    project->structure_version++;
+    verify_after_change(project, "adding activity", id);
+    return activity;
+}
+
+bool remove_activity(project_t* project, unsigned short int activity_id) {
+    milestone_t* milestone = NULL;
+    activity_t* activity = find_activity_by_id(project, activity_id, &milestone);
+    if (activity == NULL) {
+        return false;
+    }
+
+    if (milestone->activity_capacity < milestone->num_activities) {
+        milestone->activity_capacity = milestone->num_activities;
+    }
+
+    // Move the last activity into the gap and re-point its ID
+    activity_t removed = *activity;
+    int index = (int)(activity - milestone->activity_list);
+    int last = --milestone->num_activities;
+    if (index != last) {
+        *activity = milestone->activity_list[last];
+        set_id_location(project->id_manager, activity->id, (int)(milestone - project->milestone_list), index);
+        refresh_activity_columns(milestone, activity);
+    }
+    if (milestone->columns.valid) {
+        milestone->columns.open_bits[last / ID_WORD_BITS] &= ~(1ULL << (last % ID_WORD_BITS));
+    }
+
+    name_remove_owner(project->names, removed.name, removed.id);
+    release_id(removed.id, project->id_manager);
+    watch_remove(project->watchlist, removed.id);
+    rollup_activity_delta(project, milestone, &removed, NULL);
+    schedule_drop_removed(project);
+    project->structure_version++;
+    verify_after_change(project, "removing activity", activity_id);
+    return true;
+}
+
+bool remove_milestone(project_t* project, unsigned short int milestone_id) {
+    milestone_t* milestone = find_milestone_by_id(project, milestone_id);
+    if (milestone == NULL) {
+        return false;
+    }
+
+    for (int j = 0; j < milestone->num_activities; j++) {
+        const activity_t* activity = &milestone->activity_list[j];
+        name_remove_owner(project->names, activity->name, activity->id);
+        release_id(activity->id, project->id_manager);
+        watch_remove(project->watchlist, activity->id);
+    }
+    name_remove_owner(project->names, milestone->name, milestone->id);
+    release_id(milestone->id, project->id_manager);
+    watch_remove(project->watchlist, milestone->id);
+
+    // Take the milestone's totals out of the project
+    project->planned_cost -= milestone->planned_cost;
+    project->actual_cost -= milestone->actual_cost;
+    project->planned_duration = (days_t)(project->planned_duration - hours_to_days(milestone->planned_hours));
+    project->actual_duration = (days_t)(project->actual_duration - milestone->actual_duration);
+    project->num_completed_milestones -= milestone->completed;
+    project->num_open_activities -= milestone->num_activities - milestone->num_completed;
+
+    if (project->milestone_capacity < project->num_milestones) {
+        project->milestone_capacity = project->num_milestones;
+    }
+
+    // Move the last milestone into the gap; its activities keep their slots
+    int index = (int)(milestone - project->milestone_list);
+    int last = --project->num_milestones;
+    if (index != last) {
+        *milestone = project->milestone_list[last];
+        set_id_location(project->id_manager, milestone->id, index, NO_INDEX);
+        for (int j = 0; j < milestone->num_activities; j++) {
+            set_id_location(project->id_manager, milestone->activity_list[j].id, index, j);
+        }
+    }
+
+    project->completed = project->num_completed_milestones == project->num_milestones;
+    schedule_drop_removed(project);
+    project->structure_version++;
+    verify_after_change(project, "removing milestone", milestone_id);
+    return true;
+}
+
+item_handle_t get_item_handle(const project_t* project, unsigned short int id) {
+    item_handle_t handle = { id, project->id_manager->generations[id] };
+    return handle;
+}
+
+activity_t* resolve_activity(project_t* project, item_handle_t handle, milestone_t** milestone_out) {
+    if (project->id_manager->generations[handle.id] != handle.generation) {
+        return NULL; // Removed since the handle was taken
+    }
+    return find_activity_by_id(project, handle.id, milestone_out);
+}
+
+milestone_t* resolve_milestone(project_t* project, item_handle_t handle) {
+    if (project->id_manager->generations[handle.id] != handle.generation) {
+        return NULL;
+    }
+    return find_milestone_by_id(project, handle.id);
+}
+
+/**
+ * Compare an incrementally maintained cost against a recomputed one
+ * Float sums accumulate in different orders, so allow a small relative
+ * error; fixed-point sums are exact in any order and must be equal.
+ */
+static bool costs_match(money_t incremental, money_t recomputed) {
+#ifdef PM_FIXED_POINT
+    return incremental == recomputed;
+#else
+    return fabsf(incremental - recomputed) <= 0.01f + fabsf(recomputed) * 1e-5f;
+#endif
+}
+
+bool verify_rollups(const project_t* project) {
+    bool ok = true;
+    project_t expected = *project;
+    milestone_t* milestones = malloc((size_t)project->num_milestones * sizeof(milestone_t) + 1);
+    if (milestones == NULL) {
+        fprintf(stderr, "Rollup verification skipped: out of memory\n");
+        return true;
+    }
+
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* actual = &project->milestone_list[i];
+        milestones[i] = *actual;
+        milestones[i].columns.valid = false;  // Recompute from the records themselves
+        update_milestone(&milestones[i]);
+
+        // The columns must mirror the records exactly, within their bounds
+        if (actual->columns.valid) {
+            for (int j = 0; j < actual->num_activities; j++) {
+                const activity_t* activity = &actual->activity_list[j];
+                if (actual->columns.actual_cost[j] != activity->actual_cost ||
+                    actual->columns.planned_cost[j] != activity->planned_cost ||
+                    actual->columns.actual_duration[j] != activity->actual_duration ||
+                    actual->columns.planned_duration[j] != activity->planned_duration ||
+                    actual->columns.completed[j] != (activity->completed ? 1 : 0) ||
+                    (actual->columns.open_bits[j / ID_WORD_BITS] >> (j % ID_WORD_BITS) & 1) ==
+                        (activity->completed ? 1 : 0) ||
+                    (double)activity->planned_cost < actual->columns.min[BOUND_PLANNED_COST] ||
+                    (double)activity->planned_cost > actual->columns.max[BOUND_PLANNED_COST] ||
+                    (double)activity->actual_cost < actual->columns.min[BOUND_ACTUAL_COST] ||
+                    (double)activity->actual_cost > actual->columns.max[BOUND_ACTUAL_COST] ||
+                    activity->planned_duration < actual->columns.min[BOUND_PLANNED_DURATION] ||
+                    activity->planned_duration > actual->columns.max[BOUND_PLANNED_DURATION] ||
+                    activity->actual_duration < actual->columns.min[BOUND_ACTUAL_DURATION] ||
+                    activity->actual_duration > actual->columns.max[BOUND_ACTUAL_DURATION]) {
+                    fprintf(stderr, "Activity %hu column entry is stale\n", activity->id);
+                    ok = false;
+                }
+            }
+        }
+
+        if (!costs_match(actual->actual_cost, milestones[i].actual_cost) ||
+            !costs_match(actual->planned_cost, milestones[i].planned_cost) ||
+            actual->actual_hours != milestones[i].actual_hours ||
+            actual->planned_hours != milestones[i].planned_hours ||
+            actual->actual_duration != milestones[i].actual_duration ||
+            actual->num_completed != milestones[i].num_completed ||
+            actual->completed != milestones[i].completed) {
+            fprintf(stderr, "Milestone %hu totals differ from recompute "
+                    "(cost %.2f vs %.2f, hours %lld vs %lld, completed %d vs %d)\n",
+                    actual->id, money_to_dollars(actual->actual_cost),
+                    money_to_dollars(milestones[i].actual_cost),
+                    (long long)actual->actual_hours, (long long)milestones[i].actual_hours,
+                    actual->num_completed, milestones[i].num_completed);
+            ok = false;
+        }
+    }
+
+    expected.milestone_list = milestones;
+    update_project(&expected);
+    if (!costs_match(project->actual_cost, expected.actual_cost) ||
+        !costs_match(project->planned_cost, expected.planned_cost) ||
+        project->actual_duration != expected.actual_duration ||
+        project->planned_duration != expected.planned_duration ||
+        project->num_completed_milestones != expected.num_completed_milestones ||
+        project->num_open_activities != expected.num_open_activities ||
+        project->completed != expected.completed) {
+        fprintf(stderr, "Project totals differ from recompute "
+                "(cost %.2f vs %.2f, days %lld vs %lld, milestones done %d vs %d, open %d vs %d)\n",
+                money_to_dollars(project->actual_cost), money_to_dollars(expected.actual_cost),
+                (long long)project->actual_duration, (long long)expected.actual_duration,
+                project->num_completed_milestones, expected.num_completed_milestones,
+                project->num_open_activities, expected.num_open_activities);
+        ok = false;
+    }
+
+    // The watchlist ranks the incremental totals checked above
+    if (project->watchlist != NULL && !watchlist_verify(project->watchlist, project)) {
+        ok = false;
+    }
+
+    free(milestones);
+    return ok;
+}
+
+int next_open_activity(const milestone_t* milestone, int start) {
+    const activity_columns_t* columns = &milestone->columns;
+    int count = milestone->num_activities;
+
+    if (start >= count || milestone->num_completed == count) {
+        return NO_INDEX;
+    }
+
+    if (!columns->valid) {
+        for (int i = start; i < count; i++) {
+            if (!milestone->activity_list[i].completed) {
+                return i;
+            }
+        }
+        return NO_INDEX;
+    }
+
+    // Mask off the bits below start in the first word, then skip empty words
+    int word_index = start / ID_WORD_BITS;
+    int num_words = (count + ID_WORD_BITS - 1) / ID_WORD_BITS;
+    uint64_t word = columns->open_bits[word_index] & (~0ULL << (start % ID_WORD_BITS));
+    while (word == 0) {
+        if (++word_index == num_words) {
+            return NO_INDEX;
+        }
+        word = columns->open_bits[word_index];
+    }
+    return word_index * ID_WORD_BITS + first_zero_bit(~word);
+}
@@ -1,40 +1,440 @@
-/* a1_functions.h */
-#ifndef A1_FUNCTIONS_H
-#define A1_FUNCTIONS_H
-
-#include "a1_data_structures.h"
-
-// Constants
-#define HOURS_PER_DAY 8
-#define INITIAL_ID_CAPACITY 100
-
-unsigned short int get_input_usi(void);
-float get_input_f(void);
-
-
-
-// ID management functions (Task 5)
-id_manager_t* init_id_manager(int initial_capacity);
-void free_id_manager(id_manager_t* manager);
-bool is_id_unique(unsigned short int id, id_manager_t* manager);
-bool add_id(unsigned short int id, id_manager_t* manager);
-
-// Memory management functions
-project_t* create_project(void);
-milestone_t* create_milestone_array(int size);
-activity_t* create_activity_array(int size);
-void free_project(project_t* project);
-void free_milestone(milestone_t* milestone);
-
-// Core project management functions
-void init_activity(activity_t* activity_to_init);
-void init_milestone(milestone_t* milestone_to_init);
-project_t* init_project(char name[]);
-void print_main_menu(void);
-void print_milestone_stats(const project_t* project);
-void print_project_stats(const project_t* project);
-void update_activity(activity_t* activity_to_update);
-void update_milestone(milestone_t* milestone_to_update);
-void update_project(project_t* project);
-
-#endif
+/* a1_functions.h */
+#ifndef A1_FUNCTIONS_H
+#define A1_FUNCTIONS_H
+
+#include "a1_data_structures.h"
+
+// System Constants
+#define HOURS_PER_DAY 8          // Standard 8-hour work day for conversion
+#define NO_FREE_ID 0             // Returned by allocate_id when the ID space is full
+#define NO_INDEX (-1)            // Location index meaning "not placed" / "milestone itself"
+#define NAME_INPUT_SIZE 100      // Longest name accepted at a prompt is 99 characters
+#define MAX_NAME_MATCHES 50      // Name search results considered when picking an activity
+#define MAX_SCENARIOS 16         // What-if scenarios open at once in the interactive menu
+#define DEFAULT_HISTORY_DAYS 90  // Look-back of the progress history report
+#define DEFAULT_WATCHLIST_ENTRIES 10  // Entries per list in the watchlist report
+
+// Main menu choices (Exit keeps its original number; new entries are appended)
+#define MENU_UPDATE_ACTIVITY 1
+#define MENU_PRINT_STATS 2
+#define MENU_EXIT 3
+#define MENU_SAVE_SNAPSHOT 4
+#define MENU_INSTRUMENTATION 5
+#define MENU_EDIT_STRUCTURE 6
+#define MENU_CRITICAL_PATH 7
+#define MENU_SCENARIOS 8
+#define MENU_HISTORY 9
+#define MENU_QUERY 10
+#define MENU_WATCHLIST 11
+#define MENU_LAST_OPTION 11
+
+// =============================================================================
+// INPUT VALIDATION FUNCTIONS
+// =============================================================================
+
+/**
+ * Discard the rest of the current input line
+ * Input that ends before the newline can never answer a prompt, so the
+ * program reports it and exits rather than waiting forever
+ */
+void discard_input_line(void);
+
+/**
+ * Get validated unsigned short integer input from user
+ * Continuously prompts until valid non-negative integer is entered
+ * @return Valid unsigned short integer (0 to 65535)
+ */
+unsigned short int get_input_usi(void);
+
+/**
+ * Get validated float input from user
+ * Continuously prompts until valid non-negative float is entered
+ * @return Valid non-negative float value
+ */
+float get_input_f(void);
+
+/**
+ * Get a validated amount of money in dollars from user
+ * Continuously prompts until a non-negative amount of at most
+ * ACTIVITY_MAX_DOLLARS is entered; read as a double so fixed-point builds
+ * keep every cent
+ * @return Amount as money_t
+ */
+money_t get_input_money(void);
+
+/**
+ * Get a non-empty line of text from user (names may contain spaces)
+ * Leading whitespace, including a newline left by a previous prompt, is skipped
+ * @param buffer Receives at most NAME_INPUT_SIZE - 1 characters
+ */
+void get_input_line(char buffer[NAME_INPUT_SIZE]);
+
+// =============================================================================
+// ID MANAGEMENT FUNCTIONS (Task 5)
+// =============================================================================
+
+/**
+ * Initialize ID manager with an empty bitmap
+ * ID 0 is reserved (it means "cancel"/"none" in the UI) and is never handed out
+ * @param arena Arena to allocate the manager from
+ * @return Pointer to initialized ID manager, exits on allocation failure
+ */
+id_manager_t* init_id_manager(arena_t* arena);
+
+/**
+ * Number of table entries needed to cover every ID in use
+ * @param manager ID manager to inspect
+ * @return Highest used ID + 1 (1 when only the reserved ID 0 is set)
+ */
+int id_table_span(const id_manager_t* manager);
+
+/**
+ * Check if an ID is unique (not already in use) - O(1)
+ * @param id ID to check for uniqueness
+ * @param manager ID manager to search in
+ * @return true if ID is unique, false if already used or reserved
+ */
+bool is_id_unique(unsigned short int id, const id_manager_t* manager);
+
+/**
+ * Mark an ID as used - O(1)
+ * @param id ID to add to the manager
+ * @param manager ID manager to add ID to
+ * @return true on success, false if the ID is already used or reserved
+ */
+bool add_id(unsigned short int id, id_manager_t* manager);
+
+/**
+ * Return an ID to the free pool - O(1)
+ * @param id ID to release (releasing an unused or reserved ID is a no-op)
+ * @param manager ID manager to release the ID from
+ */
+void release_id(unsigned short int id, id_manager_t* manager);
+
+/**
+ * Allocate the lowest free ID and mark it as used
+ * Uses a find-first-zero scan over bitmap words starting at the free hint,
+ * so consecutive allocations are amortized O(1)
+ * @param manager ID manager to allocate from
+ * @return Newly allocated ID, or NO_FREE_ID if all 65,535 IDs are in use
+ */
+unsigned short int allocate_id(id_manager_t* manager);
+
+/**
+ * Record where the owner of an ID lives in the project hierarchy
+ * Must be called whenever a milestone or activity is placed or moved
+ * @param manager ID manager holding the location index
+ * @param id ID whose location to record (must already be in use)
+ * @param milestone_index Index of the milestone in the project
+ * @param activity_index Index of the activity, or NO_INDEX for a milestone ID
+ */
+void set_id_location(id_manager_t* manager, unsigned short int id,
+                     int milestone_index, int activity_index);
+
+/**
+ * Find activity by ID using the project's location index - O(1)
+ * @param project Project to search in
+ * @param activity_id ID of activity to find
+ * @param milestone_out Output parameter for containing milestone (may be NULL)
+ * @return Pointer to activity if found, NULL otherwise
+ */
+activity_t* find_activity_by_id(project_t* project, unsigned short int activity_id,
+                                milestone_t** milestone_out);
+
+/**
+ * Find milestone by ID using the project's location index - O(1)
+ * @param project Project to search in
+ * @param milestone_id ID of milestone to find
+ * @return Pointer to milestone if found, NULL otherwise
+ */
+milestone_t* find_milestone_by_id(project_t* project, unsigned short int milestone_id);
+
+/**
+ * Give a milestone a name, interning it and indexing it for search
+ * The milestone's ID must already be set
+ * @param project Project owning the name pool
+ * @param milestone Milestone to name
+ * @param name Name text
+ */
+void set_milestone_name(project_t* project, milestone_t* milestone, const char* name);
+
+/**
+ * Give an activity a name, interning it and indexing it for search
+ * The activity's ID must already be set
+ * @param project Project owning the name pool
+ * @param activity Activity to name
+ * @param name Name text
+ */
+void set_activity_name(project_t* project, activity_t* activity, const char* name);
+
+/**
+ * Text of a milestone or activity name
+ * @param project Project owning the name pool
+ * @param name Name reference stored in the item
+ * @return NUL-terminated name (valid until the next name is added)
+ */
+const char* get_name(const project_t* project, name_ref_t name);
+
+// =============================================================================
+// MEMORY MANAGEMENT FUNCTIONS
+// =============================================================================
+
+/**
+ * Create and initialize a new project structure
+ * Creates the project's arena, then allocates the project, its ID
+ * manager and its name pool from it
+ * @return Pointer to new project, exits on allocation failure
+ */
+project_t* create_project(void);
+
+/**
+ * Create dynamic array of milestones
+ * @param arena Arena of the owning project
+ * @param size Number of milestones to allocate
+ * @return Pointer to zeroed milestone array, exits on allocation failure
+ */
+milestone_t* create_milestone_array(arena_t* arena, int size);
+
+/**
+ * Create dynamic array of activities
+ * @param arena Arena of the owning project
+ * @param size Number of activities to allocate
+ * @return Pointer to zeroed activity array, exits on allocation failure
+ */
+activity_t* create_activity_array(arena_t* arena, int size);
+
+/**
+ * Free entire project and all associated memory
+ * Destroys the project's arena, which holds the project, milestones,
+ * activities, ID manager and any snapshot mapping - no tree walk needed
+ * @param project Pointer to project to free
+ */
+void free_project(project_t* project);
+
+// =============================================================================
+// CORE PROJECT MANAGEMENT FUNCTIONS
+// =============================================================================
+
+/**
+ * Initialize activity with user input for planned values
+ * Sets actual values to 0 and completed to false
+ * @param project Project owning the activity (provides the name pool)
+ * @param activity_to_init Pointer to activity to initialize
+ */
+void init_activity(const project_t* project, activity_t* activity_to_init);
+
+/**
+ * Initialize milestone with user input for number of activities
+ * Creates activity array and sets initial values
+ * @param project Project owning the milestone (provides the arena)
+ * @param milestone_to_init Pointer to milestone to initialize
+ */
+void init_milestone(project_t* project, milestone_t* milestone_to_init);
+
+/**
+ * Create and initialize project with given name
+ * Gets number of milestones from user and creates milestone array
+ * @param name Project name to set
+ * @return Pointer to initialized project
+ */
+project_t* init_project(char name[]);
+
+// =============================================================================
+// USER INTERFACE FUNCTIONS
+// =============================================================================
+
+/**
+ * Display main menu options to user
+ */
+void print_main_menu(void);
+
+/**
+ * Display all incomplete activities with their IDs
+ * Skips completed milestones and walks each remaining milestone's
+ * open-activity bitmap, so the cost follows the open work rather than
+ * the size of the project; output goes through the buffered report writer
+ * @param project Project to search for incomplete activities
+ * @return Number of incomplete activities found
+ */
+int display_incomplete_activities(const project_t* project);
+
+/**
+ * Print detailed statistics for all milestones in project
+ * Shows completion status and progress for each milestone
+ * (buffered: see report_milestone_stats)
+ * @param project Project containing milestones to display
+ */
+void print_milestone_stats(const project_t* project);
+
+/**
+ * Print comprehensive project statistics
+ * Includes cost/schedule variance analysis if completed
+ * (buffered: see report_project_stats)
+ * @param project Project to display statistics for
+ */
+void print_project_stats(const project_t* project);
+
+// =============================================================================
+// UPDATE FUNCTIONS
+// =============================================================================
+
+/**
+ * Update activity with actual duration, cost, and completion status
+ * Gets input from user for all actual values
+ * @param activity_to_update Pointer to activity to update
+ */
+void update_activity(activity_t* activity_to_update);
+
+/**
+ * Copy the hot fields of every activity into the milestone's columns
+ * Call after the activity records were filled or edited in bulk; single
+ * updates made through rollup_activity_change keep the columns in sync.
+ * @param arena Arena of the owning project (columns grow from it if needed)
+ * @param milestone Milestone whose columns to build
+ */
+void build_activity_columns(arena_t* arena, milestone_t* milestone);
+
+/**
+ * Copy one edited activity into its milestone's columns without rolling up
+ * For bulk edits that finish with update_milestone on the milestone
+ * @param milestone Milestone containing the activity
+ * @param activity Activity that was edited in place
+ */
+void refresh_activity_columns(milestone_t* milestone, const activity_t* activity);
+
+/**
+ * Update milestone based on its activities' current status
+ * Recalculates completion status, planned and actual totals, and duration
+ * using the SIMD kernels over the activity columns when they are valid,
+ * or a scalar pass over the activity records otherwise
+ * @param milestone_to_update Pointer to milestone to update
+ */
+void update_milestone(milestone_t* milestone_to_update);
+
+/**
+ * Update project based on its milestones' current status
+ * Recalculates overall completion status, total cost, duration and the
+ * open activity count from the milestone totals, so every milestone must be
+ * up to date first
+ * @param project Pointer to project to update
+ */
+void update_project(project_t* project);
+
+/**
+ * Propagate a single activity change to its milestone and project - O(1)
+ * Applies only the difference between the old and new activity values
+ * instead of re-summing the hierarchy, and refreshes the activity's column
+ * entry. Totals must have been established by a full
+ * update_milestone/update_project pass beforehand.
+ * Building with -DPM_VERIFY_ROLLUPS checks every call against a full recompute.
+ * @param project Project containing the activity
+ * @param milestone Milestone containing the activity
+ * @param before Activity values prior to the change
+ * @param after Activity values after the change
+ */
+void rollup_activity_change(project_t* project, milestone_t* milestone,
+                            const activity_t* before, const activity_t* after);
+
+/**
+ * Set an activity's actual values and roll the change up - O(1)
+ * Non-interactive counterpart of update_activity + rollup_activity_change,
+ * used wherever updates arrive as data (journal replay, batches, server)
+ * @param project Project containing the activity
+ * @param activity_id ID of the activity to update
+ * @param actual_duration New actual duration in hours
+ * @param actual_cost New actual cost
+ * @param completed New completion status
+ * @return true on success, false if no activity has that ID
+ */
+bool apply_activity_update(project_t* project, unsigned short int activity_id,
+                           unsigned short int actual_duration, money_t actual_cost,
+                           bool completed);
+
+/**
+ * Check incremental totals against a full recompute of the hierarchy
+ * Prints every mismatching field to stderr
+ * @param project Project to verify
+ * @return true if all milestone and project totals match
+ */
+bool verify_rollups(const project_t* project);
+
+/**
+ * Find the next incomplete activity of a milestone
+ * Walks the milestone's open-activity bitmap when its columns are valid,
+ * skipping 64 completed activities per word, or the records otherwise.
+ * Loop with: for (j = next_open_activity(m, 0); j != NO_INDEX; j = next_open_activity(m, j + 1))
+ * @param milestone Milestone to search
+ * @param start First activity index to consider
+ * @return Index of the first incomplete activity at or after start, or NO_INDEX
+ */
+int next_open_activity(const milestone_t* milestone, int start);
+
+// =============================================================================
+// DYNAMIC STRUCTURE FUNCTIONS
+// =============================================================================
+
+/*
+ * Items can be added and removed after setup. Arrays grow by doubling, so
+ * additions are amortized O(1); removals move the last item into the gap
+ * and re-point its ID, so they are O(1) for activities (milestones also
+ * re-point the moved milestone's activities). Totals are adjusted
+ * incrementally. Any pointer to a milestone or activity may be invalidated
+ * by these calls; keep an item_handle_t across them instead.
+ */
+
+/**
+ * Append a new, empty milestone
+ * @param project Project to add to
+ * @param id Unique ID for the milestone, or 0 to assign the next free one
+ * @param name Milestone name
+ * @return The new milestone, or NULL if the ID is in use or none are left
+ */
+milestone_t* add_milestone(project_t* project, unsigned short int id, const char* name);
+
+/**
+ * Append a new, not yet started activity to a milestone
+ * @param project Project containing the milestone
+ * @param milestone Milestone to add to
+ * @param id Unique ID for the activity, or 0 to assign the next free one
+ * @param name Activity name
+ * @param planned_duration Planned duration in hours
+ * @param planned_cost Planned cost
+ * @return The new activity, or NULL if the ID is in use or none are left
+ */
+activity_t* add_activity(project_t* project, milestone_t* milestone, unsigned short int id,
+                         const char* name, unsigned short int planned_duration, money_t planned_cost);
+
+/**
+ * Remove an activity and release its ID - O(1)
+ * The milestone's last activity takes its place in the array. Dependencies
+ * on the activity are dropped (one pass over the project's dependencies).
+ * @return false if no activity has that ID
+ */
+bool remove_activity(project_t* project, unsigned short int activity_id);
+
+/**
+ * Remove a milestone with all of its activities and release their IDs
+ * The project's last milestone takes its place in the array.
+ * @return false if no milestone has that ID
+ */
+bool remove_milestone(project_t* project, unsigned short int milestone_id);
+
+/**
+ * Take a stable handle to the milestone or activity that owns an ID
+ */
+item_handle_t get_item_handle(const project_t* project, unsigned short int id);
+
+/**
+ * Resolve a handle to its activity - O(1)
+ * @param milestone_out Output parameter for containing milestone (may be NULL)
+ * @return The activity, or NULL if it has been removed since
+ */
+activity_t* resolve_activity(project_t* project, item_handle_t handle, milestone_t** milestone_out);
+
+/**
+ * Resolve a handle to its milestone - O(1)
+ * @return The milestone, or NULL if it has been removed since
+ */
+milestone_t* resolve_milestone(project_t* project, item_handle_t handle);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+/* arena.c */
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/**
+ * Round a size up to the arena alignment
+ */
+static size_t align_size(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * Obtain a new zeroed block from the system
+ * calloc serves large blocks straight from fresh pages, so untouched parts
+ * of a block cost no resident memory.
+ */
+static arena_block_t* new_block(arena_t* arena, size_t size) {
+    arena_block_t* block = calloc(1, sizeof(arena_block_t) + size);
+    if (block == NULL) {
+        printf("ERROR: Failed to allocate arena block. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    block->size = size;
+    arena->num_blocks++;
+    arena->bytes_reserved += size;
+    return block;
+}
+
+arena_t* arena_create(size_t block_size) {
+    arena_t* arena = calloc(1, sizeof(arena_t));
+    if (arena == NULL) {
+        printf("ERROR: Failed to allocate arena. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    arena->block_size = block_size ? align_size(block_size) : ARENA_DEFAULT_BLOCK_SIZE;
+    return arena;
+}
+
+void* arena_alloc(arena_t* arena, size_t size) {
+    size = align_size(size ? size : 1);
+    arena->num_allocations++;
+    arena->bytes_used += size;
+
+    arena_block_t* head = arena->head;
+    if (head != NULL && head->size - head->used >= size) {
+        head->last_offset = head->used;
+        head->used += size;
+        return head->data + head->last_offset;
+    }
+
+    if (size > arena->block_size / 2) {
+        // Big request: dedicated block, linked behind the head so the
+        // partially filled head keeps serving small requests
+        arena_block_t* block = new_block(arena, size);
+        block->used = size;
+        if (head != NULL) {
+            block->next = head->next;
+            head->next = block;
+        } else {
+            arena->head = block;
+        }
+        return block->data;
+    }
+
+    arena_block_t* block = new_block(arena, arena->block_size);
+    block->next = head;
+    block->used = size;
+    arena->head = block;
+    return block->data;
+}
+
+void* arena_grow(arena_t* arena, void* pointer, size_t old_size, size_t new_size) {
+    if (pointer == NULL) {
+        return arena_alloc(arena, new_size);
+    }
+
+    // In place: the allocation is the last one carved from the head block
+    arena_block_t* head = arena->head;
+    size_t old_aligned = align_size(old_size ? old_size : 1);
+    size_t new_aligned = align_size(new_size ? new_size : 1);
+    if (head != NULL && (char*)pointer == head->data + head->last_offset &&
+        head->last_offset + old_aligned == head->used &&
+        head->size - head->last_offset >= new_aligned) {
+        head->used = head->last_offset + new_aligned;
+        arena->bytes_used += new_aligned - old_aligned;
+        return pointer;
+    }
+
+    void* grown = arena_alloc(arena, new_size);
+    memcpy(grown, pointer, old_size);
+    return grown;
+}
+
+void arena_adopt_mapping(arena_t* arena, void* base, size_t size) {
+    arena->mapping = base;
+    arena->mapping_size = size;
+}
+
+bool arena_in_mapping(const arena_t* arena, const void* pointer) {
+    const char* base = arena->mapping;
+    const char* p = pointer;
+    return base != NULL && p >= base && p < base + arena->mapping_size;
+}
+
+void arena_destroy(arena_t* arena) {
+    if (arena == NULL) {
+        return;
+    }
+
+    arena_block_t* block = arena->head;
+    while (block != NULL) {
+        arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+    if (arena->mapping != NULL) {
+        munmap(arena->mapping, arena->mapping_size);
+    }
+    free(arena);
+}
@@ -0,0 +1,102 @@
+/* arena.h */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (1 << 20)  // 1 MiB blocks
+#define ARENA_ALIGNMENT 16                  // Every allocation is 16-byte aligned
+
+/**
+ * Arena Block
+ *
+ * One contiguous chunk of memory carved up by pointer bumps. Blocks are
+ * chained so the whole arena can be released in one walk.
+ */
+typedef struct arena_block {
+    struct arena_block* next;   // Previously filled block
+    size_t size;                // Usable bytes in data
+    size_t used;                // Bytes handed out so far
+    size_t last_offset;         // Offset of the most recent allocation (for in-place growth)
+    _Alignas(ARENA_ALIGNMENT) char data[];
+} arena_block_t;
+
+/**
+ * Arena Structure
+ *
+ * Project-scoped bump allocator. Everything belonging to a project (the
+ * project itself, milestones, activities, the ID manager and later index
+ * structures) comes from one arena, so creating a project costs a handful
+ * of large allocations and freeing it is independent of the number of items.
+ * Individual allocations are never freed; memory returns when the arena is
+ * destroyed.
+ *
+ * An arena can also adopt a mapped snapshot file; data used in place from the
+ * mapping is then released together with the arena.
+ *
+ * Fields:
+ * - head: Block currently being filled
+ * - block_size: Size of regular blocks (larger requests get their own block)
+ * - mapping/mapping_size: Adopted snapshot mapping (NULL if none)
+ * - num_blocks/num_allocations: Allocation counters
+ * - bytes_reserved/bytes_used: Memory obtained from the system vs handed out
+ */
+typedef struct {
+    arena_block_t* head;
+    size_t block_size;
+    void* mapping;
+    size_t mapping_size;
+    size_t num_blocks;
+    size_t num_allocations;
+    size_t bytes_reserved;
+    size_t bytes_used;
+} arena_t;
+
+/**
+ * Create an empty arena
+ * @param block_size Size of regular blocks (0 for ARENA_DEFAULT_BLOCK_SIZE)
+ * @return New arena, exits on allocation failure
+ */
+arena_t* arena_create(size_t block_size);
+
+/**
+ * Allocate zeroed, aligned memory from the arena (pointer bump)
+ * @param arena Arena to allocate from
+ * @param size Number of bytes (0 returns a valid unique pointer)
+ * @return Pointer to the memory, exits on allocation failure
+ */
+void* arena_alloc(arena_t* arena, size_t size);
+
+/**
+ * Grow an allocation made from this arena
+ * The most recent allocation of a block grows in place when the block has
+ * room; otherwise the data is copied to a new allocation and the old space is
+ * abandoned until the arena is destroyed. New bytes are zeroed.
+ * @param arena Arena the allocation came from
+ * @param pointer Existing allocation (NULL behaves like arena_alloc)
+ * @param old_size Current size of the allocation
+ * @param new_size Requested size (must be >= old_size)
+ * @return Pointer to the grown allocation
+ */
+void* arena_grow(arena_t* arena, void* pointer, size_t old_size, size_t new_size);
+
+/**
+ * Hand a mapped snapshot region over to the arena
+ * It is unmapped when the arena is destroyed.
+ */
+void arena_adopt_mapping(arena_t* arena, void* base, size_t size);
+
+/**
+ * Check whether a pointer lies inside the adopted mapping
+ */
+bool arena_in_mapping(const arena_t* arena, const void* pointer);
+
+/**
+ * Release every block and the adopted mapping - O(number of blocks)
+ * Pointers into the arena (including a project allocated from it) become
+ * invalid.
+ */
+void arena_destroy(arena_t* arena);
+
+#endif
@@ -0,0 +1,290 @@
+/* bench.c */
+#include "a1_functions.h"
+#include "bench_util.h"
+#include "kernels.h"
+#include "workload.h"
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+/**
+ * OPERATION BENCHMARK SUITE
+ *
+ * Times the core operations against synthetic projects of several shapes.
+ * Each operation is measured as a series of samples; a sample runs the
+ * operation a fixed number of times so cheap operations rise well above
+ * the clock resolution. Output written by the timed operations themselves
+ * (listings, reports) goes to /dev/null while they run.
+ *
+ * Usage: bench [--samples N] [--completed PERCENT] [--seed N] [shape ...]
+ *        shape is <milestones>x<activities>, default 10x6000 100x600 5000x10
+ * Output: JSON Lines on stdout, one object per shape and operation:
+ *   {"shape":"10x6000","op":"find_activity_by_id","samples":101,"ops_per_sample":4096,
+ *    "ns_per_op":..,"min":..,"p50":..,"p90":..,"p99":..,"max":..}
+ * followed by {"summary":..,"peak_rss_kb":..} for the whole run.
+ */
+
+#define DEFAULT_SAMPLES 101
+#define DEFAULT_COMPLETED_PERCENT 50
+#define OPS_PER_SAMPLE 4096          // Repetitions of the per-item operations per sample
+
+/**
+ * Benchmark Run
+ *
+ * - shape: Textual shape, echoed in every result line
+ * - project: Project under test
+ * - samples: Scratch array of per-sample ns/op values
+ * - num_samples: Samples per operation
+ * - activity_ids/random_ids: OPS_PER_SAMPLE activity IDs and arbitrary IDs
+ * - null_fd/stdout_fd: /dev/null and the saved standard output
+ */
+typedef struct {
+    const char* shape;
+    project_t* project;
+    double* samples;
+    int num_samples;
+    unsigned short int activity_ids[OPS_PER_SAMPLE];
+    unsigned short int random_ids[OPS_PER_SAMPLE];
+    int null_fd;
+    int stdout_fd;
+} bench_t;
+
+static volatile long sink;  // Keeps results of timed calls alive
+
+static long peak_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;  // Kilobytes on Linux
+}
+
+/**
+ * Value at a percentile of sorted samples (nearest rank)
+ */
+static double percentile(const double* sorted, int count, int percent) {
+    int rank = (percent * count + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * Print one result line (sorts the samples in place)
+ */
+static void report(bench_t* bench, const char* op, long ops_per_sample) {
+    double total = 0;
+    for (int i = 0; i < bench->num_samples; i++) {
+        total += bench->samples[i];
+    }
+    qsort(bench->samples, (size_t)bench->num_samples, sizeof(double), compare_doubles);
+
+    printf("{\"shape\":\"%s\",\"op\":\"%s\",\"samples\":%d,\"ops_per_sample\":%ld,"
+           "\"ns_per_op\":%.1f,\"min\":%.1f,\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"max\":%.1f}\n",
+           bench->shape, op, bench->num_samples, ops_per_sample,
+           total / bench->num_samples, bench->samples[0],
+           percentile(bench->samples, bench->num_samples, 50),
+           percentile(bench->samples, bench->num_samples, 90),
+           percentile(bench->samples, bench->num_samples, 99),
+           bench->samples[bench->num_samples - 1]);
+    fflush(stdout);
+}
+
+/**
+ * Send standard output to /dev/null while output-producing operations run
+ */
+static void silence_stdout(bench_t* bench) {
+    fflush(stdout);
+    dup2(bench->null_fd, STDOUT_FILENO);
+}
+
+static void restore_stdout(bench_t* bench) {
+    fflush(stdout);
+    dup2(bench->stdout_fd, STDOUT_FILENO);
+}
+
+static void bench_id_operations(bench_t* bench) {
+    for (int s = 0; s < bench->num_samples; s++) {
+        long hits = 0;
+        double start = now_ns();
+        for (int i = 0; i < OPS_PER_SAMPLE; i++) {
+            hits += is_id_unique(bench->random_ids[i], bench->project->id_manager);
+        }
+        bench->samples[s] = (now_ns() - start) / OPS_PER_SAMPLE;
+        sink += hits;
+    }
+    report(bench, "is_id_unique", OPS_PER_SAMPLE);
+
+    // Fresh manager per run so every add succeeds; releases are not timed
+    arena_t* arena = arena_create(0);
+    id_manager_t* manager = init_id_manager(arena);
+    for (int s = 0; s < bench->num_samples; s++) {
+        long added = 0;
+        double start = now_ns();
+        for (int i = 0; i < OPS_PER_SAMPLE; i++) {
+            added += add_id(bench->random_ids[i], manager);
+        }
+        bench->samples[s] = (now_ns() - start) / OPS_PER_SAMPLE;
+        sink += added;
+        for (int i = 0; i < OPS_PER_SAMPLE; i++) {
+            release_id(bench->random_ids[i], manager);
+        }
+    }
+    report(bench, "add_id", OPS_PER_SAMPLE);
+    arena_destroy(arena);
+
+    for (int s = 0; s < bench->num_samples; s++) {
+        long found = 0;
+        double start = now_ns();
+        for (int i = 0; i < OPS_PER_SAMPLE; i++) {
+            found += find_activity_by_id(bench->project, bench->activity_ids[i], NULL) != NULL;
+        }
+        bench->samples[s] = (now_ns() - start) / OPS_PER_SAMPLE;
+        sink += found;
+    }
+    report(bench, "find_activity_by_id", OPS_PER_SAMPLE);
+}
+
+static void bench_rollups(bench_t* bench) {
+    project_t* project = bench->project;
+
+    // Re-post each activity's current values so the workload stays fixed
+    for (int s = 0; s < bench->num_samples; s++) {
+        double start = now_ns();
+        for (int i = 0; i < OPS_PER_SAMPLE; i++) {
+            const activity_t* activity = find_activity_by_id(project, bench->activity_ids[i], NULL);
+            apply_activity_update(project, activity->id, activity->actual_duration,
+                                  activity->actual_cost + money_from_dollars(1), activity->completed);
+        }
+        bench->samples[s] = (now_ns() - start) / OPS_PER_SAMPLE;
+    }
+    report(bench, "apply_activity_update", OPS_PER_SAMPLE);
+
+    for (int s = 0; s < bench->num_samples; s++) {
+        double start = now_ns();
+        for (int i = 0; i < project->num_milestones; i++) {
+            update_milestone(&project->milestone_list[i]);
+        }
+        bench->samples[s] = (now_ns() - start) / project->num_milestones;
+    }
+    report(bench, "update_milestone", project->num_milestones);
+
+    long repeats = OPS_PER_SAMPLE / project->num_milestones + 1;
+    for (int s = 0; s < bench->num_samples; s++) {
+        double start = now_ns();
+        for (long i = 0; i < repeats; i++) {
+            update_project(project);
+        }
+        bench->samples[s] = (now_ns() - start) / (double)repeats;
+    }
+    report(bench, "update_project", repeats);
+}
+
+static void bench_output(bench_t* bench) {
+    for (int s = 0; s < bench->num_samples; s++) {
+        silence_stdout(bench);
+        double start = now_ns();
+        sink += display_incomplete_activities(bench->project);
+        fflush(stdout);
+        bench->samples[s] = now_ns() - start;
+        restore_stdout(bench);
+    }
+    report(bench, "display_incomplete_activities", 1);
+
+    for (int s = 0; s < bench->num_samples; s++) {
+        silence_stdout(bench);
+        double start = now_ns();
+        print_project_stats(bench->project);
+        fflush(stdout);
+        bench->samples[s] = now_ns() - start;
+        restore_stdout(bench);
+    }
+    report(bench, "print_project_stats", 1);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--samples N] [--completed PERCENT] [--seed N] [<milestones>x<activities> ...]\n"
+                    "  Each shape may hold at most 65,535 IDs: milestones * (activities + 1)\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    const char* default_shapes[] = { "10x6000", "100x600", "5000x10" };
+    const char* shapes[64];
+    int num_shapes = 0;
+    int num_samples = DEFAULT_SAMPLES;
+    workload_shape_t shape = { 0, 0, DEFAULT_COMPLETED_PERCENT, 1 };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            num_samples = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--completed") == 0 && i + 1 < argc) {
+            shape.completed_percent = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            shape.seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (num_shapes < 64 && workload_parse_shape(argv[i], &shape)) {
+            shapes[num_shapes++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (num_samples < 1 || shape.completed_percent < 0 || shape.completed_percent > 100) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (num_shapes == 0) {
+        for (int i = 0; i < 3; i++) {
+            shapes[num_shapes++] = default_shapes[i];
+        }
+    }
+
+    bench_t bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.num_samples = num_samples;
+    bench.samples = malloc((size_t)num_samples * sizeof(double));
+    bench.null_fd = open("/dev/null", O_WRONLY);
+    bench.stdout_fd = dup(STDOUT_FILENO);
+    if (bench.samples == NULL || bench.null_fd < 0 || bench.stdout_fd < 0) {
+        fprintf(stderr, "ERROR: Failed to set up the benchmark\n");
+        return EXIT_FAILURE;
+    }
+
+    for (int n = 0; n < num_shapes; n++) {
+        if (!workload_parse_shape(shapes[n], &shape)) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        bench.shape = shapes[n];
+
+        double start = now_ns();
+        bench.project = generate_project(&shape);
+        double build_ms = (now_ns() - start) / 1e6;
+        printf("{\"shape\":\"%s\",\"op\":\"generate_project\",\"ms\":%.3f,\"activities\":%d,"
+               "\"open_activities\":%d,\"peak_rss_kb\":%ld}\n",
+               bench.shape, build_ms, shape.num_milestones * shape.activities_per_milestone,
+               bench.project->num_open_activities, peak_rss_kb());
+
+        // Same pseudo-random picks for every shape with the same seed
+        uint32_t random = shape.seed ? shape.seed : 1;
+        int num_activities = shape.num_milestones * shape.activities_per_milestone;
+        for (int i = 0; i < OPS_PER_SAMPLE; i++) {
+            random = random * 1103515245u + 12345u;
+            bench.random_ids[i] = (unsigned short int)(1 + (random >> 8) % 65535);
+            if (num_activities > 0) {
+                int slot = (int)((random >> 4) % (uint32_t)num_activities);
+                const milestone_t* milestone =
+                    &bench.project->milestone_list[slot / shape.activities_per_milestone];
+                bench.activity_ids[i] = milestone->activity_list[slot % shape.activities_per_milestone].id;
+            }
+        }
+
+        bench_id_operations(&bench);
+        if (num_activities > 0) {
+            bench_rollups(&bench);
+        }
+        bench_output(&bench);
+        free_project(bench.project);
+    }
+
+    printf("{\"summary\":{\"shapes\":%d,\"samples\":%d,\"kernels\":\"%s\"},\"peak_rss_kb\":%ld}\n",
+           num_shapes, num_samples, kernel_isa(), peak_rss_kb());
+    free(bench.samples);
+    return 0;
+}
@@ -0,0 +1,188 @@
+/* bench_history.c */
+#include "a1_functions.h"
+#include "bench_util.h"
+#include "history.h"
+#include "workload.h"
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * PROGRESS HISTORY BENCHMARK
+ *
+ * Builds a synthetic project and replays a year of random activity updates
+ * on it, recording every milestone change in a history file with the
+ * update's simulated time. Reports the compressed size per row against the
+ * plain row size, the recording cost per update, and how long a 90-day
+ * trend query takes and how many blocks it decodes.
+ *
+ * The query result is checked against the same trends computed from an
+ * uncompressed copy of every row kept in memory.
+ *
+ * Usage: bench_history [--updates N] [--days N] [--file PATH] [--seed N] [shape]
+ *        defaults: 60x1000, 1000000 updates over 365 days, 90-day query
+ * Output: key=value lines
+ */
+
+#define DEFAULT_UPDATES 1000000
+#define HISTORY_SPAN_DAYS 365
+#define DEFAULT_QUERY_DAYS 90
+#define DEFAULT_FILE "bench_history.tmp"
+
+static bool rows_equal(const history_row_t* a, const history_row_t* b) {
+    return a->time == b->time && a->milestone_id == b->milestone_id && a->planned_cents == b->planned_cents &&
+           a->actual_cents == b->actual_cents && a->planned_hours == b->planned_hours &&
+           a->actual_hours == b->actual_hours && a->num_completed == b->num_completed &&
+           a->num_activities == b->num_activities;
+}
+
+int main(int argc, char* argv[]) {
+    workload_shape_t shape = { 60, 1000, 0, 1 };
+    long num_updates = DEFAULT_UPDATES;
+    int query_days = DEFAULT_QUERY_DAYS;
+    const char* path = DEFAULT_FILE;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--updates") == 0 && i + 1 < argc) {
+            num_updates = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+            query_days = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (!workload_parse_shape(argv[i], &shape)) {
+            fprintf(stderr, "Usage: %s [--updates N] [--days N] [--file PATH] [--seed N] "
+                            "[<milestones>x<activities>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (num_updates < 1 || query_days < 1 || query_days >= HISTORY_SPAN_DAYS || seed == 0) {
+        fprintf(stderr, "ERROR: --updates and --seed must be positive, --days between 1 and %d\n",
+                HISTORY_SPAN_DAYS - 1);
+        return EXIT_FAILURE;
+    }
+
+    shape.seed = seed;
+    project_t* project = generate_project(&shape);
+    unlink(path);
+    history_t* history = history_open(path, project);
+    if (history == NULL) {
+        free_project(project);
+        return EXIT_FAILURE;
+    }
+
+    int num_activities = 0;
+    unsigned short int* ids = malloc((size_t)shape.num_milestones * (size_t)shape.activities_per_milestone *
+                                     sizeof(unsigned short int));
+    history_row_t* rows = malloc((size_t)num_updates * sizeof(history_row_t));
+    if (ids == NULL || rows == NULL) {
+        printf("ERROR: Failed to allocate benchmark state. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        for (int j = 0; j < milestone->num_activities; j++) {
+            ids[num_activities++] = milestone->activity_list[j].id;
+        }
+    }
+
+    // A year of updates, spread evenly; the history's baseline rows are the
+    // start (they carry the real current time, so the year ends a year later)
+    int64_t start_time = history->last_time;
+    int64_t span = (int64_t)HISTORY_SPAN_DAYS * SECONDS_PER_DAY;
+    uint32_t random = seed;
+    double recording_ns = 0;
+    for (long u = 0; u < num_updates; u++) {
+        unsigned short int id = ids[next_random(&random) % (uint32_t)num_activities];
+        milestone_t* milestone = NULL;
+        activity_t* activity = find_activity_by_id(project, id, &milestone);
+        unsigned short int hours = (unsigned short int)(activity->actual_duration + next_random(&random) % 8);
+        money_t cost = activity->actual_cost + money_from_dollars((float)(next_random(&random) % 20000) / 100);
+        apply_activity_update(project, id, hours, cost, activity->completed || next_random(&random) % 8 == 0);
+
+        history_row_t* row = &rows[u];
+        row->time = start_time + span * (u + 1) / num_updates;
+        row->milestone_id = milestone->id;
+        row->planned_cents = money_to_cents(milestone->planned_cost);
+        row->actual_cents = money_to_cents(milestone->actual_cost);
+        row->planned_hours = milestone->planned_hours;
+        row->actual_hours = milestone->actual_hours;
+        row->num_completed = milestone->num_completed;
+        row->num_activities = milestone->num_activities;
+
+        double begin = now_ns();
+        history_append(history, row);
+        recording_ns += now_ns() - begin;
+    }
+    history_flush(history);
+
+    long written_rows = history->num_rows;
+    printf("shape=%dx%d updates=%ld rows=%ld blocks=%ld\n", shape.num_milestones, shape.activities_per_milestone,
+           num_updates, written_rows, history->num_blocks);
+    printf("bytes_per_row=%.2f plain_bytes_per_row=%zu compression=%.1fx file_mb=%.2f\n",
+           (double)history->file_size / (double)written_rows, sizeof(history_row_t),
+           (double)sizeof(history_row_t) * (double)written_rows / (double)history->file_size,
+           (double)history->file_size / (1024.0 * 1024.0));
+    printf("record_ns=%.0f\n", recording_ns / (double)num_updates);
+
+    // Range query: the last query_days of the year
+    int64_t end_time = start_time + span;
+    int64_t from = end_time - (int64_t)query_days * SECONDS_PER_DAY;
+    history_trend_t* trends;
+    double begin = now_ns();
+    int num_trends = history_trends(history, from, end_time, &trends);
+    double query_ms = (now_ns() - begin) / 1e6;
+
+    history_cursor_t* cursor = history_cursor_open(history, from, end_time);
+    history_row_t row;
+    long in_range = 0;
+    while (history_cursor_next(cursor, &row)) {
+        in_range++;
+    }
+    printf("query_days=%d query_ms=%.2f rows_in_range=%ld blocks_read=%ld blocks_skipped=%ld milestones=%d\n",
+           query_days, query_ms, in_range, cursor->blocks_read, cursor->blocks_skipped, num_trends);
+    history_cursor_close(cursor);
+
+    // Same trends from the uncompressed rows (the baseline rows are older
+    // than the window, which is shorter than the year)
+    int* index = malloc(65536 * sizeof(int));
+    history_trend_t* expected = calloc((size_t)project->num_milestones, sizeof(history_trend_t));
+    if (index == NULL || expected == NULL) {
+        printf("ERROR: Failed to allocate verification state. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    int num_expected = 0;
+    memset(index, -1, 65536 * sizeof(int));
+    for (long u = 0; u < num_updates; u++) {
+        if (rows[u].time < from) {
+            continue;
+        }
+        int slot = index[rows[u].milestone_id];
+        if (slot < 0) {
+            slot = index[rows[u].milestone_id] = num_expected++;
+            expected[slot].first = rows[u];
+        }
+        expected[slot].num_samples++;
+        expected[slot].last = rows[u];
+    }
+    bool verified = num_trends == num_expected;
+    for (int i = 0; verified && i < num_trends; i++) {
+        const history_trend_t* got = &trends[i];
+        int slot = index[got->milestone_id];
+        verified = slot >= 0 && got->num_samples == expected[slot].num_samples &&
+                   rows_equal(&got->first, &expected[slot].first) && rows_equal(&got->last, &expected[slot].last);
+    }
+    printf("verified=%s\n", verified ? "yes" : "NO");
+
+    free(index);
+    free(expected);
+    free(trends);
+    free(rows);
+    free(ids);
+    history_close(history);
+    unlink(path);
+    free_project(project);
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,86 @@
+/* bench_journal.c */
+#include "a1_functions.h"
+#include "bench_util.h"
+#include "journal.h"
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * JOURNAL THROUGHPUT BENCHMARK
+ *
+ * Measures sustained activity updates per second (apply_activity_update
+ * followed by journal_append) under each durability policy.
+ *
+ * Usage: bench_journal [updates] [journal_file]
+ * Output: one line per policy, key=value pairs
+ */
+
+#define BENCH_MILESTONES 10
+#define BENCH_ACTIVITIES_PER_MILESTONE 1000
+
+/**
+ * Build a small project with auto-assigned IDs and zeroed actuals
+ */
+static project_t* build_bench_project(void) {
+    project_t* project = create_project();
+    snprintf(project->name, sizeof(project->name), "journal bench");
+    project->num_milestones = BENCH_MILESTONES;
+    project->milestone_list = create_milestone_array(project->arena, BENCH_MILESTONES);
+
+    for (int i = 0; i < BENCH_MILESTONES; i++) {
+        milestone_t* milestone = &project->milestone_list[i];
+        milestone->id = allocate_id(project->id_manager);
+        set_id_location(project->id_manager, milestone->id, i, NO_INDEX);
+        milestone->num_activities = BENCH_ACTIVITIES_PER_MILESTONE;
+        milestone->activity_list = create_activity_array(project->arena, BENCH_ACTIVITIES_PER_MILESTONE);
+
+        for (int j = 0; j < BENCH_ACTIVITIES_PER_MILESTONE; j++) {
+            activity_t* activity = &milestone->activity_list[j];
+            activity->id = allocate_id(project->id_manager);
+            set_id_location(project->id_manager, activity->id, i, j);
+            activity->planned_duration = 8;
+            activity->planned_cost = money_from_dollars(100);
+        }
+        build_activity_columns(project->arena, milestone);
+        update_milestone(milestone);
+    }
+    update_project(project);
+    return project;
+}
+
+int main(int argc, char* argv[]) {
+    long updates = argc > 1 ? atol(argv[1]) : 20000;
+    const char* path = argc > 2 ? argv[2] : "bench.journal";
+    const char* names[] = { "always", "group", "none" };
+    const journal_sync_t policies[] = { JOURNAL_SYNC_ALWAYS, JOURNAL_SYNC_GROUP, JOURNAL_SYNC_NONE };
+
+    for (int p = 0; p < 3; p++) {
+        project_t* project = build_bench_project();
+        unlink(path);
+        journal_t* journal = journal_open(path, policies[p], NULL);
+        if (journal == NULL) {
+            return EXIT_FAILURE;
+        }
+
+        int total_activities = BENCH_MILESTONES * BENCH_ACTIVITIES_PER_MILESTONE;
+        double start = now_ns();
+        for (long n = 0; n < updates; n++) {
+            long slot = n % total_activities;
+            milestone_t* milestone = &project->milestone_list[slot / BENCH_ACTIVITIES_PER_MILESTONE];
+            const activity_t* activity = &milestone->activity_list[slot % BENCH_ACTIVITIES_PER_MILESTONE];
+
+            apply_activity_update(project, activity->id, (unsigned short int)(n % 16),
+                                  (float)(n % 200), false);
+            journal_append(journal, project, activity);
+        }
+        journal_close(journal); // Final flush counts towards the measured time
+        double elapsed = (now_ns() - start) / 1e9;
+
+        printf("policy=%s updates=%ld seconds=%.6f updates_per_sec=%.0f\n",
+               names[p], updates, elapsed, (double)updates / elapsed);
+        free_project(project);
+    }
+
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,161 @@
+/* bench_numeric.c */
+#include "bench_util.h"
+#include "kernels.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * NUMERIC MODE BENCHMARK
+ *
+ * Compares the two ways costs can be held (see a1_data_structures.h):
+ * float dollars, the default, and integer cents (-DPM_FIXED_POINT). Both
+ * kernels are in every build, so one run measures both.
+ *
+ * Accuracy, against exact integer sums of the same random cents:
+ *   - sum: the error of sum_floats over float dollars, at sizes from a
+ *     small milestone up to the whole value array
+ *   - drift: a running total kept by adding each update's difference, as
+ *     the rollups do, at every power of two updates and at the end, then a
+ *     fresh sum of the updated values
+ *
+ * Speed: best time of several runs of sum_floats and sum_int32s over one
+ * milestone's worth of values (the ID space caps it at 65535), in ns per
+ * value. The int32 cents column is as many bytes as the float one; the
+ * kernel widens it into 64-bit accumulators.
+ *
+ * Rollup timings in each mode come from bench.c built with and without
+ * -DPM_FIXED_POINT.
+ *
+ * Checked: sum_int32s equals a plain 64-bit loop at every size.
+ *
+ * Usage: bench_numeric [--runs N] [--values N] [--updates N] [--seed N]
+ *        defaults: 200 runs, 1000000 values, 1000000 updates
+ * Output: key=value lines
+ */
+
+#define DEFAULT_RUNS 200
+#define DEFAULT_VALUES 1000000
+#define DEFAULT_UPDATES 1000000
+#define KERNEL_VALUES 65535          // One milestone at most
+#define MAX_CENTS 100000             // Values up to $1000.00
+
+static volatile double sink;  // Keeps results of timed calls alive
+
+static void* allocate(size_t size) {
+    void* memory = malloc(size);
+    if (memory == NULL) {
+        printf("ERROR: Failed to allocate benchmark state. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+static int64_t exact_sum(const int32_t* cents, int count) {
+    int64_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += cents[i];
+    }
+    return total;
+}
+
+/**
+ * Error of a float sum of dollars, in cents
+ */
+static double float_error_cents(float total, int64_t exact_cents) {
+    return fabs((double)total * 100 - (double)exact_cents);
+}
+
+int main(int argc, char* argv[]) {
+    int runs = DEFAULT_RUNS;
+    int num_values = DEFAULT_VALUES;
+    long num_updates = DEFAULT_UPDATES;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--values") == 0 && i + 1 < argc) {
+            num_values = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--updates") == 0 && i + 1 < argc) {
+            num_updates = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--runs N] [--values N] [--updates N] [--seed N]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (runs < 1 || num_values < KERNEL_VALUES || num_updates < 0 || seed == 0) {
+        fprintf(stderr, "ERROR: --runs and --seed must be positive and --values at least %d\n", KERNEL_VALUES);
+        return EXIT_FAILURE;
+    }
+
+    // The same amounts both ways: whole cents, and the float nearest each
+    uint32_t random = seed;
+    int32_t* cents = allocate((size_t)num_values * sizeof(int32_t));
+    float* dollars = allocate((size_t)num_values * sizeof(float));
+    for (int i = 0; i < num_values; i++) {
+        cents[i] = (int32_t)(next_random(&random) % MAX_CENTS);
+        dollars[i] = (float)((double)cents[i] / 100);
+    }
+    printf("values=%d runs=%d updates=%ld\n", num_values, runs, num_updates);
+
+    bool verified = true;
+    for (int count = 1000; ; count *= 8) {
+        if (count > num_values) {
+            count = num_values;
+        }
+        int64_t exact = exact_sum(cents, count);
+        int64_t fixed = sum_int32s(cents, count);
+        float total = sum_floats(dollars, count);
+        verified &= fixed == exact;
+        printf("sum values=%d exact=%lld.%02lld float=%.2f float_error_cents=%.0f fixed_error_cents=%lld\n",
+               count, (long long)(exact / 100), (long long)(exact % 100), total, float_error_cents(total, exact),
+               (long long)(fixed - exact));
+        if (count == num_values) {
+            break;
+        }
+    }
+
+    // Running totals moved by each update's difference, as the rollups do
+    int64_t exact_total = exact_sum(cents, KERNEL_VALUES);
+    float float_total = sum_floats(dollars, KERNEL_VALUES);
+    for (long u = 1; u <= num_updates; u++) {
+        int i = (int)(next_random(&random) % KERNEL_VALUES);
+        int32_t new_cents = (int32_t)(next_random(&random) % MAX_CENTS);
+        float new_dollars = (float)((double)new_cents / 100);
+        exact_total += new_cents - cents[i];
+        float_total += new_dollars - dollars[i];
+        cents[i] = new_cents;
+        dollars[i] = new_dollars;
+        if (u == num_updates || ((u & (u - 1)) == 0 && u >= 1024)) {
+            printf("drift updates=%ld float_error_cents=%.0f\n", u, float_error_cents(float_total, exact_total));
+        }
+    }
+    int64_t rescanned = sum_int32s(cents, KERNEL_VALUES);
+    verified &= rescanned == exact_sum(cents, KERNEL_VALUES);
+    printf("drift rescan float_error_cents=%.0f fixed_error_cents=%lld\n",
+           float_error_cents(sum_floats(dollars, KERNEL_VALUES), exact_total),
+           (long long)(rescanned - exact_total));
+
+    double float_best = INFINITY, fixed_best = INFINITY;
+    for (int r = 0; r < runs; r++) {
+        double begin = now_ns();
+        sink += sum_floats(dollars, KERNEL_VALUES);
+        double middle = now_ns();
+        sink += (double)sum_int32s(cents, KERNEL_VALUES);
+        fixed_best = fmin(fixed_best, now_ns() - middle);
+        float_best = fmin(float_best, middle - begin);
+    }
+    printf("kernel values=%d sum_floats_ns_per_value=%.3f sum_int32s_ns_per_value=%.3f int32_over_float=%.2f\n",
+           KERNEL_VALUES, float_best / KERNEL_VALUES, fixed_best / KERNEL_VALUES, fixed_best / float_best);
+    printf("kernels=%s\n", kernel_isa());
+
+    printf("verified=%s\n", verified ? "yes" : "NO");
+    free(cents);
+    free(dollars);
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
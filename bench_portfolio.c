@@ -0,0 +1,98 @@
+/* bench_portfolio.c */
+#include "bench_util.h"
+#include "portfolio.h"
+#include "workload.h"
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * PORTFOLIO ROLLUP SCALING BENCHMARK
+ *
+ * Builds a portfolio of identical synthetic projects and times full
+ * portfolio rollups at 1, 2, 4, ... threads up to the given maximum.
+ * Speedup is relative to the single-thread run; it can only approach the
+ * thread count when that many cores are actually available.
+ *
+ * Usage: bench_portfolio [--projects N] [--threads MAX] [--rounds N] [shape]
+ *        defaults: 1000 projects of 10x1000, MAX = online CPUs, 5 rounds
+ * Output: one line per thread count, key=value pairs
+ */
+
+#define DEFAULT_PROJECTS 1000
+#define DEFAULT_ROUNDS 5
+
+/**
+ * Fastest of several rollups, in milliseconds
+ */
+static double time_rollups(portfolio_t* portfolio, int rounds) {
+    double best = 0;
+    for (int r = 0; r < rounds; r++) {
+        double start = now_ns();
+        portfolio_rollup(portfolio);
+        double elapsed = (now_ns() - start) / 1e6;
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    workload_shape_t shape = { 10, 1000, 50, 1 };
+    int num_projects = DEFAULT_PROJECTS;
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int rounds = DEFAULT_ROUNDS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--projects") == 0 && i + 1 < argc) {
+            num_projects = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else if (!workload_parse_shape(argv[i], &shape)) {
+            fprintf(stderr, "Usage: %s [--projects N] [--threads MAX] [--rounds N] [<milestones>x<activities>]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (num_projects < 1 || max_threads < 1 || rounds < 1) {
+        fprintf(stderr, "ERROR: --projects, --threads and --rounds must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    // Projects are generated once and shared by every thread count
+    portfolio_t* source = portfolio_create(1);
+    for (int p = 0; p < num_projects; p++) {
+        shape.seed = (uint32_t)p + 1;
+        portfolio_add(source, generate_project(&shape));
+    }
+    printf("projects=%d shape=%dx%d activities=%ld cpus=%ld\n", num_projects, shape.num_milestones,
+           shape.activities_per_milestone, (long)num_projects * shape.num_milestones * shape.activities_per_milestone,
+           sysconf(_SC_NPROCESSORS_ONLN));
+
+    double single_ms = 0;
+    for (int threads = 1;; threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+        portfolio_t* portfolio = portfolio_create(threads);
+        portfolio->projects = source->projects;
+        portfolio->num_projects = source->num_projects;
+
+        double ms = time_rollups(portfolio, rounds);
+        if (threads == 1) {
+            single_ms = ms;
+        }
+        printf("threads=%d rollup_ms=%.3f activities_per_s=%.0f speedup=%.2f\n", threads, ms,
+               (double)portfolio->num_activities / (ms / 1e3), single_ms / ms);
+
+        // The projects belong to the source portfolio
+        portfolio->projects = NULL;
+        portfolio->num_projects = 0;
+        portfolio_free(portfolio);
+        if (threads == max_threads) {
+            break;
+        }
+    }
+
+    portfolio_free(source);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,300 @@
+/* bench_query.c */
+#include "a1_functions.h"
+#include "bench_util.h"
+#include "query.h"
+#include "workload.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * QUERY BENCHMARK
+ *
+ * Builds a portfolio of synthetic projects (16 of 60x1000 by default, about
+ * a million activities) and brings each one part-way through its plan: the
+ * earlier milestones are completed with actuals between 80% and 140% of
+ * plan, the rest are still open. A fixed set of queries is then run over
+ * every project, reporting the best time of several runs and how many
+ * milestones each query skipped on their summaries alone.
+ *
+ * Each result is checked against a brute-force scan of the activity
+ * records: the match count, the keys of the returned rows (the best keys
+ * overall when ordered) and the aggregate totals.
+ *
+ * Usage: bench_query [--projects N] [--progress PERCENT] [--runs N] [--seed N] [shape]
+ *        defaults: 16 projects of 60x1000, 50% of milestones completed, 5 runs
+ * Output: key=value lines, one per query
+ */
+
+#define DEFAULT_PROJECTS 16
+#define DEFAULT_PROGRESS 50
+#define DEFAULT_RUNS 5
+
+static const char* const QUERIES[] = {
+    "activities where open and planned_cost > 900 order by planned_cost desc limit 10",
+    "select count, sum(actual_cost), max(cost_ratio) from activities where completed and cost_ratio > 130%",
+    "activities where milestone between 10000 and 20000 and cost_variance > 0 order by cost_variance desc limit 20",
+    "select count, avg(hours_ratio), min(actual_hours) from activities where completed group by milestone",
+    "activities where actual_cost > 1200 order by actual_cost desc limit 5",
+    "milestones where percent_complete < 100 order by planned_cost desc limit 5",
+};
+
+static double ratio(double actual, double planned) {
+    return planned > 0 ? actual / planned : (actual > 0 ? INFINITY : 0);
+}
+
+/**
+ * Field value from an activity record, independently of the query engine
+ * (money in money_t units, which compiled bounds use)
+ */
+static double activity_value(const milestone_t* milestone, const activity_t* activity, query_field_t field) {
+    switch (field) {
+        case QUERY_FIELD_ID:
+            return activity->id;
+        case QUERY_FIELD_MILESTONE:
+            return milestone->id;
+        case QUERY_FIELD_PLANNED_COST:
+            return (double)activity->planned_cost;
+        case QUERY_FIELD_ACTUAL_COST:
+            return (double)activity->actual_cost;
+        case QUERY_FIELD_PLANNED_HOURS:
+            return activity->planned_duration;
+        case QUERY_FIELD_ACTUAL_HOURS:
+            return activity->actual_duration;
+        case QUERY_FIELD_COMPLETED:
+            return activity->completed;
+        case QUERY_FIELD_COST_RATIO:
+            return ratio((double)activity->actual_cost, (double)activity->planned_cost);
+        case QUERY_FIELD_HOURS_RATIO:
+            return ratio(activity->actual_duration, activity->planned_duration);
+        case QUERY_FIELD_COST_VARIANCE:
+            return (double)(money_t)(activity->actual_cost - activity->planned_cost);
+        case QUERY_FIELD_HOURS_VARIANCE:
+            return (double)activity->actual_duration - activity->planned_duration;
+        default:
+            return 0;
+    }
+}
+
+static double milestone_value(const milestone_t* milestone, query_field_t field) {
+    switch (field) {
+        case QUERY_FIELD_ID:
+            return milestone->id;
+        case QUERY_FIELD_PLANNED_COST:
+            return (double)milestone->planned_cost;
+        case QUERY_FIELD_ACTUAL_COST:
+            return (double)milestone->actual_cost;
+        case QUERY_FIELD_PERCENT_COMPLETE:
+            return milestone->num_activities > 0
+                   ? 100.0 * milestone->num_completed / milestone->num_activities : 100.0;
+        default:
+            fprintf(stderr, "ERROR: field %d not covered by the brute-force milestone scan\n", field);
+            exit(EXIT_FAILURE);
+    }
+}
+
+static bool satisfies(const query_predicate_t* predicate, double value) {
+    return (value >= predicate->lo && value <= predicate->hi) != predicate->negate;
+}
+
+static bool close_to(double a, double b) {
+    return a == b || fabs(a - b) <= 1e-9 * fmax(fabs(a), fabs(b));
+}
+
+/**
+ * Recompute a query by scanning every activity record and compare
+ */
+static bool verify(const query_t* query, const query_result_t* result, project_t** projects, int num_projects) {
+    long matches = 0, capacity = 1024;
+    double* keys = malloc((size_t)capacity * sizeof(double));
+    query_accumulator_t totals = { 0, { 0 } };
+    int num_groups = 0;
+    if (keys == NULL) {
+        printf("ERROR: Failed to allocate verification state. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int a = 0; a < query->num_aggregates; a++) {
+        totals.value[a] = query->aggregates[a].op == QUERY_MIN ? INFINITY
+                          : query->aggregates[a].op == QUERY_MAX ? -INFINITY : 0;
+    }
+
+    for (int p = 0; p < num_projects; p++) {
+        for (int i = 0; i < projects[p]->num_milestones; i++) {
+            const milestone_t* milestone = &projects[p]->milestone_list[i];
+            int count = query->target == QUERY_MILESTONES ? 1 : milestone->num_activities;
+            long milestone_matches = 0;
+
+            for (int j = 0; j < count; j++) {
+                const activity_t* activity = &milestone->activity_list[j];
+                bool match = true;
+                for (int c = 0; c < query->num_milestone_predicates && match; c++) {
+                    match = satisfies(&query->milestone_predicates[c], milestone->id);
+                }
+                for (int c = 0; c < query->num_predicates && match; c++) {
+                    query_field_t field = query->predicates[c].field;
+                    match = satisfies(&query->predicates[c], query->target == QUERY_MILESTONES
+                                      ? milestone_value(milestone, field)
+                                      : activity_value(milestone, activity, field));
+                }
+                if (!match) {
+                    continue;
+                }
+                milestone_matches++;
+
+                for (int a = 0; a < query->num_aggregates; a++) {
+                    double value = activity_value(milestone, activity, query->aggregates[a].field);
+                    switch (query->aggregates[a].op) {
+                        case QUERY_SUM:
+                        case QUERY_AVG:
+                            totals.value[a] += value;
+                            break;
+                        case QUERY_MIN:
+                            totals.value[a] = fmin(totals.value[a], value);
+                            break;
+                        case QUERY_MAX:
+                            totals.value[a] = fmax(totals.value[a], value);
+                            break;
+                        case QUERY_COUNT:
+                            break;
+                    }
+                }
+                if (query->ordered) {
+                    if (matches == capacity) {
+                        capacity *= 2;
+                        keys = realloc(keys, (size_t)capacity * sizeof(double));
+                        if (keys == NULL) {
+                            printf("ERROR: Failed to allocate verification state. Exiting...\n");
+                            exit(EXIT_FAILURE);
+                        }
+                    }
+                    keys[matches] = query->target == QUERY_MILESTONES
+                                    ? milestone_value(milestone, query->order_field)
+                                    : activity_value(milestone, activity, query->order_field);
+                }
+                matches++;
+            }
+            num_groups += milestone_matches > 0;
+        }
+    }
+    totals.count = matches;
+
+    // Milestones outranked by the returned rows were not counted
+    bool ok = result->milestones_outranked > 0 ? result->matches <= matches : result->matches == matches;
+    if (query->num_aggregates == 0) {
+        ok = ok && result->num_rows == (matches < query->limit ? matches : query->limit);
+        if (ok && query->ordered) {
+            qsort(keys, (size_t)matches, sizeof(double), compare_doubles);
+            for (int r = 0; ok && r < result->num_rows; r++) {
+                double expected = query->descending ? keys[matches - 1 - r] : keys[r];
+                ok = result->rows[r].key == expected;
+            }
+        }
+    } else {
+        ok = ok && result->totals.count == totals.count;
+        for (int a = 0; ok && a < query->num_aggregates; a++) {
+            ok = query->aggregates[a].op == QUERY_COUNT || close_to(result->totals.value[a], totals.value[a]);
+        }
+        ok = ok && (!query->group_by_milestone || result->num_groups == num_groups);
+    }
+    free(keys);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    workload_shape_t shape = { 60, 1000, 0, 1 };
+    int num_projects = DEFAULT_PROJECTS;
+    int progress = DEFAULT_PROGRESS;
+    int num_runs = DEFAULT_RUNS;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--projects") == 0 && i + 1 < argc) {
+            num_projects = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--progress") == 0 && i + 1 < argc) {
+            progress = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            num_runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (!workload_parse_shape(argv[i], &shape)) {
+            fprintf(stderr, "Usage: %s [--projects N] [--progress PERCENT] [--runs N] [--seed N] "
+                            "[<milestones>x<activities>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (num_projects < 1 || num_runs < 1 || progress < 0 || progress > 100 || seed == 0) {
+        fprintf(stderr, "ERROR: --projects, --runs and --seed must be positive, --progress 0-100\n");
+        return EXIT_FAILURE;
+    }
+
+    project_t** projects = malloc((size_t)num_projects * sizeof(project_t*));
+    if (projects == NULL) {
+        printf("ERROR: Failed to allocate benchmark state. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    uint32_t random = seed;
+    long num_activities = 0;
+    for (int p = 0; p < num_projects; p++) {
+        shape.seed = seed + (uint32_t)p;
+        projects[p] = generate_project(&shape);
+
+        // Earlier milestones done, at 80-140% of their plan
+        int completed_milestones = projects[p]->num_milestones * progress / 100;
+        for (int i = 0; i < projects[p]->num_milestones; i++) {
+            milestone_t* milestone = &projects[p]->milestone_list[i];
+            num_activities += milestone->num_activities;
+            for (int j = 0; i < completed_milestones && j < milestone->num_activities; j++) {
+                const activity_t* activity = &milestone->activity_list[j];
+                float scale = 0.8f + (float)(next_random(&random) % 61) / 100;
+                apply_activity_update(projects[p], activity->id,
+                                      (unsigned short int)fminf(activity->planned_duration * scale, 65535),
+                                      money_from_dollars(money_to_float(activity->planned_cost) * scale), true);
+            }
+        }
+    }
+    printf("projects=%d shape=%dx%d activities=%ld progress=%d%%\n", num_projects, shape.num_milestones,
+           shape.activities_per_milestone, num_activities, progress);
+
+    bool all_verified = true;
+    for (size_t q = 0; q < sizeof(QUERIES) / sizeof(QUERIES[0]); q++) {
+        query_t query;
+        query_result_t result;
+        char error[QUERY_ERROR_SIZE];
+        if (!query_compile(QUERIES[q], &query, error)) {
+            fprintf(stderr, "ERROR: query %zu does not compile: %s\n", q + 1, error);
+            return EXIT_FAILURE;
+        }
+
+        double best_ms = INFINITY;
+        for (int run = 0; run < num_runs; run++) {
+            double begin = now_ns();
+            query_result_init(&result, &query);
+            for (int p = 0; p < num_projects; p++) {
+                query_accumulate(&result, projects[p]);
+            }
+            query_finish(&result);
+            best_ms = fmin(best_ms, (now_ns() - begin) / 1e6);
+            if (run + 1 < num_runs) {
+                query_result_free(&result);
+            }
+        }
+
+        double begin = now_ns();
+        bool verified = verify(&query, &result, projects, num_projects);
+        double brute_ms = (now_ns() - begin) / 1e6;
+        all_verified = all_verified && verified;
+
+        printf("query%zu=\"%s\"\n", q + 1, QUERIES[q]);
+        printf("query%zu_ms=%.3f brute_force_ms=%.3f matches=%ld milestones_scanned=%ld milestones_skipped=%ld "
+               "milestones_outranked=%ld verified=%s\n", q + 1, best_ms, brute_ms, result.matches,
+               result.milestones_scanned, result.milestones_skipped, result.milestones_outranked,
+               verified ? "yes" : "NO");
+        query_result_free(&result);
+    }
+    printf("verified=%s\n", all_verified ? "yes" : "NO");
+
+    for (int p = 0; p < num_projects; p++) {
+        free_project(projects[p]);
+    }
+    free(projects);
+    return all_verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,271 @@
+/* bench_report.c */
+#include "a1_functions.h"
+#include "bench_util.h"
+#include "report.h"
+#include "schedule.h"
+#include "workload.h"
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * REPORT BENCHMARK
+ *
+ * Builds a synthetic project with half of its activities completed and
+ * writes the full report (see report_project) to /dev/null in each format,
+ * reporting the best time of several runs as MB/s. For scale, the text
+ * report is also written with one fprintf per line, as the statistics were
+ * printed before, and the same number of bytes is copied with memcpy.
+ *
+ * Checked: the buffered text report is byte for byte what the fprintf
+ * version writes, and report_int/report_fixed agree with snprintf's "%lld"
+ * and "%.Nf" on random values.
+ *
+ * Usage: bench_report [--runs N] [--values N] [--seed N] [shape]
+ *        defaults: 60x1000, 5 runs, 1000000 values
+ * Output: key=value lines
+ */
+
+#define DEFAULT_RUNS 5
+#define DEFAULT_VALUES 1000000
+
+static const char* const FORMAT_LABELS[] = { "text", "csv", "json" };
+
+/**
+ * The text report written with stdio, one fprintf per line
+ */
+static void stdio_report(FILE* out, const project_t* project) {
+    fprintf(out, "\nPROJECT STATISTICS: %s\n", project->name);
+    fprintf(out, "========================================\n");
+    fprintf(out, "Status: %s\n", project->completed ? "COMPLETED" : "IN PROGRESS");
+    fprintf(out, "Planned cost: $%.2f | Actual cost: $%.2f\n", money_to_dollars(project->planned_cost),
+            money_to_dollars(project->actual_cost));
+    fprintf(out, "Planned duration: %lld day(s) | Actual duration: %lld day(s)\n",
+            (long long)project->planned_duration, (long long)project->actual_duration);
+    if (project->schedule != NULL && !project->schedule->stale) {
+        fprintf(out, "Critical path: %lld hour(s) (%lld day(s))\n", (long long)project->schedule->finish,
+                (long long)((project->schedule->finish + HOURS_PER_DAY - 1) / HOURS_PER_DAY));
+    }
+    if (project->completed) {
+        money_t cost_variance = project->actual_cost - project->planned_cost;
+        money_t variance_size = cost_variance < 0 ? -cost_variance : cost_variance;
+        fprintf(out, "\nVARIANCE ANALYSIS\n");
+        fprintf(out, "----------------------------------------\n");
+        if (project->planned_cost > 0) {
+            fprintf(out, "Cost variance: $%.2f (%.1f%% %s budget)\n", money_to_dollars(variance_size),
+                    money_to_float(variance_size) / money_to_float(project->planned_cost) * 100,
+                    cost_variance > 0 ? "over" : "under");
+        } else {
+            fprintf(out, "Cost variance: $%.2f\n", money_to_dollars(cost_variance));
+        }
+        int schedule_variance = (int)project->actual_duration - (int)project->planned_duration;
+        fprintf(out, "Schedule variance: %d day(s) %s schedule\n", abs(schedule_variance),
+                schedule_variance > 0 ? "behind" : "ahead of");
+    } else {
+        fprintf(out, "\nMILESTONE STATISTICS\n");
+        fprintf(out, "----------------------------------------\n");
+        for (int i = 0; i < project->num_milestones; i++) {
+            const milestone_t* milestone = &project->milestone_list[i];
+            fprintf(out, "Milestone '%s' (ID: %hu): %s\n", get_name(project, milestone->name), milestone->id,
+                    milestone->completed ? "COMPLETED" : "IN PROGRESS");
+            fprintf(out, "  Activities completed: %d/%d\n", milestone->num_completed, milestone->num_activities);
+            fprintf(out, "  Planned cost: $%.2f | Actual cost: $%.2f\n", money_to_dollars(milestone->planned_cost),
+                    money_to_dollars(milestone->actual_cost));
+            fprintf(out, "  Actual duration: %lld day(s)\n", (long long)milestone->actual_duration);
+        }
+    }
+
+    fprintf(out, "\nACTIVITIES\n");
+    fprintf(out, "----------------------------------------\n");
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        for (int j = 0; j < milestone->num_activities; j++) {
+            const activity_t* activity = &milestone->activity_list[j];
+            fprintf(out, "ID: %hu | %s (in milestone: %s) | Hours: %hu/%hu | Cost: $%.2f/$%.2f | %s\n",
+                    activity->id, get_name(project, activity->name), get_name(project, milestone->name),
+                    activity->actual_duration, activity->planned_duration, money_to_dollars(activity->actual_cost),
+                    money_to_dollars(activity->planned_cost), activity->completed ? "COMPLETED" : "IN PROGRESS");
+        }
+    }
+}
+
+/**
+ * Read back everything written to a file
+ */
+static char* read_all(FILE* file, long* length) {
+    fflush(file);
+    *length = ftell(file);
+    char* bytes = malloc((size_t)*length + 1);
+    if (bytes == NULL) {
+        printf("ERROR: Failed to allocate benchmark state. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    rewind(file);
+    if (fread(bytes, 1, (size_t)*length, file) != (size_t)*length) {
+        printf("ERROR: Failed to read back report. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    return bytes;
+}
+
+/**
+ * Compare the buffered text report with the fprintf version
+ */
+static bool check_text_report(const project_t* project) {
+    FILE* expected_file = tmpfile();
+    FILE* actual_file = tmpfile();
+    if (expected_file == NULL || actual_file == NULL) {
+        printf("ERROR: Failed to create temporary files. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    stdio_report(expected_file, project);
+
+    report_writer_t writer;
+    report_init(&writer, fileno(actual_file), REPORT_TEXT);
+    report_project(&writer, project);
+    report_free(&writer);
+    fseek(actual_file, 0, SEEK_END);
+
+    long expected_length, actual_length;
+    char* expected = read_all(expected_file, &expected_length);
+    char* actual = read_all(actual_file, &actual_length);
+    bool same = expected_length == actual_length && memcmp(expected, actual, (size_t)actual_length) == 0;
+    free(expected);
+    free(actual);
+    fclose(expected_file);
+    fclose(actual_file);
+    return same;
+}
+
+/**
+ * Format random values both ways, in batches that fit the writer's buffer
+ */
+static bool check_numbers(long num_values, uint32_t seed) {
+    report_writer_t writer;
+    report_init(&writer, -1, REPORT_TEXT);
+    uint32_t random = seed;
+    bool same = true;
+    for (long v = 0; same && v < num_values; v++) {
+        char expected[512];
+        int length;
+        uint32_t kind = next_random(&random) % 4;
+        if (kind == 0) {
+            long long value = (long long)(((uint64_t)next_random(&random) << 32) | next_random(&random));
+            value >>= next_random(&random) % 63;
+            length = snprintf(expected, sizeof(expected), "%lld", value);
+            report_int(&writer, value);
+        } else {
+            // Cents, fractions of a cent and ties, across magnitudes and signs
+            float value = (float)((int32_t)next_random(&random)) / (float)(1u << (next_random(&random) % 31));
+            if (kind == 1) {
+                value = (float)((int32_t)next_random(&random) % 2000000) / 200;
+            }
+            int decimals = (int)(next_random(&random) % 4);
+            length = snprintf(expected, sizeof(expected), "%.*f", decimals, value);
+            report_fixed(&writer, value, decimals);
+        }
+        same = writer.used == (size_t)length && memcmp(writer.buffer, expected, writer.used) == 0;
+        if (!same) {
+            fprintf(stderr, "mismatch: expected '%s', wrote '%.*s'\n", expected, (int)writer.used, writer.buffer);
+        }
+        writer.used = 0;
+    }
+    free(writer.buffer);
+    return same;
+}
+
+int main(int argc, char* argv[]) {
+    workload_shape_t shape = { 60, 1000, 50, 1 };
+    int runs = DEFAULT_RUNS;
+    long num_values = DEFAULT_VALUES;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--values") == 0 && i + 1 < argc) {
+            num_values = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (!workload_parse_shape(argv[i], &shape)) {
+            fprintf(stderr, "Usage: %s [--runs N] [--values N] [--seed N] [<milestones>x<activities>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (runs < 1 || num_values < 0 || seed == 0) {
+        fprintf(stderr, "ERROR: --runs and --seed must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    shape.seed = seed;
+    project_t* project = generate_project(&shape);
+    int null_fd = open("/dev/null", O_WRONLY);
+    FILE* null_file = fdopen(dup(null_fd), "w");
+    if (null_fd < 0 || null_file == NULL) {
+        printf("ERROR: Cannot open /dev/null. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("shape=%dx%d activities=%d runs=%d\n", shape.num_milestones, shape.activities_per_milestone,
+           shape.num_milestones * shape.activities_per_milestone, runs);
+
+    report_writer_t writer;
+    report_init(&writer, null_fd, REPORT_TEXT);
+    long long text_bytes = 0;
+    for (int f = REPORT_TEXT; f <= REPORT_JSON; f++) {
+        double best = INFINITY;
+        long long bytes = 0;
+        for (int r = 0; r < runs; r++) {
+            report_reset(&writer, null_fd, (report_format_t)f);
+            double begin = now_ns();
+            report_project(&writer, project);
+            report_flush(&writer);
+            best = fmin(best, now_ns() - begin);
+            bytes = writer.bytes_written;
+        }
+        if (f == REPORT_TEXT) {
+            text_bytes = bytes;
+        }
+        printf("format=%s bytes=%lld ms=%.3f mb_per_s=%.0f\n", FORMAT_LABELS[f], bytes, best / 1e6,
+               (double)bytes / best * 1e3);
+    }
+    report_free(&writer);
+
+    double stdio_best = INFINITY;
+    for (int r = 0; r < runs; r++) {
+        double begin = now_ns();
+        stdio_report(null_file, project);
+        fflush(null_file);
+        stdio_best = fmin(stdio_best, now_ns() - begin);
+    }
+    printf("format=text_fprintf bytes=%lld ms=%.3f mb_per_s=%.0f\n", text_bytes, stdio_best / 1e6,
+           (double)text_bytes / stdio_best * 1e3);
+
+    // Bandwidth ceiling: the same bytes copied once
+    char* source = malloc((size_t)text_bytes);
+    char* target = malloc((size_t)text_bytes);
+    if (source == NULL || target == NULL) {
+        printf("ERROR: Failed to allocate benchmark state. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(source, 'x', (size_t)text_bytes);
+    memset(target, 0, (size_t)text_bytes);
+    double copy_best = INFINITY;
+    for (int r = 0; r < runs; r++) {
+        double begin = now_ns();
+        memcpy(target, source, (size_t)text_bytes);
+        copy_best = fmin(copy_best, now_ns() - begin);
+        source[r % text_bytes] = target[(r * 7) % text_bytes];  // Keep the copies observable
+    }
+    printf("memcpy_mb_per_s=%.0f\n", (double)text_bytes / copy_best * 1e3);
+
+    bool verified = check_text_report(project) && check_numbers(num_values, seed);
+    printf("verified=%s\n", verified ? "yes" : "NO");
+
+    free(source);
+    free(target);
+    fclose(null_file);
+    close(null_fd);
+    free_project(project);
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
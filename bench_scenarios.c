@@ -0,0 +1,214 @@
+/* bench_scenarios.c */
+#include "a1_functions.h"
+#include "bench_util.h"
+#include "scenario.h"
+#include "workload.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * WHAT-IF SCENARIO BENCHMARK
+ *
+ * Builds a synthetic project, forks many scenarios from it and applies a
+ * few random plan edits to each (re-plans, dropped activities, scaled or
+ * dropped milestones). Reports the cost of a fork, of an edit and of a
+ * scenario rollup, and the memory each scenario holds next to what a full
+ * copy of the activities would take.
+ *
+ * Progress is then recorded on the base, and every scenario's totals are
+ * checked against a recompute that walks all activities through
+ * scenario_get_activity.
+ *
+ * Usage: bench_scenarios [--scenarios N] [--edits N] [--updates N] [--seed N] [shape]
+ *        defaults: 60x1000, 200 scenarios, 20 edits each, 10000 updates
+ * Output: key=value lines
+ */
+
+#define DEFAULT_SCENARIOS 200
+#define DEFAULT_EDITS 20
+#define DEFAULT_UPDATES 10000
+
+/**
+ * Totals of a scenario from every activity it contains
+ */
+static void recompute_totals(const project_t* base, const scenario_t* scenario, scenario_totals_t* totals) {
+    memset(totals, 0, sizeof(*totals));
+    for (int i = 0; i < base->num_milestones; i++) {
+        const milestone_t* milestone = &base->milestone_list[i];
+        if (scenario->milestones != NULL && scenario->milestones[i] != NULL && scenario->milestones[i]->dropped) {
+            continue;
+        }
+
+        double planned_cost = 0, actual_cost = 0;
+        long planned_hours = 0, actual_hours = 0, num_activities = 0, num_completed = 0;
+        for (int j = 0; j < milestone->num_activities; j++) {
+            activity_t activity;
+            if (!scenario_get_activity(scenario, milestone->activity_list[j].id, &activity)) {
+                continue;
+            }
+            planned_cost += (double)activity.planned_cost;
+            actual_cost += (double)activity.actual_cost;
+            planned_hours += activity.planned_duration;
+            actual_hours += activity.actual_duration;
+            num_activities++;
+            num_completed += activity.completed;
+        }
+
+        totals->planned_cost += planned_cost;
+        totals->actual_cost += actual_cost;
+        totals->planned_days += (planned_hours + HOURS_PER_DAY - 1) / HOURS_PER_DAY;
+        totals->actual_days += (actual_hours + HOURS_PER_DAY - 1) / HOURS_PER_DAY;
+        totals->num_milestones++;
+        totals->num_completed_milestones += num_completed == num_activities;
+        totals->num_activities += num_activities;
+        totals->num_open_activities += num_activities - num_completed;
+    }
+}
+
+/**
+ * Compare two sets of totals (costs are float sums taken in different orders)
+ */
+static bool totals_match(const scenario_totals_t* a, const scenario_totals_t* b) {
+    return fabs(a->planned_cost - b->planned_cost) <= 1e-6 * fabs(b->planned_cost) + 0.01 &&
+           fabs(a->actual_cost - b->actual_cost) <= 1e-6 * fabs(b->actual_cost) + 0.01 &&
+           a->planned_days == b->planned_days && a->actual_days == b->actual_days &&
+           a->num_milestones == b->num_milestones && a->num_completed_milestones == b->num_completed_milestones &&
+           a->num_activities == b->num_activities && a->num_open_activities == b->num_open_activities;
+}
+
+int main(int argc, char* argv[]) {
+    workload_shape_t shape = { 60, 1000, 0, 1 };
+    int num_scenarios = DEFAULT_SCENARIOS;
+    int edits_per_scenario = DEFAULT_EDITS;
+    int num_updates = DEFAULT_UPDATES;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--scenarios") == 0 && i + 1 < argc) {
+            num_scenarios = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--edits") == 0 && i + 1 < argc) {
+            edits_per_scenario = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--updates") == 0 && i + 1 < argc) {
+            num_updates = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (!workload_parse_shape(argv[i], &shape)) {
+            fprintf(stderr, "Usage: %s [--scenarios N] [--edits N] [--updates N] [--seed N] "
+                            "[<milestones>x<activities>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (num_scenarios < 1 || edits_per_scenario < 0 || num_updates < 0 || seed == 0) {
+        fprintf(stderr, "ERROR: --scenarios and --seed must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    shape.seed = seed;
+    project_t* project = generate_project(&shape);
+
+    int num_activities = 0;
+    unsigned short int* ids = malloc((size_t)shape.num_milestones * (size_t)shape.activities_per_milestone *
+                                     sizeof(unsigned short int));
+    scenario_t** scenarios = malloc((size_t)num_scenarios * sizeof(scenario_t*));
+    if (ids == NULL || scenarios == NULL) {
+        printf("ERROR: Failed to allocate benchmark state. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        for (int j = 0; j < milestone->num_activities; j++) {
+            ids[num_activities++] = milestone->activity_list[j].id;
+        }
+    }
+    printf("shape=%dx%d activities=%d scenarios=%d edits_per_scenario=%d\n", shape.num_milestones,
+           shape.activities_per_milestone, num_activities, num_scenarios, edits_per_scenario);
+
+    // Forks
+    double start = now_ns();
+    for (int s = 0; s < num_scenarios; s++) {
+        char name[SCENARIO_NAME_SIZE];
+        snprintf(name, sizeof(name), "scenario %d", s + 1);
+        scenarios[s] = scenario_fork(project, name);
+    }
+    printf("fork_ns=%.0f\n", (now_ns() - start) / num_scenarios);
+
+    // Edits: mostly re-plans, some dropped activities, rarely whole milestones
+    uint32_t random = seed;
+    start = now_ns();
+    for (int s = 0; s < num_scenarios; s++) {
+        for (int e = 0; e < edits_per_scenario; e++) {
+            uint32_t kind = next_random(&random) % 100;
+            unsigned short int id = ids[next_random(&random) % (uint32_t)num_activities];
+            milestone_t* milestone = NULL;
+            find_activity_by_id(project, id, &milestone);
+            if (kind < 75) {
+                scenario_set_plan(scenarios[s], id, (unsigned short int)(next_random(&random) % 200),
+                                  (float)(next_random(&random) % 500000) / 100);
+            } else if (kind < 95) {
+                scenario_drop_activity(scenarios[s], id);
+            } else if (kind < 99) {
+                scenario_scale_milestone(scenarios[s], milestone->id,
+                                         0.5f + (float)(next_random(&random) % 100) / 100);
+            } else {
+                scenario_drop_milestone(scenarios[s], milestone->id);
+            }
+        }
+    }
+    double edit_ns = edits_per_scenario > 0
+                   ? (now_ns() - start) / ((double)num_scenarios * edits_per_scenario) : 0;
+    printf("edit_ns=%.0f\n", edit_ns);
+
+    size_t memory = 0;
+    long chunks = 0;
+    for (int s = 0; s < num_scenarios; s++) {
+        memory += scenario_memory(scenarios[s]);
+        chunks += scenarios[s]->num_chunks;
+    }
+    printf("memory_per_scenario_kb=%.1f chunks_per_scenario=%.1f full_copy_kb=%.1f\n",
+           (double)memory / num_scenarios / 1024, (double)chunks / num_scenarios,
+           (double)num_activities * sizeof(activity_t) / 1024);
+
+    // Progress on the base shows in every scenario
+    for (int u = 0; u < num_updates; u++) {
+        unsigned short int id = ids[next_random(&random) % (uint32_t)num_activities];
+        unsigned short int hours = (unsigned short int)(next_random(&random) % 400);
+        apply_activity_update(project, id, hours, (float)(next_random(&random) % 100000) / 100,
+                              next_random(&random) % 4 == 0);
+    }
+
+    // Rollups: overlay adjustment vs walking every activity
+    scenario_totals_t totals, expected;
+    start = now_ns();
+    for (int s = 0; s < num_scenarios; s++) {
+        scenario_totals(project, scenarios[s], &totals);
+    }
+    double totals_ns = (now_ns() - start) / num_scenarios;
+    start = now_ns();
+    for (int s = 0; s < num_scenarios; s++) {
+        recompute_totals(project, scenarios[s], &expected);
+    }
+    double recompute_ns = (now_ns() - start) / num_scenarios;
+    printf("totals_us=%.3f recompute_us=%.3f speedup=%.0f\n", totals_ns / 1e3, recompute_ns / 1e3,
+           recompute_ns / totals_ns);
+
+    bool verified = true;
+    for (int s = 0; s < num_scenarios; s++) {
+        scenario_totals(project, scenarios[s], &totals);
+        recompute_totals(project, scenarios[s], &expected);
+        if (!totals_match(&totals, &expected)) {
+            printf("mismatch=%s planned_cost=%.2f/%.2f planned_days=%ld/%ld open=%ld/%ld\n", scenarios[s]->name,
+                   totals.planned_cost / MONEY_SCALE, expected.planned_cost / MONEY_SCALE, totals.planned_days,
+                   expected.planned_days, totals.num_open_activities, expected.num_open_activities);
+            verified = false;
+        }
+    }
+    printf("verified=%s\n", verified ? "yes" : "NO");
+
+    for (int s = 0; s < num_scenarios; s++) {
+        scenario_free(scenarios[s]);
+    }
+    free(scenarios);
+    free(ids);
+    free_project(project);
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,149 @@
+/* bench_schedule.c */
+#include "a1_functions.h"
+#include "bench_util.h"
+#include "schedule.h"
+#include "workload.h"
+#include <string.h>
+
+/**
+ * CRITICAL PATH SCHEDULING BENCHMARK
+ *
+ * Builds a synthetic project, wires its activities into a random DAG and
+ * compares a full schedule rebuild with incremental re-scheduling after
+ * single activity updates. Each activity gets predecessors drawn from the
+ * activities shortly before it (in ID order), which gives long chains
+ * like real project plans rather than a shallow random graph.
+ *
+ * After the updates the incrementally maintained schedule is checked
+ * against a fresh rebuild.
+ *
+ * Usage: bench_schedule [--edges PER_ACTIVITY] [--window N] [--updates N]
+ *                       [--rounds N] [--seed N] [shape]
+ *        defaults: 60x1000, 2 edges per activity, window 500, 10000 updates
+ * Output: key=value lines
+ */
+
+#define DEFAULT_EDGES_PER_ACTIVITY 2
+#define DEFAULT_WINDOW 500
+#define DEFAULT_UPDATES 10000
+#define DEFAULT_ROUNDS 5
+
+/**
+ * Compare the maintained schedule with one rebuilt from scratch
+ */
+static bool matches_rebuild(project_t* project) {
+    schedule_t* schedule = project->schedule;
+    int num_nodes = schedule->num_nodes;
+    int64_t finish = schedule->finish;
+    int64_t* earliest_start = malloc((size_t)num_nodes * sizeof(int64_t));
+    int64_t* tail = malloc((size_t)num_nodes * sizeof(int64_t));
+    if (earliest_start == NULL || tail == NULL) {
+        printf("ERROR: Failed to allocate verification copy. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(earliest_start, schedule->earliest_start, (size_t)num_nodes * sizeof(int64_t));
+    memcpy(tail, schedule->tail, (size_t)num_nodes * sizeof(int64_t));
+
+    schedule_invalidate(schedule);
+    schedule_refresh(project);
+
+    // Node numbering is the same because the structure did not change
+    bool same = finish == schedule->finish &&
+                memcmp(earliest_start, schedule->earliest_start, (size_t)num_nodes * sizeof(int64_t)) == 0 &&
+                memcmp(tail, schedule->tail, (size_t)num_nodes * sizeof(int64_t)) == 0;
+    free(earliest_start);
+    free(tail);
+    return same;
+}
+
+int main(int argc, char* argv[]) {
+    workload_shape_t shape = { 60, 1000, 0, 1 };
+    int edges_per_activity = DEFAULT_EDGES_PER_ACTIVITY;
+    int window = DEFAULT_WINDOW;
+    int num_updates = DEFAULT_UPDATES;
+    int rounds = DEFAULT_ROUNDS;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--edges") == 0 && i + 1 < argc) {
+            edges_per_activity = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            window = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--updates") == 0 && i + 1 < argc) {
+            num_updates = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (!workload_parse_shape(argv[i], &shape)) {
+            fprintf(stderr, "Usage: %s [--edges PER_ACTIVITY] [--window N] [--updates N] [--rounds N] "
+                            "[--seed N] [<milestones>x<activities>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (edges_per_activity < 0 || window < 1 || num_updates < 1 || rounds < 1 || seed == 0) {
+        fprintf(stderr, "ERROR: --window, --updates, --rounds and --seed must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    shape.seed = seed;
+    project_t* project = generate_project(&shape);
+
+    // Activity IDs in project order; edges only point backwards in it
+    int num_activities = 0;
+    unsigned short int* ids = malloc((size_t)shape.num_milestones * (size_t)shape.activities_per_milestone *
+                                     sizeof(unsigned short int));
+    if (ids == NULL) {
+        printf("ERROR: Failed to allocate activity IDs. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        for (int j = 0; j < milestone->num_activities; j++) {
+            ids[num_activities++] = milestone->activity_list[j].id;
+        }
+    }
+
+    uint32_t random = seed;
+    for (int a = 1; a < num_activities; a++) {
+        int span = a < window ? a : window;
+        for (int e = 0; e < edges_per_activity; e++) {
+            dependency_t dependency = { ids[a], ids[a - 1 - (int)(next_random(&random) % (uint32_t)span)] };
+            append_dependency(project, dependency);
+        }
+    }
+
+    // Full rebuilds
+    double build_ns = 0;
+    for (int r = 0; r < rounds; r++) {
+        schedule_invalidate(project->schedule);
+        double start = now_ns();
+        schedule_refresh(project);
+        double elapsed = now_ns() - start;
+        if (r == 0 || elapsed < build_ns) {
+            build_ns = elapsed;
+        }
+    }
+    printf("shape=%dx%d activities=%d dependencies=%d critical_path_hours=%lld\n", shape.num_milestones,
+           shape.activities_per_milestone, num_activities, project->schedule->num_dependencies,
+           (long long)project->schedule->finish);
+    printf("full_rebuild_ms=%.3f\n", build_ns / 1e6);
+
+    // Incremental: single updates through the normal rollup path
+    double start = now_ns();
+    for (int u = 0; u < num_updates; u++) {
+        unsigned short int id = ids[next_random(&random) % (uint32_t)num_activities];
+        unsigned short int hours = (unsigned short int)(next_random(&random) % 400);
+        apply_activity_update(project, id, hours, (float)(next_random(&random) % 100000) / 100, false);
+    }
+    double update_ns = (now_ns() - start) / num_updates;
+    printf("updates=%d update_us=%.3f speedup_vs_rebuild=%.0f critical_path_hours=%lld\n", num_updates,
+           update_ns / 1e3, build_ns / update_ns, (long long)project->schedule->finish);
+
+    bool verified = matches_rebuild(project);
+    printf("verified=%s\n", verified ? "yes" : "NO");
+
+    free(ids);
+    free_project(project);
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,44 @@
+/* bench_util.h */
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * BENCHMARK HELPERS
+ *
+ * Clock, random numbers and sorting shared by the benchmarks, the workload
+ * generator and the load generator, so every measurement uses the same ones.
+ */
+
+/**
+ * Monotonic clock in nanoseconds, for timing benchmarks and load tests
+ */
+static inline double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * xorshift32 step; cheap and good enough for spreading test values
+ * @param state Non-zero seed, advanced in place
+ */
+static inline uint32_t next_random(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/**
+ * qsort comparison of doubles, ascending
+ */
+static inline int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+#endif
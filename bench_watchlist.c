@@ -0,0 +1,159 @@
+/* bench_watchlist.c */
+#include "a1_functions.h"
+#include "bench_util.h"
+#include "watchlist.h"
+#include "workload.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * WATCHLIST BENCHMARK
+ *
+ * Builds a synthetic project and applies the same stream of random activity
+ * updates (actuals from 50% to 150% of plan) twice: once without and once
+ * with a watchlist, to show what keeping the rankings costs per update.
+ * Then reads the worst N activities by cost overrun from the watchlist and
+ * by a scan over every activity, and compares the two.
+ *
+ * The watchlist is checked against the project with watchlist_verify and
+ * its worst N against the scan.
+ *
+ * Usage: bench_watchlist [--updates N] [--worst N] [--seed N] [shape]
+ *        defaults: 60x1000, 200000 updates, worst 10
+ * Output: key=value lines
+ */
+
+#define DEFAULT_UPDATES 200000
+#define DEFAULT_WORST 10
+#define READ_REPEATS 1000
+
+/**
+ * Apply the update stream of a seed; returns the time spent in updates
+ */
+static double apply_updates(project_t* project, const unsigned short int* ids, int num_activities,
+                            long num_updates, uint32_t seed) {
+    uint32_t random = seed;
+    double elapsed = 0;
+    for (long u = 0; u < num_updates; u++) {
+        unsigned short int id = ids[next_random(&random) % (uint32_t)num_activities];
+        milestone_t* milestone = NULL;
+        const activity_t* activity = find_activity_by_id(project, id, &milestone);
+        float scale = 0.5f + (float)(next_random(&random) % 101) / 100;
+        unsigned short int hours = (unsigned short int)fminf(activity->planned_duration * scale, 65535);
+        money_t cost = money_from_dollars(money_to_float(activity->planned_cost) * scale);
+        bool completed = next_random(&random) % 4 == 0;
+
+        double begin = now_ns();
+        apply_activity_update(project, id, hours, cost, completed);
+        elapsed += now_ns() - begin;
+    }
+    return elapsed;
+}
+
+/**
+ * Worst cost overruns by visiting every activity (insertion into a sorted
+ * array of the best so far)
+ */
+static int scan_worst(const project_t* project, float* worst, int max_entries) {
+    int count = 0;
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        for (int j = 0; j < milestone->num_activities; j++) {
+            const activity_t* activity = &milestone->activity_list[j];
+            float overrun = money_to_float(activity->actual_cost - activity->planned_cost);
+            if (!(overrun > 0) || (count == max_entries && overrun <= worst[count - 1])) {
+                continue;
+            }
+            int k = count < max_entries ? count++ : count - 1;
+            while (k > 0 && worst[k - 1] < overrun) {
+                worst[k] = worst[k - 1];
+                k--;
+            }
+            worst[k] = overrun;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    workload_shape_t shape = { 60, 1000, 0, 1 };
+    long num_updates = DEFAULT_UPDATES;
+    int num_worst = DEFAULT_WORST;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--updates") == 0 && i + 1 < argc) {
+            num_updates = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--worst") == 0 && i + 1 < argc) {
+            num_worst = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (!workload_parse_shape(argv[i], &shape)) {
+            fprintf(stderr, "Usage: %s [--updates N] [--worst N] [--seed N] [<milestones>x<activities>]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (num_updates < 1 || num_worst < 1 || seed == 0) {
+        fprintf(stderr, "ERROR: --updates, --worst and --seed must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    shape.seed = seed;
+    project_t* plain = generate_project(&shape);
+    project_t* watched = generate_project(&shape);
+    watched->watchlist = watchlist_create(watched, WATCH_DEFAULT_THRESHOLD, WATCH_DEFAULT_THRESHOLD);
+
+    int num_activities = 0;
+    unsigned short int* ids = malloc((size_t)shape.num_milestones * (size_t)shape.activities_per_milestone *
+                                     sizeof(unsigned short int));
+    watch_entry_t* entries = malloc((size_t)num_worst * sizeof(watch_entry_t));
+    float* scanned = malloc((size_t)num_worst * sizeof(float));
+    if (ids == NULL || entries == NULL || scanned == NULL) {
+        printf("ERROR: Failed to allocate benchmark state. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < plain->num_milestones; i++) {
+        const milestone_t* milestone = &plain->milestone_list[i];
+        for (int j = 0; j < milestone->num_activities; j++) {
+            ids[num_activities++] = milestone->activity_list[j].id;
+        }
+    }
+
+    double plain_ns = apply_updates(plain, ids, num_activities, num_updates, seed);
+    double watched_ns = apply_updates(watched, ids, num_activities, num_updates, seed);
+    const watchlist_t* watchlist = watched->watchlist;
+    printf("shape=%dx%d activities=%d updates=%ld\n", shape.num_milestones, shape.activities_per_milestone,
+           num_activities, num_updates);
+    printf("update_ns=%.0f update_ns_with_watchlist=%.0f alerts=%ld\n", plain_ns / (double)num_updates,
+           watched_ns / (double)num_updates, watchlist->num_alerts);
+    printf("listed_cost=%d listed_schedule=%d listed_milestone_cost=%d listed_milestone_schedule=%d\n",
+           watchlist->heaps[WATCH_ACTIVITY_COST].count, watchlist->heaps[WATCH_ACTIVITY_SCHEDULE].count,
+           watchlist->heaps[WATCH_MILESTONE_COST].count, watchlist->heaps[WATCH_MILESTONE_SCHEDULE].count);
+
+    int count = 0, scanned_count = 0;
+    double begin = now_ns();
+    for (int r = 0; r < READ_REPEATS; r++) {
+        count = watchlist_worst(watchlist, WATCH_ACTIVITY_COST, entries, num_worst);
+    }
+    double read_ns = (now_ns() - begin) / READ_REPEATS;
+    begin = now_ns();
+    for (int r = 0; r < READ_REPEATS / 10; r++) {
+        scanned_count = scan_worst(watched, scanned, num_worst);
+    }
+    double scan_ns = (now_ns() - begin) / (READ_REPEATS / 10);
+    printf("worst=%d read_ns=%.0f scan_ns=%.0f\n", num_worst, read_ns, scan_ns);
+
+    bool verified = watchlist_verify(watchlist, watched) && count == scanned_count;
+    for (int n = 0; verified && n < count; n++) {
+        verified = entries[n].overrun == scanned[n];
+    }
+    printf("verified=%s\n", verified ? "yes" : "NO");
+
+    free(ids);
+    free(entries);
+    free(scanned);
+    free_project(plain);
+    free_project(watched);
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,651 @@
+/* history.c */
+#include "history.h"
+#include "a1_functions.h"
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define NUM_VALUE_COLUMNS (HISTORY_NUM_COLUMNS - HISTORY_PLANNED_COST)
+
+// =============================================================================
+// ENCODING
+// =============================================================================
+
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/**
+ * Write a LEB128 varint
+ * @return Bytes written (1-10)
+ */
+static size_t put_varint(uint8_t* out, uint64_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+/**
+ * Read count varints from exactly size bytes
+ * @return false if the bytes do not hold exactly count varints
+ */
+static bool get_varints(const uint8_t* in, size_t size, uint64_t* values, int count) {
+    size_t position = 0;
+    for (int i = 0; i < count; i++) {
+        uint64_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (position == size || shift > 63) {
+                return false;
+            }
+            uint8_t byte = in[position++];
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if (byte < 0x80) {
+                break;
+            }
+        }
+        values[i] = value;
+    }
+    return position == size;
+}
+
+/**
+ * Last values of a milestone in the current block (zero on first sight)
+ */
+static int64_t* milestone_bases(history_bases_t* bases, unsigned short int id) {
+    if (bases->stamp[id] != bases->generation) {
+        bases->stamp[id] = bases->generation;
+        bases->slot[id] = (uint16_t)bases->num_slots;
+        memset(bases->values[bases->num_slots], 0, sizeof(bases->values[0]));
+        bases->num_slots++;
+    }
+    return bases->values[bases->slot[id]];
+}
+
+static void reset_bases(history_bases_t* bases) {
+    if (++bases->generation == 0) {
+        memset(bases->stamp, 0, sizeof(bases->stamp));
+        bases->generation = 1;
+    }
+    bases->num_slots = 0;
+}
+
+/**
+ * FNV-1a 32 over the header fields after the checksum and the payload
+ */
+static uint32_t block_checksum(const history_block_header_t* header, const uint8_t* payload) {
+    const unsigned char* bytes = (const unsigned char*)header + offsetof(history_block_header_t, num_rows);
+    size_t length = sizeof(history_block_header_t) - offsetof(history_block_header_t, num_rows);
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    for (size_t i = 0; i < header->payload_size; i++) {
+        hash ^= payload[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Compress rows into a block payload
+ */
+static void encode_block(int64_t (*rows)[HISTORY_BLOCK_ROWS], int num_rows, uint64_t (*scratch)[HISTORY_BLOCK_ROWS],
+                         history_bases_t* bases, uint8_t* payload, history_block_header_t* header) {
+    // Differences first, one pass over the rows
+    reset_bases(bases);
+    int64_t previous_time = 0;
+    for (int r = 0; r < num_rows; r++) {
+        scratch[HISTORY_TIME][r] = zigzag(rows[HISTORY_TIME][r] - previous_time);
+        previous_time = rows[HISTORY_TIME][r];
+        scratch[HISTORY_MILESTONE][r] = (uint64_t)rows[HISTORY_MILESTONE][r];
+
+        int64_t* last = milestone_bases(bases, (unsigned short int)rows[HISTORY_MILESTONE][r]);
+        for (int c = 0; c < NUM_VALUE_COLUMNS; c++) {
+            int64_t value = rows[HISTORY_PLANNED_COST + c][r];
+            scratch[HISTORY_PLANNED_COST + c][r] = zigzag(value - last[c]);
+            last[c] = value;
+        }
+    }
+
+    // Then each column as one run of varints
+    size_t size = 0;
+    for (int c = 0; c < HISTORY_NUM_COLUMNS; c++) {
+        size_t start = size;
+        for (int r = 0; r < num_rows; r++) {
+            size += put_varint(payload + size, scratch[c][r]);
+        }
+        header->column_size[c] = (uint32_t)(size - start);
+    }
+
+    header->magic = HISTORY_BLOCK_MAGIC;
+    header->num_rows = (uint32_t)num_rows;
+    header->payload_size = (uint32_t)size;
+    header->first_time = rows[HISTORY_TIME][0];
+    header->last_time = rows[HISTORY_TIME][num_rows - 1];
+    header->checksum = block_checksum(header, payload);
+}
+
+/**
+ * Decompress a block payload back into rows
+ * @return false if the payload does not match its header
+ */
+static bool decode_block(const history_block_header_t* header, const uint8_t* payload,
+                         int64_t (*rows)[HISTORY_BLOCK_ROWS], uint64_t (*scratch)[HISTORY_BLOCK_ROWS],
+                         history_bases_t* bases) {
+    int num_rows = (int)header->num_rows;
+    size_t offset = 0;
+    for (int c = 0; c < HISTORY_NUM_COLUMNS; c++) {
+        if (header->column_size[c] > header->payload_size - offset ||
+            !get_varints(payload + offset, header->column_size[c], scratch[c], num_rows)) {
+            return false;
+        }
+        offset += header->column_size[c];
+    }
+
+    reset_bases(bases);
+    int64_t time = 0;
+    for (int r = 0; r < num_rows; r++) {
+        time += unzigzag(scratch[HISTORY_TIME][r]);
+        rows[HISTORY_TIME][r] = time;
+        if (scratch[HISTORY_MILESTONE][r] > USHRT_MAX) {
+            return false;
+        }
+        rows[HISTORY_MILESTONE][r] = (int64_t)scratch[HISTORY_MILESTONE][r];
+
+        int64_t* last = milestone_bases(bases, (unsigned short int)scratch[HISTORY_MILESTONE][r]);
+        for (int c = 0; c < NUM_VALUE_COLUMNS; c++) {
+            last[c] += unzigzag(scratch[HISTORY_PLANNED_COST + c][r]);
+            rows[HISTORY_PLANNED_COST + c][r] = last[c];
+        }
+    }
+    return true;
+}
+
+static bool header_plausible(const history_block_header_t* header) {
+    return header->magic == HISTORY_BLOCK_MAGIC && header->num_rows > 0 &&
+           header->num_rows <= HISTORY_BLOCK_ROWS && header->payload_size <= HISTORY_MAX_PAYLOAD &&
+           header->first_time <= header->last_time;
+}
+
+static void* allocate_buffer(size_t size) {
+    void* buffer = malloc(size);
+    if (buffer == NULL) {
+        printf("ERROR: Failed to allocate history buffers. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    return buffer;
+}
+
+// =============================================================================
+// FILE I/O
+// =============================================================================
+
+/**
+ * pread() that retries on interruption and short reads
+ */
+static bool read_at(int fd, void* data, size_t length, off_t offset) {
+    char* bytes = data;
+    while (length > 0) {
+        ssize_t got = pread(fd, bytes, length, offset);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        bytes += got;
+        length -= (size_t)got;
+        offset += got;
+    }
+    return true;
+}
+
+/**
+ * write() that retries on interruption and short writes
+ */
+static bool write_all(int fd, const void* data, size_t length) {
+    const char* bytes = data;
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+/**
+ * Walk the block headers and cut off a torn tail
+ * Only the last block can be torn (every earlier write completed before the
+ * next began), so only its checksum is checked here.
+ */
+static bool scan_blocks(history_t* history, off_t size) {
+    history_block_header_t header;
+    off_t offset = 0, last_offset = -1;
+    history_block_header_t last_header;
+    int64_t previous_last_time = 0;
+
+    while (offset + (off_t)sizeof(header) <= size && read_at(history->fd, &header, sizeof(header), offset) &&
+           header_plausible(&header) && offset + (off_t)sizeof(header) + header.payload_size <= size) {
+        if (last_offset >= 0) {
+            previous_last_time = last_header.last_time;
+        }
+        last_offset = offset;
+        last_header = header;
+        offset += (off_t)sizeof(header) + header.payload_size;
+        history->num_blocks++;
+        history->num_rows += header.num_rows;
+    }
+
+    if (last_offset >= 0) {
+        uint8_t* payload = allocate_buffer(HISTORY_MAX_PAYLOAD);
+        bool intact = read_at(history->fd, payload, last_header.payload_size,
+                              last_offset + (off_t)sizeof(last_header)) &&
+                      block_checksum(&last_header, payload) == last_header.checksum;
+        free(payload);
+        if (intact) {
+            history->last_time = last_header.last_time;
+        } else {
+            offset = last_offset;
+            history->num_blocks--;
+            history->num_rows -= last_header.num_rows;
+            history->last_time = previous_last_time;
+        }
+    }
+
+    if (offset < size) {
+        fprintf(stderr, "WARNING: %s: discarding torn history tail\n", history->path);
+        if (ftruncate(history->fd, offset) != 0) {
+            fprintf(stderr, "ERROR: Failed to truncate history '%s'\n", history->path);
+            return false;
+        }
+    }
+    history->file_size = offset;
+    return true;
+}
+
+// =============================================================================
+// RECORDING
+// =============================================================================
+
+history_t* history_open(const char* path, const project_t* project) {
+    history_t* history = calloc(1, sizeof(history_t));
+    if (history == NULL) {
+        printf("ERROR: Failed to allocate history. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    snprintf(history->path, sizeof(history->path), "%s", path);
+
+    history->fd = open(path, O_RDWR | O_APPEND | O_CREAT, 0644);
+    struct stat info;
+    if (history->fd < 0 || fstat(history->fd, &info) != 0) {
+        fprintf(stderr, "ERROR: Cannot open history '%s'\n", path);
+        if (history->fd >= 0) {
+            close(history->fd);
+        }
+        free(history);
+        return NULL;
+    }
+
+    history->scratch = allocate_buffer(HISTORY_NUM_COLUMNS * sizeof(*history->scratch));
+    history->payload = allocate_buffer(HISTORY_MAX_PAYLOAD);
+    history->bases = calloc(1, sizeof(history_bases_t));
+    if (history->bases == NULL) {
+        printf("ERROR: Failed to allocate history buffers. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (!scan_blocks(history, info.st_size)) {
+        history_close(history);
+        return NULL;
+    }
+
+    // A new history starts from the state the project is in now
+    if (history->num_rows == 0) {
+        for (int i = 0; i < project->num_milestones; i++) {
+            history_record(history, &project->milestone_list[i]);
+        }
+    }
+    return history;
+}
+
+bool history_append(history_t* history, const history_row_t* row) {
+    // The block only stays full after a failed flush; never write past it
+    if (history->num_pending == HISTORY_BLOCK_ROWS && !history_flush(history)) {
+        return false;
+    }
+
+    int64_t time = row->time > history->last_time ? row->time : history->last_time;
+    int r = history->num_pending;
+
+    history->pending[HISTORY_TIME][r] = time;
+    history->pending[HISTORY_MILESTONE][r] = row->milestone_id;
+    history->pending[HISTORY_PLANNED_COST][r] = row->planned_cents;
+    history->pending[HISTORY_ACTUAL_COST][r] = row->actual_cents;
+    history->pending[HISTORY_PLANNED_HOURS][r] = row->planned_hours;
+    history->pending[HISTORY_ACTUAL_HOURS][r] = row->actual_hours;
+    history->pending[HISTORY_NUM_COMPLETED][r] = row->num_completed;
+    history->pending[HISTORY_NUM_ACTIVITIES][r] = row->num_activities;
+    history->num_pending++;
+    history->num_rows++;
+    history->last_time = time;
+
+    return history->num_pending < HISTORY_BLOCK_ROWS || history_flush(history);
+}
+
+void history_record(history_t* history, const milestone_t* milestone) {
+    if (history == NULL) {
+        return;
+    }
+
+    history_row_t row = {
+        .time = (int64_t)time(NULL),
+        .milestone_id = milestone->id,
+        .planned_cents = money_to_cents(milestone->planned_cost),
+        .actual_cents = money_to_cents(milestone->actual_cost),
+        .planned_hours = milestone->planned_hours,
+        .actual_hours = milestone->actual_hours,
+        .num_completed = milestone->num_completed,
+        .num_activities = milestone->num_activities,
+    };
+    if (!history_append(history, &row)) {
+        fprintf(stderr, "WARNING: Progress history could not be written to '%s'\n", history->path);
+    }
+}
+
+bool history_flush(history_t* history) {
+    if (history->num_pending == 0) {
+        return true;
+    }
+
+    history_block_header_t header;
+    memset(&header, 0, sizeof(header));
+    encode_block(history->pending, history->num_pending, history->scratch, history->bases, history->payload,
+                 &header);
+
+    // One write per block; a failed one is cut off so the file stays intact
+    bool ok = write_all(history->fd, &header, sizeof(header)) &&
+              write_all(history->fd, history->payload, header.payload_size);
+    if (!ok) {
+        fprintf(stderr, "ERROR: Failed to write history '%s'\n", history->path);
+        if (ftruncate(history->fd, history->file_size) != 0) {
+            fprintf(stderr, "ERROR: Failed to truncate history '%s'\n", history->path);
+        }
+        return false;
+    }
+
+    history->file_size += (off_t)sizeof(header) + header.payload_size;
+    history->num_blocks++;
+    history->num_pending = 0;
+    return true;
+}
+
+void history_close(history_t* history) {
+    if (history == NULL) {
+        return;
+    }
+    history_flush(history);
+    close(history->fd);
+    free(history->scratch);
+    free(history->payload);
+    free(history->bases);
+    free(history);
+}
+
+// =============================================================================
+// QUERIES
+// =============================================================================
+
+history_cursor_t* history_cursor_open(const history_t* history, int64_t from, int64_t to) {
+    history_cursor_t* cursor = calloc(1, sizeof(history_cursor_t));
+    if (cursor == NULL) {
+        printf("ERROR: Failed to allocate history cursor. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    cursor->history = history;
+    cursor->from = from;
+    cursor->to = to;
+    cursor->end = history->file_size;
+    cursor->rows = allocate_buffer(HISTORY_NUM_COLUMNS * sizeof(*cursor->rows));
+    cursor->scratch = allocate_buffer(HISTORY_NUM_COLUMNS * sizeof(*cursor->scratch));
+    cursor->payload = allocate_buffer(HISTORY_MAX_PAYLOAD);
+    cursor->bases = calloc(1, sizeof(history_bases_t));
+    if (cursor->bases == NULL) {
+        printf("ERROR: Failed to allocate history cursor. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    return cursor;
+}
+
+/**
+ * Decode the next block that overlaps the range into cursor->rows
+ * @return false when no block is left in the file
+ */
+static bool load_next_block(history_cursor_t* cursor) {
+    const history_t* history = cursor->history;
+    history_block_header_t header;
+
+    while (cursor->offset < cursor->end) {
+        off_t offset = cursor->offset;
+        if (!read_at(history->fd, &header, sizeof(header), offset) || !header_plausible(&header)) {
+            fprintf(stderr, "WARNING: %s: unreadable history block, query stopped\n", history->path);
+            cursor->offset = cursor->end;
+            return false;
+        }
+        cursor->offset = offset + (off_t)sizeof(header) + header.payload_size;
+
+        // Rows are in time order, so only the header is needed to skip
+        if (header.last_time < cursor->from) {
+            cursor->blocks_skipped++;
+            continue;
+        }
+        if (header.first_time > cursor->to) {
+            cursor->offset = cursor->end;
+            return false;
+        }
+
+        if (!read_at(history->fd, cursor->payload, header.payload_size, offset + (off_t)sizeof(header)) ||
+            block_checksum(&header, cursor->payload) != header.checksum ||
+            !decode_block(&header, cursor->payload, cursor->rows, cursor->scratch, cursor->bases)) {
+            fprintf(stderr, "WARNING: %s: corrupt history block skipped\n", history->path);
+            continue;
+        }
+        cursor->blocks_read++;
+        cursor->num_rows = (int)header.num_rows;
+        cursor->next_row = 0;
+        return true;
+    }
+    return false;
+}
+
+bool history_cursor_next(history_cursor_t* cursor, history_row_t* row) {
+    for (;;) {
+        int64_t (*rows)[HISTORY_BLOCK_ROWS] = cursor->in_pending
+                                            ? (int64_t (*)[HISTORY_BLOCK_ROWS])cursor->history->pending
+                                            : cursor->rows;
+        while (cursor->next_row < cursor->num_rows) {
+            int r = cursor->next_row++;
+            int64_t time = rows[HISTORY_TIME][r];
+            if (time < cursor->from) {
+                continue;
+            }
+            if (time > cursor->to) {
+                cursor->next_row = cursor->num_rows;
+                cursor->offset = cursor->end;
+                cursor->in_pending = true;   // Nothing later can be in range
+                return false;
+            }
+            row->time = time;
+            row->milestone_id = (unsigned short int)rows[HISTORY_MILESTONE][r];
+            row->planned_cents = rows[HISTORY_PLANNED_COST][r];
+            row->actual_cents = rows[HISTORY_ACTUAL_COST][r];
+            row->planned_hours = rows[HISTORY_PLANNED_HOURS][r];
+            row->actual_hours = rows[HISTORY_ACTUAL_HOURS][r];
+            row->num_completed = (int32_t)rows[HISTORY_NUM_COMPLETED][r];
+            row->num_activities = (int32_t)rows[HISTORY_NUM_ACTIVITIES][r];
+            return true;
+        }
+
+        if (cursor->in_pending) {
+            return false;
+        }
+        if (!load_next_block(cursor)) {
+            // Rows still in memory come after everything in the file
+            cursor->in_pending = true;
+            cursor->num_rows = cursor->history->num_pending;
+            cursor->next_row = 0;
+        }
+    }
+}
+
+void history_cursor_close(history_cursor_t* cursor) {
+    if (cursor == NULL) {
+        return;
+    }
+    free(cursor->rows);
+    free(cursor->scratch);
+    free(cursor->payload);
+    free(cursor->bases);
+    free(cursor);
+}
+
+double history_earned_value(const history_row_t* row) {
+    if (row->num_activities == 0) {
+        return 0;
+    }
+    return (double)row->planned_cents / 100 * row->num_completed / row->num_activities;
+}
+
+double history_cost_variance(const history_row_t* row) {
+    return (double)row->actual_cents / 100 - history_earned_value(row);
+}
+
+double history_effort_variance(const history_row_t* row) {
+    double earned_hours = row->num_activities == 0
+                        ? 0 : (double)row->planned_hours * row->num_completed / row->num_activities;
+    return (double)row->actual_hours - earned_hours;
+}
+
+int history_trends(const history_t* history, int64_t from, int64_t to, history_trend_t** trends) {
+    // Trend slots in first-seen order; IDs map to them directly
+    int* index = malloc(65536 * sizeof(int));
+    int capacity = 64, count = 0;
+    history_trend_t* list = malloc((size_t)capacity * sizeof(history_trend_t));
+    if (index == NULL || list == NULL) {
+        printf("ERROR: Failed to allocate history trends. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < 65536; i++) {
+        index[i] = -1;
+    }
+
+    history_cursor_t* cursor = history_cursor_open(history, from, to);
+    history_row_t row;
+    while (history_cursor_next(cursor, &row)) {
+        history_trend_t* trend;
+        double cost_variance = history_cost_variance(&row);
+        if (index[row.milestone_id] < 0) {
+            if (count == capacity) {
+                capacity *= 2;
+                list = realloc(list, (size_t)capacity * sizeof(history_trend_t));
+                if (list == NULL) {
+                    printf("ERROR: Failed to allocate history trends. Exiting...\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            index[row.milestone_id] = count;
+            trend = &list[count++];
+            trend->milestone_id = row.milestone_id;
+            trend->num_samples = 0;
+            trend->first = row;
+            trend->peak_cost_variance = cost_variance;
+        } else {
+            trend = &list[index[row.milestone_id]];
+        }
+        trend->num_samples++;
+        trend->last = row;
+        if (cost_variance > trend->peak_cost_variance) {
+            trend->peak_cost_variance = cost_variance;
+        }
+    }
+    history_cursor_close(cursor);
+
+    // Order by milestone ID through the index instead of sorting
+    history_trend_t* ordered = malloc((size_t)(count > 0 ? count : 1) * sizeof(history_trend_t));
+    if (ordered == NULL) {
+        printf("ERROR: Failed to allocate history trends. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    int next = 0;
+    for (int id = 0; id < 65536 && next < count; id++) {
+        if (index[id] >= 0) {
+            ordered[next++] = list[index[id]];
+        }
+    }
+    free(list);
+    free(index);
+    *trends = ordered;
+    return count;
+}
+
+void print_history_trend(project_t* project, const history_t* history, int days, int64_t now) {
+    int64_t from = now - (int64_t)days * SECONDS_PER_DAY;
+    history_trend_t* trends;
+    int count = history_trends(history, from, now, &trends);
+
+    printf("\nPROGRESS HISTORY: last %d day(s)\n", days);
+    printf("========================================\n");
+    printf("%ld row(s) in %ld block(s), %.1f byte(s) per written row\n", history->num_rows, history->num_blocks,
+           history->num_rows > history->num_pending
+           ? (double)history->file_size / (double)(history->num_rows - history->num_pending) : 0.0);
+    if (count == 0) {
+        printf("No milestone changed in this period.\n");
+        free(trends);
+        return;
+    }
+
+    printf("Cost variance = actual cost - earned value; effort variance = actual - earned hours\n");
+    printf("(positive: over budget / behind). Earned = planned x completed share of activities.\n\n");
+    printf("%-24s %7s %14s %22s %20s %12s\n", "Milestone", "Samples", "Complete", "Cost variance",
+           "Effort variance", "Peak CV");
+    for (int i = 0; i < count; i++) {
+        const history_trend_t* trend = &trends[i];
+        milestone_t* milestone = find_milestone_by_id(project, trend->milestone_id);
+        char label[32];
+        if (milestone != NULL) {
+            snprintf(label, sizeof(label), "%s", get_name(project, milestone->name));
+        } else {
+            snprintf(label, sizeof(label), "(removed %hu)", trend->milestone_id);
+        }
+        printf("%-24.24s %7ld %5.1f%%->%5.1f%% %10.2f->%10.2f %9.1f->%9.1f %12.2f\n", label, trend->num_samples,
+               trend->first.num_activities > 0
+               ? 100.0 * trend->first.num_completed / trend->first.num_activities : 0.0,
+               trend->last.num_activities > 0
+               ? 100.0 * trend->last.num_completed / trend->last.num_activities : 0.0,
+               history_cost_variance(&trend->first), history_cost_variance(&trend->last),
+               history_effort_variance(&trend->first), history_effort_variance(&trend->last),
+               trend->peak_cost_variance);
+    }
+    free(trends);
+}
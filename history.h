@@ -0,0 +1,232 @@
+/* history.h */
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "a1_data_structures.h"
+#include <sys/types.h>
+
+#define HISTORY_BLOCK_MAGIC 0x54534948u    // "HIST"
+#define HISTORY_BLOCK_ROWS 4096            // Rows per compressed block
+#define HISTORY_NUM_COLUMNS 8
+#define HISTORY_MAX_PAYLOAD (HISTORY_NUM_COLUMNS * HISTORY_BLOCK_ROWS * 10)  // 10 bytes per varint at most
+#define SECONDS_PER_DAY 86400
+
+/**
+ * PROGRESS HISTORY
+ *
+ * Append-only record of how every milestone's rollup evolved: each time a
+ * change reaches a milestone's totals, one row with the new totals and the
+ * time is added. The journal keeps the latest value of each activity; the
+ * history keeps the trend, so cost and effort variance can be charted over
+ * time.
+ *
+ * Rows are gathered in memory and written in blocks of HISTORY_BLOCK_ROWS.
+ * Each block stores its rows column by column: times as differences from
+ * the previous row, milestone IDs as they are, and every total as the
+ * difference from the previous row of the same milestone in the block
+ * (most updates move one or two totals by a little, and planned values
+ * rarely move at all). Differences are zigzag-encoded varints, so a typical
+ * row takes 10-14 bytes instead of 48. Every block starts its differences
+ * afresh and can be decoded on its own.
+ *
+ * Block headers carry the time range of their rows, so a range query reads
+ * only the headers of older blocks and decodes the blocks in range one at a
+ * time; its memory does not depend on the length of the history. Rows not
+ * yet written are part of every query. A crash loses them, like any buffered
+ * write; the journal, not the history, is what makes updates durable.
+ */
+
+/**
+ * Column order within a block
+ */
+typedef enum {
+    HISTORY_TIME,
+    HISTORY_MILESTONE,
+    HISTORY_PLANNED_COST,          // Cents
+    HISTORY_ACTUAL_COST,           // Cents
+    HISTORY_PLANNED_HOURS,
+    HISTORY_ACTUAL_HOURS,
+    HISTORY_NUM_COMPLETED,
+    HISTORY_NUM_ACTIVITIES
+} history_column_t;
+
+/**
+ * One recorded milestone state
+ */
+typedef struct {
+    int64_t time;                       // Seconds since the epoch
+    unsigned short int milestone_id;
+    int64_t planned_cents, actual_cents;
+    int64_t planned_hours, actual_hours;
+    int32_t num_completed, num_activities;
+} history_row_t;
+
+/**
+ * Block Header (on disk, followed by the column data)
+ *
+ * The checksum (FNV-1a 32) covers every header field after it and the
+ * payload, so a block torn by a crash is detected.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t checksum;
+    uint32_t num_rows;
+    uint32_t payload_size;
+    int64_t first_time, last_time;
+    uint32_t column_size[HISTORY_NUM_COLUMNS];
+} history_block_header_t;
+
+/**
+ * Per-milestone delta bases while a block is encoded or decoded
+ *
+ * stamp[id] == generation marks an ID seen in the current block; its last
+ * values are in values[slot[id]]. Bumping the generation clears the table.
+ */
+typedef struct {
+    uint32_t generation;
+    uint32_t stamp[65536];
+    uint16_t slot[65536];
+    int num_slots;
+    int64_t values[HISTORY_BLOCK_ROWS][HISTORY_NUM_COLUMNS - HISTORY_PLANNED_COST];
+} history_bases_t;
+
+/**
+ * History Structure
+ *
+ * - fd/path: History file, opened for reading and appending
+ * - file_size: Bytes of intact blocks in the file
+ * - num_blocks/num_rows: Blocks in the file; rows in the file and pending
+ * - pending/num_pending: Rows not yet written, column by column
+ * - last_time: Time of the newest row (rows never go back in time)
+ * - scratch/payload/bases: Encoding buffers
+ */
+typedef struct history {
+    int fd;
+    char path[4096];
+    off_t file_size;
+    long num_blocks;
+    long num_rows;
+    int64_t pending[HISTORY_NUM_COLUMNS][HISTORY_BLOCK_ROWS];
+    int num_pending;
+    int64_t last_time;
+    uint64_t (*scratch)[HISTORY_BLOCK_ROWS];
+    uint8_t* payload;
+    history_bases_t* bases;
+} history_t;
+
+/**
+ * Streaming range query over a history
+ *
+ * Holds one decoded block at a time. Rows come in time order.
+ */
+typedef struct {
+    const history_t* history;
+    int64_t from, to;
+    off_t offset, end;                  // Next block in the file; end of the blocks at open
+    bool in_pending;                    // File done, reading the pending rows
+    int num_rows, next_row;
+    int64_t (*rows)[HISTORY_BLOCK_ROWS];
+    uint64_t (*scratch)[HISTORY_BLOCK_ROWS];
+    uint8_t* payload;
+    history_bases_t* bases;
+    long blocks_read, blocks_skipped;
+} history_cursor_t;
+
+/**
+ * Change of one milestone over a time range
+ *
+ * - first/last: Earliest and latest recorded state in the range
+ * - num_samples: Rows recorded in the range
+ * - peak_cost_variance: Largest cost variance seen in the range
+ */
+typedef struct {
+    unsigned short int milestone_id;
+    long num_samples;
+    history_row_t first, last;
+    double peak_cost_variance;
+} history_trend_t;
+
+/**
+ * Open (creating if needed) a history file
+ * A torn last block is cut off. A new history records the current state
+ * of every milestone as its starting point.
+ * @param path History file
+ * @param project Project whose changes will be recorded
+ * @return History handle, or NULL after printing an error
+ */
+history_t* history_open(const char* path, const project_t* project);
+
+/**
+ * Record the current totals of a milestone, stamped with the current time
+ * Does nothing if history is NULL.
+ */
+void history_record(history_t* history, const milestone_t* milestone);
+
+/**
+ * Append a row with an explicit time (clamped so time never goes back)
+ * @return false if a full block could not be written; if the block was
+ *         already full from an earlier failure and still cannot be written,
+ *         the row is not recorded
+ */
+bool history_append(history_t* history, const history_row_t* row);
+
+/**
+ * Write the pending rows as a block
+ * @return true on success
+ */
+bool history_flush(history_t* history);
+
+/**
+ * Flush and close the history (NULL is ignored)
+ */
+void history_close(history_t* history);
+
+/**
+ * Start a range query over rows with from <= time <= to
+ * @return Cursor, exits on allocation failure
+ */
+history_cursor_t* history_cursor_open(const history_t* history, int64_t from, int64_t to);
+
+/**
+ * Fetch the next row in range
+ * Blocks that fail their checksum are skipped with a warning.
+ * @return false when the range is exhausted
+ */
+bool history_cursor_next(history_cursor_t* cursor, history_row_t* row);
+
+/**
+ * Free a cursor
+ */
+void history_cursor_close(history_cursor_t* cursor);
+
+/**
+ * Earned value of a recorded state: planned cost times the completed share
+ * of its activities
+ */
+double history_earned_value(const history_row_t* row);
+
+/**
+ * Cost variance of a recorded state: actual cost minus earned value
+ * (positive means over budget, like the project's cost variance)
+ */
+double history_cost_variance(const history_row_t* row);
+
+/**
+ * Effort variance of a recorded state in hours: actual hours minus the
+ * planned hours earned by the completed share (positive means behind)
+ */
+double history_effort_variance(const history_row_t* row);
+
+/**
+ * Summarise every milestone's change over a time range in one pass
+ * @param trends Receives a malloc'd array ordered by milestone ID
+ * @return Number of milestones with rows in the range
+ */
+int history_trends(const history_t* history, int64_t from, int64_t to, history_trend_t** trends);
+
+/**
+ * Print the milestone trends of the last days up to now
+ */
+void print_history_trend(project_t* project, const history_t* history, int days, int64_t now);
+
+#endif
@@ -0,0 +1,157 @@
+/* instrument.c */
+#include "instrument.h"
+
+#ifdef PM_INSTRUMENT
+
+#include <time.h>
+
+probe_stats_t probe_table[PROBE_COUNT];
+
+static const char* const probe_names[PROBE_COUNT] = {
+    "id_check",
+    "activity_lookup",
+    "activity_update",
+    "milestone_rollup",
+    "project_rollup",
+    "print_stats",
+    "allocation"
+};
+
+// Probes recorded with PROBE_HIT carry a count but no durations
+static const bool probe_timed[PROBE_COUNT] = { false, false, true, true, true, true, true };
+
+// Reference points for converting ticks to nanoseconds
+static uint64_t start_ticks;
+static uint64_t start_ns;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+__attribute__((constructor)) static void instrument_start(void) {
+    start_ticks = probe_ticks();
+    start_ns = monotonic_ns();
+}
+
+/**
+ * Nanoseconds per tick, measured over the life of the process so far
+ */
+static double ns_per_tick(void) {
+    if (!PROBE_TICKS_ARE_CYCLES) {
+        return 1.0;
+    }
+    uint64_t ticks = probe_ticks() - start_ticks;
+    uint64_t ns = monotonic_ns() - start_ns;
+    return ticks > 0 ? (double)ns / (double)ticks : 1.0;
+}
+
+/**
+ * Upper bound (in ticks) of the histogram bucket holding a percentile,
+ * capped at the longest recorded duration
+ */
+static uint64_t bucket_percentile(const probe_stats_t* stats, int percent) {
+    uint64_t target = (stats->count * (uint64_t)percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (int b = 0; b < PROBE_BUCKETS; b++) {
+        seen += stats->buckets[b];
+        if (seen >= target && seen > 0) {
+            uint64_t bound = b == 0 ? 0 : (1ULL << b) - 1;
+            return bound < stats->max_ticks ? bound : stats->max_ticks;
+        }
+    }
+    return stats->max_ticks;
+}
+
+bool instrument_enabled(void) {
+    return true;
+}
+
+void instrument_print(FILE* out) {
+    double scale = ns_per_tick();
+
+    fprintf(out, "\nINSTRUMENTATION (%s, percentiles are histogram bucket bounds)\n",
+            PROBE_TICKS_ARE_CYCLES ? "TSC" : "monotonic clock");
+    fprintf(out, "%-18s %12s %10s %10s %10s %10s %12s\n",
+            "operation", "calls", "mean ns", "p50 ns", "p99 ns", "max ns", "units");
+    for (int p = 0; p < PROBE_COUNT; p++) {
+        const probe_stats_t* stats = &probe_table[p];
+        if (!probe_timed[p]) {
+            fprintf(out, "%-18s %12llu %10s %10s %10s %10s %12s\n", probe_names[p],
+                    (unsigned long long)stats->count, "-", "-", "-", "-", "-");
+            continue;
+        }
+        double mean = stats->count ? (double)stats->total_ticks / (double)stats->count * scale : 0;
+        fprintf(out, "%-18s %12llu %10.1f %10.0f %10.0f %10.0f %12llu\n",
+                probe_names[p], (unsigned long long)stats->count, mean,
+                (double)bucket_percentile(stats, 50) * scale,
+                (double)bucket_percentile(stats, 99) * scale,
+                (double)stats->max_ticks * scale, (unsigned long long)stats->units);
+    }
+}
+
+bool instrument_write_json(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        fprintf(stderr, "ERROR: Cannot create instrumentation file '%s'\n", path);
+        return false;
+    }
+
+    double scale = ns_per_tick();
+    fprintf(out, "{\"clock\":\"%s\",\"ns_per_tick\":%.6f,\"probes\":{",
+            PROBE_TICKS_ARE_CYCLES ? "tsc" : "monotonic", scale);
+    for (int p = 0; p < PROBE_COUNT; p++) {
+        const probe_stats_t* stats = &probe_table[p];
+        if (!probe_timed[p]) {
+            fprintf(out, "%s\n  \"%s\":{\"count\":%llu}", p ? "," : "", probe_names[p],
+                    (unsigned long long)stats->count);
+            continue;
+        }
+        fprintf(out, "%s\n  \"%s\":{\"count\":%llu,\"total_ns\":%.0f,\"max_ns\":%.0f,\"units\":%llu,"
+                     "\"p50_ns\":%.0f,\"p90_ns\":%.0f,\"p99_ns\":%.0f,\"histogram\":[",
+                p ? "," : "", probe_names[p], (unsigned long long)stats->count,
+                (double)stats->total_ticks * scale, (double)stats->max_ticks * scale,
+                (unsigned long long)stats->units,
+                (double)bucket_percentile(stats, 50) * scale,
+                (double)bucket_percentile(stats, 90) * scale,
+                (double)bucket_percentile(stats, 99) * scale);
+
+        // Only non-empty buckets, each with its upper bound in nanoseconds
+        bool first = true;
+        for (int b = 0; b < PROBE_BUCKETS; b++) {
+            if (stats->buckets[b] != 0) {
+                fprintf(out, "%s{\"le_ns\":%.0f,\"count\":%llu}", first ? "" : ",",
+                        (double)(b == 0 ? 0 : (1ULL << b) - 1) * scale,
+                        (unsigned long long)stats->buckets[b]);
+                first = false;
+            }
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "\n}}\n");
+
+    if (fclose(out) != 0) {
+        fprintf(stderr, "ERROR: Failed to write instrumentation file '%s'\n", path);
+        return false;
+    }
+    return true;
+}
+
+#else
+
+bool instrument_enabled(void) {
+    return false;
+}
+
+void instrument_print(FILE* out) {
+    fprintf(out, "\nInstrumentation is not compiled in (rebuild with -DPM_INSTRUMENT).\n");
+}
+
+bool instrument_write_json(const char* path) {
+    fprintf(stderr, "ERROR: Cannot write '%s': built without -DPM_INSTRUMENT\n", path);
+    return false;
+}
+
+#endif
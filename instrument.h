@@ -0,0 +1,124 @@
+/* instrument.h */
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * HOT-PATH INSTRUMENTATION
+ *
+ * Call counters and log2 latency histograms for the core operations,
+ * compiled in only when building with -DPM_INSTRUMENT. Without the flag the
+ * PROBE_* macros expand to nothing, so the instrumented functions compile
+ * exactly as before.
+ *
+ * Recording never allocates: every probe owns a fixed slot in a static
+ * table. Operations that take a few nanoseconds (ID checks, lookups) are
+ * only counted, since reading the clock twice would cost more than the
+ * operation itself. Durations are read from the CPU timestamp counter on
+ * x86 (cycles, converted to nanoseconds when reported) and from
+ * CLOCK_MONOTONIC elsewhere. Slots are plain counters, not atomics; probes belong on paths
+ * run by one thread at a time.
+ */
+
+#define PROBE_BUCKETS 40    // Bucket b counts durations in [2^(b-1), 2^b) ticks
+
+/**
+ * Instrumented Operations
+ */
+typedef enum {
+    PROBE_ID_CHECK,             // is_id_unique (counted only)
+    PROBE_ACTIVITY_LOOKUP,      // find_activity_by_id (counted only)
+    PROBE_ACTIVITY_UPDATE,      // rollup_activity_change (every single update)
+    PROBE_MILESTONE_ROLLUP,     // update_milestone
+    PROBE_PROJECT_ROLLUP,       // update_project
+    PROBE_PRINT_STATS,          // print_project_stats
+    PROBE_ALLOCATION,           // create_milestone_array / create_activity_array
+    PROBE_COUNT
+} probe_t;
+
+/**
+ * Probe Statistics
+ *
+ * - count: Completed calls
+ * - total_ticks/max_ticks: Summed and longest duration
+ * - units: Operation-specific total (bytes for allocations, else 0)
+ * - buckets: log2 histogram of durations
+ */
+typedef struct {
+    uint64_t count;
+    uint64_t total_ticks;
+    uint64_t max_ticks;
+    uint64_t units;
+    uint64_t buckets[PROBE_BUCKETS];
+} probe_stats_t;
+
+#ifdef PM_INSTRUMENT
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROBE_TICKS_ARE_CYCLES 1
+static inline uint64_t probe_ticks(void) {
+    return __rdtsc();
+}
+#else
+#include <time.h>
+#define PROBE_TICKS_ARE_CYCLES 0
+static inline uint64_t probe_ticks(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+extern probe_stats_t probe_table[PROBE_COUNT];
+
+static inline void probe_record(probe_t probe, uint64_t ticks, uint64_t units) {
+    probe_stats_t* stats = &probe_table[probe];
+    int bucket = ticks ? 64 - __builtin_clzll(ticks) : 0;
+
+    stats->count++;
+    stats->total_ticks += ticks;
+    stats->units += units;
+    if (ticks > stats->max_ticks) {
+        stats->max_ticks = ticks;
+    }
+    stats->buckets[bucket < PROBE_BUCKETS ? bucket : PROBE_BUCKETS - 1]++;
+}
+
+// Open a timed region in the current block; PROBE_END closes it
+#define PROBE_BEGIN() uint64_t probe_start_ = probe_ticks()
+#define PROBE_END(probe) probe_record((probe), probe_ticks() - probe_start_, 0)
+#define PROBE_END_UNITS(probe, units) probe_record((probe), probe_ticks() - probe_start_, (units))
+#define PROBE_HIT(probe) (probe_table[probe].count++)
+
+#else
+
+#define PROBE_BEGIN() ((void)0)
+#define PROBE_END(probe) ((void)0)
+#define PROBE_END_UNITS(probe, units) ((void)0)
+#define PROBE_HIT(probe) ((void)0)
+
+#endif
+
+/**
+ * Whether this build records anything (built with -DPM_INSTRUMENT)
+ */
+bool instrument_enabled(void);
+
+/**
+ * Print a human-readable table of every probe with its percentiles
+ * @param out Stream to print to
+ */
+void instrument_print(FILE* out);
+
+/**
+ * Write every probe, including its histogram, as one JSON object
+ * @param path File to create
+ * @return true on success, false after printing an error to stderr
+ */
+bool instrument_write_json(const char* path);
+
+#endif
@@ -0,0 +1,395 @@
+/* journal.c */
+#include "journal.h"
+#include "a1_functions.h"
+#include "snapshot.h"
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define REPLAY_CHUNK_RECORDS 4096
+
+/**
+ * FNV-1a 32 over every record field after the checksum
+ */
+static uint32_t record_checksum(const journal_record_t* record) {
+    const unsigned char* bytes = (const unsigned char*)record + offsetof(journal_record_t, sequence);
+    size_t length = sizeof(journal_record_t) - offsetof(journal_record_t, sequence);
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool record_valid(const journal_record_t* record) {
+    return record->magic == JOURNAL_RECORD_MAGIC && record->checksum == record_checksum(record);
+}
+
+/**
+ * write() that retries on interruption and short writes
+ */
+static bool write_all(int fd, const void* data, size_t length) {
+    const char* bytes = data;
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+/**
+ * read() that retries on interruption and fills the buffer unless EOF is hit
+ * @return Bytes read, or -1 on error
+ */
+static ssize_t read_full(int fd, void* data, size_t length) {
+    char* bytes = data;
+    size_t total = 0;
+    while (total < length) {
+        ssize_t got = read(fd, bytes + total, length - total);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (got == 0) {
+            break;
+        }
+        total += (size_t)got;
+    }
+    return (ssize_t)total;
+}
+
+/**
+ * Move buffered records to the file (no fsync)
+ * A failed write is cut back off the file, so the records stay buffered and
+ * a later retry does not leave a torn record ahead of intact ones.
+ */
+static bool write_buffered(journal_t* journal) {
+    if (journal->num_buffered == 0) {
+        return true;
+    }
+    off_t intact_end = lseek(journal->fd, 0, SEEK_END);
+    if (intact_end < 0 || !write_all(journal->fd, journal->buffer,
+                                     (size_t)journal->num_buffered * sizeof(journal_record_t))) {
+        fprintf(stderr, "ERROR: Failed to write journal '%s'\n", journal->path);
+        if (intact_end >= 0 && ftruncate(journal->fd, intact_end) != 0) {
+            fprintf(stderr, "ERROR: Failed to truncate journal '%s'\n", journal->path);
+        }
+        return false;
+    }
+    journal->num_unsynced += journal->num_buffered;
+    journal->num_buffered = 0;
+    return true;
+}
+
+/**
+ * Write buffered records and make everything written so far durable
+ */
+static bool sync_journal(journal_t* journal) {
+    if (!write_buffered(journal)) {
+        return false;
+    }
+    if (journal->num_unsynced > 0 && fdatasync(journal->fd) != 0) {
+        fprintf(stderr, "ERROR: Failed to sync journal '%s'\n", journal->path);
+        return false;
+    }
+    journal->num_unsynced = 0;
+    return true;
+}
+
+long journal_replay(project_t* project, const char* path) {
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    journal_record_t* records = malloc(REPLAY_CHUNK_RECORDS * sizeof(journal_record_t));
+    if (records == NULL) {
+        printf("ERROR: Failed to allocate replay buffer. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    long applied = 0;
+    off_t valid_end = 0;
+    bool torn = false, foreign = false;
+    ssize_t got;
+
+    while (!torn && !foreign && (got = read_full(fd, records, REPLAY_CHUNK_RECORDS * sizeof(journal_record_t))) > 0) {
+        size_t count = (size_t)got / sizeof(journal_record_t);
+        torn = (size_t)got % sizeof(journal_record_t) != 0;
+
+        for (size_t i = 0; i < count; i++) {
+            const journal_record_t* record = &records[i];
+            if (record->magic == JOURNAL_FOREIGN_MAGIC) {
+                foreign = true;
+                break;
+            }
+            if (!record_valid(record)) {
+                torn = true;
+                break;
+            }
+            valid_end += (off_t)sizeof(journal_record_t);
+
+            if (record->sequence <= project->journal_sequence) {
+                continue; // Already contained in the snapshot
+            }
+            if (!apply_activity_update(project, record->activity_id, record->actual_duration,
+                                       record->actual_cost, record->completed != 0)) {
+                fprintf(stderr, "WARNING: %s: record %llu names unknown activity %hu, skipped\n",
+                        path, (unsigned long long)record->sequence, record->activity_id);
+            }
+            project->journal_sequence = record->sequence;
+            applied++;
+        }
+    }
+
+    if (foreign) {
+        // Costs in the other unit would be misread, and cutting them off would lose them
+        fprintf(stderr, "ERROR: %s: journal was written by a build of the other numeric mode "
+                "(PM_FIXED_POINT)\n", path);
+        applied = -1;
+    } else if (torn) {
+        // Anything after the last intact record was never acknowledged
+        fprintf(stderr, "WARNING: %s: discarding torn journal tail\n", path);
+        if (ftruncate(fd, valid_end) != 0) {
+            fprintf(stderr, "ERROR: Failed to truncate journal '%s'\n", path);
+            applied = -1;
+        }
+    }
+
+    free(records);
+    close(fd);
+    return applied;
+}
+
+journal_t* journal_open(const char* path, journal_sync_t policy, const char* snapshot_path) {
+    journal_t* journal = calloc(1, sizeof(journal_t));
+    if (journal == NULL) {
+        printf("ERROR: Failed to allocate journal. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    journal->fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    struct stat info;
+    if (journal->fd < 0 || fstat(journal->fd, &info) != 0) {
+        fprintf(stderr, "ERROR: Cannot open journal '%s'\n", path);
+        if (journal->fd >= 0) {
+            close(journal->fd);
+        }
+        free(journal);
+        return NULL;
+    }
+
+    snprintf(journal->path, sizeof(journal->path), "%s", path);
+    journal->policy = policy;
+    journal->group_size = JOURNAL_GROUP_SIZE;
+    journal->num_records = (long)(info.st_size / (off_t)sizeof(journal_record_t));
+    journal->snapshot_path = snapshot_path;
+    return journal;
+}
+
+bool journal_append(journal_t* journal, project_t* project, const activity_t* activity) {
+    if (journal->compaction_pid != 0) {
+        journal_poll_compaction(journal, false);
+    }
+
+    // The buffer only stays full after a failed write; never record past it
+    if (journal->num_buffered == JOURNAL_BUFFER_RECORDS && !write_buffered(journal)) {
+        return false;
+    }
+
+    journal_record_t* record = &journal->buffer[journal->num_buffered++];
+    memset(record, 0, sizeof(*record));
+    record->magic = JOURNAL_RECORD_MAGIC;
+    record->sequence = ++project->journal_sequence;
+    record->activity_id = activity->id;
+    record->actual_duration = activity->actual_duration;
+    record->actual_cost = activity->actual_cost;
+    record->completed = activity->completed ? 1 : 0;
+    record->checksum = record_checksum(record);
+    journal->num_records++;
+
+    bool ok = true;
+    switch (journal->policy) {
+        case JOURNAL_SYNC_ALWAYS:
+            ok = sync_journal(journal);
+            break;
+        case JOURNAL_SYNC_GROUP:
+            if (journal->num_buffered >= journal->group_size) {
+                ok = sync_journal(journal);
+            }
+            break;
+        case JOURNAL_SYNC_NONE:
+            break;
+    }
+    if (ok && journal->num_buffered == JOURNAL_BUFFER_RECORDS) {
+        ok = write_buffered(journal);
+    }
+
+    if (ok && !journal->compaction_held && journal->snapshot_path != NULL &&
+        journal->compaction_pid == 0 && journal->num_records >= JOURNAL_COMPACT_THRESHOLD) {
+        journal_compact(journal, project);
+    }
+    return ok;
+}
+
+void journal_compact_inline(journal_t* journal) {
+    journal->compaction_inline = true;
+}
+
+void journal_hold_compaction(journal_t* journal) {
+    journal->compaction_held = true;
+}
+
+void journal_release_compaction(journal_t* journal, const project_t* project) {
+    journal->compaction_held = false;
+    if (journal->snapshot_path != NULL && journal->compaction_pid == 0 &&
+        journal->num_records >= JOURNAL_COMPACT_THRESHOLD) {
+        journal_compact(journal, project);
+    }
+}
+
+bool journal_flush(journal_t* journal) {
+    return sync_journal(journal);
+}
+
+/**
+ * Replace the journal with only the records the new snapshot does not contain
+ */
+static bool rewrite_journal_tail(journal_t* journal) {
+    char temp_path[sizeof(journal->path) + 8];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", journal->path);
+
+    if (!sync_journal(journal)) {
+        return false;
+    }
+
+    int in = open(journal->path, O_RDONLY);
+    int out = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    journal_record_t* records = malloc(REPLAY_CHUNK_RECORDS * sizeof(journal_record_t));
+    bool ok = in >= 0 && out >= 0 && records != NULL;
+    long kept = 0;
+    ssize_t got;
+
+    while (ok && (got = read_full(in, records, REPLAY_CHUNK_RECORDS * sizeof(journal_record_t))) > 0) {
+        size_t count = (size_t)got / sizeof(journal_record_t);
+        size_t first = 0;
+        while (first < count && records[first].sequence <= journal->compaction_sequence) {
+            first++;
+        }
+        ok = write_all(out, &records[first], (count - first) * sizeof(journal_record_t));
+        kept += (long)(count - first);
+    }
+
+    ok = ok && fsync(out) == 0 && rename(temp_path, journal->path) == 0;
+    free(records);
+    if (in >= 0) {
+        close(in);
+    }
+    if (out >= 0) {
+        close(out);
+    }
+    if (!ok) {
+        remove(temp_path);
+        return false;
+    }
+
+    close(journal->fd);
+    journal->fd = open(journal->path, O_WRONLY | O_APPEND);
+    journal->num_records = kept;
+    return journal->fd >= 0;
+}
+
+bool journal_compact(journal_t* journal, const project_t* project) {
+    if (journal->snapshot_path == NULL || journal->compaction_pid != 0) {
+        return false;
+    }
+
+    // The rewrite later copies the surviving tail out of the file itself
+    if (!sync_journal(journal)) {
+        return false;
+    }
+
+    if (journal->compaction_inline) {
+        // Written by the caller: stdio and malloc are unsafe in a child
+        // forked from a threaded process
+        if (!save_snapshot(project, journal->snapshot_path)) {
+            fprintf(stderr, "WARNING: Journal compaction failed; journal kept in full\n");
+            return false;
+        }
+        journal->compaction_sequence = project->journal_sequence;
+        if (!rewrite_journal_tail(journal)) {
+            fprintf(stderr, "ERROR: Failed to rewrite journal '%s' after compaction\n", journal->path);
+        }
+        return true;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "WARNING: Cannot start journal compaction\n");
+        return false;
+    }
+    if (pid == 0) {
+        // Child: the forked address space is a frozen copy of the project
+        _exit(save_snapshot(project, journal->snapshot_path) ? 0 : 1);
+    }
+
+    journal->compaction_pid = pid;
+    journal->compaction_sequence = project->journal_sequence;
+    return true;
+}
+
+void journal_poll_compaction(journal_t* journal, bool wait) {
+    int status;
+
+    if (journal->compaction_pid == 0 ||
+        waitpid(journal->compaction_pid, &status, wait ? 0 : WNOHANG) != journal->compaction_pid) {
+        return;
+    }
+    journal->compaction_pid = 0;
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "WARNING: Journal compaction failed; journal kept in full\n");
+        return;
+    }
+    if (!rewrite_journal_tail(journal)) {
+        fprintf(stderr, "ERROR: Failed to rewrite journal '%s' after compaction\n", journal->path);
+    }
+}
+
+void journal_close(journal_t* journal) {
+    if (journal == NULL) {
+        return;
+    }
+    sync_journal(journal);
+    journal_poll_compaction(journal, true);
+    close(journal->fd);
+    free(journal);
+}
+
+bool journal_parse_policy(const char* name, journal_sync_t* policy) {
+    if (strcmp(name, "always") == 0) {
+        *policy = JOURNAL_SYNC_ALWAYS;
+    } else if (strcmp(name, "group") == 0) {
+        *policy = JOURNAL_SYNC_GROUP;
+    } else if (strcmp(name, "none") == 0) {
+        *policy = JOURNAL_SYNC_NONE;
+    } else {
+        return false;
+    }
+    return true;
+}
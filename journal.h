@@ -0,0 +1,184 @@
+/* journal.h */
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "a1_data_structures.h"
+#include <sys/types.h>
+
+// Records carry the numeric mode in their magic; each build refuses the other's
+#ifdef PM_FIXED_POINT
+#define JOURNAL_RECORD_MAGIC 0x434e524au   // "JRNC": costs in cents
+#define JOURNAL_FOREIGN_MAGIC 0x4c4e524au  // "JRNL": written by a float build
+#else
+#define JOURNAL_RECORD_MAGIC 0x4c4e524au   // "JRNL"
+#define JOURNAL_FOREIGN_MAGIC 0x434e524au  // "JRNC": written by a fixed-point build
+#endif
+#define JOURNAL_BUFFER_RECORDS 1024        // Records held in memory before a forced write
+
+// Tunables; override with -D at build time
+#ifndef JOURNAL_GROUP_SIZE
+#define JOURNAL_GROUP_SIZE 64              // Records per fsync under JOURNAL_SYNC_GROUP
+#endif
+#ifndef JOURNAL_COMPACT_THRESHOLD
+#define JOURNAL_COMPACT_THRESHOLD 100000   // Records after which a compaction is started
+#endif
+
+/**
+ * Journal Durability Policy
+ *
+ * - JOURNAL_SYNC_ALWAYS: write and fsync every record before returning
+ * - JOURNAL_SYNC_GROUP: fsync once per group_size records (group commit);
+ *   a crash can lose at most the last unsynced group
+ * - JOURNAL_SYNC_NONE: write when the buffer fills and leave flushing to the OS
+ */
+typedef enum {
+    JOURNAL_SYNC_ALWAYS,
+    JOURNAL_SYNC_GROUP,
+    JOURNAL_SYNC_NONE
+} journal_sync_t;
+
+/**
+ * Journal Record (32 bytes on disk)
+ *
+ * One activity update: the new actual values, exactly as passed to
+ * apply_activity_update. The checksum covers every field after it, so a
+ * record torn by a crash is detected and replay stops there.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t checksum;
+    uint64_t sequence;
+    money_t actual_cost;
+    unsigned short int activity_id;
+    unsigned short int actual_duration;
+    uint8_t completed;
+    uint8_t reserved[11 - sizeof(money_t)];  // 32 bytes in either numeric mode
+} journal_record_t;
+
+/**
+ * Journal Structure
+ *
+ * Append-only write-ahead log of activity updates. Appends only copy the
+ * record into an in-memory buffer; the sync policy decides when the buffer
+ * is written and fsynced.
+ *
+ * Fields:
+ * - fd/path: Open journal file (append mode)
+ * - policy/group_size: Durability policy, see journal_sync_t
+ * - buffer/num_buffered: Records not yet written to the file
+ * - num_unsynced: Records written but not yet fsynced
+ * - num_records: Records currently in the file (drives compaction)
+ * - snapshot_path: Snapshot rewritten by compaction (NULL disables it)
+ * - compaction_pid: Child process writing the snapshot, 0 if none running
+ * - compaction_sequence: Last sequence number captured by that snapshot
+ * - compaction_held: Appends do not start a compaction while set
+ * - compaction_inline: Compactions write the snapshot in the calling thread
+ */
+typedef struct {
+    int fd;
+    char path[4096];
+    journal_sync_t policy;
+    int group_size;
+    journal_record_t buffer[JOURNAL_BUFFER_RECORDS];
+    int num_buffered;
+    int num_unsynced;
+    long num_records;
+    const char* snapshot_path;
+    pid_t compaction_pid;
+    uint64_t compaction_sequence;
+    bool compaction_held;
+    bool compaction_inline;
+} journal_t;
+
+/**
+ * Re-apply journaled updates on top of a freshly loaded project
+ * Records with a sequence number at or below project->journal_sequence are
+ * already part of the project and are skipped. A torn or corrupt tail is
+ * cut off so later appends start from the last intact record.
+ * A missing journal file is not an error; one written by a build of the
+ * other numeric mode is, and is left untouched.
+ * @param project Project to update (snapshot or CSV state)
+ * @param path Journal file
+ * @return Number of records applied, or -1 after printing an error
+ */
+long journal_replay(project_t* project, const char* path);
+
+/**
+ * Open (creating if needed) a journal for appending
+ * Call journal_replay first so the project's sequence number is current.
+ * @param path Journal file
+ * @param policy Durability policy
+ * @param snapshot_path Snapshot to rewrite on compaction, or NULL
+ * @return Journal handle, or NULL after printing an error
+ */
+journal_t* journal_open(const char* path, journal_sync_t policy, const char* snapshot_path);
+
+/**
+ * Record an applied activity update
+ * Assigns the next sequence number and stores it in project->journal_sequence.
+ * Starts a background compaction when the journal grows past
+ * JOURNAL_COMPACT_THRESHOLD records.
+ * @param journal Journal to append to
+ * @param project Project the update was applied to
+ * @param activity Activity holding the new values
+ * @return true on success, false if the record could not be written (when
+ *         earlier records are still waiting for a failed write, the update
+ *         is not recorded at all)
+ */
+bool journal_append(journal_t* journal, project_t* project, const activity_t* activity);
+
+/**
+ * Write and fsync everything buffered so far, regardless of policy
+ * @return true on success
+ */
+bool journal_flush(journal_t* journal);
+
+/**
+ * Start a compaction: a forked child writes the current project to the
+ * snapshot while the parent keeps accepting updates. When the child has
+ * finished, journal_poll_compaction drops the records it captured.
+ * See journal_compact_inline for threaded callers.
+ * @return true if a compaction was started
+ */
+bool journal_compact(journal_t* journal, const project_t* project);
+
+/**
+ * Make compactions write the snapshot and trim the journal before returning
+ * instead of forking; required once the process has more than one thread,
+ * since a forked child may then only make async-signal-safe calls
+ */
+void journal_compact_inline(journal_t* journal);
+
+/**
+ * Stop appends from starting a compaction
+ * Used while the project's rollups lag behind its activities (batch
+ * updates), since a compaction would snapshot the stale totals.
+ */
+void journal_hold_compaction(journal_t* journal);
+
+/**
+ * Allow compactions again, starting one now if the journal has grown past
+ * the threshold in the meantime
+ * @param journal Journal to release
+ * @param project Project with up-to-date rollups
+ */
+void journal_release_compaction(journal_t* journal, const project_t* project);
+
+/**
+ * Finish a completed background compaction, if any
+ * @param wait Block until a running compaction finishes
+ */
+void journal_poll_compaction(journal_t* journal, bool wait);
+
+/**
+ * Flush, wait for any compaction and close the journal
+ */
+void journal_close(journal_t* journal);
+
+/**
+ * Parse a policy name ("always", "group", "none")
+ * @return true if the name was recognised
+ */
+bool journal_parse_policy(const char* name, journal_sync_t* policy);
+
+#endif
@@ -0,0 +1,171 @@
+/* kernels.c */
+#include "kernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define KERNEL_ISA "avx2"
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define KERNEL_ISA "sse2"
+#else
+#define KERNEL_ISA "scalar"
+#endif
+
+// 32-bit lanes take at most this many 16-bit adds before being widened
+#define USHORT_FLUSH_ELEMENTS 32768
+// Elements per block of split 32-bit sums: each lane adds a quarter of them,
+// and 16384 16-bit halves stay within a 32-bit lane
+#define INT32_FLUSH_ELEMENTS 65536
+
+const char* kernel_isa(void) {
+    return KERNEL_ISA;
+}
+
+float sum_floats(const float* values, int count) {
+    int i = 0;
+    float total = 0;
+
+#if defined(__AVX2__)
+    // Two accumulators hide the latency of dependent vector adds
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= count; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(values + i));
+        acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(values + i + 8));
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    float lanes[4];
+    _mm_storeu_ps(lanes, half);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_loadu_ps(values + i));
+        acc1 = _mm_add_ps(acc1, _mm_loadu_ps(values + i + 4));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+
+    for (; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+int64_t sum_int32s(const int32_t* values, int count) {
+    int i = 0;
+    int64_t total = 0;
+
+    // Integer adds are associative, so every lane split gives the exact total
+#if defined(__AVX2__)
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        // Sign-extend each group of four i32 values into i64 lanes
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(values + i))));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(values + i + 4))));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(acc0, acc1));
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE2__)
+    // SSE2 cannot sign-extend to 64 bits cheaply, so each value is split into
+    // an unsigned low and a signed high 16-bit half, summed in 32-bit lanes
+    // and widened once per block
+    const __m128i low_mask = _mm_set1_epi32(0xFFFF);
+    while (i + 8 <= count) {
+        int block_end = i + INT32_FLUSH_ELEMENTS < count ? i + INT32_FLUSH_ELEMENTS : count;
+        __m128i low = _mm_setzero_si128(), high = _mm_setzero_si128();
+        for (; i + 8 <= block_end; i += 8) {
+            __m128i v0 = _mm_loadu_si128((const __m128i*)(values + i));
+            __m128i v1 = _mm_loadu_si128((const __m128i*)(values + i + 4));
+            low = _mm_add_epi32(low, _mm_add_epi32(_mm_and_si128(v0, low_mask), _mm_and_si128(v1, low_mask)));
+            high = _mm_add_epi32(high, _mm_add_epi32(_mm_srai_epi32(v0, 16), _mm_srai_epi32(v1, 16)));
+        }
+        int32_t low_lanes[4], high_lanes[4];
+        _mm_storeu_si128((__m128i*)low_lanes, low);
+        _mm_storeu_si128((__m128i*)high_lanes, high);
+        for (int lane = 0; lane < 4; lane++) {
+            total += (int64_t)high_lanes[lane] * 65536 + low_lanes[lane];
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+int64_t sum_ushorts(const uint16_t* values, int count) {
+    int i = 0;
+    int64_t total = 0;
+
+#if defined(__AVX2__)
+    while (i + 16 <= count) {
+        int block_end = i + USHORT_FLUSH_ELEMENTS < count ? i + USHORT_FLUSH_ELEMENTS : count;
+        __m256i acc = _mm256_setzero_si256();
+        for (; i + 16 <= block_end; i += 16) {
+            // Zero-extend each group of eight u16 values into i32 lanes
+            acc = _mm256_add_epi32(acc, _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(values + i))));
+            acc = _mm256_add_epi32(acc, _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(values + i + 8))));
+        }
+        int32_t lanes[8];
+        _mm256_storeu_si256((__m256i*)lanes, acc);
+        for (int lane = 0; lane < 8; lane++) {
+            total += lanes[lane];
+        }
+    }
+#elif defined(__SSE2__)
+    while (i + 8 <= count) {
+        int block_end = i + USHORT_FLUSH_ELEMENTS < count ? i + USHORT_FLUSH_ELEMENTS : count;
+        __m128i acc = _mm_setzero_si128();
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= block_end; i += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(values + i));
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+        }
+        int32_t lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        total += (int64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+#endif
+
+    for (; i < count; i++) {
+        total += values[i];
+    }
+    return total;
+}
+
+int count_flags(const uint8_t* flags, int count) {
+    int i = 0;
+    int64_t total = 0;
+
+#if defined(__AVX2__)
+    // Sum of absolute differences against zero adds bytes into 64-bit lanes
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 32 <= count; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(flags + i));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, _mm256_setzero_si256()));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(flags + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(v, _mm_setzero_si128()));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    total = lanes[0] + lanes[1];
+#endif
+
+    for (; i < count; i++) {
+        total += flags[i];
+    }
+    return (int)total;
+}
@@ -0,0 +1,56 @@
+/* kernels.h */
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stdint.h>
+
+/**
+ * SUMMATION KERNELS
+ *
+ * Reductions over contiguous columns used by the rollups. The instruction
+ * set is chosen at compile time: AVX2 when built with -mavx2 (or
+ * -march=native on a capable CPU), otherwise SSE2 on x86-64, otherwise a
+ * portable scalar loop. All paths return identical integer results; float
+ * sums may differ in the last bits because lanes add in a different order.
+ */
+
+/**
+ * Name of the instruction set the kernels were compiled for
+ * @return "avx2", "sse2" or "scalar"
+ */
+const char* kernel_isa(void);
+
+/**
+ * Sum an array of floats
+ * @param values Array to sum
+ * @param count Number of elements
+ * @return Sum of all elements
+ */
+float sum_floats(const float* values, int count);
+
+/**
+ * Sum an array of signed 32-bit values (fixed-point money columns) in
+ * 64-bit accumulators, so the total cannot overflow
+ * @param values Array to sum
+ * @param count Number of elements
+ * @return Exact sum of all elements
+ */
+int64_t sum_int32s(const int32_t* values, int count);
+
+/**
+ * Sum an array of unsigned 16-bit values without overflow
+ * @param values Array to sum
+ * @param count Number of elements
+ * @return Exact sum of all elements
+ */
+int64_t sum_ushorts(const uint16_t* values, int count);
+
+/**
+ * Count the non-zero bytes of an array of 0/1 flags
+ * @param flags Array of flags, each 0 or 1
+ * @param count Number of elements
+ * @return Number of flags set
+ */
+int count_flags(const uint8_t* flags, int count);
+
+#endif
@@ -0,0 +1,659 @@
+/* loader.c */
+#include "loader.h"
+#include "a1_functions.h"
+#include "journal.h"
+#include "schedule.h"
+#include "history.h"
+#include "watchlist.h"
+#include <string.h>
+
+#define MAX_FIELDS 8
+
+/**
+ * Outcome of streaming a file line by line
+ */
+typedef enum {
+    STREAM_DONE,            // Every line was handled
+    STREAM_STOPPED,         // The line handler returned false
+    STREAM_LINE_TOO_LONG,   // A line did not fit in one block
+    STREAM_READ_ERROR
+} stream_status_t;
+
+/**
+ * Dependency waiting for the end of the file, with its line for diagnostics
+ */
+typedef struct {
+    dependency_t dependency;
+    long line;
+} pending_dependency_t;
+
+/**
+ * Parser state carried across lines and blocks
+ *
+ * Fields:
+ * - path/line: Position reported in diagnostics
+ * - project: Project being built (NULL until the project line is read)
+ * - milestone_index: Milestone currently receiving activities (-1 before the first)
+ * - activity_index: Next free activity slot in that milestone
+ * - pending: Locations of items declared with ID 0, assigned once all
+ *   explicit IDs are known so an auto-assigned ID never steals a later one
+ * - dependencies: Declared dependencies with their lines, resolved at the
+ *   end because they may name activities that appear further down
+ */
+typedef struct {
+    const char* path;
+    long line;
+    project_t* project;
+    int milestone_index;
+    int activity_index;
+    id_location_t* pending;
+    int num_pending;
+    int pending_capacity;
+    pending_dependency_t* dependencies;
+    int num_dependencies;
+    int dependency_capacity;
+} load_state_t;
+
+/**
+ * Print a diagnostic for the current line
+ * @return Always false so callers can `return load_error(...)`
+ */
+static bool load_error(const load_state_t* state, const char* message) {
+    fprintf(stderr, "ERROR: %s:%ld: %s\n", state->path, state->line, message);
+    return false;
+}
+
+/**
+ * Parse a decimal integer in [0, max] with no sign or trailing characters
+ */
+static bool parse_uint(const char* text, unsigned long max, unsigned long* out) {
+    unsigned long value = 0;
+
+    if (*text == '\0') {
+        return false;
+    }
+    for (; *text; text++) {
+        if (*text < '0' || *text > '9') {
+            return false;
+        }
+        value = value * 10 + (unsigned long)(*text - '0');
+        if (value > max) {
+            return false;
+        }
+    }
+
+    *out = value;
+    return true;
+}
+
+/**
+ * Parse a non-negative amount of dollars, at most ACTIVITY_MAX_DOLLARS, with
+ * no trailing characters
+ * Read as a double so fixed-point builds round to the intended cent.
+ */
+static bool parse_cost(const char* text, money_t* out) {
+    char* end;
+    double value = strtod(text, &end);
+
+    if (end == text || *end != '\0' || !(value >= 0 && value <= ACTIVITY_MAX_DOLLARS)) {
+        return false;
+    }
+    *out = money_from_dollars(value);
+    return true;
+}
+
+/**
+ * Split a line on commas in place
+ * @return Number of fields found (at most MAX_FIELDS + 1 to flag excess)
+ */
+static int split_fields(char* line, char* fields[]) {
+    int count = 0;
+
+    fields[count++] = line;
+    for (char* c = line; *c; c++) {
+        if (*c == ',') {
+            *c = '\0';
+            if (count > MAX_FIELDS) {
+                return count;
+            }
+            fields[count++] = c + 1;
+        }
+    }
+    return count;
+}
+
+/**
+ * Register an explicit ID, or queue the item for auto-assignment if it is 0
+ */
+static bool claim_id(load_state_t* state, unsigned short int id,
+                     int milestone_index, int activity_index) {
+    id_manager_t* manager = state->project->id_manager;
+
+    if (id == 0) {
+        if (state->num_pending == state->pending_capacity) {
+            int capacity = state->pending_capacity ? state->pending_capacity * 2 : 64;
+            id_location_t* grown = realloc(state->pending, (size_t)capacity * sizeof(id_location_t));
+            if (grown == NULL) {
+                return load_error(state, "out of memory");
+            }
+            state->pending = grown;
+            state->pending_capacity = capacity;
+        }
+        state->pending[state->num_pending].milestone_index = milestone_index;
+        state->pending[state->num_pending].activity_index = activity_index;
+        state->num_pending++;
+        return true;
+    }
+
+    if (!add_id(id, manager)) {
+        return load_error(state, "duplicate ID");
+    }
+    set_id_location(manager, id, milestone_index, activity_index);
+    return true;
+}
+
+/**
+ * Check that the current milestone received every activity it declared
+ */
+static bool milestone_filled(const load_state_t* state) {
+    if (state->milestone_index < 0) {
+        return true;
+    }
+    const milestone_t* milestone = &state->project->milestone_list[state->milestone_index];
+    if (state->activity_index != milestone->num_activities) {
+        return load_error(state, "milestone has fewer activity lines than declared");
+    }
+    return true;
+}
+
+static bool handle_project(load_state_t* state, char* fields[], int count) {
+    unsigned long num_milestones;
+
+    if (state->project != NULL) {
+        return load_error(state, "duplicate project line");
+    }
+    if (count != 3 || !parse_uint(fields[2], 65535, &num_milestones)) {
+        return load_error(state, "expected project,<name>,<num_milestones>");
+    }
+
+    state->project = create_project();
+    strncpy(state->project->name, fields[1], 99);
+    state->project->name[99] = '\0';
+    state->project->num_milestones = (int)num_milestones;
+    state->project->milestone_list = create_milestone_array(state->project->arena, (int)num_milestones);
+    return true;
+}
+
+static bool handle_milestone(load_state_t* state, char* fields[], int count) {
+    unsigned long id, num_activities;
+
+    if (state->project == NULL) {
+        return load_error(state, "milestone before project line");
+    }
+    if (count != 4 || !parse_uint(fields[1], 65535, &id) ||
+        !parse_uint(fields[3], 65535, &num_activities)) {
+        return load_error(state, "expected milestone,<id>,<name>,<num_activities>");
+    }
+    if (!milestone_filled(state)) {
+        return false;
+    }
+    if (state->milestone_index + 1 >= state->project->num_milestones) {
+        return load_error(state, "more milestones than declared on the project line");
+    }
+
+    state->milestone_index++;
+    state->activity_index = 0;
+
+    milestone_t* milestone = &state->project->milestone_list[state->milestone_index];
+    milestone->id = (unsigned short int)id;
+    set_milestone_name(state->project, milestone, fields[2]);
+    milestone->num_activities = (int)num_activities;
+    milestone->activity_list = create_activity_array(state->project->arena, (int)num_activities);
+
+    return claim_id(state, milestone->id, state->milestone_index, NO_INDEX);
+}
+
+static bool handle_activity(load_state_t* state, char* fields[], int count) {
+    unsigned long id, planned_hours, actual_hours = 0, completed = 0;
+    money_t planned_cost, actual_cost = 0;
+
+    if (state->milestone_index < 0) {
+        return load_error(state, "activity before any milestone line");
+    }
+    if ((count != 5 && count != 8) ||
+        !parse_uint(fields[1], 65535, &id) ||
+        !parse_uint(fields[3], 65535, &planned_hours) ||
+        !parse_cost(fields[4], &planned_cost) ||
+        (count == 8 && (!parse_uint(fields[5], 65535, &actual_hours) ||
+                        !parse_cost(fields[6], &actual_cost) ||
+                        !parse_uint(fields[7], 1, &completed)))) {
+        return load_error(state, "expected activity,<id>,<name>,<planned_hours>,<planned_cost>"
+                                 "[,<actual_hours>,<actual_cost>,<completed>]");
+    }
+
+    milestone_t* milestone = &state->project->milestone_list[state->milestone_index];
+    if (state->activity_index >= milestone->num_activities) {
+        return load_error(state, "more activities than declared on the milestone line");
+    }
+
+    activity_t* activity = &milestone->activity_list[state->activity_index];
+    activity->id = (unsigned short int)id;
+    set_activity_name(state->project, activity, fields[2]);
+    activity->planned_duration = (unsigned short int)planned_hours;
+    activity->planned_cost = planned_cost;
+    activity->actual_duration = (unsigned short int)actual_hours;
+    activity->actual_cost = actual_cost;
+    activity->completed = completed == 1;
+
+    return claim_id(state, activity->id, state->milestone_index, state->activity_index++);
+}
+
+/**
+ * A dep record may list any number of predecessors, so it is walked field by
+ * field in place rather than split into a fixed field array
+ * @param rest The line after "dep": empty or starting with a comma
+ */
+static bool handle_dependency(load_state_t* state, char* rest) {
+    static const char USAGE[] = "expected dep,<activity_id>,<predecessor_id>[,<predecessor_id>...]"
+                                " with explicit IDs";
+    unsigned long activity_id, predecessor_id;
+
+    if (state->project == NULL) {
+        return load_error(state, "dependency before project line");
+    }
+    char* field = rest + 1;
+    char* next = *rest == ',' ? strchr(field, ',') : NULL;
+    if (next == NULL) {
+        return load_error(state, USAGE);
+    }
+    *next = '\0';
+    if (!parse_uint(field, 65535, &activity_id) || activity_id == 0) {
+        return load_error(state, USAGE);
+    }
+
+    while (next != NULL) {
+        field = next + 1;
+        next = strchr(field, ',');
+        if (next != NULL) {
+            *next = '\0';
+        }
+        if (!parse_uint(field, 65535, &predecessor_id) || predecessor_id == 0) {
+            return load_error(state, USAGE);
+        }
+        if (state->num_dependencies == state->dependency_capacity) {
+            int capacity = state->dependency_capacity ? state->dependency_capacity * 2 : 64;
+            pending_dependency_t* grown = realloc(state->dependencies,
+                                                  (size_t)capacity * sizeof(pending_dependency_t));
+            if (grown == NULL) {
+                return load_error(state, "out of memory");
+            }
+            state->dependencies = grown;
+            state->dependency_capacity = capacity;
+        }
+        pending_dependency_t* pending = &state->dependencies[state->num_dependencies++];
+        pending->dependency.activity = (unsigned short int)activity_id;
+        pending->dependency.predecessor = (unsigned short int)predecessor_id;
+        pending->line = state->line;
+    }
+    return true;
+}
+
+/**
+ * Dispatch one complete line (already NUL-terminated, newline stripped)
+ */
+static bool handle_project_line(void* context, char* line) {
+    load_state_t* state = context;
+    char* fields[MAX_FIELDS + 1];
+    size_t length = strlen(line);
+
+    state->line++;
+    if (length > 0 && line[length - 1] == '\r') {
+        line[--length] = '\0';
+    }
+    if (length == 0 || line[0] == '#') {
+        return true;
+    }
+
+    if (strncmp(line, "dep", 3) == 0 && (line[3] == ',' || line[3] == '\0')) {
+        return handle_dependency(state, line + 3);
+    }
+
+    int count = split_fields(line, fields);
+    if (count > MAX_FIELDS) {
+        return load_error(state, "too many fields");
+    }
+
+    if (strcmp(fields[0], "activity") == 0) {
+        return handle_activity(state, fields, count);
+    }
+    if (strcmp(fields[0], "milestone") == 0) {
+        return handle_milestone(state, fields, count);
+    }
+    if (strcmp(fields[0], "project") == 0) {
+        return handle_project(state, fields, count);
+    }
+    return load_error(state, "unknown record type");
+}
+
+/**
+ * Hand out IDs to every item that was declared with ID 0
+ */
+static bool assign_pending_ids(load_state_t* state) {
+    project_t* project = state->project;
+
+    for (int i = 0; i < state->num_pending; i++) {
+        const id_location_t* location = &state->pending[i];
+        unsigned short int id = allocate_id(project->id_manager);
+        if (id == NO_FREE_ID) {
+            return load_error(state, "ran out of IDs while auto-assigning");
+        }
+
+        // Names were interned at parse time; the owner needs the real ID
+        milestone_t* milestone = &project->milestone_list[location->milestone_index];
+        if (location->activity_index == NO_INDEX) {
+            milestone->id = id;
+            name_add_owner(project->names, milestone->name, id);
+        } else {
+            activity_t* activity = &milestone->activity_list[location->activity_index];
+            activity->id = id;
+            name_add_owner(project->names, activity->name, id);
+        }
+        set_id_location(project->id_manager, id, location->milestone_index, location->activity_index);
+    }
+    return true;
+}
+
+/**
+ * Check every declared dependency against the finished project and build
+ * the schedule; diagnostics name the line that declared the dependency
+ */
+static bool resolve_dependencies(load_state_t* state) {
+    project_t* project = state->project;
+
+    for (int i = 0; i < state->num_dependencies; i++) {
+        const pending_dependency_t* pending = &state->dependencies[i];
+        state->line = pending->line;
+        if (find_activity_by_id(project, pending->dependency.activity, NULL) == NULL ||
+            find_activity_by_id(project, pending->dependency.predecessor, NULL) == NULL) {
+            return load_error(state, "dependency names an ID that is not an activity");
+        }
+        if (pending->dependency.activity == pending->dependency.predecessor) {
+            return load_error(state, "activity depends on itself");
+        }
+        append_dependency(project, pending->dependency);
+    }
+    if (!schedule_refresh(project)) {
+        fprintf(stderr, "ERROR: %s: dependencies contain a cycle\n", state->path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Feed every line of a file to a handler, reading LOADER_BLOCK_SIZE blocks
+ * Lines are NUL-terminated in place with the newline removed.
+ * @param file File to read
+ * @param handle Called once per line; returning false stops the stream
+ * @param context Passed through to the handler
+ * @return How the stream ended
+ */
+static stream_status_t stream_lines(FILE* file, bool (*handle)(void* context, char* line), void* context) {
+    char* buffer = malloc(LOADER_BLOCK_SIZE + 1);
+    if (buffer == NULL) {
+        printf("ERROR: Failed to allocate loader buffer. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    stream_status_t status = STREAM_DONE;
+    size_t carry = 0;  // Bytes of an unfinished line kept from the previous block
+    while (status == STREAM_DONE) {
+        size_t read = fread(buffer + carry, 1, LOADER_BLOCK_SIZE - carry, file);
+        size_t length = carry + read;
+        char* start = buffer;
+        char* end = buffer + length;
+        char* newline;
+
+        while (status == STREAM_DONE && (newline = memchr(start, '\n', (size_t)(end - start))) != NULL) {
+            *newline = '\0';
+            if (!handle(context, start)) {
+                status = STREAM_STOPPED;
+            }
+            start = newline + 1;
+        }
+        carry = (size_t)(end - start);
+
+        if (read == 0) {
+            // End of file: a final line may lack its newline
+            if (status == STREAM_DONE && carry > 0) {
+                start[carry] = '\0';
+                if (!handle(context, start)) {
+                    status = STREAM_STOPPED;
+                }
+            }
+            break;
+        }
+        if (carry == LOADER_BLOCK_SIZE) {
+            status = STREAM_LINE_TOO_LONG;
+        }
+        memmove(buffer, start, carry);
+    }
+
+    if (status == STREAM_DONE && ferror(file)) {
+        status = STREAM_READ_ERROR;
+    }
+    free(buffer);
+    return status;
+}
+
+project_t* load_project_csv(const char* path) {
+    load_state_t state = { path, 0, NULL, -1, 0, NULL, 0, 0, NULL, 0, 0 };
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: Cannot open project file '%s'\n", path);
+        return NULL;
+    }
+
+    bool ok = true;
+    switch (stream_lines(file, handle_project_line, &state)) {
+        case STREAM_DONE:
+            break;
+        case STREAM_STOPPED:
+            ok = false;  // Already reported
+            break;
+        case STREAM_LINE_TOO_LONG:
+            ok = load_error(&state, "line too long");
+            break;
+        case STREAM_READ_ERROR:
+            ok = load_error(&state, "read error");
+            break;
+    }
+    if (ok && state.project == NULL) {
+        ok = load_error(&state, "missing project line");
+    }
+    if (ok) {
+        ok = milestone_filled(&state);
+    }
+    if (ok && state.milestone_index + 1 != state.project->num_milestones) {
+        ok = load_error(&state, "fewer milestone lines than declared on the project line");
+    }
+    if (ok) {
+        ok = assign_pending_ids(&state);
+    }
+    if (ok && state.num_dependencies > 0) {
+        ok = resolve_dependencies(&state);
+    }
+
+    if (!ok && state.project != NULL) {
+        free_project(state.project);
+        state.project = NULL;
+    }
+
+    free(state.pending);
+    free(state.dependencies);
+    fclose(file);
+    return state.project;
+}
+
+// =============================================================================
+// BATCH UPDATES
+// =============================================================================
+
+/**
+ * Batch state carried across lines and blocks
+ *
+ * Fields:
+ * - path/line: Position reported in diagnostics
+ * - project/journal: Target of the updates (journal may be NULL)
+ * - touched: Per-milestone flag, set once the milestone has a change
+ * - touched_list: Indices of the touched milestones, in first-touch order
+ * - result: Counters reported back to the caller
+ */
+typedef struct {
+    const char* path;
+    long line;
+    project_t* project;
+    journal_t* journal;
+    bool* touched;
+    int* touched_list;
+    batch_result_t* result;
+} batch_state_t;
+
+/**
+ * Report a rejected record and keep going
+ * @return Always true so the stream continues with the next line
+ */
+static bool batch_reject(const batch_state_t* state, const char* message) {
+    fprintf(stderr, "ERROR: %s:%ld: %s\n", state->path, state->line, message);
+    state->result->rejected++;
+    return true;
+}
+
+/**
+ * Apply one update record to the activity records and columns only
+ */
+static bool handle_batch_line(void* context, char* line) {
+    batch_state_t* state = context;
+    char* fields[MAX_FIELDS + 1];
+    unsigned long id, actual_hours, completed;
+    money_t actual_cost;
+    size_t length = strlen(line);
+
+    state->line++;
+    if (length > 0 && line[length - 1] == '\r') {
+        line[--length] = '\0';
+    }
+    if (length == 0 || line[0] == '#') {
+        return true;
+    }
+
+    int count = split_fields(line, fields);
+    if (count != 4 ||
+        !parse_uint(fields[0], 65535, &id) ||
+        !parse_uint(fields[1], 65535, &actual_hours) ||
+        !parse_cost(fields[2], &actual_cost) ||
+        !parse_uint(fields[3], 1, &completed)) {
+        return batch_reject(state, "expected <id>,<actual_hours>,<actual_cost>,<completed>");
+    }
+
+    milestone_t* milestone = NULL;
+    activity_t* activity = find_activity_by_id(state->project, (unsigned short int)id, &milestone);
+    if (activity == NULL) {
+        return batch_reject(state, "no activity with this ID");
+    }
+
+    activity->actual_duration = (unsigned short int)actual_hours;
+    activity->actual_cost = actual_cost;
+    activity->completed = completed == 1;
+    refresh_activity_columns(milestone, activity);
+    watch_activity(state->project->watchlist, activity);
+    state->result->applied++;
+
+    int milestone_index = (int)(milestone - state->project->milestone_list);
+    if (!state->touched[milestone_index]) {
+        state->touched[milestone_index] = true;
+        state->touched_list[state->result->milestones_touched++] = milestone_index;
+    }
+
+    if (state->journal != NULL && !journal_append(state->journal, state->project, activity)) {
+        fprintf(stderr, "ERROR: %s:%ld: update applied but could not be journaled, stopping\n",
+                state->path, state->line);
+        return false;
+    }
+    return true;
+}
+
+bool apply_update_batch(project_t* project, const char* path, journal_t* journal,
+                        batch_result_t* result) {
+    bool use_stdin = strcmp(path, "-") == 0;
+    batch_state_t state = { use_stdin ? "<stdin>" : path, 0, project, journal, NULL, NULL, result };
+
+    memset(result, 0, sizeof(*result));
+    FILE* file = use_stdin ? stdin : fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: Cannot open batch file '%s'\n", path);
+        return false;
+    }
+
+    state.touched = calloc((size_t)project->num_milestones + 1, sizeof(bool));
+    state.touched_list = malloc(((size_t)project->num_milestones + 1) * sizeof(int));
+    if (state.touched == NULL || state.touched_list == NULL) {
+        printf("ERROR: Failed to allocate batch state. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Rollups lag behind the records until the end, so no snapshot meanwhile
+    if (journal != NULL) {
+        journal_hold_compaction(journal);
+    }
+
+    bool ok = true;
+    switch (stream_lines(file, handle_batch_line, &state)) {
+        case STREAM_DONE:
+            break;
+        case STREAM_STOPPED:
+            ok = false;  // Already reported
+            break;
+        case STREAM_LINE_TOO_LONG:
+            fprintf(stderr, "ERROR: %s:%ld: line too long\n", state.path, state.line + 1);
+            ok = false;
+            break;
+        case STREAM_READ_ERROR:
+            fprintf(stderr, "ERROR: %s: read error\n", state.path);
+            ok = false;
+            break;
+    }
+
+    // One deferred rollup (with its history row and watchlist re-rank) per
+    // touched milestone, then one for the project; this also runs after a
+    // failure so applied updates are never left unrolled
+    for (int i = 0; i < result->milestones_touched; i++) {
+        update_milestone(&project->milestone_list[state.touched_list[i]]);
+        history_record(project->history, &project->milestone_list[state.touched_list[i]]);
+        watch_milestone(project->watchlist, &project->milestone_list[state.touched_list[i]]);
+    }
+    update_project(project);
+
+    // One schedule rebuild as well; cheaper than following every record
+    schedule_invalidate(project->schedule);
+    schedule_refresh(project);
+
+#ifdef PM_VERIFY_ROLLUPS
+    if (!verify_rollups(project)) {
+        fprintf(stderr, "ROLLUP VERIFICATION FAILED after batch %s\n", state.path);
+        abort();
+    }
+#endif
+
+    if (journal != NULL) {
+        ok = journal_flush(journal) && ok;
+        journal_release_compaction(journal, project);
+    }
+
+    free(state.touched);
+    free(state.touched_list);
+    if (!use_stdin) {
+        fclose(file);
+    }
+    return ok;
+}
@@ -0,0 +1,83 @@
+/* loader.h */
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "a1_data_structures.h"
+#include "journal.h"
+
+// Size of each block read from the project file
+#define LOADER_BLOCK_SIZE (1 << 20)
+
+/**
+ * PROJECT FILE FORMAT (CSV, one record per line)
+ *
+ *   project,<name>,<num_milestones>
+ *   milestone,<id>,<name>,<num_activities>
+ *   activity,<id>,<name>,<planned_hours>,<planned_cost>[,<actual_hours>,<actual_cost>,<completed>]
+ *   dep,<activity_id>,<predecessor_id>[,<predecessor_id>...]
+ *
+ * - The project line comes first; each milestone line is followed by exactly
+ *   <num_activities> activity lines belonging to it
+ * - An ID of 0 is auto-assigned, any other ID must be unique project-wide
+ * - Names may contain spaces but not commas; <completed> is 0 or 1
+ * - A dep line may appear anywhere after the project line and says the
+ *   activity starts only after each listed predecessor has finished; both
+ *   must be activities with explicit IDs, and cycles are rejected
+ * - Blank lines and lines starting with '#' are ignored
+ *
+ * Declared counts let every array be allocated once at its final size.
+ */
+
+/**
+ * Load a project from a CSV project file without any prompts
+ * The file is streamed in LOADER_BLOCK_SIZE blocks and parsed in place.
+ * Milestone and project rollups are NOT computed; callers run
+ * update_milestone/update_project once afterwards.
+ * @param path Path of the file to read
+ * @return Newly created project, or NULL after printing a diagnostic
+ *         (file:line: message) to stderr
+ */
+project_t* load_project_csv(const char* path);
+
+/**
+ * UPDATE BATCH FORMAT (CSV, one record per line)
+ *
+ *   <activity_id>,<actual_hours>,<actual_cost>,<completed>
+ *
+ * - Each record sets an activity's actual values, like one pass through the
+ *   update menu; later records for the same activity win
+ * - <completed> is 0 or 1
+ * - Blank lines and lines starting with '#' are ignored
+ */
+
+/**
+ * Batch Result
+ *
+ * - applied: Records applied to the project
+ * - rejected: Records skipped because they were malformed or named no activity
+ * - milestones_touched: Milestones re-rolled up at the end of the batch
+ */
+typedef struct {
+    long applied;
+    long rejected;
+    int milestones_touched;
+} batch_result_t;
+
+/**
+ * Apply a stream of activity updates with one deferred rollup
+ * Records are streamed in LOADER_BLOCK_SIZE blocks; each one is resolved
+ * through the ID index and written to the activity record and columns
+ * only. Once the stream ends, every touched milestone is rolled up once
+ * and the project once. Invalid records are reported (file:line: message)
+ * and skipped without stopping the batch.
+ * @param project Project with established rollups
+ * @param path Batch file, or "-" for standard input
+ * @param journal Journal receiving every applied record, or NULL
+ * @param result Receives the record counts
+ * @return false if the file could not be read to the end or the journal
+ *         failed; updates applied before that point are still rolled up
+ */
+bool apply_update_batch(project_t* project, const char* path, journal_t* journal,
+                        batch_result_t* result);
+
+#endif
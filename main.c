@@ -1,291 +1,1155 @@
-/* main.c */
-#include "a1_functions.h"
-#include <stdio.h>
-#include <string.h>
-
-/**
- * PROJECT MANAGEMENT SYSTEM
- * 
- * This program implements a hierarchical project management system with:
- * - Projects containing multiple Milestones
- * - Milestones containing multiple Activities  
- * - Unified ID management to ensure uniqueness
- * - Cost and time tracking with variance analysis
- * - Dynamic memory allocation for scalability
- * 
- * Program Flow:
- * 1. Initialize project with user-defined structure
- * 2. Set up milestones and activities with unique IDs
- * 3. Enter main loop for activity updates and reporting
- * 4. Clean up all allocated memory on exit
- */
-
-/**
- * Find activity by ID across all milestones
- * 
- * Helper function to locate an activity by its unique ID.
- * Searches through all milestones and their activities.
- * 
- * @param project Project to search in
- * @param activity_id ID of activity to find
- * @param milestone_out Output parameter for containing milestone
- * @return Pointer to activity if found, NULL otherwise
- */
-activity_t* find_activity_by_id(project_t* project, unsigned short int activity_id, milestone_t** milestone_out) {
-    for (int i = 0; i < project->num_milestones; i++) {
-        milestone_t* milestone = &project->milestone_list[i];
-        for (int j = 0; j < milestone->num_activities; j++) {
-            if (milestone->activity_list[j].id == activity_id) {
-                if (milestone_out) {
-                    *milestone_out = milestone;
-                }
-                return &milestone->activity_list[j];
-            }
-        }
-    }
-    return NULL;
-}
-
-/**
- * Display all incomplete activities with their IDs
- * 
- * Searches through all milestones and activities to find incomplete ones.
- * Returns the count of incomplete activities found.
- * 
- * @param project Project to search for incomplete activities
- * @return Number of incomplete activities found
- */
-int display_incomplete_activities(const project_t* project) {
-    int incomplete_count = 0;
-    
-    printf("\nINCOMPLETE ACTIVITIES:\n");
-    printf("----------------------------------------\n");
-    
-    for (int i = 0; i < project->num_milestones; i++) {
-        const milestone_t* milestone = &project->milestone_list[i];
-        for (int j = 0; j < milestone->num_activities; j++) {
-            const activity_t* activity = &milestone->activity_list[j];
-            if (!activity->completed) {
-                printf("ID: %hu | %s (in milestone: %s)\n", 
-                       activity->id, activity->name, milestone->name);
-                incomplete_count++;
-            }
-        }
-    }
-    
-    if (incomplete_count == 0) {
-        printf("All activities are completed!\n");
-    }
-    
-    return incomplete_count;
-}
-
-/**
- * Get unique ID from user with validation
- * 
- * Continuously prompts user until a unique ID is provided.
- * Uses the project's ID manager to check uniqueness.
- * 
- * @param project Project containing ID manager
- * @param item_type Description of item (e.g., "milestone", "activity")
- * @param item_number Item number for display purposes
- * @return Unique validated ID
- */
-unsigned short int get_unique_id(project_t* project, const char* item_type, int item_number) {
-    unsigned short int id;
-    
-    do {
-        printf("Enter unique ID for %s %d: ", item_type, item_number);
-        id = get_input_usi();
-        
-        if (!is_id_unique(id, project->id_manager)) {
-            printf("ID %hu is already in use. Please enter a different ID.\n", id);
-        }
-    } while (!is_id_unique(id, project->id_manager));
-    
-    // Add the ID to the manager
-    if (!add_id(id, project->id_manager)) {
-        printf("ERROR: Failed to register ID. Exiting...\n");
-        exit(EXIT_FAILURE);
-    }
-    
-    return id;
-}
-
-int main(void) {
-    printf("WELCOME TO THE PROJECT MANAGEMENT SYSTEM!\n");
-    printf("============================================================\n");
-    
-    // =========================================================================
-    // PROJECT INITIALIZATION
-    // =========================================================================
-    
-    // Get project name with improved input handling
-    char project_name[100];
-    printf("Enter project name: ");
-    
-    // Clear any residual input and get project name
-    while (getchar() != '\n'); // Clear buffer
-    if (fgets(project_name, sizeof(project_name), stdin)) {
-        // Remove newline character if present
-        project_name[strcspn(project_name, "\n")] = '\0';
-    }
-    
-    project_t* project = init_project(project_name);
-    printf("\nProject '%s' created successfully!\n", project->name);
-    
-    // =========================================================================
-    // MILESTONE AND ACTIVITY SETUP
-    // =========================================================================
-    
-    printf("\nSetting up %d milestone(s)...\n", project->num_milestones);
-    
-    for (int i = 0; i < project->num_milestones; i++) {
-        milestone_t* milestone = &project->milestone_list[i];
-        
-        printf("\nMILESTONE %d SETUP\n", i + 1);
-        printf("-------------------------\n");
-        
-        // Get unique milestone ID
-        milestone->id = get_unique_id(project, "milestone", i + 1);
-        
-        // Get milestone name
-        printf("Enter name for milestone %d: ", i + 1);
-        scanf("%99s", milestone->name); // Prevent buffer overflow
-        
-        // Initialize milestone (creates activity array)
-        init_milestone(milestone);
-        
-        // =====================================================================
-        // ACTIVITY SETUP FOR THIS MILESTONE
-        // =====================================================================
-        
-        printf("\nSetting up %d activity/activities for milestone '%s':\n", 
-               milestone->num_activities, milestone->name);
-        
-        for (int j = 0; j < milestone->num_activities; j++) {
-            activity_t* activity = &milestone->activity_list[j];
-            
-            printf("\n  Activity %d/%d:\n", j + 1, milestone->num_activities);
-            
-            // Get unique activity ID
-            activity->id = get_unique_id(project, "activity", j + 1);
-            
-            // Get activity name
-            printf("  Enter name for activity %d: ", j + 1);
-            scanf("%99s", activity->name); // Prevent buffer overflow
-            
-            // Initialize activity with planned values
-            init_activity(activity);
-            
-            printf("  Activity '%s' (ID: %hu) created successfully!\n", 
-                   activity->name, activity->id);
-        }
-        
-        printf("\nMilestone '%s' setup complete!\n", milestone->name);
-    }
-    
-    printf("\nProject setup complete! Ready for activity tracking.\n");
-    
-    // =========================================================================
-    // MAIN APPLICATION LOOP
-    // =========================================================================
-    
-    int choice;
-    do {
-        print_main_menu();
-        choice = get_input_usi();
-        
-        switch (choice) {
-            case 1: {
-                // UPDATE ACTIVITY WORKFLOW
-                printf("\nUPDATE ACTIVITY WORKFLOW\n");
-                printf("===================================\n");
-                
-                // Display incomplete activities and get count
-                int incomplete_count = display_incomplete_activities(project);
-                
-                if (incomplete_count == 0) {
-                    printf("\nCongratulations! All activities are completed!\n");
-                    break;
-                }
-                
-                // Get activity ID to update
-                printf("\nEnter ID of activity to update (0 to cancel): ");
-                unsigned short int update_id = get_input_usi();
-                
-                if (update_id == 0) {
-                    printf("Update cancelled.\n");
-                    break;
-                }
-                
-                // Find the activity and its containing milestone
-                milestone_t* containing_milestone = NULL;
-                activity_t* activity = find_activity_by_id(project, update_id, &containing_milestone);
-                
-                if (activity == NULL) {
-                    printf("Activity with ID %hu not found.\n", update_id);
-                    break;
-                }
-                
-                if (activity->completed) {
-                    printf("Activity '%s' is already completed.\n", activity->name);
-                    break;
-                }
-                
-                // Update the activity
-                printf("\nUpdating activity: %s\n", activity->name);
-                update_activity(activity);
-                
-                // Propagate updates up the hierarchy
-                update_milestone(containing_milestone);
-                update_project(project);
-                
-                printf("\nActivity and related milestones updated successfully!\n");
-                
-                // Check if milestone or project just became complete
-                if (containing_milestone->completed) {
-                    printf("Milestone '%s' is now COMPLETE!\n", containing_milestone->name);
-                }
-                
-                if (project->completed) {
-                    printf("PROJECT '%s' IS NOW COMPLETE!\n", project->name);
-                }
-                
-                break;
-            }
-            
-            case 2:
-                // PRINT STATISTICS
-                print_project_stats(project);
-                break;
-                
-            case 3:
-                // EXIT
-                printf("\nThank you for using the Project Management System!\n");
-                printf("Cleaning up and exiting...\n");
-                break;
-                
-            default:
-                printf("Invalid choice. Please select 1, 2, or 3.\n");
-        }
-        
-        // Add pause for better user experience (except on exit)
-        if (choice != 3) {
-            printf("\nPress Enter to continue...");
-            while (getchar() != '\n'); // Clear any remaining input
-            getchar(); // Wait for Enter key
-        }
-        
-    } while (choice != 3);
-    
-    // =========================================================================
-    // CLEANUP AND EXIT
-    // =========================================================================
-    
-    // Free all allocated memory
-    free_project(project);
-    printf("Memory cleanup complete. Goodbye!\n");
-    
-    return 0;
+/* main.c */
+#include "a1_functions.h"
+#include "loader.h"
+#include "snapshot.h"
+#include "journal.h"
+#include "instrument.h"
+#include "portfolio.h"
+#include "server.h"
+#include "schedule.h"
+#include "simulate.h"
+#include "scenario.h"
+#include "history.h"
+#include "query.h"
+#include "watchlist.h"
+#include "report.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * PROJECT MANAGEMENT SYSTEM
+ * 
+ * This program implements a hierarchical project management system with:
+ * - Projects containing multiple Milestones
+ * - Milestones containing multiple Activities  
+ * - Unified ID management to ensure uniqueness
+ * - Cost and time tracking with variance analysis
+ * - Dynamic memory allocation for scalability
+ * 
+ * Program Flow:
+ * 1. Initialize project with user-defined structure
+ * 2. Set up milestones and activities with unique IDs
+ * 3. Enter main loop for activity updates and reporting
+ * 4. Clean up all allocated memory on exit
+ */
+
+/**
+ * Ask which activity to update, by ID or by name
+ * 
+ * A number is taken as an activity ID. Any other text is searched for
+ * (case-insensitive substring) among the names of incomplete activities
+ * through the name index; a single match is selected directly, several
+ * matches are listed so the user can pick one by ID.
+ * 
+ * @param project Project to search
+ * @return Selected activity ID, or 0 if the user cancelled or nothing matched
+ */
+unsigned short int select_activity(project_t* project) {
+    char query[NAME_INPUT_SIZE];
+    
+    printf("\nEnter ID or name of activity to update (0 to cancel): ");
+    get_input_line(query);
+    
+    if (query[strspn(query, "0123456789")] == '\0') {
+        long id = strtol(query, NULL, 10);
+        return id <= 65535 ? (unsigned short int)id : 0;
+    }
+    
+    unsigned short int matches[MAX_NAME_MATCHES];
+    int total = name_find(project->names, query, NAME_MATCH_SUBSTRING, matches, MAX_NAME_MATCHES);
+    if (total > MAX_NAME_MATCHES) {
+        total = MAX_NAME_MATCHES;
+    }
+    
+    // Keep only incomplete activities (milestones can share names)
+    int num_open = 0;
+    for (int i = 0; i < total; i++) {
+        const activity_t* activity = find_activity_by_id(project, matches[i], NULL);
+        if (activity != NULL && !activity->completed) {
+            matches[num_open++] = matches[i];
+        }
+    }
+    
+    if (num_open == 0) {
+        printf("No incomplete activity matches '%s'.\n", query);
+        return 0;
+    }
+    if (num_open == 1) {
+        return matches[0];
+    }
+    
+    printf("\n%d incomplete activities match '%s':\n", num_open, query);
+    for (int i = 0; i < num_open; i++) {
+        milestone_t* milestone = NULL;
+        const activity_t* activity = find_activity_by_id(project, matches[i], &milestone);
+        printf("ID: %hu | %s (in milestone: %s)\n", activity->id,
+               get_name(project, activity->name), get_name(project, milestone->name));
+    }
+    printf("Enter ID of activity to update (0 to cancel): ");
+    return get_input_usi();
+}
+
+/**
+ * Get unique ID from user with validation
+ * 
+ * Continuously prompts user until a unique ID is provided.
+ * Uses the project's ID manager to check uniqueness. Entering 0
+ * assigns the next free ID automatically.
+ * 
+ * @param project Project containing ID manager
+ * @param item_type Description of item (e.g., "milestone", "activity")
+ * @param item_number Item number for display purposes
+ * @return Unique validated ID
+ */
+unsigned short int get_unique_id(project_t* project, const char* item_type, int item_number) {
+    unsigned short int id;
+    
+    while (true) {
+        printf("Enter unique ID for %s %d (0 to auto-assign): ", item_type, item_number);
+        id = get_input_usi();
+        
+        if (id == 0) {
+            id = allocate_id(project->id_manager);
+            if (id == NO_FREE_ID) {
+                printf("ERROR: No free IDs left. Exiting...\n");
+                exit(EXIT_FAILURE);
+            }
+            printf("Assigned ID %hu.\n", id);
+            return id;
+        }
+        
+        // add_id performs the uniqueness check and registration in one step
+        if (add_id(id, project->id_manager)) {
+            return id;
+        }
+        printf("ID %hu is already in use. Please enter a different ID.\n", id);
+    }
+}
+
+/**
+ * Add or remove milestones, activities and dependencies
+ * 
+ * The journal only records activity updates, so after a structural change
+ * the snapshot is rewritten straight away (a compaction); replay then
+ * starts from the new structure.
+ * 
+ * @param project Project to change
+ * @param journal Open journal, or NULL
+ */
+void edit_structure(project_t* project, journal_t* journal) {
+    char name[NAME_INPUT_SIZE];
+    unsigned short int id;
+    bool changed = false;
+    
+    printf("\nADD OR REMOVE WORK\n");
+    printf("===================================\n");
+    printf("1. Add milestone\n");
+    printf("2. Add activity\n");
+    printf("3. Remove milestone (with its activities)\n");
+    printf("4. Remove activity\n");
+    printf("5. Add dependency\n");
+    printf("0. Back\n");
+    printf("Enter your choice: ");
+    
+    switch (get_input_usi()) {
+        case 1: {
+            printf("Enter unique ID for the milestone (0 to auto-assign): ");
+            id = get_input_usi();
+            printf("Enter name for the milestone: ");
+            get_input_line(name);
+            
+            milestone_t* milestone = add_milestone(project, id, name);
+            if (milestone == NULL) {
+                printf("ID %hu is already in use (or no IDs are left).\n", id);
+                break;
+            }
+            printf("Milestone '%s' (ID: %hu) added.\n", get_name(project, milestone->name), milestone->id);
+            changed = true;
+            break;
+        }
+        
+        case 2: {
+            printf("Enter ID of the milestone to add to: ");
+            milestone_t* milestone = find_milestone_by_id(project, get_input_usi());
+            if (milestone == NULL) {
+                printf("No milestone has that ID.\n");
+                break;
+            }
+            
+            printf("Enter unique ID for the activity (0 to auto-assign): ");
+            id = get_input_usi();
+            printf("Enter name for the activity: ");
+            get_input_line(name);
+            printf("Enter planned duration (in hours): ");
+            unsigned short int planned_duration = get_input_usi();
+            printf("Enter planned cost ($): ");
+            money_t planned_cost = get_input_money();
+            
+            activity_t* activity = add_activity(project, milestone, id, name, planned_duration, planned_cost);
+            if (activity == NULL) {
+                printf("ID %hu is already in use (or no IDs are left).\n", id);
+                break;
+            }
+            printf("Activity '%s' (ID: %hu) added to milestone '%s'.\n", get_name(project, activity->name),
+                   activity->id, get_name(project, milestone->name));
+            changed = true;
+            break;
+        }
+        
+        case 3: {
+            printf("Enter ID of the milestone to remove: ");
+            id = get_input_usi();
+            milestone_t* milestone = find_milestone_by_id(project, id);
+            if (milestone == NULL) {
+                printf("No milestone has ID %hu.\n", id);
+                break;
+            }
+            
+            printf("Remove milestone '%s' and its %d activity/activities? (1 = yes, 0 = no): ",
+                   get_name(project, milestone->name), milestone->num_activities);
+            if (get_input_usi() != 1) {
+                printf("Nothing removed.\n");
+                break;
+            }
+            remove_milestone(project, id);
+            printf("Milestone %hu removed.\n", id);
+            changed = true;
+            break;
+        }
+        
+        case 4:
+            printf("Enter ID of the activity to remove: ");
+            id = get_input_usi();
+            if (!remove_activity(project, id)) {
+                printf("No activity has ID %hu.\n", id);
+                break;
+            }
+            printf("Activity %hu removed.\n", id);
+            changed = true;
+            break;
+            
+        case 5: {
+            printf("Enter ID of the activity that must wait: ");
+            id = get_input_usi();
+            printf("Enter ID of the activity it waits for: ");
+            unsigned short int predecessor_id = get_input_usi();
+            
+            const char* problem = add_dependency(project, id, predecessor_id);
+            if (problem != NULL) {
+                printf("Dependency not added: %s.\n", problem);
+                break;
+            }
+            printf("Activity %hu now starts after activity %hu.\n", id, predecessor_id);
+            changed = true;
+            break;
+        }
+            
+        default:
+            break;
+    }
+    
+    // Keep the critical path current for the statistics screen (edits
+    // never introduce a cycle, add_dependency rejects those)
+    if (changed) {
+        schedule_refresh(project);
+    }
+    
+    if (changed && journal != NULL) {
+        journal_poll_compaction(journal, true);
+        if (!journal_compact(journal, project)) {
+            printf("WARNING: The journal cannot record this change; save a snapshot (option %d) to keep it.\n",
+                   MENU_SAVE_SNAPSHOT);
+        }
+    }
+}
+
+/**
+ * Ask for one of the open scenarios by its number in the list
+ * @return Scenario index, or -1 if the number is not in the list
+ */
+static int select_scenario(scenario_t* const* scenarios, int num_scenarios) {
+    if (num_scenarios == 0) {
+        printf("No scenarios are open; fork one first.\n");
+        return -1;
+    }
+    for (int i = 0; i < num_scenarios; i++) {
+        printf("%d. %s (%d edit(s))\n", i + 1, scenarios[i]->name, scenarios[i]->num_edits);
+    }
+    printf("Enter scenario number: ");
+    int number = get_input_usi();
+    if (number < 1 || number > num_scenarios) {
+        printf("No scenario has number %d.\n", number);
+        return -1;
+    }
+    return number - 1;
+}
+
+/**
+ * What-if scenario submenu
+ * 
+ * Forks the project into scenarios, edits their plans and compares them
+ * with the project. Scenarios never change the project itself; they live
+ * until discarded or the program exits, and are discarded automatically
+ * once milestones or activities are added to or removed from the project.
+ * 
+ * @param project Base project of the scenarios
+ * @param scenarios Open scenarios (MAX_SCENARIOS slots)
+ * @param num_scenarios Number of open scenarios, updated
+ */
+void manage_scenarios(project_t* project, scenario_t** scenarios, int* num_scenarios) {
+    char name[NAME_INPUT_SIZE];
+    unsigned short int id;
+    int index = -1;
+    
+    // Forks refer to items by position and cannot follow a restructured base
+    for (int i = 0; i < *num_scenarios; ) {
+        if (scenario_is_current(scenarios[i])) {
+            i++;
+            continue;
+        }
+        printf("Scenario '%s' discarded: milestones or activities were added or removed since it was forked.\n",
+               scenarios[i]->name);
+        scenario_free(scenarios[i]);
+        scenarios[i] = scenarios[--*num_scenarios];
+    }
+    
+    printf("\nWHAT-IF SCENARIOS\n");
+    printf("===================================\n");
+    printf("1. Fork a new scenario\n");
+    printf("2. Change an activity's plan\n");
+    printf("3. Drop an activity\n");
+    printf("4. Drop a milestone\n");
+    printf("5. Scale a milestone's plan\n");
+    printf("6. Show a scenario's changes\n");
+    printf("7. Compare scenarios with the project\n");
+    printf("8. Discard a scenario\n");
+    printf("0. Back\n");
+    printf("Enter your choice: ");
+    
+    int choice = get_input_usi();
+    if (choice >= 2 && choice <= 6) {
+        index = select_scenario(scenarios, *num_scenarios);
+        if (index < 0) {
+            return;
+        }
+    }
+    
+    switch (choice) {
+        case 1:
+            if (*num_scenarios == MAX_SCENARIOS) {
+                printf("At most %d scenarios can be open; discard one first.\n", MAX_SCENARIOS);
+                break;
+            }
+            printf("Enter name for the scenario: ");
+            get_input_line(name);
+            scenarios[(*num_scenarios)++] = scenario_fork(project, name);
+            printf("Scenario '%s' forked as number %d.\n", name, *num_scenarios);
+            break;
+            
+        case 2: {
+            printf("Enter ID of the activity: ");
+            id = get_input_usi();
+            printf("Enter planned duration (in hours): ");
+            unsigned short int planned_duration = get_input_usi();
+            printf("Enter planned cost ($): ");
+            money_t planned_cost = get_input_money();
+            if (!scenario_set_plan(scenarios[index], id, planned_duration, planned_cost)) {
+                printf("Activity %hu is not part of the scenario.\n", id);
+                break;
+            }
+            printf("Activity %hu re-planned in '%s'.\n", id, scenarios[index]->name);
+            break;
+        }
+        
+        case 3:
+            printf("Enter ID of the activity to drop: ");
+            id = get_input_usi();
+            if (!scenario_drop_activity(scenarios[index], id)) {
+                printf("Activity %hu is not part of the scenario.\n", id);
+                break;
+            }
+            printf("Activity %hu dropped from '%s'.\n", id, scenarios[index]->name);
+            break;
+            
+        case 4:
+            printf("Enter ID of the milestone to drop: ");
+            id = get_input_usi();
+            if (!scenario_drop_milestone(scenarios[index], id)) {
+                printf("Milestone %hu is not part of the scenario.\n", id);
+                break;
+            }
+            printf("Milestone %hu dropped from '%s'.\n", id, scenarios[index]->name);
+            break;
+            
+        case 5: {
+            printf("Enter ID of the milestone to scale: ");
+            id = get_input_usi();
+            printf("Enter factor for its planned duration and cost (e.g. 1.2): ");
+            float factor = get_input_f();
+            if (!scenario_scale_milestone(scenarios[index], id, factor)) {
+                printf("Milestone %hu is not part of the scenario (or the factor is negative).\n", id);
+                break;
+            }
+            printf("Milestone %hu scaled by %.2f in '%s'.\n", id, factor, scenarios[index]->name);
+            break;
+        }
+        
+        case 6:
+            print_scenario_diff(scenarios[index]);
+            break;
+            
+        case 7:
+            print_scenario_comparison(project, scenarios, *num_scenarios);
+            break;
+            
+        case 8:
+            index = select_scenario(scenarios, *num_scenarios);
+            if (index < 0) {
+                break;
+            }
+            printf("Scenario '%s' discarded.\n", scenarios[index]->name);
+            scenario_free(scenarios[index]);
+            scenarios[index] = scenarios[--*num_scenarios];
+            break;
+            
+        default:
+            break;
+    }
+}
+
+/**
+ * Build a project through the interactive prompt sequence
+ * 
+ * Asks for the project name, milestones and activities with their
+ * unique IDs and planned values.
+ * 
+ * @return Fully populated project (rollups not yet computed)
+ */
+project_t* setup_project_interactively(void) {
+    // =========================================================================
+    // PROJECT INITIALIZATION
+    // =========================================================================
+    
+    // Get project name with improved input handling
+    char project_name[100];
+    printf("Enter project name: ");
+    
+    // Clear any residual input and get project name
+    discard_input_line(); // Clear buffer
+    if (fgets(project_name, sizeof(project_name), stdin)) {
+        // Remove newline character if present
+        project_name[strcspn(project_name, "\n")] = '\0';
+    }
+    
+    project_t* project = init_project(project_name);
+    printf("\nProject '%s' created successfully!\n", project->name);
+    
+    // =========================================================================
+    // MILESTONE AND ACTIVITY SETUP
+    // =========================================================================
+    
+    printf("\nSetting up %d milestone(s)...\n", project->num_milestones);
+    
+    for (int i = 0; i < project->num_milestones; i++) {
+        milestone_t* milestone = &project->milestone_list[i];
+        
+        printf("\nMILESTONE %d SETUP\n", i + 1);
+        printf("-------------------------\n");
+        
+        // Get unique milestone ID
+        milestone->id = get_unique_id(project, "milestone", i + 1);
+        set_id_location(project->id_manager, milestone->id, i, NO_INDEX);
+        
+        // Get milestone name (spaces allowed)
+        char name[NAME_INPUT_SIZE];
+        printf("Enter name for milestone %d: ", i + 1);
+        get_input_line(name);
+        set_milestone_name(project, milestone, name);
+        
+        // Initialize milestone (creates activity array)
+        init_milestone(project, milestone);
+        
+        // =====================================================================
+        // ACTIVITY SETUP FOR THIS MILESTONE
+        // =====================================================================
+        
+        printf("\nSetting up %d activity/activities for milestone '%s':\n", 
+               milestone->num_activities, get_name(project, milestone->name));
+        
+        for (int j = 0; j < milestone->num_activities; j++) {
+            activity_t* activity = &milestone->activity_list[j];
+            
+            printf("\n  Activity %d/%d:\n", j + 1, milestone->num_activities);
+            
+            // Get unique activity ID
+            activity->id = get_unique_id(project, "activity", j + 1);
+            set_id_location(project->id_manager, activity->id, i, j);
+            
+            // Get activity name
+            printf("  Enter name for activity %d: ", j + 1);
+            get_input_line(name);
+            set_activity_name(project, activity, name);
+            
+            // Initialize activity with planned values
+            init_activity(project, activity);
+            
+            printf("  Activity '%s' (ID: %hu) created successfully!\n", 
+                   get_name(project, activity->name), activity->id);
+        }
+        
+        printf("\nMilestone '%s' setup complete!\n", get_name(project, milestone->name));
+    }
+    
+    return project;
+}
+
+/**
+ * Print command-line usage
+ * 
+ * @param program Name the program was invoked as
+ */
+void print_usage(const char* program) {
+    printf("Usage: %s [--load <project.csv>] [--snapshot <project.snap>]\n"
+           "       [--journal <project.journal> [--sync always|group|none]] [--batch <updates.csv>|-]\n"
+           "       [--history <project.history>] [--profile <profile.json>] [--serve <socket>]\n"
+           "       [--query <text>] [--alert COST%%,HOURS%%]\n"
+           "       [--report <file>|- [--format text|csv|json]]\n"
+           "       [--simulate N [--distribution triangular|pert] [--spread LOW,HIGH] [--seed N] [--threads N]]\n"
+           "       %s --portfolio <manifest> [--threads N] [--query <text>]\n",
+           program, program);
+    printf("  --load <file>       Load the project from a CSV project file instead of prompting\n");
+    printf("  --snapshot <file>   Map a binary snapshot (used instead of --load when it exists)\n");
+    printf("  --journal <file>    Replay and then append to an update journal; with --snapshot\n");
+    printf("                      the journal is compacted into the snapshot as it grows\n");
+    printf("  --sync <policy>     Journal durability: fsync every update, per group, or never\n");
+    printf("  --batch <file>|-    Apply activity updates from a file or stdin, then exit\n");
+    printf("  --history <file>    Record every milestone rollup change in a compressed progress\n");
+    printf("                      history for variance trends (menu option %d)\n", MENU_HISTORY);
+    printf("  --query <text>      Run a query (see query.h) over the project, or over every\n");
+    printf("                      project with --portfolio, print the result and exit\n");
+    printf("  --report <file>|-   Write a full report of the project to a file or stdout and exit\n");
+    printf("  --format F          Report format: text (default), csv or json\n");
+    printf("  --alert C,H         Alert when an activity or milestone runs more than C%% over\n");
+    printf("                      its planned cost or H%% over its planned hours (default %.0f,%.0f)\n",
+           WATCH_DEFAULT_THRESHOLD * 100, WATCH_DEFAULT_THRESHOLD * 100);
+    printf("  --profile <file>    Write instrumentation as JSON on exit (-DPM_INSTRUMENT builds)\n");
+    printf("  --serve <socket>    Serve stats and updates on a Unix domain socket until\n");
+    printf("                      SIGINT/SIGTERM (see server.h for the protocol)\n");
+    printf("  --portfolio <file>  Load every project listed in a manifest, roll them up, print\n");
+    printf("                      portfolio statistics and exit\n");
+    printf("  --simulate N        Run N Monte Carlo trials of the remaining work, print cost and\n");
+    printf("                      duration percentiles and exit\n");
+    printf("  --distribution D    Activity outcome shape for --simulate: pert (default) or triangular\n");
+    printf("  --spread LOW,HIGH   Best and worst case as multiples of plan (default 0.8,1.5)\n");
+    printf("  --seed N            Simulation seed; equal seeds give equal results (default 1)\n");
+    printf("  --threads N         Threads for --portfolio and --simulate (default: online CPUs)\n");
+}
+
+/**
+ * Apply a batch update file and report the outcome
+ * 
+ * Results are kept through the journal when one is open (main has already
+ * saved the snapshot it replays onto, so the next --snapshot --journal run
+ * starts from this one); otherwise the snapshot (if any) is rewritten so the
+ * batch is not lost on exit.
+ * 
+ * @return EXIT_SUCCESS if every record was applied, EXIT_FAILURE otherwise
+ */
+int run_batch(project_t* project, const char* batch_path, journal_t* journal,
+              const char* snapshot_path) {
+    struct timespec start, end;
+    batch_result_t result;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool ok = apply_update_batch(project, batch_path, journal, &result);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    
+    printf("\nBATCH UPDATE: %s\n", batch_path);
+    printf("========================================\n");
+    printf("Applied: %ld | Rejected: %ld | Milestones rolled up: %d\n",
+           result.applied, result.rejected, result.milestones_touched);
+    printf("Elapsed: %.3f ms (%.0f updates/s)\n", seconds * 1e3,
+           seconds > 0 ? (double)result.applied / seconds : 0.0);
+    
+    if (journal == NULL && snapshot_path != NULL && result.applied > 0) {
+        ok = save_snapshot(project, snapshot_path) && ok;
+        if (ok) {
+            printf("Project saved to %s\n", snapshot_path);
+        }
+    }
+    
+    printf("Project '%s': %d/%d milestone(s) complete, %d open activities, actual cost $%.2f\n",
+           project->name, project->num_completed_milestones, project->num_milestones,
+           project->num_open_activities, money_to_dollars(project->actual_cost));
+    if (project->watchlist != NULL) {
+        printf("Watchlist: %ld alert(s) raised; %d activities over planned cost, %d over planned hours\n",
+               project->watchlist->num_alerts, project->watchlist->heaps[WATCH_ACTIVITY_COST].count,
+               project->watchlist->heaps[WATCH_ACTIVITY_SCHEDULE].count);
+    }
+    return ok && result.rejected == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Serve the project on a socket until stopped, then keep the updates
+ * 
+ * As with batches, updates survive through the journal when one is open;
+ * otherwise the snapshot (if any) is rewritten.
+ * 
+ * @return EXIT_SUCCESS unless the server could not start or saving failed
+ */
+int run_serve(project_t* project, const char* socket_path, journal_t* journal,
+              const char* snapshot_path) {
+    printf("Serving project '%s' on %s (Ctrl+C to stop)\n", project->name, socket_path);
+    fflush(stdout);
+    
+    long updates = run_server(project, socket_path, journal);
+    if (updates < 0) {
+        return EXIT_FAILURE;
+    }
+    printf("\nServer stopped after %ld update(s)\n", updates);
+    
+    if (journal == NULL && snapshot_path != NULL && updates > 0) {
+        if (!save_snapshot(project, snapshot_path)) {
+            return EXIT_FAILURE;
+        }
+        printf("Project saved to %s\n", snapshot_path);
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Simulate the rest of the project and report the percentiles
+ * 
+ * @return EXIT_SUCCESS unless the settings were rejected
+ */
+int run_simulation(project_t* project, const simulation_config_t* config) {
+    simulation_result_t result;
+    
+    if (!simulate_project(project, config, &result)) {
+        return EXIT_FAILURE;
+    }
+    print_simulation(project, config, &result);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Write a full report of the project and say how long it took
+ * 
+ * @param fd Open output, or -1 to create report_path
+ * @return EXIT_SUCCESS unless the output could not be opened or written
+ */
+int run_report(const project_t* project, const char* report_path, int fd, report_format_t format) {
+    struct timespec start, end;
+    report_writer_t writer;
+    
+    if (fd < 0) {
+        fd = open(report_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            fprintf(stderr, "ERROR: Cannot create report '%s'\n", report_path);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    report_init(&writer, fd, format);
+    report_project(&writer, project);
+    bool ok = report_flush(&writer);
+    report_free(&writer);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    
+    if (close(fd) != 0 || !ok) {
+        fprintf(stderr, "ERROR: Failed to write report to %s\n", report_path);
+        return EXIT_FAILURE;
+    }
+    printf("Wrote %lld byte(s) of report to %s in %.3f ms\n", writer.bytes_written, report_path, seconds * 1e3);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Compile a query, run it over the given projects and print the result
+ * 
+ * @return EXIT_SUCCESS unless the query did not compile
+ */
+int run_query(project_t** projects, int num_projects, const char* text) {
+    query_t query;
+    query_result_t result;
+    char error[QUERY_ERROR_SIZE];
+    struct timespec start, end;
+    
+    if (!query_compile(text, &query, error)) {
+        printf("Invalid query: %s\n", error);
+        return EXIT_FAILURE;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    query_result_init(&result, &query);
+    for (int i = 0; i < num_projects; i++) {
+        query_accumulate(&result, projects[i]);
+    }
+    query_finish(&result);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    
+    print_query_result(&result);
+    printf("Query ran in %.3f ms\n", seconds * 1e3);
+    query_result_free(&result);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Load a portfolio manifest, roll it up in parallel and report
+ * 
+ * @param query_text Query to run over every project instead of the
+ *                   portfolio statistics (NULL for the statistics)
+ * @return EXIT_SUCCESS if every listed project loaded
+ */
+int run_portfolio(const char* manifest_path, int num_threads, const char* query_text) {
+    struct timespec start, end;
+    
+    portfolio_t* portfolio = portfolio_create(num_threads);
+    if (portfolio_load_manifest(portfolio, manifest_path) < 0) {
+        portfolio_free(portfolio);
+        return EXIT_FAILURE;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    portfolio_rollup(portfolio);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    
+    int status = EXIT_SUCCESS;
+    if (query_text != NULL) {
+        status = run_query(portfolio->projects, portfolio->num_projects, query_text);
+    } else {
+        print_portfolio_stats(portfolio);
+    }
+    printf("\nRolled up %d project(s) on %d thread(s) in %.3f ms\n",
+           portfolio->num_projects, portfolio->pool->num_workers + 1, seconds * 1e3);
+    portfolio_free(portfolio);
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    const char* load_path = NULL;
+    const char* snapshot_path = NULL;
+    const char* journal_path = NULL;
+    const char* batch_path = NULL;
+    const char* profile_path = NULL;
+    const char* portfolio_path = NULL;
+    const char* serve_path = NULL;
+    const char* history_path = NULL;
+    const char* query_text = NULL;
+    const char* report_path = NULL;
+    report_format_t report_format = REPORT_TEXT;
+    float cost_threshold = WATCH_DEFAULT_THRESHOLD * 100, schedule_threshold = WATCH_DEFAULT_THRESHOLD * 100;
+    int num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    journal_sync_t sync_policy = JOURNAL_SYNC_GROUP;
+    simulation_config_t simulation = { DISTRIBUTION_PERT, 0.8f, 1.5f, 0, 1, 1 };
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+            load_path = argv[++i];
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshot_path = argv[++i];
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journal_path = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_path = argv[++i];
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serve_path = argv[++i];
+        } else if (strcmp(argv[i], "--history") == 0 && i + 1 < argc) {
+            history_path = argv[++i];
+        } else if (strcmp(argv[i], "--alert") == 0 && i + 1 < argc &&
+                   sscanf(argv[i + 1], "%f,%f", &cost_threshold, &schedule_threshold) == 2 &&
+                   cost_threshold >= 0 && schedule_threshold >= 0) {
+            i++;
+        } else if (strcmp(argv[i], "--query") == 0 && i + 1 < argc) {
+            query_text = argv[++i];
+        } else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+            report_path = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc &&
+                   report_parse_format(argv[i + 1], &report_format)) {
+            i++;
+        } else if (strcmp(argv[i], "--portfolio") == 0 && i + 1 < argc) {
+            portfolio_path = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            num_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sync") == 0 && i + 1 < argc &&
+                   journal_parse_policy(argv[i + 1], &sync_policy)) {
+            i++;
+        } else if (strcmp(argv[i], "--simulate") == 0 && i + 1 < argc && atol(argv[i + 1]) > 0) {
+            simulation.trials = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--distribution") == 0 && i + 1 < argc &&
+                   parse_distribution(argv[i + 1], &simulation.distribution)) {
+            i++;
+        } else if (strcmp(argv[i], "--spread") == 0 && i + 1 < argc &&
+                   sscanf(argv[i + 1], "%f,%f", &simulation.optimistic, &simulation.pessimistic) == 2) {
+            i++;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            simulation.seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    // Interactive setup would read its answers from the batch stream
+    if (batch_path != NULL && load_path == NULL && snapshot_path == NULL) {
+        fprintf(stderr, "ERROR: --batch needs a project from --load or --snapshot\n");
+        return EXIT_FAILURE;
+    }
+    if ((batch_path != NULL) + (serve_path != NULL) + (simulation.trials > 0) + (query_text != NULL) +
+        (report_path != NULL) > 1) {
+        fprintf(stderr, "ERROR: --batch, --serve, --simulate, --query and --report cannot be combined\n");
+        return EXIT_FAILURE;
+    }
+    if (report_path != NULL && (portfolio_path != NULL || (load_path == NULL && snapshot_path == NULL))) {
+        fprintf(stderr, "ERROR: --report needs a project from --load or --snapshot\n");
+        return EXIT_FAILURE;
+    }
+    if (query_text != NULL && portfolio_path == NULL && load_path == NULL && snapshot_path == NULL) {
+        fprintf(stderr, "ERROR: --query needs a project from --load, --snapshot or --portfolio\n");
+        return EXIT_FAILURE;
+    }
+    if (simulation.trials > 0 && load_path == NULL && snapshot_path == NULL) {
+        fprintf(stderr, "ERROR: --simulate needs a project from --load or --snapshot\n");
+        return EXIT_FAILURE;
+    }
+    if (profile_path != NULL && !instrument_enabled()) {
+        fprintf(stderr, "WARNING: built without -DPM_INSTRUMENT, --profile will not be written\n");
+        profile_path = NULL;
+    }
+    if (portfolio_path != NULL) {
+        // Probe slots are plain counters shared by every thread
+        if (instrument_enabled() && num_threads > 1) {
+            fprintf(stderr, "WARNING: instrumented build, rolling up on one thread\n");
+            num_threads = 1;
+        }
+        return run_portfolio(portfolio_path, num_threads > 0 ? num_threads : 1, query_text);
+    }
+    
+    // A report on stdout keeps it to itself; everything else goes to stderr
+    int report_fd = -1;
+    if (report_path != NULL && strcmp(report_path, "-") == 0) {
+        fflush(stdout);
+        report_fd = dup(STDOUT_FILENO);
+        if (report_fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+            fprintf(stderr, "ERROR: Cannot redirect output for the report\n");
+            return EXIT_FAILURE;
+        }
+        report_path = "stdout";
+    }
+    
+    printf("WELCOME TO THE PROJECT MANAGEMENT SYSTEM!\n");
+    printf("============================================================\n");
+    
+    project_t* project;
+    if (snapshot_path != NULL && (load_path == NULL || access(snapshot_path, F_OK) == 0)) {
+        // Snapshots carry their rollups, so no recompute is needed
+        project = load_snapshot(snapshot_path);
+        if (project == NULL) {
+            return EXIT_FAILURE;
+        }
+        printf("Mapped project '%s' (%d milestone(s)) from %s\n",
+               project->name, project->num_milestones, snapshot_path);
+    } else {
+        if (load_path != NULL) {
+            project = load_project_csv(load_path);
+            if (project == NULL) {
+                return EXIT_FAILURE;
+            }
+            printf("Loaded project '%s' (%d milestone(s)) from %s\n",
+                   project->name, project->num_milestones, load_path);
+        } else {
+            project = setup_project_interactively();
+        }
+        
+        // Establish planned totals and initial rollups for the whole project
+        for (int i = 0; i < project->num_milestones; i++) {
+            build_activity_columns(project->arena, &project->milestone_list[i]);
+            update_milestone(&project->milestone_list[i]);
+        }
+        update_project(project);
+    }
+    
+    // Bring the project up to date with updates made since the snapshot
+    journal_t* journal = NULL;
+    if (journal_path != NULL) {
+        long replayed = journal_replay(project, journal_path);
+        if (replayed < 0) {
+            fprintf(stderr, "ERROR: Cannot replay journal '%s'\n", journal_path);
+            free_project(project);
+            return EXIT_FAILURE;
+        }
+        if (replayed > 0) {
+            printf("Replayed %ld update(s) from %s\n", replayed, journal_path);
+        }
+        
+        // The journal only holds updates, so the state they apply to must be
+        // on disk before the first one is appended
+        if (snapshot_path != NULL && access(snapshot_path, F_OK) != 0) {
+            if (!save_snapshot(project, snapshot_path)) {
+                free_project(project);
+                return EXIT_FAILURE;
+            }
+            printf("Project saved to %s\n", snapshot_path);
+        }
+        
+        journal = journal_open(journal_path, sync_policy, snapshot_path);
+        if (journal == NULL) {
+            free_project(project);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    // Opened after the replay: replayed updates were recorded when first made
+    if (history_path != NULL) {
+        project->history = history_open(history_path, project);
+        if (project->history == NULL) {
+            journal_close(journal);
+            free_project(project);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    // Ranked from the current state; batches only count their alerts
+    project->watchlist = watchlist_create(project, cost_threshold / 100, schedule_threshold / 100);
+    if (batch_path == NULL) {
+        watchlist_set_alert(project->watchlist, print_watch_alert, project);
+    }
+    
+    if (batch_path != NULL) {
+        int status = run_batch(project, batch_path, journal, snapshot_path);
+        journal_close(journal);
+        free_project(project);
+        if (profile_path != NULL && !instrument_write_json(profile_path)) {
+            status = EXIT_FAILURE;
+        }
+        return status;
+    }
+    if (simulation.trials > 0) {
+        simulation.num_threads = num_threads > 0 ? num_threads : 1;
+        int status = run_simulation(project, &simulation);
+        journal_close(journal);
+        free_project(project);
+        if (profile_path != NULL && !instrument_write_json(profile_path)) {
+            status = EXIT_FAILURE;
+        }
+        return status;
+    }
+    if (query_text != NULL) {
+        int status = run_query(&project, 1, query_text);
+        journal_close(journal);
+        free_project(project);
+        if (profile_path != NULL && !instrument_write_json(profile_path)) {
+            status = EXIT_FAILURE;
+        }
+        return status;
+    }
+    if (report_path != NULL) {
+        int status = run_report(project, report_path, report_fd, report_format);
+        journal_close(journal);
+        free_project(project);
+        if (profile_path != NULL && !instrument_write_json(profile_path)) {
+            status = EXIT_FAILURE;
+        }
+        return status;
+    }
+    if (serve_path != NULL) {
+        int status = run_serve(project, serve_path, journal, snapshot_path);
+        journal_close(journal);
+        free_project(project);
+        if (profile_path != NULL && !instrument_write_json(profile_path)) {
+            status = EXIT_FAILURE;
+        }
+        return status;
+    }
+    
+    printf("\nProject setup complete! Ready for activity tracking.\n");
+    
+    // =========================================================================
+    // MAIN APPLICATION LOOP
+    // =========================================================================
+    
+    scenario_t* scenarios[MAX_SCENARIOS];
+    int num_scenarios = 0;
+    
+    int choice;
+    do {
+        print_main_menu();
+        choice = get_input_usi();
+        
+        switch (choice) {
+            case MENU_UPDATE_ACTIVITY: {
+                // UPDATE ACTIVITY WORKFLOW
+                printf("\nUPDATE ACTIVITY WORKFLOW\n");
+                printf("===================================\n");
+                
+                // Display incomplete activities and get count
+                int incomplete_count = display_incomplete_activities(project);
+                
+                if (incomplete_count == 0) {
+                    printf("\nCongratulations! All activities are completed!\n");
+                    break;
+                }
+                
+                // Get activity to update by ID or by name
+                unsigned short int update_id = select_activity(project);
+                
+                if (update_id == 0) {
+                    printf("Update cancelled.\n");
+                    break;
+                }
+                
+                // Find the activity and its containing milestone
+                milestone_t* containing_milestone = NULL;
+                activity_t* activity = find_activity_by_id(project, update_id, &containing_milestone);
+                
+                if (activity == NULL) {
+                    printf("Activity with ID %hu not found.\n", update_id);
+                    break;
+                }
+                
+                if (activity->completed) {
+                    printf("Activity '%s' is already completed.\n", get_name(project, activity->name));
+                    break;
+                }
+                
+                // Update the activity
+                printf("\nUpdating activity: %s\n", get_name(project, activity->name));
+                activity_t before = *activity;
+                update_activity(activity);
+                
+                // Propagate only the change up the hierarchy
+                rollup_activity_change(project, containing_milestone, &before, activity);
+                
+                if (journal != NULL && !journal_append(journal, project, activity)) {
+                    printf("WARNING: Update could not be written to the journal.\n");
+                }
+                
+                printf("\nActivity and related milestones updated successfully!\n");
+                
+                // Check if milestone or project just became complete
+                if (containing_milestone->completed) {
+                    printf("Milestone '%s' is now COMPLETE!\n",
+                           get_name(project, containing_milestone->name));
+                }
+                
+                if (project->completed) {
+                    printf("PROJECT '%s' IS NOW COMPLETE!\n", project->name);
+                }
+                
+                break;
+            }
+            
+            case MENU_PRINT_STATS:
+                // PRINT STATISTICS
+                print_project_stats(project);
+                break;
+                
+            case MENU_SAVE_SNAPSHOT: {
+                char snapshot_file[256];
+                printf("Enter snapshot file name: ");
+                if (scanf("%255s", snapshot_file) != 1) {
+                    discard_input_line();
+                    break;
+                }
+                if (save_snapshot(project, snapshot_file)) {
+                    printf("Project saved to %s\n", snapshot_file);
+                }
+                break;
+            }
+            
+            case MENU_INSTRUMENTATION:
+                instrument_print(stdout);
+                break;
+                
+            case MENU_EDIT_STRUCTURE:
+                edit_structure(project, journal);
+                break;
+                
+            case MENU_CRITICAL_PATH:
+                print_critical_path(project);
+                break;
+                
+            case MENU_SCENARIOS:
+                manage_scenarios(project, scenarios, &num_scenarios);
+                break;
+                
+            case MENU_HISTORY: {
+                if (project->history == NULL) {
+                    printf("No progress history is kept; start with --history <file> to record one.\n");
+                    break;
+                }
+                printf("Enter number of days to look back (0 for %d): ", DEFAULT_HISTORY_DAYS);
+                int days = get_input_usi();
+                print_history_trend(project, project->history, days > 0 ? days : DEFAULT_HISTORY_DAYS,
+                                    (int64_t)time(NULL));
+                break;
+            }
+                
+            case MENU_QUERY: {
+                char query_text[QUERY_TEXT_SIZE];
+                printf("Enter a query, e.g. 'activities where open and cost_ratio > 120%% "
+                       "order by cost_variance desc limit 10': ");
+                if (scanf(" %511[^\n]", query_text) != 1) {
+                    discard_input_line();
+                    break;
+                }
+                run_query(&project, 1, query_text);
+                break;
+            }
+                
+            case MENU_WATCHLIST: {
+                printf("Enter number of entries per list (0 for %d): ", DEFAULT_WATCHLIST_ENTRIES);
+                int entries = get_input_usi();
+                print_watchlist(project, project->watchlist, entries > 0 ? entries : DEFAULT_WATCHLIST_ENTRIES);
+                break;
+            }
+                
+            case MENU_EXIT:
+                // EXIT
+                printf("\nThank you for using the Project Management System!\n");
+                printf("Cleaning up and exiting...\n");
+                break;
+                
+            default:
+                printf("Invalid choice. Please select 1-%d.\n", MENU_LAST_OPTION);
+        }
+        
+        // Add pause for better user experience (except on exit)
+        if (choice != MENU_EXIT) {
+            printf("\nPress Enter to continue...");
+            discard_input_line(); // Clear any remaining input
+            discard_input_line(); // Wait for Enter key
+        }
+        
+    } while (choice != MENU_EXIT);
+    
+    // =========================================================================
+    // CLEANUP AND EXIT
+    // =========================================================================
+    
+    // Make journaled updates durable before the project goes away
+    journal_close(journal);
+    
+    // Free all allocated memory (scenarios before the project they share)
+    for (int i = 0; i < num_scenarios; i++) {
+        scenario_free(scenarios[i]);
+    }
+    free_project(project);
+    printf("Memory cleanup complete. Goodbye!\n");
+    
+    if (profile_path != NULL && instrument_write_json(profile_path)) {
+        printf("Instrumentation written to %s\n", profile_path);
+    }
+    
+    return 0;
 }
\ No newline at end of file
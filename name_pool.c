@@ -0,0 +1,269 @@
+/* name_pool.c */
+#include "name_pool.h"
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#define INITIAL_CHARS 4096
+#define INITIAL_ENTRIES 256
+#define INITIAL_SLOTS 1024
+#define INITIAL_TRIGRAMS 1024
+
+static uint32_t hash_text(const char* text) {
+    uint32_t hash = 2166136261u;
+    for (; *text; text++) {
+        hash ^= (unsigned char)*text;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Case-folded 3-byte key of the trigram starting at text (never 0)
+ */
+static uint32_t trigram_key(const char* text) {
+    return (uint32_t)tolower((unsigned char)text[0]) << 16 |
+           (uint32_t)tolower((unsigned char)text[1]) << 8 |
+           (uint32_t)tolower((unsigned char)text[2]);
+}
+
+static uint32_t trigram_slot(uint32_t key, uint32_t mask) {
+    return (key * 2654435761u) & mask;
+}
+
+/**
+ * Locate the posting list for a trigram
+ * @return The list, or the empty slot where it would be inserted
+ */
+static trigram_list_t* find_trigram(const trigram_list_t* table, uint32_t mask, uint32_t key) {
+    uint32_t i = trigram_slot(key, mask);
+    while (table[i].key != 0 && table[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return (trigram_list_t*)&table[i];
+}
+
+static void grow_trigram_table(name_pool_t* pool) {
+    uint32_t capacity = (pool->trigram_mask + 1) * 2;
+    trigram_list_t* table = arena_alloc(pool->arena, capacity * sizeof(trigram_list_t));
+
+    for (uint32_t i = 0; i <= pool->trigram_mask; i++) {
+        if (pool->trigrams[i].key != 0) {
+            *find_trigram(table, capacity - 1, pool->trigrams[i].key) = pool->trigrams[i];
+        }
+    }
+    pool->trigrams = table;
+    pool->trigram_mask = capacity - 1;
+}
+
+/**
+ * Add a new name to the posting list of every trigram it contains
+ */
+static void index_trigrams(name_pool_t* pool, name_ref_t ref, const char* text) {
+    size_t length = strlen(text);
+
+    for (size_t i = 0; i + 3 <= length; i++) {
+        uint32_t key = trigram_key(text + i);
+        trigram_list_t* list = find_trigram(pool->trigrams, pool->trigram_mask, key);
+
+        if (list->key == 0) {
+            if ((pool->num_trigrams + 1) * 2 > pool->trigram_mask + 1) {
+                grow_trigram_table(pool);
+                list = find_trigram(pool->trigrams, pool->trigram_mask, key);
+            }
+            list->key = key;
+            pool->num_trigrams++;
+        }
+        if (list->count > 0 && list->refs[list->count - 1] == ref) {
+            continue; // Trigram repeats inside this name
+        }
+        if (list->count == list->capacity) {
+            uint32_t capacity = list->capacity ? list->capacity * 2 : 4;
+            list->refs = arena_grow(pool->arena, list->refs, list->capacity * sizeof(name_ref_t),
+                                    capacity * sizeof(name_ref_t));
+            list->capacity = capacity;
+        }
+        list->refs[list->count++] = ref;
+    }
+}
+
+static void grow_intern_table(name_pool_t* pool) {
+    uint32_t capacity = (pool->slot_mask + 1) * 2;
+    name_ref_t* slots = arena_alloc(pool->arena, capacity * sizeof(name_ref_t));
+
+    for (name_ref_t ref = 1; ref < pool->num_names; ref++) {
+        uint32_t i = pool->entries[ref].hash & (capacity - 1);
+        while (slots[i] != 0) {
+            i = (i + 1) & (capacity - 1);
+        }
+        slots[i] = ref;
+    }
+    pool->slots = slots;
+    pool->slot_mask = capacity - 1;
+}
+
+name_pool_t* name_pool_create(arena_t* arena) {
+    name_pool_t* pool = arena_alloc(arena, sizeof(name_pool_t));
+
+    pool->arena = arena;
+    pool->chars = arena_alloc(arena, INITIAL_CHARS);
+    pool->chars_capacity = INITIAL_CHARS;
+    pool->chars_used = 1;  // chars[0] is the empty name
+    pool->entries = arena_alloc(arena, INITIAL_ENTRIES * sizeof(name_entry_t));
+    pool->entries_capacity = INITIAL_ENTRIES;
+    pool->num_names = 1;   // entries[0] is NAME_NONE
+    pool->slots = arena_alloc(arena, INITIAL_SLOTS * sizeof(name_ref_t));
+    pool->slot_mask = INITIAL_SLOTS - 1;
+    pool->trigrams = arena_alloc(arena, INITIAL_TRIGRAMS * sizeof(trigram_list_t));
+    pool->trigram_mask = INITIAL_TRIGRAMS - 1;
+    return pool;
+}
+
+name_ref_t name_intern(name_pool_t* pool, const char* text) {
+    if (text[0] == '\0') {
+        return NAME_NONE;
+    }
+
+    char cut[NAME_MAX_LENGTH + 1];
+    size_t length = strnlen(text, NAME_MAX_LENGTH + 1);
+    if (length > NAME_MAX_LENGTH) {
+        length = NAME_MAX_LENGTH;
+        while (length > 0 && ((unsigned char)text[length] & 0xC0) == 0x80) {
+            length--;  // Never keep the first bytes of a character alone
+        }
+        memcpy(cut, text, length);
+        cut[length] = '\0';
+        text = cut;
+    }
+
+    uint32_t hash = hash_text(text);
+    uint32_t i = hash & pool->slot_mask;
+    while (pool->slots[i] != 0) {
+        const name_entry_t* entry = &pool->entries[pool->slots[i]];
+        if (entry->hash == hash && strcmp(pool->chars + entry->offset, text) == 0) {
+            return pool->slots[i];
+        }
+        i = (i + 1) & pool->slot_mask;
+    }
+
+    // New name: append its text and entry, then index it
+    length++;
+    if (pool->chars_used + length > pool->chars_capacity) {
+        size_t capacity = pool->chars_capacity * 2;
+        while (pool->chars_used + length > capacity) {
+            capacity *= 2;
+        }
+        pool->chars = arena_grow(pool->arena, pool->chars, pool->chars_capacity, capacity);
+        pool->chars_capacity = capacity;
+    }
+    if (pool->num_names == pool->entries_capacity) {
+        uint32_t capacity = pool->entries_capacity * 2;
+        pool->entries = arena_grow(pool->arena, pool->entries, pool->entries_capacity * sizeof(name_entry_t),
+                                   capacity * sizeof(name_entry_t));
+        pool->entries_capacity = capacity;
+    }
+
+    name_ref_t ref = pool->num_names++;
+    pool->entries[ref].offset = (uint32_t)pool->chars_used;
+    pool->entries[ref].hash = hash;
+    pool->entries[ref].first_owner = 0;
+    memcpy(pool->chars + pool->chars_used, text, length);
+    pool->chars_used += length;
+    pool->slots[i] = ref;
+
+    if (pool->num_names * 2 > pool->slot_mask + 1) {
+        grow_intern_table(pool);
+    }
+    index_trigrams(pool, ref, text);
+    return ref;
+}
+
+const char* name_text(const name_pool_t* pool, name_ref_t ref) {
+    return pool->chars + pool->entries[ref].offset;
+}
+
+void name_add_owner(name_pool_t* pool, name_ref_t ref, unsigned short int id) {
+    if (id == 0) {
+        return; // Not yet assigned; registered once the item gets its ID
+    }
+    pool->next_owner[id] = pool->entries[ref].first_owner;
+    pool->entries[ref].first_owner = id;
+}
+
+void name_remove_owner(name_pool_t* pool, name_ref_t ref, unsigned short int id) {
+    unsigned short int* link = &pool->entries[ref].first_owner;
+    while (*link != 0 && *link != id) {
+        link = &pool->next_owner[*link];
+    }
+    if (*link == id) {
+        *link = pool->next_owner[id];
+        pool->next_owner[id] = 0;
+    }
+}
+
+/**
+ * Case-insensitive substring test
+ */
+static bool contains_folded(const char* text, const char* query, size_t query_length) {
+    for (; *text; text++) {
+        if (strncasecmp(text, query, query_length) == 0) {
+            return true;
+        }
+    }
+    return query_length == 0;
+}
+
+static bool name_matches(const char* text, const char* query, size_t query_length, name_match_t mode) {
+    if (mode == NAME_MATCH_PREFIX) {
+        return strncasecmp(text, query, query_length) == 0;
+    }
+    return contains_folded(text, query, query_length);
+}
+
+/**
+ * Append every owner of a name to the result list
+ */
+static int collect_owners(const name_pool_t* pool, name_ref_t ref,
+                          unsigned short int ids_out[], int max_ids, int count) {
+    for (unsigned short int id = pool->entries[ref].first_owner; id != 0; id = pool->next_owner[id]) {
+        if (count < max_ids) {
+            ids_out[count] = id;
+        }
+        count++;
+    }
+    return count;
+}
+
+int name_find(const name_pool_t* pool, const char* query, name_match_t mode,
+              unsigned short int ids_out[], int max_ids) {
+    size_t length = strlen(query);
+    int count = 0;
+
+    if (length < NAME_MIN_INDEXED_QUERY) {
+        for (name_ref_t ref = 0; ref < pool->num_names; ref++) {
+            if (name_matches(name_text(pool, ref), query, length, mode)) {
+                count = collect_owners(pool, ref, ids_out, max_ids, count);
+            }
+        }
+        return count;
+    }
+
+    // Every match contains all query trigrams; verify the rarest one's names
+    const trigram_list_t* rarest = NULL;
+    for (size_t i = 0; i + 3 <= length; i++) {
+        const trigram_list_t* list = find_trigram(pool->trigrams, pool->trigram_mask, trigram_key(query + i));
+        if (list->key == 0) {
+            return 0;
+        }
+        if (rarest == NULL || list->count < rarest->count) {
+            rarest = list;
+        }
+    }
+
+    for (uint32_t i = 0; i < rarest->count; i++) {
+        if (name_matches(name_text(pool, rarest->refs[i]), query, length, mode)) {
+            count = collect_owners(pool, rarest->refs[i], ids_out, max_ids, count);
+        }
+    }
+    return count;
+}
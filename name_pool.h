@@ -0,0 +1,133 @@
+/* name_pool.h */
+#ifndef NAME_POOL_H
+#define NAME_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+
+#define NAME_NONE 0                 // Reference to the empty name
+#define NAME_MIN_INDEXED_QUERY 3    // Shorter queries scan the distinct names instead
+#define NAME_MAX_LENGTH 255         // Longer names are cut to this many bytes when interned
+
+/**
+ * Name Reference
+ *
+ * Index of a distinct name in the pool. Items store this 4-byte reference
+ * instead of a fixed character buffer; equal names share one entry.
+ */
+typedef uint32_t name_ref_t;
+
+/**
+ * Name Match Mode
+ *
+ * - NAME_MATCH_PREFIX: name starts with the query
+ * - NAME_MATCH_SUBSTRING: query appears anywhere in the name
+ * Both compare case-insensitively (ASCII).
+ */
+typedef enum {
+    NAME_MATCH_PREFIX,
+    NAME_MATCH_SUBSTRING
+} name_match_t;
+
+/**
+ * Name Entry
+ *
+ * - offset: Position of the NUL-terminated text in the pool's characters
+ * - hash: Full hash of the text (for the intern table)
+ * - first_owner: First item ID carrying this name (0 if none); the chain
+ *   continues through the pool's next_owner table
+ */
+typedef struct {
+    uint32_t offset;
+    uint32_t hash;
+    unsigned short int first_owner;
+} name_entry_t;
+
+/**
+ * Trigram Posting List
+ *
+ * Distinct names containing one lowercase 3-byte sequence.
+ */
+typedef struct {
+    uint32_t key;           // Three lowercase bytes, 0 marks an empty slot
+    uint32_t count;
+    uint32_t capacity;
+    name_ref_t* refs;
+} trigram_list_t;
+
+/**
+ * Name Pool Structure
+ *
+ * Shared string-interning pool for every milestone and activity name of a
+ * project, plus a trigram index over the distinct names for fast prefix and
+ * substring search. All storage comes from the project's arena.
+ *
+ * Fields:
+ * - chars: All distinct names, NUL-terminated, back to back
+ * - entries: One entry per distinct name, indexed by name_ref_t
+ * - slots: Open-addressing intern table of name_ref_t (0 = empty)
+ * - trigrams: Open-addressing table of posting lists
+ * - next_owner: ID-indexed chain linking items that share a name
+ */
+typedef struct {
+    arena_t* arena;
+    char* chars;
+    size_t chars_used, chars_capacity;
+    name_entry_t* entries;
+    uint32_t num_names, entries_capacity;
+    name_ref_t* slots;
+    uint32_t slot_mask;
+    trigram_list_t* trigrams;
+    uint32_t trigram_mask, num_trigrams;
+    unsigned short int next_owner[65536];
+} name_pool_t;
+
+/**
+ * Create an empty name pool (reference 0 is the empty name)
+ * @param arena Arena of the owning project
+ * @return New pool allocated from the arena
+ */
+name_pool_t* name_pool_create(arena_t* arena);
+
+/**
+ * Return the reference for a name, adding it if it is new - amortized O(length)
+ * @param pool Pool to intern into
+ * @param text Name text (may contain spaces); only its first NAME_MAX_LENGTH
+ *             bytes are kept, cut before a partial UTF-8 character
+ * @return Reference shared by every item with this exact name
+ */
+name_ref_t name_intern(name_pool_t* pool, const char* text);
+
+/**
+ * Text of an interned name
+ */
+const char* name_text(const name_pool_t* pool, name_ref_t ref);
+
+/**
+ * Record that an item (milestone or activity ID) carries a name
+ * ID 0 (not yet assigned) is ignored.
+ */
+void name_add_owner(name_pool_t* pool, name_ref_t ref, unsigned short int id);
+
+/**
+ * Forget that an item carries a name (walks only that name's owners)
+ */
+void name_remove_owner(name_pool_t* pool, name_ref_t ref, unsigned short int id);
+
+/**
+ * Find the IDs of all items whose name matches a query
+ * Queries of NAME_MIN_INDEXED_QUERY or more characters only examine names
+ * sharing the query's rarest trigram; shorter ones scan the distinct names.
+ * @param pool Pool to search
+ * @param query Text to look for
+ * @param mode Prefix or substring match
+ * @param ids_out Receives matching item IDs
+ * @param max_ids Capacity of ids_out
+ * @return Total number of matching items (may exceed max_ids)
+ */
+int name_find(const name_pool_t* pool, const char* query, name_match_t mode,
+              unsigned short int ids_out[], int max_ids);
+
+#endif
@@ -0,0 +1,269 @@
+/* pm_loadgen.c */
+#include "bench_util.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * SERVER LOAD GENERATOR
+ *
+ * Opens one connection per client thread to a project server (started with
+ * --serve) and sends requests in a closed loop for a fixed time: each
+ * client waits for a reply before sending its next request. The request mix
+ * is STATS and GET <id> for reads and UPDATE <id> for writes; IDs are drawn
+ * uniformly from the given range, and updates keep activities incomplete so
+ * the project stays updatable. Every request's round-trip latency is kept,
+ * so percentiles are exact.
+ *
+ * Usage: pm_loadgen --socket <path> [--clients N] [--seconds S]
+ *                   [--writes PERCENT] [--ids LOW-HIGH]
+ * Output: key=value lines: totals, then latency percentiles in microseconds
+ */
+
+#define DEFAULT_CLIENTS 4
+#define DEFAULT_SECONDS 5
+#define DEFAULT_WRITE_PERCENT 10
+#define REPLY_SIZE 2048
+
+/**
+ * Client Thread State
+ *
+ * - latencies/num_latencies/capacity: Round-trip time of every request (ns)
+ * - errors: Replies starting with ERR (e.g. IDs that are not activities)
+ */
+typedef struct {
+    const char* socket_path;
+    double deadline_ns;
+    int write_percent;
+    unsigned long id_low, id_high;
+    uint32_t seed;
+    double* latencies;
+    long num_latencies;
+    long capacity;
+    long reads, writes, errors;
+    bool failed;
+} client_t;
+
+static int connect_server(const char* socket_path) {
+    struct sockaddr_un address;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socket_path, sizeof(address.sun_path) - 1);
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Send one request and read its single-line reply
+ * @return false if the connection failed
+ */
+static bool round_trip(int fd, const char* request, size_t length, char reply[REPLY_SIZE]) {
+    size_t used = 0;
+
+    while (length > 0) {
+        ssize_t written = send(fd, request, length, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        request += written;
+        length -= (size_t)written;
+    }
+    while (used == 0 || reply[used - 1] != '\n') {
+        ssize_t received = read(fd, reply + used, REPLY_SIZE - 1 - used);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0 || used + (size_t)received >= REPLY_SIZE - 1) {
+            return false;
+        }
+        used += (size_t)received;
+    }
+    reply[used] = '\0';
+    return true;
+}
+
+static void* client_main(void* argument) {
+    client_t* client = argument;
+    char request[128], reply[REPLY_SIZE];
+    unsigned long span = client->id_high - client->id_low + 1;
+
+    int fd = connect_server(client->socket_path);
+    if (fd < 0) {
+        client->failed = true;
+        return NULL;
+    }
+
+    for (;;) {
+        double start = now_ns();
+        if (start >= client->deadline_ns) {
+            break;
+        }
+
+        uint32_t dice = next_random(&client->seed);
+        unsigned long id = client->id_low + next_random(&client->seed) % span;
+        bool is_write = (int)(dice % 100) < client->write_percent;
+        int length;
+        if (is_write) {
+            length = snprintf(request, sizeof(request), "UPDATE %lu %u %.2f 0\n", id,
+                              next_random(&client->seed) % 200, (double)(next_random(&client->seed) % 100000) / 100);
+        } else if (dice & 0x100) {
+            length = snprintf(request, sizeof(request), "STATS\n");
+        } else {
+            length = snprintf(request, sizeof(request), "GET %lu\n", id);
+        }
+
+        if (!round_trip(fd, request, (size_t)length, reply)) {
+            client->failed = true;
+            break;
+        }
+        if (is_write) {
+            client->writes++;
+        } else {
+            client->reads++;
+        }
+        if (strncmp(reply, "ERR", 3) == 0) {
+            client->errors++;
+        }
+
+        if (client->num_latencies == client->capacity) {
+            long capacity = client->capacity ? client->capacity * 2 : 65536;
+            double* grown = realloc(client->latencies, (size_t)capacity * sizeof(double));
+            if (grown == NULL) {
+                printf("ERROR: Failed to grow latency samples. Exiting...\n");
+                exit(EXIT_FAILURE);
+            }
+            client->latencies = grown;
+            client->capacity = capacity;
+        }
+        client->latencies[client->num_latencies++] = now_ns() - start;
+    }
+
+    send(fd, "QUIT\n", 5, MSG_NOSIGNAL);
+    close(fd);
+    return NULL;
+}
+
+/**
+ * Value at a percentile of sorted samples (nearest rank), in microseconds
+ */
+static double percentile_us(const double* sorted, long count, double percent) {
+    long rank = (long)(percent * (double)count / 100.0 + 0.999999);
+    return sorted[rank > 0 ? rank - 1 : 0] / 1e3;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s --socket <path> [--clients N] [--seconds S] [--writes PERCENT] [--ids LOW-HIGH]\n",
+            program);
+}
+
+int main(int argc, char* argv[]) {
+    const char* socket_path = NULL;
+    int num_clients = DEFAULT_CLIENTS;
+    double seconds = DEFAULT_SECONDS;
+    int write_percent = DEFAULT_WRITE_PERCENT;
+    unsigned long id_low = 1, id_high = 1000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            num_clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--writes") == 0 && i + 1 < argc) {
+            write_percent = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ids") == 0 && i + 1 < argc &&
+                   sscanf(argv[i + 1], "%lu-%lu", &id_low, &id_high) == 2) {
+            i++;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (socket_path == NULL || num_clients < 1 || seconds <= 0 || write_percent < 0 ||
+        write_percent > 100 || id_low < 1 || id_high < id_low || id_high > 65535) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    client_t* clients = calloc((size_t)num_clients, sizeof(client_t));
+    pthread_t* threads = calloc((size_t)num_clients, sizeof(pthread_t));
+    if (clients == NULL || threads == NULL) {
+        printf("ERROR: Failed to allocate clients. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double start = now_ns();
+    for (int i = 0; i < num_clients; i++) {
+        clients[i].socket_path = socket_path;
+        clients[i].deadline_ns = start + seconds * 1e9;
+        clients[i].write_percent = write_percent;
+        clients[i].id_low = id_low;
+        clients[i].id_high = id_high;
+        clients[i].seed = 0x9e3779b9u * (uint32_t)(i + 1);
+        if (pthread_create(&threads[i], NULL, client_main, &clients[i]) != 0) {
+            fprintf(stderr, "ERROR: Cannot start client thread %d\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    long total = 0, reads = 0, writes = 0, errors = 0, failed = 0;
+    for (int i = 0; i < num_clients; i++) {
+        pthread_join(threads[i], NULL);
+        total += clients[i].num_latencies;
+        reads += clients[i].reads;
+        writes += clients[i].writes;
+        errors += clients[i].errors;
+        failed += clients[i].failed;
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+
+    if (failed > 0) {
+        fprintf(stderr, "ERROR: %ld client(s) lost their connection to %s\n", failed, socket_path);
+    }
+    if (total == 0) {
+        return EXIT_FAILURE;
+    }
+
+    // Merge every client's samples for exact percentiles
+    double* all = malloc((size_t)total * sizeof(double));
+    if (all == NULL) {
+        printf("ERROR: Failed to allocate latency samples. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    long merged = 0;
+    for (int i = 0; i < num_clients; i++) {
+        memcpy(all + merged, clients[i].latencies, (size_t)clients[i].num_latencies * sizeof(double));
+        merged += clients[i].num_latencies;
+        free(clients[i].latencies);
+    }
+    qsort(all, (size_t)total, sizeof(double), compare_doubles);
+
+    printf("clients=%d seconds=%.2f requests=%ld reads=%ld writes=%ld errors=%ld requests_per_s=%.0f\n",
+           num_clients, elapsed, total, reads, writes, errors, (double)total / elapsed);
+    printf("latency_us p50=%.1f p90=%.1f p99=%.1f p999=%.1f max=%.1f\n",
+           percentile_us(all, total, 50), percentile_us(all, total, 90), percentile_us(all, total, 99),
+           percentile_us(all, total, 99.9), all[total - 1] / 1e3);
+
+    free(all);
+    free(clients);
+    free(threads);
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,248 @@
+/* portfolio.c */
+#include "portfolio.h"
+#include "a1_functions.h"
+#include "loader.h"
+#include "snapshot.h"
+#include <string.h>
+#include <math.h>
+
+#define MANIFEST_LINE_SIZE 4096
+
+/**
+ * Full rollup of one project; columns are built on first use
+ * Runs on whichever thread claimed the project, using only that project's
+ * memory (its arena included).
+ */
+static void rollup_project(project_t* project) {
+    for (int i = 0; i < project->num_milestones; i++) {
+        milestone_t* milestone = &project->milestone_list[i];
+        if (!milestone->columns.valid) {
+            build_activity_columns(project->arena, milestone);
+        }
+        update_milestone(milestone);
+    }
+    update_project(project);
+}
+
+/**
+ * Claim and roll up projects until the cursor runs past the end
+ */
+static void drain_projects(portfolio_t* portfolio) {
+    rollup_pool_t* pool = portfolio->pool;
+    int index;
+
+    while ((index = atomic_fetch_add_explicit(&pool->next_project, 1, memory_order_relaxed)) <
+           portfolio->num_projects) {
+        rollup_project(portfolio->projects[index]);
+    }
+}
+
+/**
+ * Worker thread: wait for a new generation, drain, report back, repeat
+ */
+static void* rollup_worker(void* argument) {
+    portfolio_t* portfolio = argument;
+    rollup_pool_t* pool = portfolio->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->stop) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        drain_projects(portfolio);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+portfolio_t* portfolio_create(int num_threads) {
+    portfolio_t* portfolio = calloc(1, sizeof(portfolio_t));
+    rollup_pool_t* pool = calloc(1, sizeof(rollup_pool_t));
+    if (portfolio == NULL || pool == NULL) {
+        printf("ERROR: Failed to allocate portfolio. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    portfolio->pool = pool;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    atomic_init(&pool->next_project, 0);
+
+    if (num_threads > PORTFOLIO_MAX_THREADS) {
+        num_threads = PORTFOLIO_MAX_THREADS;
+    }
+    for (int i = 0; i < num_threads - 1; i++) {
+        if (pthread_create(&pool->threads[i], NULL, rollup_worker, portfolio) != 0) {
+            break; // Run with the threads we got
+        }
+        pool->num_workers++;
+    }
+    return portfolio;
+}
+
+void portfolio_add(portfolio_t* portfolio, project_t* project) {
+    if (portfolio->num_projects == portfolio->capacity) {
+        int capacity = portfolio->capacity ? portfolio->capacity * 2 : 16;
+        project_t** grown = realloc(portfolio->projects, (size_t)capacity * sizeof(project_t*));
+        if (grown == NULL) {
+            printf("ERROR: Failed to grow portfolio. Exiting...\n");
+            exit(EXIT_FAILURE);
+        }
+        portfolio->projects = grown;
+        portfolio->capacity = capacity;
+    }
+    portfolio->projects[portfolio->num_projects++] = project;
+}
+
+int portfolio_load_manifest(portfolio_t* portfolio, const char* path) {
+    char line[MANIFEST_LINE_SIZE];
+    int added = 0;
+
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: Cannot open portfolio manifest '%s'\n", path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        size_t length = strcspn(line, "\r\n");
+        line[length] = '\0';
+        if (length == 0 || line[0] == '#') {
+            continue;
+        }
+
+        bool is_snapshot = length > 5 && strcmp(line + length - 5, ".snap") == 0;
+        project_t* project = is_snapshot ? load_snapshot(line) : load_project_csv(line);
+        if (project == NULL) {
+            fclose(file);
+            return -1;
+        }
+        portfolio_add(portfolio, project);
+        added++;
+    }
+
+    fclose(file);
+    return added;
+}
+
+void portfolio_rollup(portfolio_t* portfolio) {
+    rollup_pool_t* pool = portfolio->pool;
+
+    // Release the workers on a new generation and work alongside them
+    pthread_mutex_lock(&pool->lock);
+    atomic_store_explicit(&pool->next_project, 0, memory_order_relaxed);
+    pool->active = pool->num_workers;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    drain_projects(portfolio);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    // Portfolio totals: one pass over the project totals
+    portfolio->planned_cost = portfolio->actual_cost = 0;
+    portfolio->planned_days = portfolio->actual_days = 0;
+    portfolio->num_milestones = portfolio->num_completed_milestones = 0;
+    portfolio->num_activities = portfolio->num_open_activities = 0;
+    portfolio->num_completed_projects = 0;
+    for (int i = 0; i < portfolio->num_projects; i++) {
+        const project_t* project = portfolio->projects[i];
+        portfolio->planned_cost += (double)project->planned_cost;
+        portfolio->actual_cost += (double)project->actual_cost;
+        portfolio->planned_days += project->planned_duration;
+        portfolio->actual_days += project->actual_duration;
+        portfolio->num_milestones += project->num_milestones;
+        portfolio->num_completed_milestones += project->num_completed_milestones;
+        portfolio->num_open_activities += project->num_open_activities;
+        for (int j = 0; j < project->num_milestones; j++) {
+            portfolio->num_activities += project->milestone_list[j].num_activities;
+        }
+        if (project->completed) {
+            portfolio->num_completed_projects++;
+        }
+    }
+}
+
+void print_portfolio_stats(const portfolio_t* portfolio) {
+    printf("\nPORTFOLIO STATISTICS (%d project(s))\n", portfolio->num_projects);
+    printf("========================================\n");
+    printf("Projects completed: %d/%d\n", portfolio->num_completed_projects, portfolio->num_projects);
+    printf("Milestones completed: %ld/%ld\n", portfolio->num_completed_milestones, portfolio->num_milestones);
+    printf("Activities completed: %ld/%ld\n", portfolio->num_activities - portfolio->num_open_activities,
+           portfolio->num_activities);
+    printf("Planned cost: $%.2f | Actual cost: $%.2f\n", portfolio->planned_cost / MONEY_SCALE,
+           portfolio->actual_cost / MONEY_SCALE);
+    printf("Planned duration: %ld day(s) | Actual duration: %ld day(s) (summed over projects)\n",
+           portfolio->planned_days, portfolio->actual_days);
+
+    // Variance of completed projects only, as print_project_stats does per project
+    double planned_cost = 0, actual_cost = 0;  // Money units, as in portfolio_t
+    long planned_days = 0, actual_days = 0;
+    for (int i = 0; i < portfolio->num_projects; i++) {
+        const project_t* project = portfolio->projects[i];
+        if (project->completed) {
+            planned_cost += (double)project->planned_cost;
+            actual_cost += (double)project->actual_cost;
+            planned_days += project->planned_duration;
+            actual_days += project->actual_duration;
+        }
+    }
+
+    if (portfolio->num_completed_projects > 0) {
+        double cost_variance = actual_cost - planned_cost;
+        long schedule_variance = actual_days - planned_days;
+        printf("\nVARIANCE ANALYSIS (completed projects)\n");
+        printf("----------------------------------------\n");
+        if (planned_cost > 0) {
+            printf("Cost variance: $%.2f (%.1f%% %s budget)\n", fabs(cost_variance) / MONEY_SCALE,
+                   fabs(cost_variance) / planned_cost * 100, cost_variance > 0 ? "over" : "under");
+        } else {
+            printf("Cost variance: $%.2f\n", cost_variance / MONEY_SCALE);
+        }
+        printf("Schedule variance: %ld day(s) %s schedule\n", labs(schedule_variance),
+               schedule_variance > 0 ? "behind" : "ahead of");
+    }
+}
+
+void portfolio_free(portfolio_t* portfolio) {
+    if (portfolio == NULL) {
+        return;
+    }
+
+    rollup_pool_t* pool = portfolio->pool;
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->num_workers; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+
+    for (int i = 0; i < portfolio->num_projects; i++) {
+        free_project(portfolio->projects[i]);
+    }
+    free(portfolio->projects);
+    free(pool);
+    free(portfolio);
+}
@@ -0,0 +1,106 @@
+/* portfolio.h */
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include "a1_data_structures.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define PORTFOLIO_MAX_THREADS 256
+
+/**
+ * Rollup Thread Pool
+ *
+ * Worker threads that stay parked between rollups. A rollup publishes a
+ * new generation and every thread, the caller included, claims projects
+ * from a shared atomic cursor until none are left. Claiming one project at
+ * a time keeps the cores busy even when project sizes differ widely.
+ *
+ * Fields:
+ * - threads/num_workers: Parked workers (the caller is the extra thread)
+ * - lock/start/done: Wake-up and completion signalling
+ * - generation: Incremented for every rollup; workers wait for a change
+ * - active: Workers still running the current generation
+ * - next_project: Shared cursor into the portfolio's project array
+ * - stop: Set once to shut the workers down
+ */
+typedef struct {
+    pthread_t threads[PORTFOLIO_MAX_THREADS];
+    int num_workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation;
+    int active;
+    atomic_int next_project;
+    bool stop;
+} rollup_pool_t;
+
+/**
+ * Portfolio Structure
+ *
+ * Owns many independent projects and the totals across them. Totals are
+ * refreshed by portfolio_rollup; costs are summed in double precision so a
+ * thousand projects do not lose cents.
+ *
+ * Fields:
+ * - projects/num_projects/capacity: Owned projects (freed with the portfolio)
+ * - pool: Rollup workers, started by portfolio_create
+ * - planned_cost/actual_cost: Summed project costs in money units (dollars,
+ *   or cents in fixed-point builds, where integer sums in a double are exact)
+ * - planned_days/actual_days: Summed project durations
+ * - num_milestones/num_completed_milestones: Milestone completion
+ * - num_activities/num_open_activities: Activity completion
+ * - num_completed_projects: Projects with every milestone complete
+ */
+typedef struct {
+    project_t** projects;
+    int num_projects;
+    int capacity;
+    rollup_pool_t* pool;
+    double planned_cost, actual_cost;
+    long planned_days, actual_days;
+    long num_milestones, num_completed_milestones;
+    long num_activities, num_open_activities;
+    int num_completed_projects;
+} portfolio_t;
+
+/**
+ * Create an empty portfolio
+ * @param num_threads Threads used by rollups (including the caller), >= 1
+ * @return New portfolio, exits on allocation failure
+ */
+portfolio_t* portfolio_create(int num_threads);
+
+/**
+ * Add a project; the portfolio takes ownership
+ */
+void portfolio_add(portfolio_t* portfolio, project_t* project);
+
+/**
+ * Load every project named in a manifest file
+ * One path per line: files ending in ".snap" are mapped with load_snapshot,
+ * anything else is read with load_project_csv. Blank lines and lines
+ * starting with '#' are ignored.
+ * @return Number of projects added, or -1 after printing an error
+ */
+int portfolio_load_manifest(portfolio_t* portfolio, const char* path);
+
+/**
+ * Recompute every milestone and project rollup, then the portfolio totals
+ * Projects are spread over the rollup threads; each project is handled by
+ * exactly one thread, so no locking is needed on project data.
+ */
+void portfolio_rollup(portfolio_t* portfolio);
+
+/**
+ * Print portfolio-wide statistics in the style of print_project_stats
+ */
+void print_portfolio_stats(const portfolio_t* portfolio);
+
+/**
+ * Stop the rollup threads and free every project
+ */
+void portfolio_free(portfolio_t* portfolio);
+
+#endif
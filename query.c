@@ -0,0 +1,1119 @@
+/* query.c */
+#include "query.h"
+#include "a1_functions.h"
+#include <ctype.h>
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+
+#define QUERY_MAX_TOKENS 128
+#define QUERY_TOKEN_SIZE 48
+#define QUERY_MAX_LIMIT 100000
+
+/**
+ * Gather of one field: the field's value for each selected activity
+ */
+typedef void (*query_gather_t)(const milestone_t* milestone, const int32_t* in, int count, double* out);
+
+static const struct {
+    const char* name;
+    bool activities, milestones;         // Valid for this target
+    bool money;                          // Held in money_t units, not dollars
+    bool ratio;                          // A fraction, so 120% reads as 1.2
+} FIELDS[QUERY_NUM_FIELDS] = {
+    [QUERY_FIELD_ID] = { "id", true, true, false, false },
+    [QUERY_FIELD_MILESTONE] = { "milestone", true, false, false, false },
+    [QUERY_FIELD_PLANNED_COST] = { "planned_cost", true, true, true, false },
+    [QUERY_FIELD_ACTUAL_COST] = { "actual_cost", true, true, true, false },
+    [QUERY_FIELD_PLANNED_HOURS] = { "planned_hours", true, true, false, false },
+    [QUERY_FIELD_ACTUAL_HOURS] = { "actual_hours", true, true, false, false },
+    [QUERY_FIELD_COMPLETED] = { "completed", true, true, false, false },
+    [QUERY_FIELD_COST_RATIO] = { "cost_ratio", true, true, false, true },
+    [QUERY_FIELD_HOURS_RATIO] = { "hours_ratio", true, true, false, true },
+    [QUERY_FIELD_COST_VARIANCE] = { "cost_variance", true, true, true, false },
+    [QUERY_FIELD_HOURS_VARIANCE] = { "hours_variance", true, true, false, false },
+    [QUERY_FIELD_ACTIVITIES] = { "activities", false, true, false, false },
+    [QUERY_FIELD_COMPLETED_ACTIVITIES] = { "completed_activities", false, true, false, false },
+    [QUERY_FIELD_PERCENT_COMPLETE] = { "percent_complete", false, true, false, false },
+};
+
+static const char* const AGGREGATE_NAMES[] = { "count", "sum", "avg", "min", "max" };
+
+/**
+ * Actual over planned; 0 when both are 0, infinite when only the plan is
+ */
+static inline double ratio(double actual, double planned) {
+    return planned > 0 ? actual / planned : (actual > 0 ? INFINITY : 0);
+}
+
+/**
+ * Dollars of a field value, which money fields hold in money_t units
+ */
+static inline double field_dollars(query_field_t field, double value) {
+    return FIELDS[field].money ? value / MONEY_SCALE : value;
+}
+
+// =============================================================================
+// COMPILED FILTERS
+// =============================================================================
+
+/**
+ * Define the filter and gather of an activity field from an expression of
+ * the activity index i over columns (the milestone's activity columns).
+ * Money stays in its stored units, as exact as the columns hold it, so
+ * bounds compiled into the same units compare without rounding.
+ */
+#define DEFINE_ACTIVITY_FIELD(name, expr)                                                             \
+    static int filter_##name(const milestone_t* milestone, const query_predicate_t* predicate,        \
+                             const int32_t* in, int count, int32_t* out) {                            \
+        const activity_columns_t* columns = &milestone->columns;                                     \
+        double lo = predicate->lo, hi = predicate->hi;                                                \
+        bool negate = predicate->negate;                                                              \
+        int matches = 0;                                                                              \
+        (void)columns;                                                                                \
+        if (in == NULL) {                                                                             \
+            for (int i = 0; i < count; i++) {                                                         \
+                double value = (expr);                                                                \
+                out[matches] = i;                                                                     \
+                matches += (value >= lo && value <= hi) != negate;                                    \
+            }                                                                                         \
+        } else {                                                                                      \
+            for (int j = 0; j < count; j++) {                                                         \
+                int i = in[j];                                                                        \
+                double value = (expr);                                                                \
+                out[matches] = i;                                                                     \
+                matches += (value >= lo && value <= hi) != negate;                                    \
+            }                                                                                         \
+        }                                                                                             \
+        return matches;                                                                               \
+    }                                                                                                 \
+    static void gather_##name(const milestone_t* milestone, const int32_t* in, int count, double* out) { \
+        const activity_columns_t* columns = &milestone->columns;                                     \
+        (void)columns;                                                                                \
+        for (int j = 0; j < count; j++) {                                                             \
+            int i = in[j];                                                                            \
+            out[j] = (expr);                                                                          \
+            (void)i;                                                                                  \
+        }                                                                                             \
+    }
+
+DEFINE_ACTIVITY_FIELD(id, milestone->activity_list[i].id)
+DEFINE_ACTIVITY_FIELD(milestone, milestone->id)
+DEFINE_ACTIVITY_FIELD(planned_cost, (double)columns->planned_cost[i])
+DEFINE_ACTIVITY_FIELD(actual_cost, (double)columns->actual_cost[i])
+DEFINE_ACTIVITY_FIELD(planned_hours, columns->planned_duration[i])
+DEFINE_ACTIVITY_FIELD(actual_hours, columns->actual_duration[i])
+DEFINE_ACTIVITY_FIELD(completed_flag, columns->completed[i])
+DEFINE_ACTIVITY_FIELD(cost_ratio, ratio((double)columns->actual_cost[i], (double)columns->planned_cost[i]))
+DEFINE_ACTIVITY_FIELD(hours_ratio, ratio(columns->actual_duration[i], columns->planned_duration[i]))
+DEFINE_ACTIVITY_FIELD(cost_variance, (double)(money_t)(columns->actual_cost[i] - columns->planned_cost[i]))
+DEFINE_ACTIVITY_FIELD(hours_variance, (double)columns->actual_duration[i] - columns->planned_duration[i])
+
+/**
+ * Completion filter: a first "open" test walks the open-activity bitmap a
+ * word at a time instead of testing every activity
+ */
+static int filter_completed(const milestone_t* milestone, const query_predicate_t* predicate,
+                            const int32_t* in, int count, int32_t* out) {
+    if (in != NULL || predicate->negate || predicate->lo != 0 || predicate->hi != 0) {
+        return filter_completed_flag(milestone, predicate, in, count, out);
+    }
+
+    const uint64_t* open_bits = milestone->columns.open_bits;
+    int matches = 0;
+    for (int word = 0; word * ID_WORD_BITS < count; word++) {
+        uint64_t bits = open_bits[word];
+        while (bits != 0) {
+            out[matches++] = word * ID_WORD_BITS + __builtin_ctzll(bits);
+            bits &= bits - 1;
+        }
+    }
+    return matches;
+}
+
+static const query_filter_t ACTIVITY_FILTERS[QUERY_NUM_FIELDS] = {
+    [QUERY_FIELD_ID] = filter_id,
+    [QUERY_FIELD_MILESTONE] = filter_milestone,
+    [QUERY_FIELD_PLANNED_COST] = filter_planned_cost,
+    [QUERY_FIELD_ACTUAL_COST] = filter_actual_cost,
+    [QUERY_FIELD_PLANNED_HOURS] = filter_planned_hours,
+    [QUERY_FIELD_ACTUAL_HOURS] = filter_actual_hours,
+    [QUERY_FIELD_COMPLETED] = filter_completed,
+    [QUERY_FIELD_COST_RATIO] = filter_cost_ratio,
+    [QUERY_FIELD_HOURS_RATIO] = filter_hours_ratio,
+    [QUERY_FIELD_COST_VARIANCE] = filter_cost_variance,
+    [QUERY_FIELD_HOURS_VARIANCE] = filter_hours_variance,
+};
+
+static const query_gather_t ACTIVITY_GATHERS[QUERY_NUM_FIELDS] = {
+    [QUERY_FIELD_ID] = gather_id,
+    [QUERY_FIELD_MILESTONE] = gather_milestone,
+    [QUERY_FIELD_PLANNED_COST] = gather_planned_cost,
+    [QUERY_FIELD_ACTUAL_COST] = gather_actual_cost,
+    [QUERY_FIELD_PLANNED_HOURS] = gather_planned_hours,
+    [QUERY_FIELD_ACTUAL_HOURS] = gather_actual_hours,
+    [QUERY_FIELD_COMPLETED] = gather_completed_flag,
+    [QUERY_FIELD_COST_RATIO] = gather_cost_ratio,
+    [QUERY_FIELD_HOURS_RATIO] = gather_hours_ratio,
+    [QUERY_FIELD_COST_VARIANCE] = gather_cost_variance,
+    [QUERY_FIELD_HOURS_VARIANCE] = gather_hours_variance,
+};
+
+/**
+ * Value of a field for a milestone row (money in money_t units)
+ */
+static double milestone_value(const milestone_t* milestone, query_field_t field) {
+    switch (field) {
+        case QUERY_FIELD_ID:
+            return milestone->id;
+        case QUERY_FIELD_PLANNED_COST:
+            return (double)milestone->planned_cost;
+        case QUERY_FIELD_ACTUAL_COST:
+            return (double)milestone->actual_cost;
+        case QUERY_FIELD_PLANNED_HOURS:
+            return (double)milestone->planned_hours;
+        case QUERY_FIELD_ACTUAL_HOURS:
+            return (double)milestone->actual_hours;
+        case QUERY_FIELD_COMPLETED:
+            return milestone->completed;
+        case QUERY_FIELD_COST_RATIO:
+            return ratio((double)milestone->actual_cost, (double)milestone->planned_cost);
+        case QUERY_FIELD_HOURS_RATIO:
+            return ratio((double)milestone->actual_hours, (double)milestone->planned_hours);
+        case QUERY_FIELD_COST_VARIANCE:
+            return (double)(money_t)(milestone->actual_cost - milestone->planned_cost);
+        case QUERY_FIELD_HOURS_VARIANCE:
+            return (double)milestone->actual_hours - (double)milestone->planned_hours;
+        case QUERY_FIELD_ACTIVITIES:
+            return milestone->num_activities;
+        case QUERY_FIELD_COMPLETED_ACTIVITIES:
+            return milestone->num_completed;
+        case QUERY_FIELD_PERCENT_COMPLETE:
+            return milestone->num_activities > 0
+                   ? 100.0 * milestone->num_completed / milestone->num_activities : 100.0;
+        default:
+            return 0;
+    }
+}
+
+static bool matches_predicate(double value, const query_predicate_t* predicate) {
+    return (value >= predicate->lo && value <= predicate->hi) != predicate->negate;
+}
+
+// =============================================================================
+// MILESTONE SUMMARIES
+// =============================================================================
+
+/**
+ * Range every activity of a milestone has for a field, from the column
+ * bounds and completion count
+ * @return false if the field has no summary (every milestone may match)
+ */
+static bool activity_field_bounds(const milestone_t* milestone, query_field_t field, double* lo, double* hi) {
+    const activity_columns_t* columns = &milestone->columns;
+    double planned_lo, planned_hi, actual_lo, actual_hi;
+
+    switch (field) {
+        case QUERY_FIELD_MILESTONE:
+            *lo = *hi = milestone->id;
+            return true;
+        case QUERY_FIELD_PLANNED_COST:
+            *lo = columns->min[BOUND_PLANNED_COST];
+            *hi = columns->max[BOUND_PLANNED_COST];
+            return true;
+        case QUERY_FIELD_ACTUAL_COST:
+            *lo = columns->min[BOUND_ACTUAL_COST];
+            *hi = columns->max[BOUND_ACTUAL_COST];
+            return true;
+        case QUERY_FIELD_PLANNED_HOURS:
+            *lo = columns->min[BOUND_PLANNED_DURATION];
+            *hi = columns->max[BOUND_PLANNED_DURATION];
+            return true;
+        case QUERY_FIELD_ACTUAL_HOURS:
+            *lo = columns->min[BOUND_ACTUAL_DURATION];
+            *hi = columns->max[BOUND_ACTUAL_DURATION];
+            return true;
+        case QUERY_FIELD_COMPLETED:
+            *lo = milestone->num_completed == milestone->num_activities ? 1 : 0;
+            *hi = milestone->num_completed > 0 ? 1 : 0;
+            return true;
+        case QUERY_FIELD_COST_RATIO:
+        case QUERY_FIELD_COST_VARIANCE:
+            planned_lo = columns->min[BOUND_PLANNED_COST];
+            planned_hi = columns->max[BOUND_PLANNED_COST];
+            actual_lo = columns->min[BOUND_ACTUAL_COST];
+            actual_hi = columns->max[BOUND_ACTUAL_COST];
+            break;
+        case QUERY_FIELD_HOURS_RATIO:
+        case QUERY_FIELD_HOURS_VARIANCE:
+            planned_lo = columns->min[BOUND_PLANNED_DURATION];
+            planned_hi = columns->max[BOUND_PLANNED_DURATION];
+            actual_lo = columns->min[BOUND_ACTUAL_DURATION];
+            actual_hi = columns->max[BOUND_ACTUAL_DURATION];
+            break;
+        default:
+            return false;
+    }
+
+    if (field == QUERY_FIELD_COST_VARIANCE) {
+        // Rounded as the filter rounds a difference, which keeps the order
+        *lo = (double)(money_t)(actual_lo - planned_hi);
+        *hi = (double)(money_t)(actual_hi - planned_lo);
+        return true;
+    }
+    if (field == QUERY_FIELD_HOURS_VARIANCE) {
+        *lo = actual_lo - planned_hi;
+        *hi = actual_hi - planned_lo;
+        return true;
+    }
+    if (planned_lo <= 0) {
+        // A zero plan makes the ratio 0 or infinite
+        *lo = actual_lo < 0 ? -INFINITY : 0;
+        *hi = INFINITY;
+        return true;
+    }
+    // Division is monotonic in each operand, so the extremes are at corners
+    double corners[4] = { actual_lo / planned_lo, actual_lo / planned_hi,
+                          actual_hi / planned_lo, actual_hi / planned_hi };
+    *lo = *hi = corners[0];
+    for (int c = 1; c < 4; c++) {
+        *lo = corners[c] < *lo ? corners[c] : *lo;
+        *hi = corners[c] > *hi ? corners[c] : *hi;
+    }
+    return true;
+}
+
+/**
+ * Whether any activity of the milestone can satisfy the predicate
+ */
+static bool milestone_may_match(const milestone_t* milestone, const query_predicate_t* predicate) {
+    double lo, hi;
+    if (!activity_field_bounds(milestone, predicate->field, &lo, &hi)) {
+        return true;
+    }
+    if (predicate->negate) {
+        // Only ruled out when every value lies inside the excluded range
+        return !(lo >= predicate->lo && hi <= predicate->hi);
+    }
+    return hi >= predicate->lo && lo <= predicate->hi;
+}
+
+// =============================================================================
+// PARSING
+// =============================================================================
+
+typedef struct {
+    char tokens[QUERY_MAX_TOKENS][QUERY_TOKEN_SIZE];
+    int num_tokens, position;
+    char* error;
+} parser_t;
+
+static bool tokenize(parser_t* parser, const char* text) {
+    const char* p = text;
+    parser->num_tokens = 0;
+
+    while (*p != '\0') {
+        if (isspace((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+
+        const char* start = p;
+        if (isalpha((unsigned char)*p) || *p == '_') {
+            while (isalnum((unsigned char)*p) || *p == '_') {
+                p++;
+            }
+        } else if (isdigit((unsigned char)*p) || *p == '.' ||
+                   (*p == '-' && (isdigit((unsigned char)p[1]) || p[1] == '.'))) {
+            p++;
+            while (isdigit((unsigned char)*p) || *p == '.') {
+                p++;
+            }
+            if (*p == '%') {
+                p++;
+            }
+        } else if ((p[0] == '!' && p[1] == '=') || (p[0] == '<' && (p[1] == '=' || p[1] == '>')) ||
+                   (p[0] == '>' && p[1] == '=')) {
+            p += 2;
+        } else if (strchr("*,()=<>", *p) != NULL) {
+            p++;
+        } else {
+            snprintf(parser->error, QUERY_ERROR_SIZE, "unexpected character '%c'", *p);
+            return false;
+        }
+
+        size_t length = (size_t)(p - start);
+        if (length >= QUERY_TOKEN_SIZE || parser->num_tokens == QUERY_MAX_TOKENS) {
+            snprintf(parser->error, QUERY_ERROR_SIZE, "query too long");
+            return false;
+        }
+        memcpy(parser->tokens[parser->num_tokens], start, length);
+        parser->tokens[parser->num_tokens++][length] = '\0';
+    }
+    return true;
+}
+
+static const char* peek(const parser_t* parser, int ahead) {
+    int index = parser->position + ahead;
+    return index < parser->num_tokens ? parser->tokens[index] : "";
+}
+
+static bool accept(parser_t* parser, const char* word) {
+    if (parser->position < parser->num_tokens && strcasecmp(parser->tokens[parser->position], word) == 0) {
+        parser->position++;
+        return true;
+    }
+    return false;
+}
+
+static bool expect(parser_t* parser, const char* word) {
+    if (accept(parser, word)) {
+        return true;
+    }
+    snprintf(parser->error, QUERY_ERROR_SIZE, "expected '%s' at '%s'", word,
+             parser->position < parser->num_tokens ? peek(parser, 0) : "end of query");
+    return false;
+}
+
+/**
+ * @param percent Whether a trailing % (a fraction, 120% is 1.2) is accepted
+ */
+static bool parse_number(parser_t* parser, double* value, bool percent) {
+    const char* token = peek(parser, 0);
+    char* end;
+    *value = strtod(token, &end);
+    if (end == token || (*end != '\0' && strcmp(end, "%") != 0)) {
+        snprintf(parser->error, QUERY_ERROR_SIZE, "expected a number at '%s'",
+                 *token != '\0' ? token : "end of query");
+        return false;
+    }
+    if (*end == '%' && !percent) {
+        snprintf(parser->error, QUERY_ERROR_SIZE, "'%%' only applies to cost_ratio and hours_ratio, at '%s'",
+                 token);
+        return false;
+    }
+    if (*end == '%') {
+        *value /= 100;
+    }
+    parser->position++;
+    return true;
+}
+
+/**
+ * A money bound in money_t units: the amount the dollars would be stored as,
+ * stepped one unit (a cent, or to the next float) away when the comparison
+ * is strict
+ * @param step -1 for a strict upper bound, 1 for a strict lower bound, else 0
+ */
+static double money_bound(double dollars, int step) {
+    if (!(fabs(dollars) <= MONEY_MAX_DOLLARS)) {
+        return dollars * MONEY_SCALE;  // Beyond every amount
+    }
+    money_t amount = money_from_dollars(dollars);
+#ifdef PM_FIXED_POINT
+    return (double)(amount + step);
+#else
+    return step == 0 ? amount : nextafterf(amount, step * INFINITY);
+#endif
+}
+
+/**
+ * A bound of the closed interval a comparison becomes
+ * @param step -1 for a strict upper bound, 1 for a strict lower bound, else 0
+ */
+static double closed_bound(query_field_t field, double value, int step) {
+    if (FIELDS[field].money) {
+        return money_bound(value, step);
+    }
+    return step == 0 ? value : nextafter(value, step * INFINITY);
+}
+
+static bool parse_field(parser_t* parser, query_field_t* field) {
+    const char* token = peek(parser, 0);
+    for (int f = 0; f < QUERY_NUM_FIELDS; f++) {
+        if (strcasecmp(token, FIELDS[f].name) == 0) {
+            *field = (query_field_t)f;
+            parser->position++;
+            return true;
+        }
+    }
+    if (*token == '\0') {
+        snprintf(parser->error, QUERY_ERROR_SIZE, "expected a field at end of query");
+    } else {
+        snprintf(parser->error, QUERY_ERROR_SIZE, "unknown field '%s'", token);
+    }
+    return false;
+}
+
+static bool parse_aggregate(parser_t* parser, query_t* query) {
+    if (query->num_aggregates == QUERY_MAX_AGGREGATES) {
+        snprintf(parser->error, QUERY_ERROR_SIZE, "at most %d aggregates", QUERY_MAX_AGGREGATES);
+        return false;
+    }
+
+    int op = -1;
+    for (int o = QUERY_COUNT; o <= QUERY_MAX; o++) {
+        if (accept(parser, AGGREGATE_NAMES[o])) {
+            op = o;
+            break;
+        }
+    }
+    if (op < 0) {
+        snprintf(parser->error, QUERY_ERROR_SIZE, "expected '*' or an aggregate at '%s'",
+                 *peek(parser, 0) != '\0' ? peek(parser, 0) : "end of query");
+        return false;
+    }
+
+    query->aggregates[query->num_aggregates].op = (query_aggregate_op_t)op;
+    query->aggregates[query->num_aggregates].field = QUERY_FIELD_ID;
+    if (op == QUERY_COUNT) {
+        // "count" or "count(*)"
+        if (accept(parser, "(") && !(expect(parser, "*") && expect(parser, ")"))) {
+            return false;
+        }
+    } else if (!expect(parser, "(") || !parse_field(parser, &query->aggregates[query->num_aggregates].field) ||
+               !expect(parser, ")")) {
+        return false;
+    }
+    query->num_aggregates++;
+    return true;
+}
+
+static bool is_comparison(const char* token) {
+    static const char* const OPERATORS[] = { "=", "!=", "<>", "<", "<=", ">", ">=" };
+    for (size_t i = 0; i < sizeof(OPERATORS) / sizeof(OPERATORS[0]); i++) {
+        if (strcmp(token, OPERATORS[i]) == 0) {
+            return true;
+        }
+    }
+    return strcasecmp(token, "between") == 0;
+}
+
+static bool parse_condition(parser_t* parser, query_predicate_t* predicate) {
+    memset(predicate, 0, sizeof(*predicate));
+
+    // Bare "open" and "completed" are shorthands for the completion flag
+    if (strcasecmp(peek(parser, 0), "open") == 0 && !is_comparison(peek(parser, 1))) {
+        parser->position++;
+        predicate->field = QUERY_FIELD_COMPLETED;
+        predicate->lo = predicate->hi = 0;
+        return true;
+    }
+    if (strcasecmp(peek(parser, 0), "completed") == 0 && !is_comparison(peek(parser, 1))) {
+        parser->position++;
+        predicate->field = QUERY_FIELD_COMPLETED;
+        predicate->lo = predicate->hi = 1;
+        return true;
+    }
+
+    if (!parse_field(parser, &predicate->field)) {
+        return false;
+    }
+
+    double value;
+    if (accept(parser, "between")) {
+        bool percent = FIELDS[predicate->field].ratio;
+        if (!parse_number(parser, &predicate->lo, percent) || !expect(parser, "and") ||
+            !parse_number(parser, &predicate->hi, percent)) {
+            return false;
+        }
+        predicate->lo = closed_bound(predicate->field, predicate->lo, 0);
+        predicate->hi = closed_bound(predicate->field, predicate->hi, 0);
+        return true;
+    }
+    if (accept(parser, "=")) {
+        predicate->lo = predicate->hi = 0;
+    } else if (accept(parser, "!=") || accept(parser, "<>")) {
+        predicate->negate = true;
+    } else if (accept(parser, "<=")) {
+        predicate->lo = -INFINITY;
+    } else if (accept(parser, "<")) {
+        predicate->lo = -INFINITY;
+        predicate->hi = -1;       // Marks a strict bound below
+    } else if (accept(parser, ">=")) {
+        predicate->hi = INFINITY;
+    } else if (accept(parser, ">")) {
+        predicate->hi = INFINITY;
+        predicate->lo = 1;        // Marks a strict bound below
+    } else {
+        snprintf(parser->error, QUERY_ERROR_SIZE, "expected a comparison after '%s'", FIELDS[predicate->field].name);
+        return false;
+    }
+    if (!parse_number(parser, &value, FIELDS[predicate->field].ratio)) {
+        return false;
+    }
+
+    // Every comparison becomes a closed interval, money in money_t units
+    if (predicate->lo == -INFINITY) {
+        predicate->hi = closed_bound(predicate->field, value, predicate->hi < 0 ? -1 : 0);
+    } else if (predicate->hi == INFINITY) {
+        predicate->lo = closed_bound(predicate->field, value, predicate->lo > 0 ? 1 : 0);
+    } else {
+        predicate->lo = predicate->hi = closed_bound(predicate->field, value, 0);
+    }
+    return true;
+}
+
+/**
+ * Check the parsed query for combinations that have no meaning
+ */
+static bool validate_query(const query_t* query, char error[QUERY_ERROR_SIZE]) {
+    bool activities = query->target == QUERY_ACTIVITIES;
+    const char* target = activities ? "activities" : "milestones";
+
+    for (int a = 0; a < query->num_aggregates; a++) {
+        query_field_t field = query->aggregates[a].field;
+        if (query->aggregates[a].op != QUERY_COUNT &&
+            !(activities ? FIELDS[field].activities : FIELDS[field].milestones)) {
+            snprintf(error, QUERY_ERROR_SIZE, "%s have no field '%s'", target, FIELDS[field].name);
+            return false;
+        }
+    }
+    for (int p = 0; p < query->num_predicates; p++) {
+        query_field_t field = query->predicates[p].field;
+        if (!(activities ? FIELDS[field].activities : FIELDS[field].milestones)) {
+            snprintf(error, QUERY_ERROR_SIZE, "%s have no field '%s'", target, FIELDS[field].name);
+            return false;
+        }
+    }
+    if (query->ordered && !(activities ? FIELDS[query->order_field].activities
+                                       : FIELDS[query->order_field].milestones)) {
+        snprintf(error, QUERY_ERROR_SIZE, "%s have no field '%s'", target, FIELDS[query->order_field].name);
+        return false;
+    }
+    if (query->group_by_milestone && (!activities || query->num_aggregates == 0)) {
+        snprintf(error, QUERY_ERROR_SIZE, "'group by milestone' needs aggregates over activities");
+        return false;
+    }
+    if (query->ordered && query->num_aggregates > 0) {
+        snprintf(error, QUERY_ERROR_SIZE, "'order by' applies to rows, not aggregates");
+        return false;
+    }
+    return true;
+}
+
+bool query_compile(const char* text, query_t* query, char error[QUERY_ERROR_SIZE]) {
+    parser_t* parser = malloc(sizeof(parser_t));
+    if (parser == NULL) {
+        printf("ERROR: Failed to allocate query parser. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    parser->position = 0;
+    parser->error = error;
+    error[0] = '\0';
+
+    memset(query, 0, sizeof(*query));
+    query->limit = QUERY_DEFAULT_LIMIT;
+
+    bool ok = tokenize(parser, text);
+    if (ok && accept(parser, "select")) {
+        if (!accept(parser, "*")) {
+            do {
+                ok = parse_aggregate(parser, query);
+            } while (ok && accept(parser, ","));
+        }
+        ok = ok && expect(parser, "from");
+    }
+
+    if (ok) {
+        if (accept(parser, "activities")) {
+            query->target = QUERY_ACTIVITIES;
+        } else if (accept(parser, "milestones")) {
+            query->target = QUERY_MILESTONES;
+        } else {
+            snprintf(error, QUERY_ERROR_SIZE, "expected 'activities' or 'milestones' at '%s'",
+                     *peek(parser, 0) != '\0' ? peek(parser, 0) : "end of query");
+            ok = false;
+        }
+    }
+
+    if (ok && accept(parser, "where")) {
+        do {
+            query_predicate_t predicate;
+            ok = parse_condition(parser, &predicate);
+            if (!ok) {
+                break;
+            }
+            bool on_milestone = query->target == QUERY_ACTIVITIES && predicate.field == QUERY_FIELD_MILESTONE;
+            int* count = on_milestone ? &query->num_milestone_predicates : &query->num_predicates;
+            if (*count == QUERY_MAX_PREDICATES) {
+                snprintf(error, QUERY_ERROR_SIZE, "at most %d conditions", QUERY_MAX_PREDICATES);
+                ok = false;
+                break;
+            }
+            (on_milestone ? query->milestone_predicates : query->predicates)[(*count)++] = predicate;
+        } while (accept(parser, "and"));
+    }
+
+    if (ok && accept(parser, "group")) {
+        ok = expect(parser, "by") && expect(parser, "milestone");
+        query->group_by_milestone = true;
+    }
+    if (ok && accept(parser, "order")) {
+        ok = expect(parser, "by") && parse_field(parser, &query->order_field);
+        query->ordered = true;
+        query->descending = ok && accept(parser, "desc");
+        if (ok && !query->descending) {
+            accept(parser, "asc");
+        }
+    }
+    if (ok && accept(parser, "limit")) {
+        double limit;
+        ok = parse_number(parser, &limit, false);
+        if (ok && (limit < 1 || limit > QUERY_MAX_LIMIT || limit != floor(limit))) {
+            snprintf(error, QUERY_ERROR_SIZE, "limit must be a whole number from 1 to %d", QUERY_MAX_LIMIT);
+            ok = false;
+        }
+        query->limit = (int)limit;
+    }
+    if (ok && parser->position < parser->num_tokens) {
+        snprintf(error, QUERY_ERROR_SIZE, "unexpected '%s'", peek(parser, 0));
+        ok = false;
+    }
+    free(parser);
+
+    if (!ok || !validate_query(query, error)) {
+        return false;
+    }
+
+    // Completion first: it prunes most and its first pass uses the bitmap
+    if (query->target == QUERY_ACTIVITIES) {
+        int first = 0;
+        for (int p = 0; p < query->num_predicates; p++) {
+            if (query->predicates[p].field == QUERY_FIELD_COMPLETED) {
+                query_predicate_t predicate = query->predicates[p];
+                memmove(&query->predicates[first + 1], &query->predicates[first],
+                        (size_t)(p - first) * sizeof(query_predicate_t));
+                query->predicates[first++] = predicate;
+            }
+        }
+        for (int p = 0; p < query->num_predicates; p++) {
+            query->filters[p] = ACTIVITY_FILTERS[query->predicates[p].field];
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// EXECUTION
+// =============================================================================
+
+static void init_accumulator(const query_t* query, query_accumulator_t* accumulator) {
+    accumulator->count = 0;
+    for (int a = 0; a < query->num_aggregates; a++) {
+        switch (query->aggregates[a].op) {
+            case QUERY_MIN:
+                accumulator->value[a] = INFINITY;
+                break;
+            case QUERY_MAX:
+                accumulator->value[a] = -INFINITY;
+                break;
+            default:
+                accumulator->value[a] = 0;
+        }
+    }
+}
+
+static void add_value(const query_t* query, query_accumulator_t* accumulator, int a, double value) {
+    switch (query->aggregates[a].op) {
+        case QUERY_SUM:
+        case QUERY_AVG:
+            accumulator->value[a] += value;
+            break;
+        case QUERY_MIN:
+            accumulator->value[a] = value < accumulator->value[a] ? value : accumulator->value[a];
+            break;
+        case QUERY_MAX:
+            accumulator->value[a] = value > accumulator->value[a] ? value : accumulator->value[a];
+            break;
+        case QUERY_COUNT:
+            break;
+    }
+}
+
+static void merge_accumulator(const query_t* query, query_accumulator_t* into, const query_accumulator_t* from) {
+    into->count += from->count;
+    for (int a = 0; a < query->num_aggregates; a++) {
+        add_value(query, into, a, from->value[a]);
+    }
+}
+
+/**
+ * Whether row a ranks below row b in the requested order
+ */
+static bool ranks_below(const query_t* query, const query_row_t* a, const query_row_t* b) {
+    return query->descending ? a->key < b->key : a->key > b->key;
+}
+
+/**
+ * Offer a row to the result: appended while there is room; when ordered,
+ * rows form a heap with the lowest-ranked row at the root, which a better
+ * row replaces once the heap is full
+ */
+static void offer_row(query_result_t* result, const query_row_t* row) {
+    const query_t* query = result->query;
+    query_row_t* rows = result->rows;
+
+    if (result->num_rows < query->limit) {
+        int i = result->num_rows++;
+        rows[i] = *row;
+        while (query->ordered && i > 0 && ranks_below(query, &rows[i], &rows[(i - 1) / 2])) {
+            query_row_t swap = rows[i];
+            rows[i] = rows[(i - 1) / 2];
+            rows[(i - 1) / 2] = swap;
+            i = (i - 1) / 2;
+        }
+        return;
+    }
+    if (!query->ordered || !ranks_below(query, &rows[0], row)) {
+        return;
+    }
+
+    int i = 0;
+    rows[0] = *row;
+    for (;;) {
+        int lowest = i, left = 2 * i + 1, right = left + 1;
+        if (left < result->num_rows && ranks_below(query, &rows[left], &rows[lowest])) {
+            lowest = left;
+        }
+        if (right < result->num_rows && ranks_below(query, &rows[right], &rows[lowest])) {
+            lowest = right;
+        }
+        if (lowest == i) {
+            break;
+        }
+        query_row_t swap = rows[i];
+        rows[i] = rows[lowest];
+        rows[lowest] = swap;
+        i = lowest;
+    }
+}
+
+/**
+ * Whether a milestone can still place a row in a full top-K heap
+ */
+static bool can_beat_heap(const query_result_t* result, const milestone_t* milestone) {
+    const query_t* query = result->query;
+    double lo, hi;
+    if (!query->ordered || query->num_aggregates > 0 || result->num_rows < query->limit ||
+        !activity_field_bounds(milestone, query->order_field, &lo, &hi)) {
+        return true;
+    }
+    return query->descending ? hi > result->rows[0].key : lo < result->rows[0].key;
+}
+
+void query_result_init(query_result_t* result, const query_t* query) {
+    memset(result, 0, sizeof(*result));
+    result->query = query;
+    init_accumulator(query, &result->totals);
+    if (query->num_aggregates == 0) {
+        result->rows = malloc((size_t)query->limit * sizeof(query_row_t));
+        if (result->rows == NULL) {
+            printf("ERROR: Failed to allocate query rows. Exiting...\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/**
+ * Filter one milestone's activities and add the matches to the result
+ */
+static void scan_milestone(query_result_t* result, project_t* project, int milestone_index,
+                           int32_t* selection[2], double* values) {
+    const query_t* query = result->query;
+    milestone_t* milestone = &project->milestone_list[milestone_index];
+
+    for (int p = 0; p < query->num_milestone_predicates; p++) {
+        if (!matches_predicate(milestone->id, &query->milestone_predicates[p])) {
+            return;  // Decided by the milestone ID alone, not counted as skipped
+        }
+    }
+    if (milestone->num_activities == 0) {
+        return;
+    }
+    if (!milestone->columns.valid) {
+        build_activity_columns(project->arena, milestone);
+    }
+    for (int p = 0; p < query->num_predicates; p++) {
+        if (!milestone_may_match(milestone, &query->predicates[p])) {
+            result->milestones_skipped++;
+            return;
+        }
+    }
+    if (!can_beat_heap(result, milestone)) {
+        result->milestones_skipped++;
+        result->milestones_outranked++;
+        return;
+    }
+    result->milestones_scanned++;
+
+    // Each filter narrows the previous one's selection
+    int count = milestone->num_activities;
+    const int32_t* in = NULL;
+    for (int p = 0; p < query->num_predicates && count > 0; p++) {
+        int32_t* out = selection[p & 1];
+        count = query->filters[p](milestone, &query->predicates[p], in, count, out);
+        in = out;
+    }
+    if (count == 0) {
+        return;
+    }
+    if (in == NULL) {
+        for (int i = 0; i < count; i++) {
+            selection[0][i] = i;
+        }
+        in = selection[0];
+    }
+    result->matches += count;
+
+    if (query->num_aggregates == 0) {
+        query_row_t row = { project, milestone_index, 0, 0 };
+        if (query->ordered) {
+            ACTIVITY_GATHERS[query->order_field](milestone, in, count, values);
+        }
+        for (int j = 0; j < count; j++) {
+            row.activity_index = in[j];
+            row.key = query->ordered ? values[j] : 0;
+            offer_row(result, &row);
+            if (!query->ordered && result->num_rows == query->limit) {
+                break;
+            }
+        }
+        return;
+    }
+
+    query_accumulator_t accumulator;
+    init_accumulator(query, &accumulator);
+    accumulator.count = count;
+    for (int a = 0; a < query->num_aggregates; a++) {
+        if (query->aggregates[a].op == QUERY_COUNT) {
+            continue;
+        }
+        ACTIVITY_GATHERS[query->aggregates[a].field](milestone, in, count, values);
+        for (int j = 0; j < count; j++) {
+            add_value(query, &accumulator, a, values[j]);
+        }
+    }
+    merge_accumulator(query, &result->totals, &accumulator);
+
+    if (query->group_by_milestone) {
+        if (result->num_groups == result->group_capacity) {
+            result->group_capacity = result->group_capacity > 0 ? result->group_capacity * 2 : 64;
+            result->groups = realloc(result->groups, (size_t)result->group_capacity * sizeof(query_group_t));
+            if (result->groups == NULL) {
+                printf("ERROR: Failed to allocate query groups. Exiting...\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        query_group_t* group = &result->groups[result->num_groups++];
+        group->project = project;
+        group->milestone_index = milestone_index;
+        group->accumulator = accumulator;
+    }
+}
+
+/**
+ * Test every milestone as a row
+ */
+static void scan_milestones(query_result_t* result, project_t* project) {
+    const query_t* query = result->query;
+
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        bool match = true;
+        for (int p = 0; p < query->num_predicates && match; p++) {
+            match = matches_predicate(milestone_value(milestone, query->predicates[p].field), &query->predicates[p]);
+        }
+        if (!match) {
+            continue;
+        }
+        result->matches++;
+
+        if (query->num_aggregates == 0) {
+            query_row_t row = { project, i, -1, query->ordered ? milestone_value(milestone, query->order_field) : 0 };
+            offer_row(result, &row);
+            continue;
+        }
+        result->totals.count++;
+        for (int a = 0; a < query->num_aggregates; a++) {
+            add_value(query, &result->totals, a, milestone_value(milestone, query->aggregates[a].field));
+        }
+    }
+    result->milestones_scanned += project->num_milestones;
+}
+
+void query_accumulate(query_result_t* result, project_t* project) {
+    result->num_projects++;
+    if (result->query->target == QUERY_MILESTONES) {
+        scan_milestones(result, project);
+        return;
+    }
+
+    int largest = 1;
+    for (int i = 0; i < project->num_milestones; i++) {
+        if (project->milestone_list[i].num_activities > largest) {
+            largest = project->milestone_list[i].num_activities;
+        }
+    }
+    int32_t* selection[2] = { malloc((size_t)largest * sizeof(int32_t)), malloc((size_t)largest * sizeof(int32_t)) };
+    double* values = malloc((size_t)largest * sizeof(double));
+    if (selection[0] == NULL || selection[1] == NULL || values == NULL) {
+        printf("ERROR: Failed to allocate query buffers. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < project->num_milestones; i++) {
+        scan_milestone(result, project, i, selection, values);
+    }
+
+    free(selection[0]);
+    free(selection[1]);
+    free(values);
+}
+
+static int compare_descending(const void* a, const void* b) {
+    double x = ((const query_row_t*)a)->key, y = ((const query_row_t*)b)->key;
+    return (x < y) - (x > y);
+}
+
+static int compare_ascending(const void* a, const void* b) {
+    return compare_descending(b, a);
+}
+
+void query_finish(query_result_t* result) {
+    if (result->query->ordered && result->num_rows > 1) {
+        qsort(result->rows, (size_t)result->num_rows, sizeof(query_row_t),
+              result->query->descending ? compare_descending : compare_ascending);
+    }
+}
+
+// =============================================================================
+// REPORTING
+// =============================================================================
+
+/**
+ * Print one aggregate value, or '-' when it has no matches to cover
+ */
+static void print_aggregate(const query_t* query, const query_accumulator_t* accumulator, int a) {
+    double value = field_dollars(query->aggregates[a].field, accumulator->value[a]);
+    if (query->aggregates[a].op == QUERY_COUNT) {
+        printf(" %22ld", accumulator->count);
+    } else if (accumulator->count == 0) {
+        printf(" %22s", "-");
+    } else if (query->aggregates[a].op == QUERY_AVG) {
+        printf(" %22.2f", value / (double)accumulator->count);
+    } else {
+        printf(" %22.2f", value);
+    }
+}
+
+static void print_aggregates(const query_result_t* result) {
+    const query_t* query = result->query;
+    char label[QUERY_TOKEN_SIZE * 2];
+
+    printf("%-24s", query->group_by_milestone ? "Milestone" : "");
+    for (int a = 0; a < query->num_aggregates; a++) {
+        if (query->aggregates[a].op == QUERY_COUNT) {
+            snprintf(label, sizeof(label), "count");
+        } else {
+            snprintf(label, sizeof(label), "%s(%s)", AGGREGATE_NAMES[query->aggregates[a].op],
+                     FIELDS[query->aggregates[a].field].name);
+        }
+        printf(" %22.22s", label);
+    }
+    printf("\n");
+
+    int shown = 0;
+    for (int g = 0; g < result->num_groups && shown < query->limit; g++, shown++) {
+        const query_group_t* group = &result->groups[g];
+        const milestone_t* milestone = &group->project->milestone_list[group->milestone_index];
+        printf("%-24.24s", get_name(group->project, milestone->name));
+        for (int a = 0; a < query->num_aggregates; a++) {
+            print_aggregate(query, &group->accumulator, a);
+        }
+        printf("\n");
+    }
+    if (result->num_groups > shown) {
+        printf("... %d more milestone(s)\n", result->num_groups - shown);
+    }
+
+    printf("%-24s", query->group_by_milestone ? "(all)" : "");
+    for (int a = 0; a < query->num_aggregates; a++) {
+        print_aggregate(query, &result->totals, a);
+    }
+    printf("\n");
+}
+
+static void print_rows(const query_result_t* result) {
+    const query_t* query = result->query;
+    bool several = result->num_projects > 1;
+
+    if (several) {
+        printf("%-16s ", "Project");
+    }
+    if (query->target == QUERY_ACTIVITIES) {
+        printf("%-6s %-24s %-20s %7s %7s %12s %12s %8s %4s", "ID", "Activity", "Milestone", "Plan h", "Act h",
+               "Plan $", "Act $", "Cost %", "Done");
+    } else {
+        printf("%-6s %-24s %10s %7s %12s %12s %8s %8s", "ID", "Milestone", "Activities", "Done %", "Plan $",
+               "Act $", "Plan h", "Act h");
+    }
+    if (query->ordered) {
+        printf(" %20.20s", FIELDS[query->order_field].name);
+    }
+    printf("\n");
+
+    for (int r = 0; r < result->num_rows; r++) {
+        const query_row_t* row = &result->rows[r];
+        const milestone_t* milestone = &row->project->milestone_list[row->milestone_index];
+        if (several) {
+            printf("%-16.16s ", row->project->name);
+        }
+        if (row->activity_index >= 0) {
+            const activity_t* activity = &milestone->activity_list[row->activity_index];
+            printf("%-6hu %-24.24s %-20.20s %7hu %7hu %12.2f %12.2f %7.1f%% %4s", activity->id,
+                   get_name(row->project, activity->name), get_name(row->project, milestone->name),
+                   activity->planned_duration, activity->actual_duration, money_to_dollars(activity->planned_cost),
+                   money_to_dollars(activity->actual_cost),
+                   100 * ratio(money_to_dollars(activity->actual_cost), money_to_dollars(activity->planned_cost)),
+                   activity->completed ? "yes" : "no");
+        } else {
+            printf("%-6hu %-24.24s %10d %6.1f%% %12.2f %12.2f %8lld %8lld", milestone->id,
+                   get_name(row->project, milestone->name), milestone->num_activities,
+                   milestone_value(milestone, QUERY_FIELD_PERCENT_COMPLETE), money_to_dollars(milestone->planned_cost),
+                   money_to_dollars(milestone->actual_cost), (long long)milestone->planned_hours,
+                   (long long)milestone->actual_hours);
+        }
+        if (query->ordered) {
+            printf(" %20.2f", field_dollars(query->order_field, row->key));
+        }
+        printf("\n");
+    }
+}
+
+void print_query_result(const query_result_t* result) {
+    printf("\nQUERY RESULT\n");
+    printf("----------------------------------------\n");
+    if (result->query->num_aggregates > 0) {
+        print_aggregates(result);
+    } else if (result->num_rows > 0) {
+        print_rows(result);
+    }
+
+    printf("%s%ld match(es)", result->milestones_outranked > 0 ? "at least " : "", result->matches);
+    if (result->query->num_aggregates == 0 && result->matches > result->num_rows) {
+        printf(", first %d shown", result->num_rows);
+    }
+    if (result->query->target == QUERY_ACTIVITIES) {
+        printf("; %ld milestone(s) scanned, %ld skipped by their summaries",
+               result->milestones_scanned, result->milestones_skipped);
+    }
+    printf("\n");
+}
+
+void query_result_free(query_result_t* result) {
+    free(result->rows);
+    free(result->groups);
+    result->rows = NULL;
+    result->groups = NULL;
+}
@@ -0,0 +1,220 @@
+/* query.h */
+#ifndef QUERY_H
+#define QUERY_H
+
+#include "a1_data_structures.h"
+
+#define QUERY_TEXT_SIZE 512              // Longest query accepted is 511 characters
+#define QUERY_MAX_PREDICATES 8
+#define QUERY_MAX_AGGREGATES 8
+#define QUERY_DEFAULT_LIMIT 50           // Rows printed when a query has no limit
+#define QUERY_ERROR_SIZE 128
+
+/**
+ * AD-HOC QUERIES
+ *
+ * A small query language over the activities or milestones of one or more
+ * projects:
+ *
+ *   select * from activities where open and cost_ratio > 120%
+ *       and milestone between 3 and 7 order by cost_variance desc limit 10
+ *   select count, sum(actual_cost), max(hours_ratio) from activities
+ *       where completed group by milestone
+ *   select * from milestones where percent_complete < 50 order by actual_cost desc
+ *
+ * "activities ..." and "milestones ..." are short for "select * from ...".
+ * Conditions are joined with "and": field = != <> < <= > >= number,
+ * field between number and number, open, completed. Compared with a ratio
+ * field, a number followed by % is a fraction (120% is 1.2); elsewhere % is
+ * rejected (percent_complete is already on a 0-100 scale). Keywords and
+ * fields are case-insensitive.
+ *
+ * Compilation turns every condition into a closed interval on one field
+ * (lo <= value <= hi, or outside it for != and <>) and picks that field's
+ * filter. Money fields are compared in money_t units (cents in fixed-point
+ * builds, float dollars otherwise): a bound becomes the amount its dollars
+ * would be stored as, so "= 12.34" matches an amount entered as 12.34. The
+ * filter is a loop over the milestone's activity columns that writes the
+ * indices of matching activities to a selection vector without branching.
+ * The first filter scans the milestone, later ones only the survivors, and
+ * the open/completed test goes first (over the open-activity bitmap). Before
+ * any scan, each condition is checked against the milestone's column bounds
+ * and completion count, and a milestone that cannot match is skipped whole;
+ * conditions on the milestone ID are decided once per milestone.
+ *
+ * "order by" with a limit keeps the best rows in a bounded heap of that
+ * size; a milestone whose bounds cannot beat the heap's worst row is also
+ * skipped, and the match count becomes a lower bound. Without "order by"
+ * the first rows found are kept. Aggregates are computed over the selection
+ * vectors, per milestone with "group by milestone".
+ */
+
+typedef enum {
+    QUERY_ACTIVITIES,
+    QUERY_MILESTONES
+} query_target_t;
+
+/**
+ * Queryable fields
+ *
+ * - milestone: ID of the activity's milestone (activities only)
+ * - completed: 0 or 1
+ * - cost_ratio/hours_ratio: Actual over planned (0 when both are 0,
+ *   infinite when only the plan is 0)
+ * - cost_variance/hours_variance: Actual minus planned
+ * - activities/completed_activities/percent_complete: Milestones only
+ */
+typedef enum {
+    QUERY_FIELD_ID,
+    QUERY_FIELD_MILESTONE,
+    QUERY_FIELD_PLANNED_COST,
+    QUERY_FIELD_ACTUAL_COST,
+    QUERY_FIELD_PLANNED_HOURS,
+    QUERY_FIELD_ACTUAL_HOURS,
+    QUERY_FIELD_COMPLETED,
+    QUERY_FIELD_COST_RATIO,
+    QUERY_FIELD_HOURS_RATIO,
+    QUERY_FIELD_COST_VARIANCE,
+    QUERY_FIELD_HOURS_VARIANCE,
+    QUERY_FIELD_ACTIVITIES,
+    QUERY_FIELD_COMPLETED_ACTIVITIES,
+    QUERY_FIELD_PERCENT_COMPLETE,
+    QUERY_NUM_FIELDS
+} query_field_t;
+
+typedef enum {
+    QUERY_COUNT,
+    QUERY_SUM,
+    QUERY_AVG,
+    QUERY_MIN,
+    QUERY_MAX
+} query_aggregate_op_t;
+
+/**
+ * Compiled condition: value in [lo, hi], or outside it when negate is set
+ * (money fields in money_t units)
+ */
+typedef struct {
+    query_field_t field;
+    double lo, hi;
+    bool negate;
+} query_predicate_t;
+
+/**
+ * Filter of one field: keeps the activities of a milestone that satisfy the
+ * predicate. in lists the candidate indices (NULL: all of 0..count-1);
+ * the matching ones are written to out in order.
+ * @return Number of matches
+ */
+typedef int (*query_filter_t)(const milestone_t* milestone, const query_predicate_t* predicate,
+                              const int32_t* in, int count, int32_t* out);
+
+/**
+ * Compiled Query
+ *
+ * - predicates/filters: Activity conditions in evaluation order with the
+ *   filter chosen for each
+ * - milestone_predicates: Conditions on the milestone ID (activities)
+ * - aggregates: Requested aggregates; none means rows are returned
+ * - order_field/ordered/descending: Sort key of the returned rows
+ * - limit: Rows returned (QUERY_DEFAULT_LIMIT if not given)
+ */
+typedef struct {
+    query_target_t target;
+    query_predicate_t predicates[QUERY_MAX_PREDICATES];
+    query_filter_t filters[QUERY_MAX_PREDICATES];
+    int num_predicates;
+    query_predicate_t milestone_predicates[QUERY_MAX_PREDICATES];
+    int num_milestone_predicates;
+    struct {
+        query_aggregate_op_t op;
+        query_field_t field;
+    } aggregates[QUERY_MAX_AGGREGATES];
+    int num_aggregates;
+    bool group_by_milestone;
+    bool ordered, descending;
+    query_field_t order_field;
+    int limit;
+} query_t;
+
+/**
+ * One returned row (activity_index -1 for a milestone row)
+ */
+typedef struct {
+    project_t* project;
+    int milestone_index, activity_index;
+    double key;                          // Order field value, money in money_t units
+} query_row_t;
+
+/**
+ * Running aggregates over a set of matches
+ */
+typedef struct {
+    long count;
+    double value[QUERY_MAX_AGGREGATES];  // Sums (sum, avg) or extremes (min, max), money in money_t units
+} query_accumulator_t;
+
+typedef struct {
+    project_t* project;
+    int milestone_index;
+    query_accumulator_t accumulator;
+} query_group_t;
+
+/**
+ * Query Result, accumulated over any number of projects
+ *
+ * - matches: Activities or milestones that satisfied every condition
+ * - rows/num_rows: Returned rows (a heap until query_finish when ordered)
+ * - totals/groups: Aggregates over all matches, and per milestone
+ * - milestones_scanned/milestones_skipped: Milestones whose activities were
+ *   filtered, and those ruled out by their summaries alone
+ * - milestones_outranked: Skipped milestones whose bounds could not beat
+ *   the returned rows; their matches are not counted, so matches is then a
+ *   lower bound
+ */
+typedef struct {
+    const query_t* query;
+    long matches;
+    query_row_t* rows;
+    int num_rows;
+    query_accumulator_t totals;
+    query_group_t* groups;
+    int num_groups, group_capacity;
+    long milestones_scanned, milestones_skipped, milestones_outranked;
+    int num_projects;
+} query_result_t;
+
+/**
+ * Compile query text
+ * @param error Receives a description of the first problem on failure
+ * @return true if the query is valid
+ */
+bool query_compile(const char* text, query_t* query, char error[QUERY_ERROR_SIZE]);
+
+/**
+ * Prepare an empty result for a compiled query (exits on allocation failure)
+ */
+void query_result_init(query_result_t* result, const query_t* query);
+
+/**
+ * Run the query over one project and add its matches to the result
+ * The project is only read, apart from building missing activity columns.
+ */
+void query_accumulate(query_result_t* result, project_t* project);
+
+/**
+ * Put the returned rows in their final order
+ */
+void query_finish(query_result_t* result);
+
+/**
+ * Print the rows or aggregates of a finished result
+ */
+void print_query_result(const query_result_t* result);
+
+/**
+ * Free the rows and groups of a result
+ */
+void query_result_free(query_result_t* result);
+
+#endif
@@ -0,0 +1,512 @@
+/* report.c */
+#include "report.h"
+#include "a1_functions.h"
+#include "schedule.h"
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const double POWERS_OF_TEN[] = { 1, 10, 100, 1000 };
+
+// Largest scaled value formatted by hand; above it doubles lose whole units
+#define MAX_EXACT_UNITS 9.0e15
+
+static const char* const FORMAT_NAMES[] = { "text", "csv", "json" };
+
+// =============================================================================
+// WRITER
+// =============================================================================
+
+void report_init(report_writer_t* writer, int fd, report_format_t format) {
+    writer->buffer = malloc(REPORT_BUFFER_SIZE);
+    if (writer->buffer == NULL) {
+        printf("ERROR: Failed to allocate report buffer. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    writer->fd = fd;
+    writer->format = format;
+    writer->used = 0;
+    writer->failed = false;
+    writer->bytes_written = 0;
+}
+
+void report_reset(report_writer_t* writer, int fd, report_format_t format) {
+    report_flush(writer);
+    writer->fd = fd;
+    writer->format = format;
+    writer->failed = false;
+    writer->bytes_written = 0;
+}
+
+/**
+ * Write bytes straight to the writer's file, marking it failed on error
+ */
+static void write_out(report_writer_t* writer, const char* bytes, size_t length) {
+    size_t offset = 0;
+    while (!writer->failed && offset < length) {
+        ssize_t written = write(writer->fd, bytes + offset, length - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            writer->failed = true;
+            break;
+        }
+        offset += (size_t)written;
+        writer->bytes_written += written;
+    }
+}
+
+bool report_flush(report_writer_t* writer) {
+    write_out(writer, writer->buffer, writer->used);
+    writer->used = 0;
+    return !writer->failed;
+}
+
+void report_large(report_writer_t* writer, const char* bytes, size_t length) {
+    report_flush(writer);
+    write_out(writer, bytes, length);
+}
+
+void report_free(report_writer_t* writer) {
+    report_flush(writer);
+    free(writer->buffer);
+    writer->buffer = NULL;
+}
+
+report_writer_t* report_stdout(void) {
+    static report_writer_t writer;
+    if (writer.buffer == NULL) {
+        report_init(&writer, STDOUT_FILENO, REPORT_TEXT);
+    }
+    fflush(stdout);
+    return &writer;
+}
+
+bool report_parse_format(const char* text, report_format_t* format) {
+    for (int f = REPORT_TEXT; f <= REPORT_JSON; f++) {
+        if (strcmp(text, FORMAT_NAMES[f]) == 0) {
+            *format = (report_format_t)f;
+            return true;
+        }
+    }
+    return false;
+}
+
+char* report_space(report_writer_t* writer, size_t length) {
+    if (REPORT_BUFFER_SIZE - writer->used < length) {
+        report_flush(writer);
+    }
+    return writer->buffer + writer->used;
+}
+
+// =============================================================================
+// NUMBER AND STRING FORMATTING
+// =============================================================================
+
+/**
+ * Write the digits of value ending just before end, two at a time
+ * @return First digit written
+ */
+static char* format_digits(char* end, uint64_t value) {
+    while (value >= 100) {
+        end -= 2;
+        memcpy(end, &DIGIT_PAIRS[(value % 100) * 2], 2);
+        value /= 100;
+    }
+    if (value >= 10) {
+        end -= 2;
+        memcpy(end, &DIGIT_PAIRS[value * 2], 2);
+    } else {
+        *--end = (char)('0' + value);
+    }
+    return end;
+}
+
+void report_int(report_writer_t* writer, long long value) {
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    // Negate in unsigned arithmetic so LLONG_MIN stays representable
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    char* start = format_digits(end, magnitude);
+    if (value < 0) {
+        *--start = '-';
+    }
+    report_bytes(writer, start, (size_t)(end - start));
+}
+
+void report_fixed(report_writer_t* writer, double value, int decimals) {
+    double scaled = fabs(value) * POWERS_OF_TEN[decimals];
+    if (!(scaled < MAX_EXACT_UNITS)) {
+        // Infinities, NaN and huge values: rare enough to leave to printf
+        char text[400];
+        int length = snprintf(text, sizeof(text), "%.*f", decimals, value);
+        report_bytes(writer, text, (size_t)length);
+        return;
+    }
+
+    // Products of a float and 10^decimals are exact, so rounding here sees
+    // the same value printf rounds, and nearbyint breaks ties to even too
+    uint64_t units = (uint64_t)nearbyint(scaled);
+    uint64_t divisor = (uint64_t)POWERS_OF_TEN[decimals];
+    char digits[32];
+    char* end = digits + sizeof(digits);
+    char* start = end;
+    if (decimals > 0) {
+        uint64_t fraction = units % divisor;
+        for (int d = 0; d < decimals; d++) {
+            *--start = (char)('0' + fraction % 10);
+            fraction /= 10;
+        }
+        *--start = '.';
+    }
+    start = format_digits(start, units / divisor);
+    if (signbit(value)) {
+        *--start = '-';  // printf keeps the sign of values that round to zero
+    }
+    report_bytes(writer, start, (size_t)(end - start));
+}
+
+void report_money(report_writer_t* writer, money_t value) {
+#ifdef PM_FIXED_POINT
+    // Whole cents: the dollars, then the two cent digits, with no rounding
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    char digits[32];
+    char* end = digits + sizeof(digits);
+    char* start = end;
+    *--start = (char)('0' + magnitude % 10);
+    *--start = (char)('0' + magnitude / 10 % 10);
+    *--start = '.';
+    start = format_digits(start, magnitude / 100);
+    if (value < 0) {
+        *--start = '-';
+    }
+    report_bytes(writer, start, (size_t)(end - start));
+#else
+    report_fixed(writer, value, 2);
+#endif
+}
+
+void report_csv_field(report_writer_t* writer, const char* text) {
+    size_t length = strcspn(text, ",\"\r\n");
+    if (text[length] == '\0') {
+        report_bytes(writer, text, length);
+        return;
+    }
+    report_char(writer, '"');
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"') {
+            report_char(writer, '"');
+        }
+        report_char(writer, *c);
+    }
+    report_char(writer, '"');
+}
+
+void report_json_string(report_writer_t* writer, const char* text) {
+    report_char(writer, '"');
+    const char* c = text;
+    while (*c != '\0') {
+        // Copy the run that needs no escaping in one go
+        const char* run = c;
+        while ((unsigned char)*c >= 0x20 && *c != '"' && *c != '\\') {
+            c++;
+        }
+        if (c > run) {
+            report_bytes(writer, run, (size_t)(c - run));
+        }
+        if (*c == '\0') {
+            break;
+        }
+        char escape[8];
+        switch (*c) {
+            case '"':  report_bytes(writer, "\\\"", 2); break;
+            case '\\': report_bytes(writer, "\\\\", 2); break;
+            case '\n': report_bytes(writer, "\\n", 2); break;
+            case '\r': report_bytes(writer, "\\r", 2); break;
+            case '\t': report_bytes(writer, "\\t", 2); break;
+            default:
+                snprintf(escape, sizeof(escape), "\\u%04x", (unsigned char)*c);
+                report_bytes(writer, escape, 6);
+                break;
+        }
+        c++;
+    }
+    report_char(writer, '"');
+}
+
+// =============================================================================
+// TEXT REPORTS
+// =============================================================================
+
+#define RULE "----------------------------------------\n"
+
+static const char* status_text(bool completed) {
+    return completed ? "COMPLETED" : "IN PROGRESS";
+}
+
+void report_project_stats(report_writer_t* writer, const project_t* project) {
+    report_text(writer, "\nPROJECT STATISTICS: ");
+    report_text(writer, project->name);
+    report_text(writer, "\n========================================\nStatus: ");
+    report_text(writer, status_text(project->completed));
+    report_text(writer, "\nPlanned cost: $");
+    report_money(writer, project->planned_cost);
+    report_text(writer, " | Actual cost: $");
+    report_money(writer, project->actual_cost);
+    report_text(writer, "\nPlanned duration: ");
+    report_int(writer, project->planned_duration);
+    report_text(writer, " day(s) | Actual duration: ");
+    report_int(writer, project->actual_duration);
+    report_text(writer, " day(s)\n");
+    if (project->schedule != NULL && !project->schedule->stale) {
+        report_text(writer, "Critical path: ");
+        report_int(writer, (long long)project->schedule->finish);
+        report_text(writer, " hour(s) (");
+        report_int(writer, (long long)((project->schedule->finish + HOURS_PER_DAY - 1) / HOURS_PER_DAY));
+        report_text(writer, " day(s))\n");
+    }
+
+    if (project->completed) {
+        // Variance analysis is only meaningful once all work is done
+        money_t cost_variance = project->actual_cost - project->planned_cost;
+        money_t variance_size = cost_variance < 0 ? -cost_variance : cost_variance;
+        report_text(writer, "\nVARIANCE ANALYSIS\n" RULE "Cost variance: $");
+        if (project->planned_cost > 0) {
+            report_money(writer, variance_size);
+            report_text(writer, " (");
+            report_fixed(writer, money_to_float(variance_size) / money_to_float(project->planned_cost) * 100, 1);
+            report_text(writer, cost_variance > 0 ? "% over budget)\n" : "% under budget)\n");
+        } else {
+            report_money(writer, cost_variance);
+            report_char(writer, '\n');
+        }
+
+        int schedule_variance = (int)project->actual_duration - (int)project->planned_duration;
+        report_text(writer, "Schedule variance: ");
+        report_int(writer, abs(schedule_variance));
+        report_text(writer, schedule_variance > 0 ? " day(s) behind schedule\n" : " day(s) ahead of schedule\n");
+    } else {
+        report_milestone_stats(writer, project);
+    }
+}
+
+void report_milestone_stats(report_writer_t* writer, const project_t* project) {
+    report_text(writer, "\nMILESTONE STATISTICS\n" RULE);
+
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+
+        report_text(writer, "Milestone '");
+        report_text(writer, get_name(project, milestone->name));
+        report_text(writer, "' (ID: ");
+        report_int(writer, milestone->id);
+        report_text(writer, "): ");
+        report_text(writer, status_text(milestone->completed));
+        report_text(writer, "\n  Activities completed: ");
+        report_int(writer, milestone->num_completed);
+        report_char(writer, '/');
+        report_int(writer, milestone->num_activities);
+        report_text(writer, "\n  Planned cost: $");
+        report_money(writer, milestone->planned_cost);
+        report_text(writer, " | Actual cost: $");
+        report_money(writer, milestone->actual_cost);
+        report_text(writer, "\n  Actual duration: ");
+        report_int(writer, milestone->actual_duration);
+        report_text(writer, " day(s)\n");
+    }
+}
+
+int report_incomplete_activities(report_writer_t* writer, const project_t* project) {
+    int incomplete_count = 0;
+
+    report_text(writer, "\nINCOMPLETE ACTIVITIES:\n" RULE);
+
+    for (int i = 0; i < project->num_milestones && incomplete_count < project->num_open_activities; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        const char* milestone_name = get_name(project, milestone->name);
+        for (int j = next_open_activity(milestone, 0); j != NO_INDEX; j = next_open_activity(milestone, j + 1)) {
+            const activity_t* activity = &milestone->activity_list[j];
+            report_text(writer, "ID: ");
+            report_int(writer, activity->id);
+            report_text(writer, " | ");
+            report_text(writer, get_name(project, activity->name));
+            report_text(writer, " (in milestone: ");
+            report_text(writer, milestone_name);
+            report_text(writer, ")\n");
+            incomplete_count++;
+        }
+    }
+
+    if (incomplete_count == 0) {
+        report_text(writer, "All activities are completed!\n");
+    }
+
+    return incomplete_count;
+}
+
+// =============================================================================
+// FULL REPORTS
+// =============================================================================
+
+static void text_activity(report_writer_t* writer, const project_t* project, const char* milestone_name,
+                          const activity_t* activity) {
+    report_text(writer, "ID: ");
+    report_int(writer, activity->id);
+    report_text(writer, " | ");
+    report_text(writer, get_name(project, activity->name));
+    report_text(writer, " (in milestone: ");
+    report_text(writer, milestone_name);
+    report_text(writer, ") | Hours: ");
+    report_int(writer, activity->actual_duration);
+    report_char(writer, '/');
+    report_int(writer, activity->planned_duration);
+    report_text(writer, " | Cost: $");
+    report_money(writer, activity->actual_cost);
+    report_text(writer, "/$");
+    report_money(writer, activity->planned_cost);
+    report_text(writer, " | ");
+    report_text(writer, status_text(activity->completed));
+    report_char(writer, '\n');
+}
+
+static void csv_activity(report_writer_t* writer, const project_t* project, const milestone_t* milestone,
+                         const char* milestone_name, const activity_t* activity) {
+    report_int(writer, milestone->id);
+    report_char(writer, ',');
+    report_csv_field(writer, milestone_name);
+    report_char(writer, ',');
+    report_int(writer, activity->id);
+    report_char(writer, ',');
+    report_csv_field(writer, get_name(project, activity->name));
+    report_char(writer, ',');
+    report_int(writer, activity->planned_duration);
+    report_char(writer, ',');
+    report_int(writer, activity->actual_duration);
+    report_char(writer, ',');
+    report_money(writer, activity->planned_cost);
+    report_char(writer, ',');
+    report_money(writer, activity->actual_cost);
+    report_text(writer, activity->completed ? ",1\n" : ",0\n");
+}
+
+static void json_activity(report_writer_t* writer, const project_t* project, const activity_t* activity) {
+    report_text(writer, "{\"id\":");
+    report_int(writer, activity->id);
+    report_text(writer, ",\"name\":");
+    report_json_string(writer, get_name(project, activity->name));
+    report_text(writer, ",\"planned_hours\":");
+    report_int(writer, activity->planned_duration);
+    report_text(writer, ",\"actual_hours\":");
+    report_int(writer, activity->actual_duration);
+    report_text(writer, ",\"planned_cost\":");
+    report_money(writer, activity->planned_cost);
+    report_text(writer, ",\"actual_cost\":");
+    report_money(writer, activity->actual_cost);
+    report_text(writer, activity->completed ? ",\"completed\":true}" : ",\"completed\":false}");
+}
+
+static void json_milestone_open(report_writer_t* writer, const project_t* project, const milestone_t* milestone) {
+    report_text(writer, "{\"id\":");
+    report_int(writer, milestone->id);
+    report_text(writer, ",\"name\":");
+    report_json_string(writer, get_name(project, milestone->name));
+    report_text(writer, milestone->completed ? ",\"completed\":true" : ",\"completed\":false");
+    report_text(writer, ",\"activities_completed\":");
+    report_int(writer, milestone->num_completed);
+    report_text(writer, ",\"planned_hours\":");
+    report_int(writer, milestone->planned_hours);
+    report_text(writer, ",\"actual_hours\":");
+    report_int(writer, milestone->actual_hours);
+    report_text(writer, ",\"planned_cost\":");
+    report_money(writer, milestone->planned_cost);
+    report_text(writer, ",\"actual_cost\":");
+    report_money(writer, milestone->actual_cost);
+    report_text(writer, ",\"actual_days\":");
+    report_int(writer, milestone->actual_duration);
+    report_text(writer, ",\"activities\":[\n");
+}
+
+static void json_project_open(report_writer_t* writer, const project_t* project) {
+    report_text(writer, "{\"project\":");
+    report_json_string(writer, project->name);
+    report_text(writer, project->completed ? ",\"completed\":true" : ",\"completed\":false");
+    report_text(writer, ",\"planned_cost\":");
+    report_money(writer, project->planned_cost);
+    report_text(writer, ",\"actual_cost\":");
+    report_money(writer, project->actual_cost);
+    report_text(writer, ",\"planned_days\":");
+    report_int(writer, project->planned_duration);
+    report_text(writer, ",\"actual_days\":");
+    report_int(writer, project->actual_duration);
+    report_text(writer, ",\"open_activities\":");
+    report_int(writer, project->num_open_activities);
+    if (project->schedule != NULL && !project->schedule->stale) {
+        report_text(writer, ",\"critical_path_hours\":");
+        report_int(writer, (long long)project->schedule->finish);
+    }
+    report_text(writer, ",\"milestones\":[\n");
+}
+
+void report_project(report_writer_t* writer, const project_t* project) {
+    switch (writer->format) {
+        case REPORT_TEXT:
+            report_project_stats(writer, project);
+            report_text(writer, "\nACTIVITIES\n" RULE);
+            break;
+        case REPORT_CSV:
+            report_text(writer, "milestone_id,milestone,activity_id,activity,planned_hours,actual_hours,"
+                                "planned_cost,actual_cost,completed\n");
+            break;
+        case REPORT_JSON:
+            json_project_open(writer, project);
+            break;
+    }
+
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        const char* milestone_name = get_name(project, milestone->name);
+        if (writer->format == REPORT_JSON) {
+            if (i > 0) {
+                report_text(writer, ",\n");
+            }
+            json_milestone_open(writer, project, milestone);
+        }
+        for (int j = 0; j < milestone->num_activities; j++) {
+            const activity_t* activity = &milestone->activity_list[j];
+            switch (writer->format) {
+                case REPORT_TEXT:
+                    text_activity(writer, project, milestone_name, activity);
+                    break;
+                case REPORT_CSV:
+                    csv_activity(writer, project, milestone, milestone_name, activity);
+                    break;
+                case REPORT_JSON:
+                    if (j > 0) {
+                        report_text(writer, ",\n");
+                    }
+                    json_activity(writer, project, activity);
+                    break;
+            }
+        }
+        if (writer->format == REPORT_JSON) {
+            report_text(writer, "]}");
+        }
+    }
+
+    if (writer->format == REPORT_JSON) {
+        report_text(writer, "]}\n");
+    }
+}
@@ -0,0 +1,166 @@
+/* report.h */
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "a1_data_structures.h"
+#include <stddef.h>
+#include <string.h>
+
+#define REPORT_BUFFER_SIZE (256 * 1024)  // Bytes gathered before each write
+
+/**
+ * BUFFERED REPORTS
+ *
+ * Reports are formatted straight into a large buffer that is written out
+ * with one write(2) whenever it fills, instead of one printf per line. On a
+ * file or pipe the reader sees full pages while the project is still being
+ * scanned, and memory stays at one buffer however large the project is.
+ *
+ * Numbers are formatted by hand: integers two digits at a time, fixed-point
+ * values by rounding value * 10^decimals to an integer (half to even, as
+ * printf does; exact for float inputs, which is what the project holds), so
+ * the text matches printf's "%d" and "%.Nf" byte for byte.
+ *
+ * A writer is reusable: report_reset points it at another output without
+ * giving up its buffer. Writers are not thread-safe.
+ */
+
+typedef enum {
+    REPORT_TEXT,
+    REPORT_CSV,
+    REPORT_JSON
+} report_format_t;
+
+/**
+ * Report Writer
+ *
+ * - fd/format: Output and the format full reports are written in
+ * - buffer/used: Pending output
+ * - failed: A write failed; later output is dropped
+ * - bytes_written: Bytes handed to the output so far
+ */
+typedef struct {
+    int fd;
+    report_format_t format;
+    char* buffer;
+    size_t used;
+    bool failed;
+    long long bytes_written;
+} report_writer_t;
+
+/**
+ * Prepare a writer on a file descriptor (exits on allocation failure)
+ */
+void report_init(report_writer_t* writer, int fd, report_format_t format);
+
+/**
+ * Point a writer at another output, keeping its buffer (pending output is
+ * flushed first)
+ */
+void report_reset(report_writer_t* writer, int fd, report_format_t format);
+
+/**
+ * Write out the pending output
+ * @return false if any write so far has failed
+ */
+bool report_flush(report_writer_t* writer);
+
+/**
+ * Flush and free the buffer (the descriptor is left open)
+ */
+void report_free(report_writer_t* writer);
+
+/**
+ * Shared text writer on standard output for the interactive reports
+ * Standard I/O is flushed first so earlier printf output comes before.
+ */
+report_writer_t* report_stdout(void);
+
+/**
+ * Parse a format name: text, csv or json
+ * @return true if recognised
+ */
+bool report_parse_format(const char* text, report_format_t* format);
+
+/**
+ * Make room for length bytes, writing out the buffer if needed
+ * @return Where the bytes go (length must not exceed REPORT_BUFFER_SIZE)
+ */
+char* report_space(report_writer_t* writer, size_t length);
+
+/**
+ * Write out the buffer, then bytes too long to buffer straight to the file
+ */
+void report_large(report_writer_t* writer, const char* bytes, size_t length);
+
+static inline void report_bytes(report_writer_t* writer, const char* bytes, size_t length) {
+    if (length > REPORT_BUFFER_SIZE) {
+        report_large(writer, bytes, length);
+        return;
+    }
+    memcpy(report_space(writer, length), bytes, length);
+    writer->used += length;
+}
+
+static inline void report_text(report_writer_t* writer, const char* text) {
+    report_bytes(writer, text, strlen(text));
+}
+
+static inline void report_char(report_writer_t* writer, char c) {
+    *report_space(writer, 1) = c;
+    writer->used++;
+}
+
+/**
+ * Append an integer, as printf "%lld"
+ */
+void report_int(report_writer_t* writer, long long value);
+
+/**
+ * Append a fixed-point number, as printf "%.Nf" (decimals 0-3)
+ */
+void report_fixed(report_writer_t* writer, double value, int decimals);
+
+/**
+ * Append an amount of money, as printf "%.2f" of its dollars (exact cents
+ * with PM_FIXED_POINT)
+ */
+void report_money(report_writer_t* writer, money_t value);
+
+/**
+ * Append a CSV field, quoted only when it holds a comma, quote or newline
+ */
+void report_csv_field(report_writer_t* writer, const char* text);
+
+/**
+ * Append a quoted and escaped JSON string
+ */
+void report_json_string(report_writer_t* writer, const char* text);
+
+/**
+ * Project statistics as text: totals, critical path, and the variance
+ * analysis once complete or the milestone statistics until then
+ */
+void report_project_stats(report_writer_t* writer, const project_t* project);
+
+/**
+ * Per-milestone statistics as text
+ */
+void report_milestone_stats(report_writer_t* writer, const project_t* project);
+
+/**
+ * Listing of the incomplete activities as text
+ * @return Number of incomplete activities listed
+ */
+int report_incomplete_activities(report_writer_t* writer, const project_t* project);
+
+/**
+ * Full report in the writer's format, streamed as the project is scanned
+ * - text: the project statistics followed by every activity
+ * - csv: one row per activity with its milestone, after a header row
+ * - json: one object with the project totals, its milestones and their
+ *   activities
+ */
+void report_project(report_writer_t* writer, const project_t* project);
+
+#endif
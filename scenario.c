@@ -0,0 +1,353 @@
+/* scenario.c */
+#include "scenario.h"
+#include "a1_functions.h"
+#include <math.h>
+#include <string.h>
+
+// =============================================================================
+// FORKING AND COPY-ON-WRITE
+// =============================================================================
+
+scenario_t* scenario_fork(project_t* base, const char* name) {
+    scenario_t* scenario = calloc(1, sizeof(scenario_t));
+    if (scenario == NULL) {
+        printf("ERROR: Failed to allocate scenario. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    strncpy(scenario->name, name, sizeof(scenario->name) - 1);
+    scenario->base = base;
+    scenario->structure_version = base->structure_version;
+    scenario->num_milestones = base->num_milestones;
+    scenario->arena = arena_create(SCENARIO_ARENA_BLOCK_SIZE);
+    return scenario;
+}
+
+bool scenario_is_current(const scenario_t* scenario) {
+    return scenario->structure_version == scenario->base->structure_version;
+}
+
+/**
+ * Overlay of a milestone, created on first use
+ */
+static scenario_milestone_t* milestone_overlay(scenario_t* scenario, int milestone_index) {
+    if (scenario->milestones == NULL) {
+        scenario->milestones = arena_alloc(scenario->arena,
+                                           (size_t)scenario->num_milestones * sizeof(scenario_milestone_t*));
+    }
+    scenario_milestone_t* overlay = scenario->milestones[milestone_index];
+    if (overlay == NULL) {
+        const milestone_t* milestone = &scenario->base->milestone_list[milestone_index];
+        overlay = arena_alloc(scenario->arena, sizeof(scenario_milestone_t));
+        overlay->num_chunks = (milestone->num_activities + SCENARIO_CHUNK_SIZE - 1) / SCENARIO_CHUNK_SIZE;
+        overlay->chunks = arena_alloc(scenario->arena, (size_t)overlay->num_chunks * sizeof(scenario_chunk_t*));
+        scenario->milestones[milestone_index] = overlay;
+    }
+    return overlay;
+}
+
+/**
+ * Copy of the chunk holding an activity, made from the base on first write
+ */
+static scenario_chunk_t* writable_chunk(scenario_t* scenario, int milestone_index, int activity_index) {
+    scenario_milestone_t* overlay = milestone_overlay(scenario, milestone_index);
+    int chunk_index = activity_index >> SCENARIO_CHUNK_BITS;
+    scenario_chunk_t* chunk = overlay->chunks[chunk_index];
+
+    if (chunk == NULL) {
+        const milestone_t* milestone = &scenario->base->milestone_list[milestone_index];
+        int first = chunk_index * SCENARIO_CHUNK_SIZE;
+        int count = milestone->num_activities - first < SCENARIO_CHUNK_SIZE
+                  ? milestone->num_activities - first : SCENARIO_CHUNK_SIZE;
+
+        chunk = arena_alloc(scenario->arena, sizeof(scenario_chunk_t));
+        for (int slot = 0; slot < count; slot++) {
+            const activity_t* activity = &milestone->activity_list[first + slot];
+            chunk->planned_cost[slot] = activity->planned_cost;
+            chunk->planned_duration[slot] = activity->planned_duration;
+        }
+        overlay->chunks[chunk_index] = chunk;
+        scenario->num_chunks++;
+    }
+    return chunk;
+}
+
+/**
+ * Chunk currently holding an activity's plan, NULL while it is shared
+ */
+static const scenario_chunk_t* readable_chunk(const scenario_t* scenario, int milestone_index, int activity_index) {
+    if (scenario->milestones == NULL || scenario->milestones[milestone_index] == NULL) {
+        return NULL;
+    }
+    return scenario->milestones[milestone_index]->chunks[activity_index >> SCENARIO_CHUNK_BITS];
+}
+
+static bool milestone_dropped(const scenario_t* scenario, int milestone_index) {
+    return scenario->milestones != NULL && scenario->milestones[milestone_index] != NULL &&
+           scenario->milestones[milestone_index]->dropped;
+}
+
+/**
+ * Position of a base activity that is still part of the scenario
+ * @return false if the ID is not such an activity
+ */
+static bool locate_activity(const scenario_t* scenario, unsigned short int activity_id,
+                            int* milestone_index, int* activity_index) {
+    milestone_t* milestone = NULL;
+    activity_t* activity = find_activity_by_id(scenario->base, activity_id, &milestone);
+    if (activity == NULL) {
+        return false;
+    }
+
+    *milestone_index = (int)(milestone - scenario->base->milestone_list);
+    *activity_index = (int)(activity - milestone->activity_list);
+    if (milestone_dropped(scenario, *milestone_index)) {
+        return false;
+    }
+    const scenario_chunk_t* chunk = readable_chunk(scenario, *milestone_index, *activity_index);
+    return chunk == NULL || !(chunk->dropped >> (*activity_index & (SCENARIO_CHUNK_SIZE - 1)) & 1);
+}
+
+// =============================================================================
+// EDITS
+// =============================================================================
+
+bool scenario_set_plan(scenario_t* scenario, unsigned short int activity_id,
+                       unsigned short int planned_duration, money_t planned_cost) {
+    int milestone_index, activity_index;
+    if (!scenario_is_current(scenario) ||
+        !locate_activity(scenario, activity_id, &milestone_index, &activity_index)) {
+        return false;
+    }
+
+    scenario_chunk_t* chunk = writable_chunk(scenario, milestone_index, activity_index);
+    int slot = activity_index & (SCENARIO_CHUNK_SIZE - 1);
+    chunk->planned_duration[slot] = planned_duration;
+    chunk->planned_cost[slot] = planned_cost;
+    scenario->num_edits++;
+    return true;
+}
+
+bool scenario_drop_activity(scenario_t* scenario, unsigned short int activity_id) {
+    int milestone_index, activity_index;
+    if (!scenario_is_current(scenario) ||
+        !locate_activity(scenario, activity_id, &milestone_index, &activity_index)) {
+        return false;
+    }
+
+    scenario_chunk_t* chunk = writable_chunk(scenario, milestone_index, activity_index);
+    chunk->dropped |= 1ULL << (activity_index & (SCENARIO_CHUNK_SIZE - 1));
+    scenario->num_edits++;
+    return true;
+}
+
+bool scenario_drop_milestone(scenario_t* scenario, unsigned short int milestone_id) {
+    milestone_t* milestone = find_milestone_by_id(scenario->base, milestone_id);
+    if (milestone == NULL || !scenario_is_current(scenario)) {
+        return false;
+    }
+    int milestone_index = (int)(milestone - scenario->base->milestone_list);
+    if (milestone_dropped(scenario, milestone_index)) {
+        return false;
+    }
+
+    milestone_overlay(scenario, milestone_index)->dropped = true;
+    scenario->num_edits++;
+    return true;
+}
+
+bool scenario_scale_milestone(scenario_t* scenario, unsigned short int milestone_id, float factor) {
+    milestone_t* milestone = find_milestone_by_id(scenario->base, milestone_id);
+    if (milestone == NULL || !scenario_is_current(scenario) || !(factor >= 0)) {
+        return false;
+    }
+    int milestone_index = (int)(milestone - scenario->base->milestone_list);
+    if (milestone_dropped(scenario, milestone_index)) {
+        return false;
+    }
+
+    for (int first = 0; first < milestone->num_activities; first += SCENARIO_CHUNK_SIZE) {
+        scenario_chunk_t* chunk = writable_chunk(scenario, milestone_index, first);
+        int count = milestone->num_activities - first < SCENARIO_CHUNK_SIZE
+                  ? milestone->num_activities - first : SCENARIO_CHUNK_SIZE;
+        for (int slot = 0; slot < count; slot++) {
+            float hours = roundf((float)chunk->planned_duration[slot] * factor);
+            chunk->planned_duration[slot] = (uint16_t)(hours > 65535 ? 65535 : hours);
+            chunk->planned_cost[slot] = money_from_dollars(money_to_dollars(chunk->planned_cost[slot]) * factor);
+        }
+    }
+    scenario->num_edits++;
+    return true;
+}
+
+// =============================================================================
+// READING AND ROLLUPS
+// =============================================================================
+
+bool scenario_get_activity(const scenario_t* scenario, unsigned short int activity_id, activity_t* out) {
+    int milestone_index, activity_index;
+    if (!scenario_is_current(scenario) ||
+        !locate_activity(scenario, activity_id, &milestone_index, &activity_index)) {
+        return false;
+    }
+
+    *out = scenario->base->milestone_list[milestone_index].activity_list[activity_index];
+    const scenario_chunk_t* chunk = readable_chunk(scenario, milestone_index, activity_index);
+    if (chunk != NULL) {
+        int slot = activity_index & (SCENARIO_CHUNK_SIZE - 1);
+        out->planned_duration = chunk->planned_duration[slot];
+        out->planned_cost = chunk->planned_cost[slot];
+    }
+    return true;
+}
+
+/**
+ * Convert a number of work hours to whole days, rounding up
+ */
+static long hours_to_days(long hours) {
+    return (hours + HOURS_PER_DAY - 1) / HOURS_PER_DAY;
+}
+
+void scenario_totals(const project_t* base, const scenario_t* scenario, scenario_totals_t* totals) {
+    memset(totals, 0, sizeof(*totals));
+
+    for (int i = 0; i < base->num_milestones; i++) {
+        const milestone_t* milestone = &base->milestone_list[i];
+        const scenario_milestone_t* overlay = scenario != NULL && scenario->milestones != NULL
+                                            ? scenario->milestones[i] : NULL;
+        if (overlay != NULL && overlay->dropped) {
+            continue;
+        }
+
+        // Shared milestones contribute the base's rollup as it is
+        double planned_cost = (double)milestone->planned_cost, actual_cost = (double)milestone->actual_cost;
+        long planned_hours = milestone->planned_hours, actual_hours = milestone->actual_hours;
+        long num_activities = milestone->num_activities, num_completed = milestone->num_completed;
+
+        // Copied chunks only adjust it by their differences from the base
+        for (int c = 0; overlay != NULL && c < overlay->num_chunks; c++) {
+            const scenario_chunk_t* chunk = overlay->chunks[c];
+            if (chunk == NULL) {
+                continue;
+            }
+            int first = c * SCENARIO_CHUNK_SIZE;
+            int count = milestone->num_activities - first < SCENARIO_CHUNK_SIZE
+                      ? milestone->num_activities - first : SCENARIO_CHUNK_SIZE;
+            for (int slot = 0; slot < count; slot++) {
+                const activity_t* activity = &milestone->activity_list[first + slot];
+                if (chunk->dropped >> slot & 1) {
+                    planned_cost -= (double)activity->planned_cost;
+                    actual_cost -= (double)activity->actual_cost;
+                    planned_hours -= activity->planned_duration;
+                    actual_hours -= activity->actual_duration;
+                    num_activities--;
+                    num_completed -= activity->completed;
+                } else {
+                    planned_cost += (double)(chunk->planned_cost[slot] - activity->planned_cost);
+                    planned_hours += (long)chunk->planned_duration[slot] - (long)activity->planned_duration;
+                }
+            }
+        }
+
+        totals->planned_cost += planned_cost;
+        totals->actual_cost += actual_cost;
+        totals->planned_days += hours_to_days(planned_hours);
+        totals->actual_days += hours_to_days(actual_hours);
+        totals->num_milestones++;
+        totals->num_completed_milestones += num_completed == num_activities;
+        totals->num_activities += num_activities;
+        totals->num_open_activities += num_activities - num_completed;
+    }
+}
+
+size_t scenario_memory(const scenario_t* scenario) {
+    return sizeof(scenario_t) + sizeof(arena_t) + scenario->arena->bytes_reserved;
+}
+
+// =============================================================================
+// REPORTING
+// =============================================================================
+
+int print_scenario_diff(const scenario_t* scenario) {
+    const project_t* base = scenario->base;
+    int differences = 0;
+
+    printf("\nSCENARIO CHANGES: %s\n", scenario->name);
+    printf("----------------------------------------\n");
+    for (int i = 0; scenario->milestones != NULL && i < base->num_milestones; i++) {
+        const scenario_milestone_t* overlay = scenario->milestones[i];
+        const milestone_t* milestone = &base->milestone_list[i];
+        if (overlay == NULL) {
+            continue;
+        }
+        if (overlay->dropped) {
+            printf("Milestone '%s' (ID: %hu): dropped with its %d activity/activities\n",
+                   get_name(base, milestone->name), milestone->id, milestone->num_activities);
+            differences++;
+            continue;
+        }
+
+        for (int c = 0; c < overlay->num_chunks; c++) {
+            const scenario_chunk_t* chunk = overlay->chunks[c];
+            int first = c * SCENARIO_CHUNK_SIZE;
+            for (int slot = 0; chunk != NULL && slot < SCENARIO_CHUNK_SIZE &&
+                               first + slot < milestone->num_activities; slot++) {
+                const activity_t* activity = &milestone->activity_list[first + slot];
+                if (chunk->dropped >> slot & 1) {
+                    printf("Activity '%s' (ID: %hu): dropped\n", get_name(base, activity->name), activity->id);
+                    differences++;
+                } else if (chunk->planned_duration[slot] != activity->planned_duration ||
+                           chunk->planned_cost[slot] != activity->planned_cost) {
+                    printf("Activity '%s' (ID: %hu): %hu -> %hu hour(s), $%.2f -> $%.2f\n",
+                           get_name(base, activity->name), activity->id, activity->planned_duration,
+                           chunk->planned_duration[slot], money_to_dollars(activity->planned_cost),
+                           money_to_dollars(chunk->planned_cost[slot]));
+                    differences++;
+                }
+            }
+        }
+    }
+
+    if (differences == 0) {
+        printf("No changes from the base plan.\n");
+    }
+    return differences;
+}
+
+void print_scenario_comparison(const project_t* base, scenario_t* const* scenarios, int num_scenarios) {
+    scenario_totals_t totals;
+
+    printf("\nSCENARIO COMPARISON: %s\n", base->name);
+    printf("========================================\n");
+    printf("%-16s %10s %14s %14s %9s %9s %12s %8s %8s\n", "Scenario", "Milestones", "Planned cost",
+           "Actual cost", "Plan days", "Act days", "Open", "Edits", "Memory");
+
+    scenario_totals(base, NULL, &totals);
+    printf("%-16.16s %4d/%-5d %14.2f %14.2f %9ld %9ld %12ld %8s %8s\n", "(base)",
+           totals.num_completed_milestones, totals.num_milestones, totals.planned_cost / MONEY_SCALE,
+           totals.actual_cost / MONEY_SCALE,
+           totals.planned_days, totals.actual_days, totals.num_open_activities, "-", "-");
+    double base_planned_cost = totals.planned_cost;
+    long base_planned_days = totals.planned_days;
+
+    for (int s = 0; s < num_scenarios; s++) {
+        const scenario_t* scenario = scenarios[s];
+        scenario_totals(base, scenario, &totals);
+        printf("%-16.16s %4d/%-5d %14.2f %14.2f %9ld %9ld %12ld %8d %7zuK\n", scenario->name,
+               totals.num_completed_milestones, totals.num_milestones, totals.planned_cost / MONEY_SCALE,
+               totals.actual_cost / MONEY_SCALE,
+               totals.planned_days, totals.actual_days, totals.num_open_activities, scenario->num_edits,
+               (scenario_memory(scenario) + 1023) / 1024);
+        printf("%-16s %10s %+14.2f %14s %+9ld\n", "  vs base", "",
+               (totals.planned_cost - base_planned_cost) / MONEY_SCALE, "",
+               totals.planned_days - base_planned_days);
+    }
+}
+
+void scenario_free(scenario_t* scenario) {
+    if (scenario == NULL) {
+        return;
+    }
+    arena_destroy(scenario->arena);
+    free(scenario);
+}
@@ -0,0 +1,163 @@
+/* scenario.h */
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "a1_data_structures.h"
+
+#define SCENARIO_CHUNK_BITS 6
+#define SCENARIO_CHUNK_SIZE (1 << SCENARIO_CHUNK_BITS)   // Activities per copied chunk
+#define SCENARIO_ARENA_BLOCK_SIZE (16 * 1024)           // Small blocks: memory tracks the edits
+#define SCENARIO_NAME_SIZE 100
+
+/**
+ * WHAT-IF SCENARIOS
+ *
+ * A scenario is a fork of a project that changes its plan without touching
+ * the project itself: activities can get a different planned duration and
+ * cost, and activities or whole milestones can be dropped (re-scoped).
+ *
+ * Forking is O(1): a new scenario shares every milestone and activity with
+ * its base. The first edit inside a chunk of SCENARIO_CHUNK_SIZE activities
+ * copies that chunk's plan values into the scenario; later edits in the
+ * same chunk change the copy. Everything else - the other chunks, names and
+ * all actual values - is read from the base, so a scenario's memory grows
+ * with the chunks it has edited, not with the size of the project, and
+ * progress recorded on the base shows in every scenario.
+ *
+ * Rollups start from the base's milestone totals and adjust only the
+ * milestones with copied chunks, so they cost O(milestones + edits). Forks
+ * refer to base items by position; adding or removing milestones or
+ * activities in the base makes its forks stale (scenario_is_current). Edits
+ * to a stale fork are refused, and it must not be rolled up or diffed.
+ */
+
+/**
+ * Copied Chunk
+ *
+ * Plan values of SCENARIO_CHUNK_SIZE consecutive activities of one
+ * milestone; slot i is activity (chunk_index * SCENARIO_CHUNK_SIZE + i).
+ */
+typedef struct {
+    money_t planned_cost[SCENARIO_CHUNK_SIZE];
+    uint16_t planned_duration[SCENARIO_CHUNK_SIZE];
+    uint64_t dropped;                   // Bit i set: activity removed from the scenario
+} scenario_chunk_t;
+
+/**
+ * Milestone Overlay (allocated on the first edit in the milestone)
+ *
+ * - chunks: One slot per chunk of the base milestone, NULL while shared
+ * - dropped: The whole milestone is removed from the scenario
+ */
+typedef struct {
+    scenario_chunk_t** chunks;
+    int num_chunks;
+    bool dropped;
+} scenario_milestone_t;
+
+/**
+ * Scenario Structure
+ *
+ * - name: Label used in comparisons
+ * - base: Project the scenario was forked from (must outlive it)
+ * - structure_version: Base structure_version at fork time
+ * - milestones: One overlay pointer per base milestone, allocated with the
+ *   first edit (NULL entries are shared milestones)
+ * - arena: Owns the overlays and copied chunks
+ * - num_edits/num_chunks: Edits applied and chunks copied
+ */
+typedef struct scenario {
+    char name[SCENARIO_NAME_SIZE];
+    project_t* base;
+    uint32_t structure_version;
+    scenario_milestone_t** milestones;
+    int num_milestones;
+    arena_t* arena;
+    int num_edits;
+    int num_chunks;
+} scenario_t;
+
+/**
+ * Rolled-up Totals of a project or scenario
+ * Durations follow the project's convention: days per milestone, summed.
+ * Costs are in money units (cents with PM_FIXED_POINT, exact in a double).
+ */
+typedef struct {
+    double planned_cost, actual_cost;
+    long planned_days, actual_days;
+    int num_milestones, num_completed_milestones;
+    long num_activities, num_open_activities;
+} scenario_totals_t;
+
+/**
+ * Fork a scenario from a project - O(1)
+ * @return New scenario, exits on allocation failure
+ */
+scenario_t* scenario_fork(project_t* base, const char* name);
+
+/**
+ * Check that the base has not been restructured since the fork
+ */
+bool scenario_is_current(const scenario_t* scenario);
+
+/**
+ * Change an activity's plan in the scenario
+ * @return false if the ID is not an activity of the scenario
+ */
+bool scenario_set_plan(scenario_t* scenario, unsigned short int activity_id,
+                       unsigned short int planned_duration, money_t planned_cost);
+
+/**
+ * Remove an activity from the scenario
+ * @return false if the ID is not an activity of the scenario
+ */
+bool scenario_drop_activity(scenario_t* scenario, unsigned short int activity_id);
+
+/**
+ * Remove a milestone with its activities from the scenario
+ * @return false if the ID is not a milestone of the scenario
+ */
+bool scenario_drop_milestone(scenario_t* scenario, unsigned short int milestone_id);
+
+/**
+ * Scale the plan of every activity of a milestone (copies all of its chunks)
+ * Durations are rounded and capped at 65535 hours.
+ * @return false if the ID is not a milestone of the scenario or factor < 0
+ */
+bool scenario_scale_milestone(scenario_t* scenario, unsigned short int milestone_id, float factor);
+
+/**
+ * Read an activity as the scenario sees it
+ * @param out Receives a copy of the base activity with the scenario's plan
+ * @return false if the ID is not an activity or was dropped
+ */
+bool scenario_get_activity(const scenario_t* scenario, unsigned short int activity_id, activity_t* out);
+
+/**
+ * Roll up the base (scenario NULL) or a scenario - O(milestones + edits)
+ * The base's own rollups must be established.
+ */
+void scenario_totals(const project_t* base, const scenario_t* scenario, scenario_totals_t* totals);
+
+/**
+ * Bytes the scenario holds beyond its base
+ */
+size_t scenario_memory(const scenario_t* scenario);
+
+/**
+ * Print every item whose plan differs from the base
+ * @return Number of differences printed
+ */
+int print_scenario_diff(const scenario_t* scenario);
+
+/**
+ * Print the base and scenarios side by side
+ */
+void print_scenario_comparison(const project_t* base, scenario_t* const* scenarios, int num_scenarios);
+
+/**
+ * Free a scenario (the base is not affected)
+ */
+void scenario_free(scenario_t* scenario);
+
+#endif
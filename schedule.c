@@ -0,0 +1,559 @@
+/* schedule.c */
+#include "schedule.h"
+#include "a1_functions.h"
+#include <string.h>
+
+#define MAX_PATH_LINES 50        // Critical path activities listed before eliding the rest
+
+// =============================================================================
+// GRAPH CONSTRUCTION
+// =============================================================================
+
+/**
+ * Hours an activity occupies in the schedule
+ * Finished work counts as it happened; open work as planned, unless more
+ * hours have already been spent than were planned.
+ */
+static int scheduled_hours(const activity_t* activity) {
+    if (activity->completed || activity->actual_duration > activity->planned_duration) {
+        return activity->actual_duration;
+    }
+    return activity->planned_duration;
+}
+
+/**
+ * Get the project's schedule, creating an empty (stale) one if needed
+ */
+static schedule_t* get_schedule(project_t* project) {
+    if (project->schedule == NULL) {
+        project->schedule = calloc(1, sizeof(schedule_t));
+        if (project->schedule == NULL) {
+            printf("ERROR: Failed to allocate schedule. Exiting...\n");
+            exit(EXIT_FAILURE);
+        }
+        project->schedule->stale = true;
+    }
+    return project->schedule;
+}
+
+/**
+ * Free the derived graph, keeping the declared dependencies
+ */
+static void release_graph(schedule_t* schedule) {
+    free(schedule->node_ids);
+    free(schedule->node_of);
+    free(schedule->pred_start);
+    free(schedule->preds);
+    free(schedule->succ_start);
+    free(schedule->succs);
+    free(schedule->position);
+    free(schedule->order);
+    free(schedule->hours);
+    free(schedule->earliest_start);
+    free(schedule->tail);
+    free(schedule->sources);
+    free(schedule->source_slot);
+    free(schedule->heap);
+    free(schedule->queued);
+
+    dependency_t* dependencies = schedule->dependencies;
+    int num_dependencies = schedule->num_dependencies;
+    int capacity = schedule->capacity;
+    memset(schedule, 0, sizeof(schedule_t));
+    schedule->dependencies = dependencies;
+    schedule->num_dependencies = num_dependencies;
+    schedule->capacity = capacity;
+    schedule->stale = true;
+}
+
+static void* allocate_graph_array(size_t count, size_t size) {
+    void* memory = malloc((count > 0 ? count : 1) * size);
+    if (memory == NULL) {
+        printf("ERROR: Failed to allocate schedule graph. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+/**
+ * Fill one direction of the compressed graph: row start offsets by counting,
+ * then the entries. from/to select which end of each edge owns the row.
+ */
+static void build_rows(const schedule_t* schedule, const int* edge_from, const int* edge_to, int num_edges,
+                       int* row_start, int* entries) {
+    memset(row_start, 0, ((size_t)schedule->num_nodes + 1) * sizeof(int));
+    for (int e = 0; e < num_edges; e++) {
+        row_start[edge_from[e] + 1]++;
+    }
+    for (int v = 0; v < schedule->num_nodes; v++) {
+        row_start[v + 1] += row_start[v];
+    }
+
+    // Fill using row_start as a cursor, then shift it back into place
+    for (int e = 0; e < num_edges; e++) {
+        entries[row_start[edge_from[e]]++] = edge_to[e];
+    }
+    for (int v = schedule->num_nodes; v > 0; v--) {
+        row_start[v] = row_start[v - 1];
+    }
+    row_start[0] = 0;
+}
+
+/**
+ * Move a source to its place in the max-heap on tail, upwards and downwards
+ */
+static void source_place(schedule_t* schedule, int slot, int node) {
+    schedule->sources[slot] = node;
+    schedule->source_slot[node] = slot;
+}
+
+static void source_sift_down(schedule_t* schedule, int slot) {
+    int node = schedule->sources[slot];
+    while (true) {
+        int child = 2 * slot + 1;
+        if (child >= schedule->num_sources) {
+            break;
+        }
+        if (child + 1 < schedule->num_sources &&
+            schedule->tail[schedule->sources[child + 1]] > schedule->tail[schedule->sources[child]]) {
+            child++;
+        }
+        if (schedule->tail[schedule->sources[child]] <= schedule->tail[node]) {
+            break;
+        }
+        source_place(schedule, slot, schedule->sources[child]);
+        slot = child;
+    }
+    source_place(schedule, slot, node);
+}
+
+static void source_sift_up(schedule_t* schedule, int slot) {
+    int node = schedule->sources[slot];
+    while (slot > 0) {
+        int parent = (slot - 1) / 2;
+        if (schedule->tail[schedule->sources[parent]] >= schedule->tail[node]) {
+            break;
+        }
+        source_place(schedule, slot, schedule->sources[parent]);
+        slot = parent;
+    }
+    source_place(schedule, slot, node);
+}
+
+/**
+ * Rebuild the whole graph and schedule from the project - O(V + E)
+ * @return false if the dependencies contain a cycle
+ */
+static bool rebuild_schedule(project_t* project, schedule_t* schedule) {
+    release_graph(schedule);
+
+    int num_nodes = 0;
+    for (int i = 0; i < project->num_milestones; i++) {
+        num_nodes += project->milestone_list[i].num_activities;
+    }
+    int num_edges = schedule->num_dependencies;
+
+    schedule->num_nodes = num_nodes;
+    schedule->node_ids = allocate_graph_array((size_t)num_nodes, sizeof(unsigned short int));
+    schedule->node_of = allocate_graph_array(ID_SPACE_SIZE, sizeof(int));
+    schedule->pred_start = allocate_graph_array((size_t)num_nodes + 1, sizeof(int));
+    schedule->preds = allocate_graph_array((size_t)num_edges, sizeof(int));
+    schedule->succ_start = allocate_graph_array((size_t)num_nodes + 1, sizeof(int));
+    schedule->succs = allocate_graph_array((size_t)num_edges, sizeof(int));
+    schedule->position = allocate_graph_array((size_t)num_nodes, sizeof(int));
+    schedule->order = allocate_graph_array((size_t)num_nodes, sizeof(int));
+    schedule->hours = allocate_graph_array((size_t)num_nodes, sizeof(int));
+    schedule->earliest_start = allocate_graph_array((size_t)num_nodes, sizeof(int64_t));
+    schedule->tail = allocate_graph_array((size_t)num_nodes, sizeof(int64_t));
+    schedule->sources = allocate_graph_array((size_t)num_nodes, sizeof(int));
+    schedule->source_slot = allocate_graph_array((size_t)num_nodes, sizeof(int));
+    schedule->heap = allocate_graph_array((size_t)num_nodes, sizeof(int));
+    schedule->queued = calloc((size_t)num_nodes + 1, sizeof(bool));
+    if (schedule->queued == NULL) {
+        printf("ERROR: Failed to allocate schedule graph. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Dense node numbering in milestone order
+    for (int id = 0; id < ID_SPACE_SIZE; id++) {
+        schedule->node_of[id] = NO_INDEX;
+    }
+    int node = 0;
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        for (int j = 0; j < milestone->num_activities; j++) {
+            const activity_t* activity = &milestone->activity_list[j];
+            schedule->node_ids[node] = activity->id;
+            schedule->node_of[activity->id] = node;
+            schedule->hours[node] = scheduled_hours(activity);
+            node++;
+        }
+    }
+
+    // Edges as node pairs; both ends are activities (drop_removed keeps it so)
+    int* edge_activity = allocate_graph_array((size_t)num_edges, sizeof(int));
+    int* edge_predecessor = allocate_graph_array((size_t)num_edges, sizeof(int));
+    for (int e = 0; e < num_edges; e++) {
+        edge_activity[e] = schedule->node_of[schedule->dependencies[e].activity];
+        edge_predecessor[e] = schedule->node_of[schedule->dependencies[e].predecessor];
+    }
+    build_rows(schedule, edge_activity, edge_predecessor, num_edges, schedule->pred_start, schedule->preds);
+    build_rows(schedule, edge_predecessor, edge_activity, num_edges, schedule->succ_start, schedule->succs);
+    free(edge_activity);
+    free(edge_predecessor);
+
+    // Kahn's algorithm; position doubles as the remaining in-degree
+    int head = 0, sorted = 0;
+    for (int v = 0; v < num_nodes; v++) {
+        schedule->position[v] = schedule->pred_start[v + 1] - schedule->pred_start[v];
+        if (schedule->position[v] == 0) {
+            schedule->order[sorted++] = v;
+        }
+    }
+    while (head < sorted) {
+        int u = schedule->order[head++];
+        for (int k = schedule->succ_start[u]; k < schedule->succ_start[u + 1]; k++) {
+            int v = schedule->succs[k];
+            if (--schedule->position[v] == 0) {
+                schedule->order[sorted++] = v;
+            }
+        }
+    }
+    if (sorted < num_nodes) {
+        return false; // The rest sit on or behind a cycle
+    }
+    for (int i = 0; i < num_nodes; i++) {
+        schedule->position[schedule->order[i]] = i;
+    }
+
+    // Forward pass: earliest starts
+    for (int i = 0; i < num_nodes; i++) {
+        int u = schedule->order[i];
+        int64_t start = 0;
+        for (int k = schedule->pred_start[u]; k < schedule->pred_start[u + 1]; k++) {
+            int p = schedule->preds[k];
+            int64_t end = schedule->earliest_start[p] + schedule->hours[p];
+            if (end > start) {
+                start = end;
+            }
+        }
+        schedule->earliest_start[u] = start;
+    }
+
+    // Backward pass: tails
+    for (int i = num_nodes - 1; i >= 0; i--) {
+        int u = schedule->order[i];
+        int64_t rest = 0;
+        for (int k = schedule->succ_start[u]; k < schedule->succ_start[u + 1]; k++) {
+            int64_t tail = schedule->tail[schedule->succs[k]];
+            if (tail > rest) {
+                rest = tail;
+            }
+        }
+        schedule->tail[u] = schedule->hours[u] + rest;
+    }
+
+    // The longest tail, which always starts at a source, is the project duration
+    schedule->num_sources = 0;
+    for (int v = 0; v < num_nodes; v++) {
+        bool source = schedule->pred_start[v] == schedule->pred_start[v + 1];
+        schedule->source_slot[v] = source ? schedule->num_sources : NO_INDEX;
+        if (source) {
+            schedule->sources[schedule->num_sources++] = v;
+        }
+    }
+    for (int i = schedule->num_sources / 2 - 1; i >= 0; i--) {
+        source_sift_down(schedule, i);
+    }
+    schedule->finish = schedule->num_sources > 0 ? schedule->tail[schedule->sources[0]] : 0;
+
+    schedule->stale = false;
+    return true;
+}
+
+// =============================================================================
+// INCREMENTAL UPDATES
+// =============================================================================
+
+/**
+ * Heap order on topological position: direction 1 pops the earliest node
+ * (forward propagation), -1 the latest (backward propagation)
+ */
+static bool heap_before(const schedule_t* schedule, int a, int b, int direction) {
+    return direction * (schedule->position[a] - schedule->position[b]) < 0;
+}
+
+static void heap_push(schedule_t* schedule, int* size, int node, int direction) {
+    if (schedule->queued[node]) {
+        return;
+    }
+    schedule->queued[node] = true;
+
+    int i = (*size)++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!heap_before(schedule, node, schedule->heap[parent], direction)) {
+            break;
+        }
+        schedule->heap[i] = schedule->heap[parent];
+        i = parent;
+    }
+    schedule->heap[i] = node;
+}
+
+static int heap_pop(schedule_t* schedule, int* size, int direction) {
+    int top = schedule->heap[0];
+    int last = schedule->heap[--(*size)];
+    int i = 0;
+
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= *size) {
+            break;
+        }
+        if (child + 1 < *size && heap_before(schedule, schedule->heap[child + 1], schedule->heap[child], direction)) {
+            child++;
+        }
+        if (!heap_before(schedule, schedule->heap[child], last, direction)) {
+            break;
+        }
+        schedule->heap[i] = schedule->heap[child];
+        i = child;
+    }
+    if (*size > 0) {
+        schedule->heap[i] = last;
+    }
+    schedule->queued[top] = false;
+    return top;
+}
+
+void schedule_activity_changed(schedule_t* schedule, const activity_t* activity) {
+    if (schedule == NULL || schedule->stale) {
+        return;
+    }
+    int node = schedule->node_of[activity->id];
+    int hours = scheduled_hours(activity);
+    if (node == NO_INDEX || hours == schedule->hours[node]) {
+        return;
+    }
+    schedule->hours[node] = hours;
+
+    // Descendants in topological order: each is settled once all of its
+    // predecessors are, and propagation stops where a start does not move
+    int size = 0;
+    for (int k = schedule->succ_start[node]; k < schedule->succ_start[node + 1]; k++) {
+        heap_push(schedule, &size, schedule->succs[k], 1);
+    }
+    while (size > 0) {
+        int u = heap_pop(schedule, &size, 1);
+        int64_t start = 0;
+        for (int k = schedule->pred_start[u]; k < schedule->pred_start[u + 1]; k++) {
+            int p = schedule->preds[k];
+            int64_t end = schedule->earliest_start[p] + schedule->hours[p];
+            if (end > start) {
+                start = end;
+            }
+        }
+        if (start != schedule->earliest_start[u]) {
+            schedule->earliest_start[u] = start;
+            for (int k = schedule->succ_start[u]; k < schedule->succ_start[u + 1]; k++) {
+                heap_push(schedule, &size, schedule->succs[k], 1);
+            }
+        }
+    }
+
+    // Ancestors in reverse topological order, the same way for tails
+    heap_push(schedule, &size, node, -1);
+    while (size > 0) {
+        int u = heap_pop(schedule, &size, -1);
+        int64_t rest = 0;
+        for (int k = schedule->succ_start[u]; k < schedule->succ_start[u + 1]; k++) {
+            int64_t tail = schedule->tail[schedule->succs[k]];
+            if (tail > rest) {
+                rest = tail;
+            }
+        }
+        int64_t tail = schedule->hours[u] + rest;
+        if (tail != schedule->tail[u]) {
+            bool longer = tail > schedule->tail[u];
+            schedule->tail[u] = tail;
+            int slot = schedule->source_slot[u];
+            if (slot != NO_INDEX && longer) {
+                source_sift_up(schedule, slot);
+            } else if (slot != NO_INDEX) {
+                source_sift_down(schedule, slot);
+            }
+            for (int k = schedule->pred_start[u]; k < schedule->pred_start[u + 1]; k++) {
+                heap_push(schedule, &size, schedule->preds[k], -1);
+            }
+        }
+    }
+
+    // A source always exists: the changed node has one among its ancestors
+    schedule->finish = schedule->tail[schedule->sources[0]];
+}
+
+// =============================================================================
+// DEPENDENCY MANAGEMENT
+// =============================================================================
+
+void append_dependency(project_t* project, dependency_t dependency) {
+    schedule_t* schedule = get_schedule(project);
+
+    if (schedule->num_dependencies == schedule->capacity) {
+        int capacity = schedule->capacity < 16 ? 16 : schedule->capacity * 2;
+        dependency_t* grown = realloc(schedule->dependencies, (size_t)capacity * sizeof(dependency_t));
+        if (grown == NULL) {
+            printf("ERROR: Failed to grow dependency list. Exiting...\n");
+            exit(EXIT_FAILURE);
+        }
+        schedule->dependencies = grown;
+        schedule->capacity = capacity;
+    }
+    schedule->dependencies[schedule->num_dependencies++] = dependency;
+    schedule->stale = true;
+}
+
+const char* add_dependency(project_t* project, unsigned short int activity_id,
+                           unsigned short int predecessor_id) {
+    if (find_activity_by_id(project, activity_id, NULL) == NULL ||
+        find_activity_by_id(project, predecessor_id, NULL) == NULL) {
+        return "both IDs must belong to activities";
+    }
+    if (activity_id == predecessor_id) {
+        return "an activity cannot depend on itself";
+    }
+
+    const schedule_t* schedule = get_schedule(project);
+    for (int e = 0; e < schedule->num_dependencies; e++) {
+        if (schedule->dependencies[e].activity == activity_id &&
+            schedule->dependencies[e].predecessor == predecessor_id) {
+            return "that dependency already exists";
+        }
+    }
+
+    dependency_t dependency = { activity_id, predecessor_id };
+    append_dependency(project, dependency);
+    if (!schedule_refresh(project)) {
+        project->schedule->num_dependencies--;
+        project->schedule->stale = true;
+        schedule_refresh(project);
+        return "it would create a cycle";
+    }
+    return NULL;
+}
+
+bool schedule_refresh(project_t* project) {
+    schedule_t* schedule = project->schedule;
+    if (schedule == NULL || !schedule->stale) {
+        return true;
+    }
+    return rebuild_schedule(project, schedule);
+}
+
+void schedule_drop_removed(project_t* project) {
+    schedule_t* schedule = project->schedule;
+    if (schedule == NULL) {
+        return;
+    }
+
+    int kept = 0;
+    for (int e = 0; e < schedule->num_dependencies; e++) {
+        dependency_t dependency = schedule->dependencies[e];
+        if (find_activity_by_id(project, dependency.activity, NULL) != NULL &&
+            find_activity_by_id(project, dependency.predecessor, NULL) != NULL) {
+            schedule->dependencies[kept++] = dependency;
+        }
+    }
+    schedule->num_dependencies = kept;
+    schedule->stale = true;
+}
+
+void schedule_invalidate(schedule_t* schedule) {
+    if (schedule != NULL) {
+        schedule->stale = true;
+    }
+}
+
+bool schedule_lookup(const schedule_t* schedule, unsigned short int activity_id,
+                     int64_t* earliest_start, int64_t* latest_start, int64_t* slack) {
+    if (schedule == NULL || schedule->stale || schedule->node_of[activity_id] == NO_INDEX) {
+        return false;
+    }
+    int node = schedule->node_of[activity_id];
+    *earliest_start = schedule->earliest_start[node];
+    *latest_start = schedule->finish - schedule->tail[node];
+    *slack = *latest_start - *earliest_start;
+    return true;
+}
+
+// =============================================================================
+// REPORTING
+// =============================================================================
+
+void print_critical_path(project_t* project) {
+    schedule_t* schedule = get_schedule(project);
+
+    printf("\nCRITICAL PATH\n");
+    printf("----------------------------------------\n");
+    if (!schedule_refresh(project)) {
+        printf("The dependencies contain a cycle, so no schedule exists.\n");
+        return;
+    }
+    if (schedule->num_nodes == 0) {
+        printf("The project has no activities.\n");
+        return;
+    }
+
+    // Start at the first source on a longest chain, then keep following a
+    // successor that starts the moment the current activity ends and is
+    // itself on a longest chain
+    int node = NO_INDEX;
+    for (int i = 0; i < schedule->num_nodes && node == NO_INDEX; i++) {
+        int v = schedule->order[i];
+        if (schedule->earliest_start[v] == 0 && schedule->tail[v] == schedule->finish) {
+            node = v;
+        }
+    }
+
+    int length = 0;
+    while (node != NO_INDEX) {
+        int64_t end = schedule->earliest_start[node] + schedule->hours[node];
+        if (length < MAX_PATH_LINES) {
+            const activity_t* activity = find_activity_by_id(project, schedule->node_ids[node], NULL);
+            printf("ID: %hu | %s | hours %lld-%lld\n", activity->id, get_name(project, activity->name),
+                   (long long)schedule->earliest_start[node], (long long)end);
+        }
+        length++;
+
+        int next = NO_INDEX;
+        for (int k = schedule->succ_start[node]; k < schedule->succ_start[node + 1] && next == NO_INDEX; k++) {
+            int v = schedule->succs[k];
+            if (schedule->earliest_start[v] == end && end + schedule->tail[v] == schedule->finish) {
+                next = v;
+            }
+        }
+        node = next;
+    }
+    if (length > MAX_PATH_LINES) {
+        printf("... and %d more\n", length - MAX_PATH_LINES);
+    }
+
+    int with_slack = 0;
+    for (int v = 0; v < schedule->num_nodes; v++) {
+        with_slack += schedule->earliest_start[v] + schedule->tail[v] < schedule->finish;
+    }
+    printf("Critical path: %d activity/activities, %lld hour(s) (%lld day(s))\n", length,
+           (long long)schedule->finish, (long long)((schedule->finish + HOURS_PER_DAY - 1) / HOURS_PER_DAY));
+    printf("Activities with slack: %d of %d | Dependencies: %d\n", with_slack, schedule->num_nodes,
+           schedule->num_dependencies);
+}
+
+void schedule_free(schedule_t* schedule) {
+    if (schedule == NULL) {
+        return;
+    }
+    release_graph(schedule);
+    free(schedule->dependencies);
+    free(schedule);
+}
@@ -0,0 +1,141 @@
+/* schedule.h */
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include "a1_data_structures.h"
+
+/**
+ * CRITICAL PATH SCHEDULING
+ *
+ * Activities may declare predecessors: an activity starts once all of its
+ * predecessors have finished. The schedule holds the dependency graph and,
+ * for every activity, its earliest start (ES) and its tail - the longest
+ * chain of work from its own start to the end of the project. From those:
+ *
+ *   finish        = longest path through the graph (the project duration)
+ *   latest start  = finish - tail
+ *   slack         = finish - tail - ES   (0 on the critical path)
+ *
+ * A full build is one topological sort plus a forward (ES) and a backward
+ * (tail) pass, O(V + E). When an activity's duration changes, ES is
+ * re-propagated only to its descendants and tail only to its ancestors,
+ * stopping wherever a value does not change, so an update costs the size
+ * of the affected subgraph rather than the whole graph. The finish is kept
+ * in a heap of the chains' starting points, so it follows in O(log V).
+ *
+ * Durations are in hours: completed activities count with their actual
+ * hours, the others with their planned hours (or the hours already spent,
+ * when that is more).
+ *
+ * Adding or removing activities or dependencies marks the schedule stale;
+ * it is rebuilt on the next query.
+ */
+
+/**
+ * Dependency: activity cannot start before predecessor has finished
+ */
+typedef struct {
+    unsigned short int activity;
+    unsigned short int predecessor;
+} dependency_t;
+
+/**
+ * Schedule Structure
+ *
+ * Fields:
+ * - dependencies/num_dependencies/capacity: Declared edges (source of truth)
+ * - stale: Graph must be rebuilt before it is used
+ * - num_nodes/node_ids/node_of: Dense node index <-> activity ID
+ * - pred_start/preds, succ_start/succs: Graph in compressed row form
+ * - position/order: Topological position of each node and its inverse
+ * - hours/earliest_start/tail: Per-node duration, ES and tail (hours)
+ * - finish: Project duration along the critical path (hours)
+ * - sources/num_sources: Max-heap on tail of the nodes without predecessors;
+ *   every chain starts at one, so the top's tail is finish
+ * - source_slot: Each node's index in sources (NO_INDEX if it has predecessors)
+ * - heap/queued: Scratch work list for incremental updates
+ */
+typedef struct schedule {
+    dependency_t* dependencies;
+    int num_dependencies;
+    int capacity;
+    bool stale;
+    int num_nodes;
+    unsigned short int* node_ids;
+    int* node_of;
+    int* pred_start;
+    int* preds;
+    int* succ_start;
+    int* succs;
+    int* position;
+    int* order;
+    int* hours;
+    int64_t* earliest_start;
+    int64_t* tail;
+    int64_t finish;
+    int* sources;
+    int num_sources;
+    int* source_slot;
+    int* heap;
+    bool* queued;
+} schedule_t;
+
+/**
+ * Declare that an activity depends on a predecessor
+ * Creates the project's schedule on first use. The edge is rejected if
+ * either ID is not an activity, if it already exists, or if it would
+ * create a cycle.
+ * @return NULL on success, otherwise the reason for rejecting it
+ */
+const char* add_dependency(project_t* project, unsigned short int activity_id,
+                           unsigned short int predecessor_id);
+
+/**
+ * Append a dependency without validating it (bulk loading)
+ * Creates the project's schedule on first use. The caller checks that both
+ * IDs are activities and calls schedule_refresh afterwards to detect cycles.
+ */
+void append_dependency(project_t* project, dependency_t dependency);
+
+/**
+ * Bring the schedule up to date, rebuilding it if it is stale
+ * @return false if the dependencies contain a cycle
+ */
+bool schedule_refresh(project_t* project);
+
+/**
+ * Re-schedule after one activity's values changed - O(affected subgraph)
+ * Called by rollup_activity_change; a no-op when the activity's scheduled
+ * duration is unchanged or the schedule is stale.
+ */
+void schedule_activity_changed(schedule_t* schedule, const activity_t* activity);
+
+/**
+ * Forget dependencies of IDs that no longer belong to activities
+ * Called after activities are removed, before their IDs can be reused.
+ */
+void schedule_drop_removed(project_t* project);
+
+/**
+ * Mark the graph for a rebuild (activities added or changed in bulk)
+ */
+void schedule_invalidate(schedule_t* schedule);
+
+/**
+ * Scheduled values of one activity (schedule must be fresh)
+ * @return false if the ID is not a scheduled activity
+ */
+bool schedule_lookup(const schedule_t* schedule, unsigned short int activity_id,
+                     int64_t* earliest_start, int64_t* latest_start, int64_t* slack);
+
+/**
+ * Print the critical path and the project duration
+ */
+void print_critical_path(project_t* project);
+
+/**
+ * Free the schedule (free_project does this for the project's schedule)
+ */
+void schedule_free(schedule_t* schedule);
+
+#endif
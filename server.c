@@ -0,0 +1,600 @@
+/* server.c */
+#include "server.h"
+#include "a1_functions.h"
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define SERVER_INPUT_SIZE 4096        // Longest request line plus pipelined data
+#define SERVER_OUTPUT_SIZE 16384      // Replies collected before one write
+#define SERVER_REPLY_MAX 1024         // Room kept free for a single reply
+
+enum { SLOT_FREE, SLOT_RUNNING, SLOT_FINISHED };
+
+static volatile sig_atomic_t stop_requested;
+
+static void request_stop(int signal_number) {
+    (void)signal_number;
+    stop_requested = 1;
+}
+
+// =============================================================================
+// VIEWS AND RECLAMATION
+// =============================================================================
+
+static void* checked_malloc(size_t size) {
+    void* memory = malloc(size);
+    if (memory == NULL) {
+        printf("ERROR: Failed to allocate server view. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+static void fill_milestone_row(view_row_t* row, const milestone_t* milestone) {
+    row->kind = VIEW_ROW_MILESTONE;
+    row->completed = milestone->completed;
+    row->milestone_id = milestone->id;
+    row->name = milestone->name;
+    row->planned_cost = milestone->planned_cost;
+    row->actual_cost = milestone->actual_cost;
+    row->planned_hours = milestone->planned_hours;
+    row->actual_hours = milestone->actual_hours;
+    row->num_completed = milestone->num_completed;
+    row->num_activities = milestone->num_activities;
+}
+
+static void fill_activity_row(view_row_t* row, const milestone_t* milestone, const activity_t* activity) {
+    row->kind = VIEW_ROW_ACTIVITY;
+    row->completed = activity->completed;
+    row->milestone_id = milestone->id;
+    row->name = activity->name;
+    row->planned_cost = activity->planned_cost;
+    row->actual_cost = activity->actual_cost;
+    row->planned_hours = activity->planned_duration;
+    row->actual_hours = activity->actual_duration;
+    row->num_completed = 0;
+    row->num_activities = 0;
+}
+
+static void copy_project_totals(project_view_t* view, const project_t* project) {
+    view->planned_cost = project->planned_cost;
+    view->actual_cost = project->actual_cost;
+    view->planned_duration = project->planned_duration;
+    view->actual_duration = project->actual_duration;
+    view->completed = project->completed;
+    view->num_milestones = project->num_milestones;
+    view->num_completed_milestones = project->num_completed_milestones;
+    view->num_open_activities = project->num_open_activities;
+}
+
+/**
+ * Row of a fresh leaf, allocating the leaf on first use
+ */
+static view_row_t* initial_row(project_view_t* view, unsigned short int id) {
+    view_leaf_t** leaf = &view->leaves[id >> VIEW_LEAF_BITS];
+    if (*leaf == NULL) {
+        *leaf = checked_malloc(sizeof(view_leaf_t));
+        memset(*leaf, 0, sizeof(view_leaf_t));
+    }
+    return &(*leaf)->rows[id & (VIEW_LEAF_SIZE - 1)];
+}
+
+static project_view_t* build_initial_view(const project_t* project) {
+    project_view_t* view = checked_malloc(sizeof(project_view_t));
+    memset(view, 0, sizeof(project_view_t));
+    copy_project_totals(view, project);
+
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        fill_milestone_row(initial_row(view, milestone->id), milestone);
+        for (int j = 0; j < milestone->num_activities; j++) {
+            const activity_t* activity = &milestone->activity_list[j];
+            fill_activity_row(initial_row(view, activity->id), milestone, activity);
+        }
+    }
+    return view;
+}
+
+static void retire(server_t* server, void* memory) {
+    if (server->num_retired == server->retired_capacity) {
+        int capacity = server->retired_capacity ? server->retired_capacity * 2 : 64;
+        retired_t* grown = realloc(server->retired, (size_t)capacity * sizeof(retired_t));
+        if (grown == NULL) {
+            printf("ERROR: Failed to grow server retire list. Exiting...\n");
+            exit(EXIT_FAILURE);
+        }
+        server->retired = grown;
+        server->retired_capacity = capacity;
+    }
+    server->retired[server->num_retired].memory = memory;
+    server->retired[server->num_retired].epoch = 0;  // Stamped after publishing
+    server->num_retired++;
+}
+
+/**
+ * Row in a new view that may be written, copying its leaf on first write
+ * The new view starts as a copy of the old one, so a leaf still shared
+ * with the old view is copied and the old leaf is retired.
+ */
+static view_row_t* writable_row(server_t* server, project_view_t* view, const project_view_t* old,
+                                unsigned short int id) {
+    int index = id >> VIEW_LEAF_BITS;
+    if (view->leaves[index] == old->leaves[index]) {
+        view_leaf_t* copy = checked_malloc(sizeof(view_leaf_t));
+        memcpy(copy, old->leaves[index], sizeof(view_leaf_t));
+        retire(server, old->leaves[index]);
+        view->leaves[index] = copy;
+    }
+    return &view->leaves[index]->rows[id & (VIEW_LEAF_SIZE - 1)];
+}
+
+/**
+ * Free retired memory that no reader can still reach
+ * A reader that entered at an epoch later than the retirement stamp loaded
+ * the view after it was replaced, so it cannot hold the old memory.
+ */
+static void reclaim(server_t* server) {
+    unsigned long oldest = ULONG_MAX;
+    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+        unsigned long epoch = atomic_load(&server->clients[i].epoch);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    int kept = 0;
+    for (int i = 0; i < server->num_retired; i++) {
+        if (server->retired[i].epoch < oldest) {
+            free(server->retired[i].memory);
+        } else {
+            server->retired[kept++] = server->retired[i];
+        }
+    }
+    server->num_retired = kept;
+}
+
+/**
+ * Publish the state after an update of one activity (write lock held)
+ */
+static void publish_update(server_t* server, const milestone_t* milestone, const activity_t* activity) {
+    project_view_t* old = atomic_load_explicit(&server->view, memory_order_relaxed);
+    project_view_t* view = checked_malloc(sizeof(project_view_t));
+    int first_retired = server->num_retired;
+
+    memcpy(view, old, sizeof(project_view_t));
+    view->version = ++server->updates;
+    copy_project_totals(view, server->project);
+    fill_activity_row(writable_row(server, view, old, activity->id), milestone, activity);
+    fill_milestone_row(writable_row(server, view, old, milestone->id), milestone);
+    retire(server, old);
+
+    atomic_store(&server->view, view);
+    unsigned long epoch = atomic_fetch_add(&server->epoch, 1);
+    for (int i = first_retired; i < server->num_retired; i++) {
+        server->retired[i].epoch = epoch;
+    }
+    reclaim(server);
+}
+
+static const project_view_t* read_begin(client_slot_t* slot) {
+    atomic_store(&slot->epoch, atomic_load(&slot->server->epoch));
+    return atomic_load(&slot->server->view);
+}
+
+static void read_end(client_slot_t* slot) {
+    atomic_store_explicit(&slot->epoch, 0, memory_order_release);
+}
+
+// =============================================================================
+// REQUESTS
+// =============================================================================
+
+/**
+ * Reply Buffer
+ */
+typedef struct {
+    char data[SERVER_OUTPUT_SIZE];
+    size_t length;
+} reply_buffer_t;
+
+/**
+ * Append one reply line; overlong replies are cut short but keep their newline
+ */
+static void reply(reply_buffer_t* out, const char* format, ...) {
+    size_t room = sizeof(out->data) - out->length;
+    va_list args;
+
+    va_start(args, format);
+    int written = vsnprintf(out->data + out->length, room, format, args);
+    va_end(args);
+
+    if (written < 0) {
+        written = 0;
+    }
+    if ((size_t)written >= room - 1) {
+        written = (int)room - 2;
+    }
+    out->length += (size_t)written;
+    out->data[out->length++] = '\n';
+}
+
+static bool parse_uint(const char* text, unsigned long max, unsigned long* out) {
+    char* end;
+    if (text == NULL || *text < '0' || *text > '9') {
+        return false;
+    }
+    errno = 0;
+    unsigned long value = strtoul(text, &end, 10);
+    if (*end != '\0' || errno != 0 || value > max) {
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+static bool parse_cost(const char* text, money_t* out) {
+    char* end;
+    if (text == NULL) {
+        return false;
+    }
+    double value = strtod(text, &end);
+    if (end == text || *end != '\0' || !(value >= 0 && value <= ACTIVITY_MAX_DOLLARS)) {
+        return false;
+    }
+    *out = money_from_dollars(value);
+    return true;
+}
+
+static void handle_stats(client_slot_t* slot, reply_buffer_t* out) {
+    const project_view_t* view = read_begin(slot);
+    reply(out, "OK version=%llu planned_cost=%.2f actual_cost=%.2f planned_days=%lld actual_days=%lld "
+               "milestones=%d/%d open_activities=%d completed=%d",
+          (unsigned long long)view->version, money_to_dollars(view->planned_cost),
+          money_to_dollars(view->actual_cost), (long long)view->planned_duration,
+          (long long)view->actual_duration, view->num_completed_milestones,
+          view->num_milestones, view->num_open_activities, view->completed);
+    read_end(slot);
+}
+
+static void handle_get(client_slot_t* slot, const char* argument, reply_buffer_t* out) {
+    unsigned long id;
+    if (!parse_uint(argument, 65535, &id)) {
+        reply(out, "ERR usage: GET <id>");
+        return;
+    }
+
+    const project_view_t* view = read_begin(slot);
+    const view_leaf_t* leaf = view->leaves[id >> VIEW_LEAF_BITS];
+    const view_row_t* row = leaf != NULL ? &leaf->rows[id & (VIEW_LEAF_SIZE - 1)] : NULL;
+    const char* name = row != NULL ? get_name(slot->server->project, row->name) : "";
+
+    if (row == NULL || row->kind == VIEW_ROW_EMPTY) {
+        reply(out, "ERR no item with ID %lu", id);
+    } else if (row->kind == VIEW_ROW_MILESTONE) {
+        reply(out, "OK milestone id=%lu activities=%d/%d planned_hours=%lld actual_hours=%lld "
+                   "planned_cost=%.2f actual_cost=%.2f completed=%d name=%s",
+              id, row->num_completed, row->num_activities, (long long)row->planned_hours,
+              (long long)row->actual_hours, money_to_dollars(row->planned_cost),
+              money_to_dollars(row->actual_cost), row->completed, name);
+    } else {
+        reply(out, "OK activity id=%lu milestone=%u planned_hours=%lld actual_hours=%lld "
+                   "planned_cost=%.2f actual_cost=%.2f completed=%d name=%s",
+              id, row->milestone_id, (long long)row->planned_hours, (long long)row->actual_hours,
+              money_to_dollars(row->planned_cost), money_to_dollars(row->actual_cost), row->completed, name);
+    }
+    read_end(slot);
+}
+
+static void handle_update(server_t* server, char* arguments, reply_buffer_t* out) {
+    char* save = NULL;
+    const char* fields[4];
+    unsigned long id, actual_hours, completed;
+    money_t actual_cost;
+
+    for (int i = 0; i < 4; i++) {
+        fields[i] = arguments != NULL ? strtok_r(i == 0 ? arguments : NULL, " ", &save) : NULL;
+    }
+    if (fields[3] == NULL || strtok_r(NULL, " ", &save) != NULL ||
+        !parse_uint(fields[0], 65535, &id) ||
+        !parse_uint(fields[1], 65535, &actual_hours) ||
+        !parse_cost(fields[2], &actual_cost) ||
+        !parse_uint(fields[3], 1, &completed)) {
+        reply(out, "ERR usage: UPDATE <id> <actual_hours> <actual_cost> <0|1>");
+        return;
+    }
+
+    pthread_mutex_lock(&server->write_lock);
+    milestone_t* milestone = NULL;
+    activity_t* activity = find_activity_by_id(server->project, (unsigned short int)id, &milestone);
+    if (activity == NULL) {
+        pthread_mutex_unlock(&server->write_lock);
+        reply(out, "ERR no activity with ID %lu", id);
+        return;
+    }
+
+    activity_t before = *activity;
+    activity->actual_duration = (unsigned short int)actual_hours;
+    activity->actual_cost = actual_cost;
+    activity->completed = completed == 1;
+    rollup_activity_change(server->project, milestone, &before, activity);
+
+    bool journaled = server->journal == NULL || journal_append(server->journal, server->project, activity);
+    publish_update(server, milestone, activity);
+    uint64_t version = server->updates;
+    pthread_mutex_unlock(&server->write_lock);
+
+    if (journaled) {
+        reply(out, "OK version=%llu", (unsigned long long)version);
+    } else {
+        reply(out, "ERR update applied but could not be journaled");
+    }
+}
+
+/**
+ * Handle one request line
+ * @return false if the client asked to close the connection
+ */
+static bool handle_request(client_slot_t* slot, char* line, reply_buffer_t* out) {
+    char* arguments = strchr(line, ' ');
+    if (arguments != NULL) {
+        *arguments++ = '\0';
+    }
+
+    if (strcmp(line, "STATS") == 0) {
+        handle_stats(slot, out);
+    } else if (strcmp(line, "GET") == 0) {
+        handle_get(slot, arguments, out);
+    } else if (strcmp(line, "UPDATE") == 0) {
+        handle_update(slot->server, arguments, out);
+    } else if (strcmp(line, "PING") == 0) {
+        reply(out, "OK");
+    } else if (strcmp(line, "QUIT") == 0) {
+        return false;
+    } else {
+        reply(out, "ERR unknown request");
+    }
+    return true;
+}
+
+// =============================================================================
+// CONNECTIONS
+// =============================================================================
+
+static bool write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = send(fd, data, length, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+/**
+ * Connection thread: read request lines, answer every complete line read
+ * so far with a single write
+ */
+static void* client_main(void* argument) {
+    client_slot_t* slot = argument;
+    char input[SERVER_INPUT_SIZE];
+    size_t used = 0;
+    bool open = true;
+    reply_buffer_t* out = checked_malloc(sizeof(reply_buffer_t));
+
+    while (open) {
+        ssize_t received = read(slot->fd, input + used, sizeof(input) - used);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        used += (size_t)received;
+
+        size_t start = 0;
+        char* newline;
+        out->length = 0;
+        while (open && (newline = memchr(input + start, '\n', used - start)) != NULL) {
+            char* line = input + start;
+            start = (size_t)(newline - input) + 1;
+            *newline = '\0';
+            if (newline > line && newline[-1] == '\r') {
+                newline[-1] = '\0';
+            }
+
+            open = handle_request(slot, line, out);
+            if (sizeof(out->data) - out->length < SERVER_REPLY_MAX) {
+                open = open && write_all(slot->fd, out->data, out->length);
+                out->length = 0;
+            }
+        }
+        if (start == 0 && used == sizeof(input)) {
+            reply(out, "ERR request line too long");
+            open = false;
+        }
+        if (out->length > 0 && !write_all(slot->fd, out->data, out->length)) {
+            break;
+        }
+
+        memmove(input, input + start, used - start);
+        used -= start;
+    }
+
+    // The socket is closed once the thread is joined, so it can still be
+    // shut down safely from the accept loop until then
+    free(out);
+    shutdown(slot->fd, SHUT_RDWR);
+    atomic_store(&slot->state, SLOT_FINISHED);
+    return NULL;
+}
+
+/**
+ * Start a connection thread in a free slot, joining finished threads first
+ * The thread inherits a mask that blocks SIGINT/SIGTERM, so those always
+ * reach the accept loop.
+ */
+static bool start_client(server_t* server, int fd) {
+    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+        client_slot_t* slot = &server->clients[i];
+        if (atomic_load(&slot->state) == SLOT_FINISHED) {
+            pthread_join(slot->thread, NULL);
+            close(slot->fd);
+            atomic_store(&slot->state, SLOT_FREE);
+        }
+        if (atomic_load(&slot->state) != SLOT_FREE) {
+            continue;
+        }
+
+        sigset_t blocked, previous;
+        sigemptyset(&blocked);
+        sigaddset(&blocked, SIGINT);
+        sigaddset(&blocked, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+
+        slot->fd = fd;
+        slot->server = server;
+        atomic_store(&slot->state, SLOT_RUNNING);
+        int error = pthread_create(&slot->thread, NULL, client_main, slot);
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        if (error != 0) {
+            atomic_store(&slot->state, SLOT_FREE);
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+static int open_listener(const char* socket_path) {
+    struct sockaddr_un address;
+    struct stat info;
+
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "ERROR: Socket path '%s' is too long\n", socket_path);
+        return -1;
+    }
+    if (lstat(socket_path, &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            fprintf(stderr, "ERROR: '%s' exists and is not a socket\n", socket_path);
+            return -1;
+        }
+        unlink(socket_path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("ERROR: socket");
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        fprintf(stderr, "ERROR: Cannot listen on '%s': %s\n", socket_path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+long run_server(project_t* project, const char* socket_path, journal_t* journal) {
+    server_t* server = calloc(1, sizeof(server_t));
+    if (server == NULL) {
+        printf("ERROR: Failed to allocate server. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    server->listen_fd = open_listener(socket_path);
+    if (server->listen_fd < 0) {
+        free(server);
+        return -1;
+    }
+    server->project = project;
+    server->journal = journal;
+    if (journal != NULL) {
+        journal_compact_inline(journal); // Clients are served from threads
+    }
+    pthread_mutex_init(&server->write_lock, NULL);
+    atomic_init(&server->view, build_initial_view(project));
+    atomic_init(&server->epoch, 1);
+    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+        atomic_init(&server->clients[i].state, SLOT_FREE);
+        atomic_init(&server->clients[i].epoch, 0);
+    }
+
+    // No SA_RESTART: a signal interrupts poll so the loop sees the request
+    struct sigaction action, previous_int, previous_term;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigemptyset(&action.sa_mask);
+    stop_requested = 0;
+    sigaction(SIGINT, &action, &previous_int);
+    sigaction(SIGTERM, &action, &previous_term);
+
+    while (!stop_requested) {
+        struct pollfd listener = { server->listen_fd, POLLIN, 0 };
+        if (poll(&listener, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("ERROR: poll");
+            break;
+        }
+
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        if (!start_client(server, fd)) {
+            write_all(fd, "ERR server busy\n", 16);
+            close(fd);
+        }
+    }
+
+    // Wake every connection thread blocked in read, then wait for it
+    close(server->listen_fd);
+    unlink(socket_path);
+    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+        client_slot_t* slot = &server->clients[i];
+        if (atomic_load(&slot->state) == SLOT_RUNNING) {
+            shutdown(slot->fd, SHUT_RDWR);
+        }
+    }
+    for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+        if (atomic_load(&server->clients[i].state) != SLOT_FREE) {
+            pthread_join(server->clients[i].thread, NULL);
+            close(server->clients[i].fd);
+        }
+    }
+    sigaction(SIGINT, &previous_int, NULL);
+    sigaction(SIGTERM, &previous_term, NULL);
+
+    // No readers remain: free the last view and everything retired
+    project_view_t* view = atomic_load(&server->view);
+    for (int i = 0; i < VIEW_NUM_LEAVES; i++) {
+        free(view->leaves[i]);
+    }
+    free(view);
+    for (int i = 0; i < server->num_retired; i++) {
+        free(server->retired[i].memory);
+    }
+    free(server->retired);
+    pthread_mutex_destroy(&server->write_lock);
+
+    long updates = (long)server->updates;
+    free(server);
+    return updates;
+}
@@ -0,0 +1,139 @@
+/* server.h */
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "a1_data_structures.h"
+#include "journal.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/**
+ * LOCAL PROJECT SERVER
+ *
+ * Serves one project to many local clients over a Unix domain socket with a
+ * line-based protocol (one request line, one reply line):
+ *
+ *   PING                                        -> OK
+ *   STATS                                       -> OK version=.. planned_cost=.. ...
+ *   GET <id>                                    -> OK activity|milestone id=.. ... name=<name>
+ *   UPDATE <id> <actual_hours> <actual_cost> <0|1> -> OK version=..
+ *   QUIT                                        -> (connection closed)
+ *
+ * Failures reply "ERR <message>". Requests may be pipelined.
+ *
+ * Readers never touch the project itself. Every update publishes a new
+ * immutable view (project totals plus one row per ID) through an atomic
+ * pointer; readers load the current view and format their reply from it
+ * without taking any lock, so a burst of reads never delays an update and
+ * a reply is always consistent with a single version. Views are
+ * copy-on-write at the granularity of 256-ID leaves, so an update copies
+ * the one or two leaves it changes and shares the rest. Replaced leaves are
+ * freed once every reader that could still hold them has finished
+ * (epoch-based reclamation). Updates are serialized by one writer lock.
+ */
+
+#define SERVER_MAX_CLIENTS 64          // Concurrent connections
+#define VIEW_LEAF_BITS 8
+#define VIEW_LEAF_SIZE (1 << VIEW_LEAF_BITS)
+#define VIEW_NUM_LEAVES (ID_SPACE_SIZE / VIEW_LEAF_SIZE)
+
+typedef enum {
+    VIEW_ROW_EMPTY,
+    VIEW_ROW_ACTIVITY,
+    VIEW_ROW_MILESTONE
+} view_row_kind_t;
+
+/**
+ * View Row
+ *
+ * Published state of one ID. Milestone rows report hours and their
+ * completed/total activity counts; activity rows name their milestone.
+ */
+typedef struct {
+    uint8_t kind;                       // view_row_kind_t
+    bool completed;
+    unsigned short int milestone_id;    // Owning milestone (activity rows)
+    name_ref_t name;
+    money_t planned_cost, actual_cost;
+    hours_t planned_hours, actual_hours;
+    int num_completed, num_activities;  // Milestone rows only
+} view_row_t;
+
+typedef struct {
+    view_row_t rows[VIEW_LEAF_SIZE];
+} view_leaf_t;
+
+/**
+ * Project View
+ *
+ * Immutable once published. Leaves with no IDs in use are NULL.
+ */
+typedef struct {
+    uint64_t version;                   // Updates applied since the server started
+    money_t planned_cost, actual_cost;
+    days_t planned_duration, actual_duration;
+    bool completed;
+    int num_milestones, num_completed_milestones;
+    int num_open_activities;
+    view_leaf_t* leaves[VIEW_NUM_LEAVES];
+} project_view_t;
+
+/**
+ * Retired Allocation (freed once no reader can reach it)
+ */
+typedef struct {
+    void* memory;
+    unsigned long epoch;                // Global epoch when it was unlinked
+} retired_t;
+
+/**
+ * Client Slot
+ *
+ * - thread/fd: Connection thread and its socket
+ * - state: SLOT_FREE, SLOT_RUNNING or SLOT_FINISHED (joinable)
+ * - epoch: Global epoch seen on entering a read, 0 outside reads
+ */
+typedef struct {
+    pthread_t thread;
+    int fd;
+    atomic_int state;
+    atomic_ulong epoch;
+    struct server* server;
+} client_slot_t;
+
+/**
+ * Server State
+ *
+ * - project/journal: Served project, updated only under write_lock
+ * - view: Currently published view
+ * - epoch: Global reclamation epoch, starts at 1
+ * - retired/num_retired/retired_capacity: Memory waiting for readers to leave
+ * - updates: Updates applied (the version of the newest view)
+ */
+typedef struct server {
+    project_t* project;
+    journal_t* journal;
+    pthread_mutex_t write_lock;
+    _Atomic(project_view_t*) view;
+    atomic_ulong epoch;
+    retired_t* retired;
+    int num_retired;
+    int retired_capacity;
+    uint64_t updates;
+    int listen_fd;
+    client_slot_t clients[SERVER_MAX_CLIENTS];
+} server_t;
+
+/**
+ * Serve a project on a Unix domain socket until SIGINT or SIGTERM
+ * The project must have established rollups. Applied updates are appended
+ * to the journal when one is given; its compactions are switched to run
+ * inline, under write_lock.
+ * @param project Project to serve
+ * @param socket_path Socket to create (an existing socket file is replaced)
+ * @param journal Open journal, or NULL
+ * @return Number of updates applied, or -1 if the server could not start
+ */
+long run_server(project_t* project, const char* socket_path, journal_t* journal);
+
+#endif
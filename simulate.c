@@ -0,0 +1,514 @@
+/* simulate.c */
+#include "simulate.h"
+#include "a1_functions.h"
+#include "kernels.h"
+#include "schedule.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define RNG_LANES 8                      // Interleaved generators, the same on every ISA
+#define PERT_CDF_STEPS 65536             // Integration steps behind the PERT quantile table
+
+/**
+ * Eight xoshiro256+ generators, stored lane-major so one SIMD register
+ * holds the same state word of several generators
+ */
+typedef struct {
+    uint64_t s[4][RNG_LANES];
+} rng_t;
+
+/**
+ * Activity Columns for Sampling
+ *
+ * Element i is one activity (in topological node order when durations
+ * follow the critical path). Completed activities have zero base values,
+ * so their floors - the actual values - always win.
+ *
+ * - base_hours/base_cost: Planned values scaled by each trial's multiplier
+ * - floor_hours/floor_cost: Hours and cost already spent
+ * - schedule: Dependency graph for critical path trials, or NULL
+ */
+typedef struct {
+    int count;
+    float* base_hours;
+    float* floor_hours;
+    float* base_cost;
+    float* floor_cost;
+    const schedule_t* schedule;
+} sample_columns_t;
+
+/**
+ * Shared Simulation State
+ *
+ * - mode: Position of the plan between the two factors (0-1)
+ * - pert_table: Standardized PERT quantiles (PERT only)
+ * - trial_cost/trial_hours: Outcome of every trial, indexed by trial number
+ * - next_block: Shared cursor over blocks of SIMULATION_BLOCK_TRIALS trials
+ */
+typedef struct {
+    const sample_columns_t* columns;
+    const simulation_config_t* config;
+    float mode;
+    float pert_table[PERT_TABLE_SIZE + 1];
+    float* trial_cost;
+    float* trial_hours;
+    long num_blocks;
+    atomic_long next_block;
+} simulation_t;
+
+// =============================================================================
+// RANDOM NUMBERS
+// =============================================================================
+
+static uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Seed the generators of one block; depends only on the seed and the block
+ */
+static void rng_seed(rng_t* rng, uint64_t seed, long block) {
+    uint64_t state = seed ^ ((uint64_t)block * 0xd1342543de82ef95ULL);
+    for (int lane = 0; lane < RNG_LANES; lane++) {
+        for (int word = 0; word < 4; word++) {
+            rng->s[word][lane] = splitmix64(&state);
+        }
+    }
+}
+
+/**
+ * Step every generator once
+ * @param out Receives one 64-bit output per lane
+ */
+static void rng_next(rng_t* rng, uint64_t out[RNG_LANES]) {
+    int lane = 0;
+
+#if defined(__AVX2__)
+    for (; lane + 4 <= RNG_LANES; lane += 4) {
+        __m256i s0 = _mm256_loadu_si256((const __m256i*)&rng->s[0][lane]);
+        __m256i s1 = _mm256_loadu_si256((const __m256i*)&rng->s[1][lane]);
+        __m256i s2 = _mm256_loadu_si256((const __m256i*)&rng->s[2][lane]);
+        __m256i s3 = _mm256_loadu_si256((const __m256i*)&rng->s[3][lane]);
+        _mm256_storeu_si256((__m256i*)&out[lane], _mm256_add_epi64(s0, s3));
+        __m256i t = _mm256_slli_epi64(s1, 17);
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+        _mm256_storeu_si256((__m256i*)&rng->s[0][lane], s0);
+        _mm256_storeu_si256((__m256i*)&rng->s[1][lane], s1);
+        _mm256_storeu_si256((__m256i*)&rng->s[2][lane], s2);
+        _mm256_storeu_si256((__m256i*)&rng->s[3][lane], s3);
+    }
+#elif defined(__SSE2__)
+    for (; lane + 2 <= RNG_LANES; lane += 2) {
+        __m128i s0 = _mm_loadu_si128((const __m128i*)&rng->s[0][lane]);
+        __m128i s1 = _mm_loadu_si128((const __m128i*)&rng->s[1][lane]);
+        __m128i s2 = _mm_loadu_si128((const __m128i*)&rng->s[2][lane]);
+        __m128i s3 = _mm_loadu_si128((const __m128i*)&rng->s[3][lane]);
+        _mm_storeu_si128((__m128i*)&out[lane], _mm_add_epi64(s0, s3));
+        __m128i t = _mm_slli_epi64(s1, 17);
+        s2 = _mm_xor_si128(s2, s0);
+        s3 = _mm_xor_si128(s3, s1);
+        s1 = _mm_xor_si128(s1, s2);
+        s0 = _mm_xor_si128(s0, s3);
+        s2 = _mm_xor_si128(s2, t);
+        s3 = _mm_or_si128(_mm_slli_epi64(s3, 45), _mm_srli_epi64(s3, 19));
+        _mm_storeu_si128((__m128i*)&rng->s[0][lane], s0);
+        _mm_storeu_si128((__m128i*)&rng->s[1][lane], s1);
+        _mm_storeu_si128((__m128i*)&rng->s[2][lane], s2);
+        _mm_storeu_si128((__m128i*)&rng->s[3][lane], s3);
+    }
+#endif
+
+    for (; lane < RNG_LANES; lane++) {
+        uint64_t s0 = rng->s[0][lane], s1 = rng->s[1][lane], s2 = rng->s[2][lane], s3 = rng->s[3][lane];
+        out[lane] = s0 + s3;
+        uint64_t t = s1 << 17;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = (s3 << 45) | (s3 >> 19);
+        rng->s[0][lane] = s0;
+        rng->s[1][lane] = s1;
+        rng->s[2][lane] = s2;
+        rng->s[3][lane] = s3;
+    }
+}
+
+/**
+ * Fill an array with uniform floats in [0, 1) (24 random bits each)
+ */
+static void fill_uniforms(rng_t* rng, float* out, int count) {
+    uint64_t bits[RNG_LANES];
+
+    for (int i = 0; i < count; i += RNG_LANES) {
+        rng_next(rng, bits);
+        int lanes = count - i < RNG_LANES ? count - i : RNG_LANES;
+        for (int lane = 0; lane < lanes; lane++) {
+            out[i + lane] = (float)(uint32_t)(bits[lane] >> 40) * 0x1p-24f;
+        }
+    }
+}
+
+// =============================================================================
+// DISTRIBUTIONS
+// =============================================================================
+
+bool parse_distribution(const char* text, distribution_t* distribution) {
+    if (strcmp(text, "triangular") == 0) {
+        *distribution = DISTRIBUTION_TRIANGULAR;
+        return true;
+    }
+    if (strcmp(text, "pert") == 0) {
+        *distribution = DISTRIBUTION_PERT;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Standardized PERT density (beta with shape 4) at x, unnormalized
+ */
+static double pert_density(double x, double alpha, double beta) {
+    return pow(x, alpha - 1) * pow(1 - x, beta - 1);
+}
+
+/**
+ * Tabulate quantiles of the standardized PERT distribution with its mode
+ * at the given position; every activity shares the same shape, so one
+ * table serves them all and a sample is a lookup plus an interpolation
+ */
+static void build_pert_table(float mode, float table[PERT_TABLE_SIZE + 1]) {
+    double alpha = 1 + 4.0 * mode, beta = 1 + 4.0 * (1 - mode);
+    double total = 0;
+
+    for (int i = 0; i < PERT_CDF_STEPS; i++) {
+        total += pert_density((i + 0.5) / PERT_CDF_STEPS, alpha, beta);
+    }
+
+    // Walk the CDF once, emitting a quantile each time it passes k / SIZE
+    double cumulative = 0;
+    int k = 1;
+    table[0] = 0;
+    for (int i = 0; i < PERT_CDF_STEPS && k < PERT_TABLE_SIZE; i++) {
+        double step = pert_density((i + 0.5) / PERT_CDF_STEPS, alpha, beta) / total;
+        while (k < PERT_TABLE_SIZE && cumulative + step >= (double)k / PERT_TABLE_SIZE) {
+            double fraction = step > 0 ? ((double)k / PERT_TABLE_SIZE - cumulative) / step : 0;
+            table[k++] = (float)((i + fraction) / PERT_CDF_STEPS);
+        }
+        cumulative += step;
+    }
+    while (k <= PERT_TABLE_SIZE) {
+        table[k++] = 1;
+    }
+}
+
+/**
+ * Turn uniforms into plan multipliers in place
+ */
+static void sample_multipliers(const simulation_t* simulation, float* values, int count) {
+    float low = simulation->config->optimistic;
+    float span = simulation->config->pessimistic - low;
+    float mode = simulation->mode;
+
+    if (simulation->config->distribution == DISTRIBUTION_TRIANGULAR) {
+        for (int i = 0; i < count; i++) {
+            float u = values[i];
+            float q = u < mode ? sqrtf(u * mode) : 1 - sqrtf((1 - u) * (1 - mode));
+            values[i] = low + span * q;
+        }
+    } else {
+        const float* table = simulation->pert_table;
+        for (int i = 0; i < count; i++) {
+            float position = values[i] * PERT_TABLE_SIZE;
+            int k = (int)position;
+            float q = table[k] + (position - (float)k) * (table[k + 1] - table[k]);
+            values[i] = low + span * q;
+        }
+    }
+}
+
+// =============================================================================
+// TRIALS
+// =============================================================================
+
+/**
+ * Per-thread scratch columns, one value per activity
+ */
+typedef struct {
+    float* multipliers;
+    float* hours;
+    float* cost;
+    double* finish;
+} trial_scratch_t;
+
+/**
+ * Longest chain of sampled hours through the dependency graph
+ */
+static double critical_path_hours(const schedule_t* schedule, const float* hours, double* finish) {
+    double longest = 0;
+
+    for (int k = 0; k < schedule->num_nodes; k++) {
+        int u = schedule->order[k];
+        double start = 0;
+        for (int e = schedule->pred_start[u]; e < schedule->pred_start[u + 1]; e++) {
+            if (finish[schedule->preds[e]] > start) {
+                start = finish[schedule->preds[e]];
+            }
+        }
+        finish[u] = start + hours[u];
+        if (finish[u] > longest) {
+            longest = finish[u];
+        }
+    }
+    return longest;
+}
+
+static void run_trial(const simulation_t* simulation, rng_t* rng, trial_scratch_t* scratch, long trial) {
+    const sample_columns_t* columns = simulation->columns;
+    int count = columns->count;
+
+    fill_uniforms(rng, scratch->multipliers, count);
+    sample_multipliers(simulation, scratch->multipliers, count);
+    for (int i = 0; i < count; i++) {
+        float hours = columns->base_hours[i] * scratch->multipliers[i];
+        float cost = columns->base_cost[i] * scratch->multipliers[i];
+        scratch->hours[i] = hours > columns->floor_hours[i] ? hours : columns->floor_hours[i];
+        scratch->cost[i] = cost > columns->floor_cost[i] ? cost : columns->floor_cost[i];
+    }
+
+    simulation->trial_cost[trial] = sum_floats(scratch->cost, count);
+    simulation->trial_hours[trial] = columns->schedule != NULL
+        ? (float)critical_path_hours(columns->schedule, scratch->hours, scratch->finish)
+        : sum_floats(scratch->hours, count);
+}
+
+/**
+ * Claim blocks of trials until none are left (run by every thread)
+ */
+static void* simulation_worker(void* argument) {
+    simulation_t* simulation = argument;
+    size_t count = (size_t)simulation->columns->count + RNG_LANES;
+    trial_scratch_t scratch;
+    rng_t rng;
+
+    scratch.multipliers = malloc(count * sizeof(float));
+    scratch.hours = malloc(count * sizeof(float));
+    scratch.cost = malloc(count * sizeof(float));
+    scratch.finish = malloc(count * sizeof(double));
+    if (scratch.multipliers == NULL || scratch.hours == NULL || scratch.cost == NULL || scratch.finish == NULL) {
+        printf("ERROR: Failed to allocate simulation scratch. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    long block;
+    while ((block = atomic_fetch_add_explicit(&simulation->next_block, 1, memory_order_relaxed)) <
+           simulation->num_blocks) {
+        long first = block * SIMULATION_BLOCK_TRIALS;
+        long last = first + SIMULATION_BLOCK_TRIALS;
+        if (last > simulation->config->trials) {
+            last = simulation->config->trials;
+        }
+        rng_seed(&rng, simulation->config->seed, block);
+        for (long trial = first; trial < last; trial++) {
+            run_trial(simulation, &rng, &scratch, trial);
+        }
+    }
+
+    free(scratch.multipliers);
+    free(scratch.hours);
+    free(scratch.cost);
+    free(scratch.finish);
+    return NULL;
+}
+
+// =============================================================================
+// SIMULATION
+// =============================================================================
+
+static float* allocate_column(size_t count) {
+    float* column = malloc((count > 0 ? count : 1) * sizeof(float));
+    if (column == NULL) {
+        printf("ERROR: Failed to allocate simulation columns. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    return column;
+}
+
+static void store_sample_column(sample_columns_t* columns, int index, const activity_t* activity) {
+    columns->base_hours[index] = activity->completed ? 0 : (float)activity->planned_duration;
+    columns->floor_hours[index] = (float)activity->actual_duration;
+    columns->base_cost[index] = activity->completed ? 0 : money_to_float(activity->planned_cost);
+    columns->floor_cost[index] = money_to_float(activity->actual_cost);
+}
+
+/**
+ * Copy the activities into sampling columns - in node order when the
+ * project has dependencies, so trials can walk the schedule's graph
+ */
+static void build_sample_columns(project_t* project, sample_columns_t* columns) {
+    int count = 0;
+    for (int i = 0; i < project->num_milestones; i++) {
+        count += project->milestone_list[i].num_activities;
+    }
+
+    memset(columns, 0, sizeof(*columns));
+    columns->count = count;
+    columns->base_hours = allocate_column((size_t)count);
+    columns->floor_hours = allocate_column((size_t)count);
+    columns->base_cost = allocate_column((size_t)count);
+    columns->floor_cost = allocate_column((size_t)count);
+
+    schedule_t* schedule = project->schedule;
+    if (schedule != NULL && schedule->num_dependencies > 0 && schedule_refresh(project)) {
+        columns->schedule = schedule;
+        for (int node = 0; node < schedule->num_nodes; node++) {
+            store_sample_column(columns, node, find_activity_by_id(project, schedule->node_ids[node], NULL));
+        }
+        return;
+    }
+
+    int index = 0;
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        for (int j = 0; j < milestone->num_activities; j++) {
+            store_sample_column(columns, index++, &milestone->activity_list[j]);
+        }
+    }
+}
+
+static int compare_floats(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Value at a percentile of sorted outcomes (nearest rank)
+ */
+static double percentile(const float* sorted, long count, int percent) {
+    long rank = (percent * count + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * Sort one outcome array and take its percentiles and mean
+ */
+static void summarize(float* outcomes, long count, double percentiles[3], double* mean) {
+    double total = 0;
+    for (long i = 0; i < count; i++) {
+        total += outcomes[i];
+    }
+    *mean = total / (double)count;
+
+    qsort(outcomes, (size_t)count, sizeof(float), compare_floats);
+    percentiles[0] = percentile(outcomes, count, 50);
+    percentiles[1] = percentile(outcomes, count, 80);
+    percentiles[2] = percentile(outcomes, count, 95);
+}
+
+bool simulate_project(project_t* project, const simulation_config_t* config, simulation_result_t* result) {
+    if (config->trials < 1 || config->num_threads < 1 || !(config->optimistic >= 0) ||
+        config->optimistic > 1 || config->pessimistic < 1 || config->optimistic >= config->pessimistic) {
+        fprintf(stderr, "ERROR: Simulation needs trials >= 1 and 0 <= optimistic <= 1 <= pessimistic "
+                        "(optimistic < pessimistic)\n");
+        return false;
+    }
+
+    sample_columns_t columns;
+    build_sample_columns(project, &columns);
+
+    simulation_t* simulation = calloc(1, sizeof(simulation_t));
+    if (simulation == NULL) {
+        printf("ERROR: Failed to allocate simulation. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    simulation->columns = &columns;
+    simulation->config = config;
+    simulation->mode = (1 - config->optimistic) / (config->pessimistic - config->optimistic);
+    if (config->distribution == DISTRIBUTION_PERT) {
+        build_pert_table(simulation->mode, simulation->pert_table);
+    }
+    simulation->trial_cost = allocate_column((size_t)config->trials);
+    simulation->trial_hours = allocate_column((size_t)config->trials);
+    simulation->num_blocks = (config->trials + SIMULATION_BLOCK_TRIALS - 1) / SIMULATION_BLOCK_TRIALS;
+    atomic_init(&simulation->next_block, 0);
+
+    int num_threads = config->num_threads;
+    if (num_threads > SIMULATION_MAX_THREADS) {
+        num_threads = SIMULATION_MAX_THREADS;
+    }
+    if (num_threads > simulation->num_blocks) {
+        num_threads = (int)simulation->num_blocks;
+    }
+
+    struct timespec start, end;
+    pthread_t threads[SIMULATION_MAX_THREADS];
+    int started = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (started < num_threads - 1 &&
+           pthread_create(&threads[started], NULL, simulation_worker, simulation) == 0) {
+        started++;
+    }
+    simulation_worker(simulation);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    result->seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    result->critical_path = columns.schedule != NULL;
+
+    long within_budget = 0;
+    for (long i = 0; i < config->trials; i++) {
+        within_budget += simulation->trial_cost[i] <= money_to_float(project->planned_cost);
+    }
+    result->within_budget = (double)within_budget / (double)config->trials;
+    summarize(simulation->trial_cost, config->trials, result->cost, &result->mean_cost);
+    summarize(simulation->trial_hours, config->trials, result->hours, &result->mean_hours);
+
+    free(simulation->trial_cost);
+    free(simulation->trial_hours);
+    free(simulation);
+    free(columns.base_hours);
+    free(columns.floor_hours);
+    free(columns.base_cost);
+    free(columns.floor_cost);
+    return true;
+}
+
+void print_simulation(const project_t* project, const simulation_config_t* config,
+                      const simulation_result_t* result) {
+    printf("\nMONTE CARLO SIMULATION: %s\n", project->name);
+    printf("========================================\n");
+    printf("Trials: %ld | Distribution: %s (%.2fx - %.2fx of plan) | Seed: %llu\n", config->trials,
+           config->distribution == DISTRIBUTION_PERT ? "PERT" : "triangular", config->optimistic,
+           config->pessimistic, (unsigned long long)config->seed);
+    printf("Duration: %s\n", result->critical_path ? "critical path through the dependencies"
+                                                   : "total effort (the project has no dependencies)");
+    printf("\n%-16s%14s%14s%14s%14s\n", "", "P50", "P80", "P95", "Mean");
+    printf("%-16s%14.2f%14.2f%14.2f%14.2f\n", "Cost ($)", result->cost[0], result->cost[1], result->cost[2],
+           result->mean_cost);
+    printf("%-16s%14.1f%14.1f%14.1f%14.1f\n", "Duration (days)", result->hours[0] / HOURS_PER_DAY,
+           result->hours[1] / HOURS_PER_DAY, result->hours[2] / HOURS_PER_DAY, result->mean_hours / HOURS_PER_DAY);
+    printf("\nPlanned cost: $%.2f | Chance of finishing within it: %.1f%%\n",
+           money_to_dollars(project->planned_cost), result->within_budget * 100);
+    printf("Elapsed: %.3f ms (%.0f trials/s)\n", result->seconds * 1e3,
+           result->seconds > 0 ? (double)config->trials / result->seconds : 0.0);
+}
@@ -0,0 +1,94 @@
+/* simulate.h */
+#ifndef SIMULATE_H
+#define SIMULATE_H
+
+#include "a1_data_structures.h"
+
+#define SIMULATION_MAX_THREADS 256
+#define SIMULATION_BLOCK_TRIALS 64       // Trials per RNG stream (unit of work sharing)
+#define PERT_TABLE_SIZE 1024             // Quantile table intervals for PERT sampling
+
+/**
+ * MONTE CARLO RISK SIMULATION
+ *
+ * Replays the rest of the project many times with random activity outcomes
+ * and reports percentiles of the final cost and duration.
+ *
+ * In every trial each activity draws one multiplier of its plan from a
+ * distribution between the optimistic and pessimistic factors, with the
+ * plan itself as the most likely value, and scales its planned hours and
+ * planned cost by it. Work already done is a floor: an open activity never
+ * takes fewer hours or costs less than it already has, and a completed
+ * activity keeps its actual values. The trial's duration is the critical
+ * path when the project has dependencies, otherwise the total effort.
+ *
+ * Activity data is copied once into contiguous columns and every trial
+ * streams over them: uniforms come from eight interleaved xoshiro256+
+ * generators stepped together in SIMD registers, and the sampling and
+ * cost/effort sums are straight loops over the columns. Trials are split
+ * into blocks of SIMULATION_BLOCK_TRIALS, each with its own generator
+ * seeded from (seed, block number); threads claim blocks from a shared
+ * counter. Results therefore depend only on the seed and the build, never
+ * on the number of threads or on which thread ran which block.
+ */
+
+typedef enum {
+    DISTRIBUTION_TRIANGULAR,
+    DISTRIBUTION_PERT
+} distribution_t;
+
+/**
+ * Simulation Settings
+ *
+ * - distribution: Shape of the per-activity multiplier
+ * - optimistic/pessimistic: Lowest and highest multiplier of the plan
+ *   (optimistic <= 1 <= pessimistic, optimistic < pessimistic)
+ * - trials: Number of simulated project outcomes
+ * - num_threads: Threads used, the caller included
+ * - seed: Equal seeds give equal results
+ */
+typedef struct {
+    distribution_t distribution;
+    float optimistic, pessimistic;
+    long trials;
+    int num_threads;
+    uint64_t seed;
+} simulation_config_t;
+
+/**
+ * Simulation Result
+ *
+ * - cost/hours: P50, P80 and P95 of the trial outcomes
+ * - mean_cost/mean_hours: Averages over all trials
+ * - within_budget: Share of trials at or below the planned project cost
+ * - critical_path: Durations follow the dependency graph (else total effort)
+ * - seconds: Wall time of the trials
+ */
+typedef struct {
+    double cost[3];
+    double hours[3];
+    double mean_cost, mean_hours;
+    double within_budget;
+    bool critical_path;
+    double seconds;
+} simulation_result_t;
+
+/**
+ * Parse a distribution name ("triangular" or "pert")
+ */
+bool parse_distribution(const char* text, distribution_t* distribution);
+
+/**
+ * Run the simulation
+ * The project is only read, apart from refreshing a stale schedule.
+ * @return false after printing an error if the settings are invalid
+ */
+bool simulate_project(project_t* project, const simulation_config_t* config, simulation_result_t* result);
+
+/**
+ * Print the percentiles in the style of print_project_stats
+ */
+void print_simulation(const project_t* project, const simulation_config_t* config,
+                      const simulation_result_t* result);
+
+#endif
@@ -0,0 +1,375 @@
+/* snapshot.c */
+#include "snapshot.h"
+#include "a1_functions.h"
+#include "schedule.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+#define ENDIAN_CHECK 0x01020304u
+
+/**
+ * Extend an FNV-1a 64 hash over a block of bytes
+ */
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * Round an offset up to the next section boundary
+ */
+static uint64_t align_offset(uint64_t offset) {
+    return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(uint64_t)(SNAPSHOT_ALIGNMENT - 1);
+}
+
+/**
+ * Sequential writer that hashes everything it writes after the header
+ */
+typedef struct {
+    FILE* file;
+    uint64_t offset;
+    uint64_t checksum;
+    bool ok;
+} snapshot_writer_t;
+
+static void write_bytes(snapshot_writer_t* writer, const void* data, size_t length) {
+    if (length == 0) {
+        return; // Empty milestones have no activity array at all
+    }
+    if (writer->ok && fwrite(data, 1, length, writer->file) != length) {
+        writer->ok = false;
+    }
+    writer->checksum = fnv1a(writer->checksum, data, length);
+    writer->offset += length;
+}
+
+/**
+ * Bytes of the ID manager section: the manager record and both tables
+ */
+static uint64_t id_section_size(uint64_t id_table_size) {
+    return sizeof(id_manager_t) + id_table_size * (sizeof(id_location_t) + sizeof(uint16_t));
+}
+
+static void write_padding(snapshot_writer_t* writer) {
+    static const char zeros[SNAPSHOT_ALIGNMENT];
+    write_bytes(writer, zeros, (size_t)(align_offset(writer->offset) - writer->offset));
+}
+
+bool save_snapshot(const project_t* project, const char* path) {
+    snapshot_header_t header;
+    char temp_path[4096];
+
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE* file = fopen(temp_path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: Cannot create snapshot file '%s'\n", temp_path);
+        return false;
+    }
+
+    uint64_t num_activities = 0;
+    for (int i = 0; i < project->num_milestones; i++) {
+        num_activities += (uint64_t)project->milestone_list[i].num_activities;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.header_size = sizeof(snapshot_header_t);
+    header.activity_size = sizeof(activity_t);
+    header.milestone_size = sizeof(snapshot_milestone_t);
+    header.id_manager_size = sizeof(id_manager_t);
+    header.endian_check = ENDIAN_CHECK;
+    header.num_milestones = (uint32_t)project->num_milestones;
+    header.num_activities = (uint32_t)num_activities;
+    header.journal_sequence = project->journal_sequence;
+    memcpy(header.project_name, project->name, sizeof(header.project_name));
+
+    // Section layout is fully determined by the counts
+    header.milestones_offset = align_offset(sizeof(snapshot_header_t));
+    header.activities_offset = align_offset(header.milestones_offset +
+                                            header.num_milestones * sizeof(snapshot_milestone_t));
+    header.id_manager_offset = align_offset(header.activities_offset +
+                                            num_activities * sizeof(activity_t));
+    header.id_table_size = (uint32_t)id_table_span(project->id_manager);
+    header.num_dependencies = project->schedule != NULL ? (uint32_t)project->schedule->num_dependencies : 0;
+    header.dependencies_offset = align_offset(header.id_manager_offset + id_section_size(header.id_table_size));
+    header.names_offset = align_offset(header.dependencies_offset +
+                                       header.num_dependencies * sizeof(dependency_t));
+    header.names_size = project->names->chars_used - 1;
+    header.num_names = project->names->num_names - 1;
+    header.file_size = header.names_offset + header.names_size;
+
+    // Header is rewritten with the checksum once the body has been streamed
+    snapshot_writer_t writer = { file, 0, FNV_OFFSET_BASIS, true };
+    writer.ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    writer.offset = sizeof(header);
+    write_padding(&writer);
+    writer.checksum = FNV_OFFSET_BASIS;
+
+    uint64_t first_activity = 0;
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        snapshot_milestone_t record;
+
+        memset(&record, 0, sizeof(record));
+        record.first_activity = first_activity;
+        record.num_activities = (uint32_t)milestone->num_activities;
+        record.id = milestone->id;
+        record.name = milestone->name;
+        record.completed = milestone->completed;
+        record.actual_cost = milestone->actual_cost;
+        record.actual_duration = milestone->actual_duration;
+        record.num_completed = milestone->num_completed;
+        record.actual_hours = milestone->actual_hours;
+        record.planned_cost = milestone->planned_cost;
+        record.planned_hours = milestone->planned_hours;
+        write_bytes(&writer, &record, sizeof(record));
+
+        first_activity += (uint64_t)milestone->num_activities;
+    }
+    write_padding(&writer);
+
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        write_bytes(&writer, milestone->activity_list,
+                    (size_t)milestone->num_activities * sizeof(activity_t));
+    }
+    write_padding(&writer);
+
+    // Only the table entries up to the highest used ID are stored
+    id_manager_t manager = *project->id_manager;
+    manager.capacity = (int)header.id_table_size;
+    manager.arena = NULL;
+    manager.locations = NULL;
+    manager.generations = NULL;
+    write_bytes(&writer, &manager, sizeof(manager));
+    write_bytes(&writer, project->id_manager->locations, header.id_table_size * sizeof(id_location_t));
+    write_bytes(&writer, project->id_manager->generations, header.id_table_size * sizeof(uint16_t));
+    write_padding(&writer);
+
+    if (header.num_dependencies > 0) {
+        write_bytes(&writer, project->schedule->dependencies,
+                    header.num_dependencies * sizeof(dependency_t));
+    }
+    write_padding(&writer);
+
+    write_bytes(&writer, project->names->chars + 1, (size_t)header.names_size);
+
+    header.checksum = writer.checksum;
+    bool ok = writer.ok &&
+              fseek(file, 0, SEEK_SET) == 0 &&
+              fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fflush(file) == 0 &&
+              fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(temp_path, path) != 0) {
+        fprintf(stderr, "ERROR: Failed to write snapshot file '%s'\n", path);
+        remove(temp_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Validate a mapped header against this build and the file size
+ * @return NULL if acceptable, otherwise a description of the problem
+ */
+static const char* check_header(const snapshot_header_t* header, size_t file_size) {
+    if (file_size < sizeof(snapshot_header_t) ||
+        memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        return "not a snapshot file";
+    }
+    if (header->version != SNAPSHOT_VERSION) {
+        return "unsupported snapshot version";
+    }
+    if (header->header_size != sizeof(snapshot_header_t) ||
+        header->activity_size != sizeof(activity_t) ||
+        header->milestone_size != sizeof(snapshot_milestone_t) ||
+        header->id_manager_size != sizeof(id_manager_t) ||
+        header->endian_check != ENDIAN_CHECK) {
+        return "snapshot was written by a build with a different data layout";
+    }
+    if (header->file_size != file_size ||
+        header->milestones_offset + (uint64_t)header->num_milestones * sizeof(snapshot_milestone_t) >
+            header->activities_offset ||
+        header->activities_offset + (uint64_t)header->num_activities * sizeof(activity_t) >
+            header->id_manager_offset ||
+        header->id_table_size == 0 || header->id_table_size > ID_SPACE_SIZE ||
+        header->id_manager_offset + id_section_size(header->id_table_size) > header->dependencies_offset ||
+        header->dependencies_offset + (uint64_t)header->num_dependencies * sizeof(dependency_t) >
+            header->names_offset ||
+        header->names_offset + header->names_size != file_size ||
+        (header->names_size > 0 && ((const char*)header)[file_size - 1] != '\0')) {
+        return "snapshot file is truncated or corrupt";
+    }
+    return NULL;
+}
+
+/**
+ * Rebuild the name pool from the names section
+ * Names are interned in file order so every stored reference keeps its
+ * meaning, then each milestone and activity is registered as an owner.
+ * @return false if the section or a stored reference is inconsistent
+ */
+static bool load_names(project_t* project, const char* names, const snapshot_header_t* header) {
+    name_pool_t* pool = project->names;
+    const char* end = names + header->names_size;
+
+    for (const char* text = names; text < end; text += strlen(text) + 1) {
+        if (text[0] == '\0' || name_intern(pool, text) != pool->num_names - 1) {
+            return false; // Duplicate or empty entry
+        }
+    }
+    if (pool->num_names - 1 != header->num_names) {
+        return false;
+    }
+
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        if (milestone->name >= pool->num_names) {
+            return false;
+        }
+        name_add_owner(pool, milestone->name, milestone->id);
+        for (int j = 0; j < milestone->num_activities; j++) {
+            const activity_t* activity = &milestone->activity_list[j];
+            if (activity->name >= pool->num_names) {
+                return false;
+            }
+            name_add_owner(pool, activity->name, activity->id);
+        }
+    }
+    return true;
+}
+
+/**
+ * Copy the ID manager record out of the mapping and use its tables in place
+ * The tables are copied to the arena only if a higher ID is taken later.
+ * @return NULL if an ID in use lies beyond the stored tables
+ */
+static id_manager_t* load_id_manager(arena_t* arena, char* section, uint32_t id_table_size) {
+    id_manager_t* manager = arena_alloc(arena, sizeof(id_manager_t));
+    memcpy(manager, section, sizeof(id_manager_t));
+    manager->capacity = (int)id_table_size;
+    manager->arena = arena;
+    manager->locations = (id_location_t*)(section + sizeof(id_manager_t));
+    manager->generations = (uint16_t*)(manager->locations + id_table_size);
+    return id_table_span(manager) <= manager->capacity ? manager : NULL;
+}
+
+project_t* load_snapshot(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: Cannot open snapshot file '%s'\n", path);
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        fprintf(stderr, "ERROR: Cannot read snapshot file '%s'\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    // Private writable mapping: updates made after loading never reach the file
+    size_t size = (size_t)info.st_size;
+    char* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "ERROR: Cannot map snapshot file '%s'\n", path);
+        return NULL;
+    }
+
+    const snapshot_header_t* header = (const snapshot_header_t*)base;
+    const char* problem = check_header(header, size);
+    if (problem == NULL) {
+        uint64_t body_start = align_offset(sizeof(snapshot_header_t));
+        if (fnv1a(FNV_OFFSET_BASIS, base + body_start, size - body_start) != header->checksum) {
+            problem = "snapshot checksum mismatch";
+        }
+    }
+    if (problem != NULL) {
+        fprintf(stderr, "ERROR: %s: %s\n", path, problem);
+        munmap(base, size);
+        return NULL;
+    }
+
+    // The arena takes over the mapping; the data inside it is used in place
+    arena_t* arena = arena_create(0);
+    arena_adopt_mapping(arena, base, size);
+    project_t* project = arena_alloc(arena, sizeof(project_t));
+    project->arena = arena;
+    memcpy(project->name, header->project_name, sizeof(project->name));
+    project->name[sizeof(project->name) - 1] = '\0';
+    project->id_manager = load_id_manager(arena, base + header->id_manager_offset, header->id_table_size);
+    if (project->id_manager == NULL) {
+        fprintf(stderr, "ERROR: %s: ID tables do not cover every ID in use\n", path);
+        free_project(project);
+        return NULL;
+    }
+    project->num_milestones = (int)header->num_milestones;
+    project->journal_sequence = header->journal_sequence;
+    project->names = name_pool_create(arena);
+    project->milestone_list = create_milestone_array(arena, project->num_milestones);
+
+    const snapshot_milestone_t* records = (const snapshot_milestone_t*)(base + header->milestones_offset);
+    activity_t* activities = (activity_t*)(base + header->activities_offset);
+    for (int i = 0; i < project->num_milestones; i++) {
+        const snapshot_milestone_t* record = &records[i];
+        milestone_t* milestone = &project->milestone_list[i];
+
+        if (record->first_activity + record->num_activities > header->num_activities) {
+            fprintf(stderr, "ERROR: %s: milestone %d points outside the activity section\n", path, i);
+            free_project(project);
+            return NULL;
+        }
+
+        milestone->id = record->id;
+        milestone->name = record->name;
+        milestone->activity_list = activities + record->first_activity;
+        milestone->num_activities = (int)record->num_activities;
+        milestone->completed = record->completed;
+        milestone->actual_cost = record->actual_cost;
+        milestone->actual_duration = record->actual_duration;
+        milestone->num_completed = record->num_completed;
+        milestone->actual_hours = record->actual_hours;
+        milestone->planned_cost = record->planned_cost;
+        milestone->planned_hours = record->planned_hours;
+        build_activity_columns(arena, milestone);
+    }
+
+    if (!load_names(project, base + header->names_offset, header)) {
+        fprintf(stderr, "ERROR: %s: names section does not match the items\n", path);
+        free_project(project);
+        return NULL;
+    }
+
+    // Dependencies are copied out so they can grow like any others
+    const dependency_t* dependencies = (const dependency_t*)(base + header->dependencies_offset);
+    for (uint32_t e = 0; e < header->num_dependencies; e++) {
+        if (find_activity_by_id(project, dependencies[e].activity, NULL) == NULL ||
+            find_activity_by_id(project, dependencies[e].predecessor, NULL) == NULL) {
+            fprintf(stderr, "ERROR: %s: dependency %u does not join two activities\n", path, e);
+            free_project(project);
+            return NULL;
+        }
+        append_dependency(project, dependencies[e]);
+    }
+    if (!schedule_refresh(project)) {
+        fprintf(stderr, "ERROR: %s: dependencies contain a cycle\n", path);
+        free_project(project);
+        return NULL;
+    }
+
+    update_project(project);
+    return project;
+}
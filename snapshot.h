@@ -0,0 +1,108 @@
+/* snapshot.h */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "a1_data_structures.h"
+
+#define SNAPSHOT_MAGIC "PMSNAP\0"   // 8 bytes including the terminator
+#define SNAPSHOT_VERSION 6        // 2: journal_sequence added, 3: interned names, 4: ID generations,
+                                    // 5: dependencies, 6: ID tables cut to the highest ID
+#define SNAPSHOT_ALIGNMENT 64       // Every section starts on a 64-byte boundary
+
+/**
+ * Snapshot File Header
+ *
+ * A snapshot is a single file laid out as:
+ *   header | milestone records | activity array | ID manager | dependencies | names
+ * Sections are referenced by byte offsets from the start of the file, never by
+ * pointers, so the file can be mapped at any address and used in place.
+ * Activities of all milestones are stored back to back in one array in the
+ * exact in-memory activity_t layout; a milestone record names its first
+ * activity by index into that array. Milestone and activity names are
+ * name_ref_t values into the names section, which holds the distinct names
+ * NUL-terminated in reference order (reference 0, the empty name, omitted).
+ *
+ * Fields:
+ * - magic/version: Format identification
+ * - activity_size/milestone_size/id_manager_size/endian_check: Layout of the
+ *   build that wrote the file; a build with a different layout refuses it
+ *   (including one of the other numeric mode, see PM_FIXED_POINT)
+ * - checksum: FNV-1a 64 of every byte after the header
+ * - file_size: Expected total size, catches truncated files
+ * - *_offset: Start of each section
+ * - num_names/names_size: Distinct names and bytes in the names section
+ * - num_dependencies: dependency_t records in the dependencies section
+ * - id_table_size: Entries of the ID location and generation tables, which
+ *   follow the id_manager_t record in the ID manager section (highest used
+ *   ID + 1; the record's pointers are not meaningful on disk)
+ * - journal_sequence: Last journal record contained in the snapshot
+ * - project_*: Project-level fields (rollups are recomputed from milestones)
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t activity_size;
+    uint32_t milestone_size;
+    uint32_t id_manager_size;
+    uint32_t endian_check;
+    uint64_t checksum;
+    uint64_t file_size;
+    uint64_t milestones_offset;
+    uint64_t activities_offset;
+    uint64_t id_manager_offset;
+    uint64_t dependencies_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+    uint32_t num_names;
+    uint32_t num_milestones;
+    uint32_t num_activities;
+    uint32_t num_dependencies;
+    uint32_t id_table_size;
+    uint64_t journal_sequence;
+    char project_name[100];
+} snapshot_header_t;
+
+/**
+ * Snapshot Milestone Record
+ *
+ * On-disk form of milestone_t: the activity_list pointer is replaced by
+ * the index of the milestone's first activity in the activity section.
+ */
+typedef struct {
+    uint64_t first_activity;
+    uint32_t num_activities;
+    unsigned short int id;
+    name_ref_t name;
+    bool completed;
+    money_t actual_cost;
+    days_t actual_duration;
+    int num_completed;
+    hours_t actual_hours;
+    money_t planned_cost;
+    hours_t planned_hours;
+} snapshot_milestone_t;
+
+/**
+ * Write the whole project to a snapshot file in one sequential pass
+ * Data goes to <path>.tmp first and is renamed over <path> only after it
+ * has been flushed to disk, so a crash never leaves a half-written snapshot.
+ * @param project Project to save
+ * @param path Destination file
+ * @return true on success, false after printing an error to stderr
+ */
+bool save_snapshot(const project_t* project, const char* path);
+
+/**
+ * Map a snapshot file and build a project that uses it in place
+ * The file is mapped privately: activities and the ID manager are read
+ * directly from the mapping and later edits stay in memory (copy-on-write).
+ * Only the small milestone array, the activity columns and the name pool
+ * (re-interned from the names section) are allocated. The mapping is adopted by the
+ * project's arena and released by free_project.
+ * @param path Snapshot file to open
+ * @return Loaded project, or NULL after printing an error to stderr
+ */
+project_t* load_snapshot(const char* path);
+
+#endif
@@ -0,0 +1,474 @@
+/* watchlist.c */
+#include "watchlist.h"
+#include "a1_functions.h"
+#include <math.h>
+#include <string.h>
+
+static const char* const LIST_TITLES[WATCH_NUM_LISTS] = {
+    "ACTIVITIES OVER PLANNED COST",
+    "ACTIVITIES OVER PLANNED HOURS",
+    "MILESTONES OVER EARNED COST",
+    "MILESTONES OVER EARNED HOURS",
+};
+
+static const char* const LIST_MEASURES[WATCH_NUM_LISTS] = {
+    "planned cost", "planned hours", "earned cost", "earned hours"
+};
+
+static bool is_cost_list(watch_list_t list) {
+    return list == WATCH_ACTIVITY_COST || list == WATCH_MILESTONE_COST;
+}
+
+static bool is_milestone_list(watch_list_t list) {
+    return list == WATCH_MILESTONE_COST || list == WATCH_MILESTONE_SCHEDULE;
+}
+
+/**
+ * Overrun of an activity and the plan it is measured against
+ */
+static void activity_overrun(const activity_t* activity, watch_list_t list, float* overrun, float* plan) {
+    if (is_cost_list(list)) {
+        *overrun = money_to_float(activity->actual_cost - activity->planned_cost);
+        *plan = money_to_float(activity->planned_cost);
+    } else {
+        *overrun = (float)activity->actual_duration - (float)activity->planned_duration;
+        *plan = activity->planned_duration;
+    }
+}
+
+/**
+ * Overrun of a milestone against its earned plan, and its full plan
+ */
+static void milestone_overrun(const milestone_t* milestone, watch_list_t list, float* overrun, float* plan) {
+    float completed_share = milestone->num_activities > 0
+                            ? (float)milestone->num_completed / (float)milestone->num_activities : 0;
+    if (is_cost_list(list)) {
+        *overrun = money_to_float(milestone->actual_cost) -
+                   money_to_float(milestone->planned_cost) * completed_share;
+        *plan = money_to_float(milestone->planned_cost);
+    } else {
+        *overrun = (float)milestone->actual_hours - (float)milestone->planned_hours * completed_share;
+        *plan = (float)milestone->planned_hours;
+    }
+}
+
+static float overrun_share(float overrun, float plan) {
+    return plan > 0 ? overrun / plan : (overrun > 0 ? INFINITY : 0);
+}
+
+// =============================================================================
+// INDEXED HEAP
+// =============================================================================
+
+static void heap_swap(watch_heap_t* heap, int i, int j) {
+    watch_entry_t entry = heap->entries[i];
+    heap->entries[i] = heap->entries[j];
+    heap->entries[j] = entry;
+    heap->position[heap->entries[i].id] = i;
+    heap->position[heap->entries[j].id] = j;
+}
+
+static void sift_up(watch_heap_t* heap, int i) {
+    while (i > 0 && heap->entries[(i - 1) / 2].overrun < heap->entries[i].overrun) {
+        heap_swap(heap, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void sift_down(watch_heap_t* heap, int i) {
+    for (;;) {
+        int largest = i, left = 2 * i + 1, right = left + 1;
+        if (left < heap->count && heap->entries[left].overrun > heap->entries[largest].overrun) {
+            largest = left;
+        }
+        if (right < heap->count && heap->entries[right].overrun > heap->entries[largest].overrun) {
+            largest = right;
+        }
+        if (largest == i) {
+            return;
+        }
+        heap_swap(heap, i, largest);
+        i = largest;
+    }
+}
+
+/**
+ * Restore the heap order around an entry whose overrun changed
+ */
+static void heap_fix(watch_heap_t* heap, int i) {
+    if (i > 0 && heap->entries[(i - 1) / 2].overrun < heap->entries[i].overrun) {
+        sift_up(heap, i);
+    } else {
+        sift_down(heap, i);
+    }
+}
+
+static void heap_remove(watch_heap_t* heap, unsigned short int id) {
+    int i = heap->position[id];
+    if (i == WATCH_ABSENT) {
+        return;
+    }
+
+    heap->position[id] = WATCH_ABSENT;
+    int last = --heap->count;
+    if (i != last) {
+        heap->entries[i] = heap->entries[last];
+        heap->position[heap->entries[i].id] = i;
+        heap_fix(heap, i);
+    }
+}
+
+/**
+ * Insert, move or remove an item: listed while its overrun is positive
+ */
+static void heap_set(watch_heap_t* heap, unsigned short int id, float overrun) {
+    int i = heap->position[id];
+    if (!(overrun > 0)) {
+        heap_remove(heap, id);
+        return;
+    }
+    if (i != WATCH_ABSENT) {
+        heap->entries[i].overrun = overrun;
+        heap_fix(heap, i);
+        return;
+    }
+
+    if (heap->count == heap->capacity) {
+        heap->capacity = heap->capacity > 0 ? heap->capacity * 2 : 64;
+        heap->entries = realloc(heap->entries, (size_t)heap->capacity * sizeof(watch_entry_t));
+        if (heap->entries == NULL) {
+            printf("ERROR: Failed to allocate watchlist. Exiting...\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    i = heap->count++;
+    heap->entries[i].overrun = overrun;
+    heap->entries[i].id = id;
+    heap->position[id] = i;
+    sift_up(heap, i);
+}
+
+// =============================================================================
+// WATCHLIST
+// =============================================================================
+
+/**
+ * Re-rank one item in one list and report a threshold crossing
+ */
+static void rank_item(watchlist_t* watchlist, watch_list_t list, unsigned short int id, float overrun, float plan) {
+    heap_set(&watchlist->heaps[list], id, overrun);
+
+    float share = overrun_share(overrun, plan);
+    float threshold = is_cost_list(list) ? watchlist->cost_threshold : watchlist->schedule_threshold;
+    bool above = overrun > 0 && share > threshold;
+    uint8_t bit = (uint8_t)(1u << list);
+    if (above == ((watchlist->alerting[id] & bit) != 0)) {
+        return;
+    }
+
+    watchlist->alerting[id] ^= bit;
+    watchlist->num_alerts += above;
+    if (watchlist->alert != NULL) {
+        watch_alert_t alert = { list, id, overrun, share, above };
+        watchlist->alert(watchlist->alert_context, &alert);
+    }
+}
+
+watchlist_t* watchlist_create(const project_t* project, float cost_threshold, float schedule_threshold) {
+    watchlist_t* watchlist = calloc(1, sizeof(watchlist_t));
+    if (watchlist == NULL) {
+        printf("ERROR: Failed to allocate watchlist. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int list = 0; list < WATCH_NUM_LISTS; list++) {
+        for (int id = 0; id < ID_SPACE_SIZE; id++) {
+            watchlist->heaps[list].position[id] = WATCH_ABSENT;
+        }
+    }
+    watchlist->cost_threshold = cost_threshold;
+    watchlist->schedule_threshold = schedule_threshold;
+
+    // No alert function yet, so current overruns are marked silently
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        for (int j = 0; j < milestone->num_activities; j++) {
+            watch_activity(watchlist, &milestone->activity_list[j]);
+        }
+        watch_milestone(watchlist, milestone);
+    }
+    watchlist->num_alerts = 0;
+    return watchlist;
+}
+
+void watchlist_set_alert(watchlist_t* watchlist, watch_alert_fn alert, void* context) {
+    watchlist->alert = alert;
+    watchlist->alert_context = context;
+}
+
+void watch_activity(watchlist_t* watchlist, const activity_t* activity) {
+    if (watchlist == NULL) {
+        return;
+    }
+    float overrun, plan;
+    activity_overrun(activity, WATCH_ACTIVITY_COST, &overrun, &plan);
+    rank_item(watchlist, WATCH_ACTIVITY_COST, activity->id, overrun, plan);
+    activity_overrun(activity, WATCH_ACTIVITY_SCHEDULE, &overrun, &plan);
+    rank_item(watchlist, WATCH_ACTIVITY_SCHEDULE, activity->id, overrun, plan);
+}
+
+void watch_milestone(watchlist_t* watchlist, const milestone_t* milestone) {
+    if (watchlist == NULL) {
+        return;
+    }
+    float overrun, plan;
+    milestone_overrun(milestone, WATCH_MILESTONE_COST, &overrun, &plan);
+    rank_item(watchlist, WATCH_MILESTONE_COST, milestone->id, overrun, plan);
+    milestone_overrun(milestone, WATCH_MILESTONE_SCHEDULE, &overrun, &plan);
+    rank_item(watchlist, WATCH_MILESTONE_SCHEDULE, milestone->id, overrun, plan);
+}
+
+void watch_remove(watchlist_t* watchlist, unsigned short int id) {
+    if (watchlist == NULL) {
+        return;
+    }
+    for (int list = 0; list < WATCH_NUM_LISTS; list++) {
+        heap_remove(&watchlist->heaps[list], id);
+    }
+    watchlist->alerting[id] = 0;  // The ID may be reused by a new item
+}
+
+/**
+ * Frontier of heap positions still to visit, itself a max-heap by overrun
+ */
+static void frontier_push(int* frontier, int* size, const watch_entry_t* entries, int index) {
+    int i = (*size)++;
+    frontier[i] = index;
+    while (i > 0 && entries[frontier[(i - 1) / 2]].overrun < entries[frontier[i]].overrun) {
+        int swap = frontier[i];
+        frontier[i] = frontier[(i - 1) / 2];
+        frontier[(i - 1) / 2] = swap;
+        i = (i - 1) / 2;
+    }
+}
+
+static int frontier_pop(int* frontier, int* size, const watch_entry_t* entries) {
+    int top = frontier[0];
+    frontier[0] = frontier[--*size];
+    for (int i = 0;;) {
+        int largest = i, left = 2 * i + 1, right = left + 1;
+        if (left < *size && entries[frontier[left]].overrun > entries[frontier[largest]].overrun) {
+            largest = left;
+        }
+        if (right < *size && entries[frontier[right]].overrun > entries[frontier[largest]].overrun) {
+            largest = right;
+        }
+        if (largest == i) {
+            break;
+        }
+        int swap = frontier[i];
+        frontier[i] = frontier[largest];
+        frontier[largest] = swap;
+        i = largest;
+    }
+    return top;
+}
+
+int watchlist_worst(const watchlist_t* watchlist, watch_list_t list, watch_entry_t* out, int max_entries) {
+    const watch_heap_t* heap = &watchlist->heaps[list];
+    int wanted = max_entries < heap->count ? max_entries : heap->count;
+    if (wanted <= 0) {
+        return 0;
+    }
+
+    // Each visit takes one position out and puts at most two in
+    int* frontier = malloc(((size_t)wanted + 2) * sizeof(int));
+    if (frontier == NULL) {
+        printf("ERROR: Failed to allocate watchlist frontier. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+    int size = 0;
+    frontier_push(frontier, &size, heap->entries, 0);
+    for (int n = 0; n < wanted; n++) {
+        int index = frontier_pop(frontier, &size, heap->entries);
+        out[n] = heap->entries[index];
+        if (2 * index + 1 < heap->count) {
+            frontier_push(frontier, &size, heap->entries, 2 * index + 1);
+        }
+        if (2 * index + 2 < heap->count) {
+            frontier_push(frontier, &size, heap->entries, 2 * index + 2);
+        }
+    }
+    free(frontier);
+    return wanted;
+}
+
+/**
+ * Check one item's entry in one list
+ */
+static bool verify_item(const watchlist_t* watchlist, watch_list_t list, unsigned short int id, float overrun,
+                        int* listed) {
+    const watch_heap_t* heap = &watchlist->heaps[list];
+    int i = heap->position[id];
+    if (overrun > 0) {
+        (*listed)++;
+    }
+    if ((overrun > 0) != (i != WATCH_ABSENT) || (i != WATCH_ABSENT && heap->entries[i].overrun != overrun)) {
+        fprintf(stderr, "Watchlist entry of %hu in '%s' is stale (overrun %.2f)\n", id, LIST_TITLES[list],
+                overrun);
+        return false;
+    }
+    return true;
+}
+
+bool watchlist_verify(const watchlist_t* watchlist, const project_t* project) {
+    bool ok = true;
+    int listed[WATCH_NUM_LISTS] = { 0 };
+    float overrun, plan;
+
+    for (int i = 0; i < project->num_milestones; i++) {
+        const milestone_t* milestone = &project->milestone_list[i];
+        for (int j = 0; j < milestone->num_activities; j++) {
+            const activity_t* activity = &milestone->activity_list[j];
+            for (int list = WATCH_ACTIVITY_COST; list <= WATCH_ACTIVITY_SCHEDULE; list++) {
+                activity_overrun(activity, (watch_list_t)list, &overrun, &plan);
+                ok &= verify_item(watchlist, (watch_list_t)list, activity->id, overrun, &listed[list]);
+            }
+        }
+        for (int list = WATCH_MILESTONE_COST; list <= WATCH_MILESTONE_SCHEDULE; list++) {
+            milestone_overrun(milestone, (watch_list_t)list, &overrun, &plan);
+            ok &= verify_item(watchlist, (watch_list_t)list, milestone->id, overrun, &listed[list]);
+        }
+    }
+
+    for (int list = 0; list < WATCH_NUM_LISTS; list++) {
+        const watch_heap_t* heap = &watchlist->heaps[list];
+        if (heap->count != listed[list]) {
+            fprintf(stderr, "Watchlist '%s' holds %d entries for %d overrun(s)\n", LIST_TITLES[list],
+                    heap->count, listed[list]);
+            ok = false;
+        }
+        for (int i = 0; i < heap->count; i++) {
+            if (heap->position[heap->entries[i].id] != i ||
+                (i > 0 && heap->entries[(i - 1) / 2].overrun < heap->entries[i].overrun)) {
+                fprintf(stderr, "Watchlist '%s' is out of heap order at %d\n", LIST_TITLES[list], i);
+                ok = false;
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+// =============================================================================
+// REPORTING
+// =============================================================================
+
+/**
+ * Name and plan of a listed item
+ * @return false if the ID is no longer an item of the list's kind
+ */
+static bool describe_item(project_t* project, watch_list_t list, unsigned short int id, const char** name,
+                          float* plan) {
+    float overrun;
+    if (is_milestone_list(list)) {
+        const milestone_t* milestone = find_milestone_by_id(project, id);
+        if (milestone == NULL) {
+            return false;
+        }
+        milestone_overrun(milestone, list, &overrun, plan);
+        *name = get_name(project, milestone->name);
+    } else {
+        milestone_t* milestone = NULL;
+        const activity_t* activity = find_activity_by_id(project, id, &milestone);
+        if (activity == NULL) {
+            return false;
+        }
+        activity_overrun(activity, list, &overrun, plan);
+        *name = get_name(project, activity->name);
+    }
+    return true;
+}
+
+static void format_overrun(char* text, size_t size, watch_list_t list, float overrun) {
+    if (is_cost_list(list)) {
+        snprintf(text, size, "$%.2f", overrun);
+    } else {
+        snprintf(text, size, "%.1f h", overrun);
+    }
+}
+
+static void format_share(char* text, size_t size, float share) {
+    if (isinf(share)) {
+        snprintf(text, size, "no plan");
+    } else {
+        snprintf(text, size, "%.1f%%", share * 100);
+    }
+}
+
+void print_watchlist(project_t* project, const watchlist_t* watchlist, int max_entries) {
+    watch_entry_t* entries = malloc((size_t)(max_entries > 0 ? max_entries : 1) * sizeof(watch_entry_t));
+    if (entries == NULL) {
+        printf("ERROR: Failed to allocate watchlist report. Exiting...\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("\nOVERRUN WATCHLIST\n");
+    printf("========================================\n");
+    printf("Alerts at %.0f%% over planned cost and %.0f%% over planned hours; %ld raised so far\n",
+           watchlist->cost_threshold * 100, watchlist->schedule_threshold * 100, watchlist->num_alerts);
+
+    for (int list = 0; list < WATCH_NUM_LISTS; list++) {
+        int count = watchlist_worst(watchlist, (watch_list_t)list, entries, max_entries);
+        printf("\n%s (%d listed)\n", LIST_TITLES[list], watchlist->heaps[list].count);
+        printf("----------------------------------------\n");
+        if (count == 0) {
+            printf("None.\n");
+            continue;
+        }
+
+        printf("%-4s %-6s %-30s %12s %10s\n", "#", "ID", "Name", "Overrun", "Of plan");
+        for (int n = 0; n < count; n++) {
+            const char* name;
+            float plan;
+            char overrun_text[32], share_text[16];
+            if (!describe_item(project, (watch_list_t)list, entries[n].id, &name, &plan)) {
+                continue;
+            }
+            format_overrun(overrun_text, sizeof(overrun_text), (watch_list_t)list, entries[n].overrun);
+            format_share(share_text, sizeof(share_text), overrun_share(entries[n].overrun, plan));
+            printf("%-4d %-6hu %-30.30s %12s %10s%s\n", n + 1, entries[n].id, name, overrun_text, share_text,
+                   watchlist->alerting[entries[n].id] & (1u << list) ? "  ALERT" : "");
+        }
+    }
+    free(entries);
+}
+
+void print_watch_alert(void* project, const watch_alert_t* alert) {
+    const char* name;
+    float plan;
+    char overrun_text[32], share_text[16];
+
+    if (!describe_item(project, alert->list, alert->id, &name, &plan)) {
+        return;
+    }
+    const char* kind = is_milestone_list(alert->list) ? "Milestone" : "Activity";
+    if (alert->raised) {
+        format_overrun(overrun_text, sizeof(overrun_text), alert->list, alert->overrun);
+        format_share(share_text, sizeof(share_text), alert->share);
+        printf("ALERT: %s %hu '%s' is %s (%s) over its %s\n", kind, alert->id, name, overrun_text, share_text,
+               LIST_MEASURES[alert->list]);
+    } else {
+        printf("Cleared: %s %hu '%s' is back within the threshold of its %s\n", kind, alert->id, name,
+               LIST_MEASURES[alert->list]);
+    }
+}
+
+void watchlist_free(watchlist_t* watchlist) {
+    if (watchlist == NULL) {
+        return;
+    }
+    for (int list = 0; list < WATCH_NUM_LISTS; list++) {
+        free(watchlist->heaps[list].entries);
+    }
+    free(watchlist);
+}
@@ -0,0 +1,157 @@
+/* watchlist.h */
+#ifndef WATCHLIST_H
+#define WATCHLIST_H
+
+#include "a1_data_structures.h"
+
+#define WATCH_DEFAULT_THRESHOLD 0.10f   // Overrun share of plan that raises an alert
+#define WATCH_ABSENT (-1)               // Heap position of an item that is not listed
+
+/**
+ * OVERRUN WATCHLIST
+ *
+ * Keeps every activity and milestone that is over its plan ranked by how
+ * far over it is, as the work is updated rather than when the project is
+ * done. Four rankings are kept:
+ *
+ *   activity cost:       actual cost - planned cost
+ *   activity schedule:   actual hours - planned hours
+ *   milestone cost:      actual cost - earned cost
+ *   milestone schedule:  actual hours - earned hours
+ *
+ * where earned values are the milestone's plan times the completed share of
+ * its activities (as in the progress history). Only items with a positive
+ * overrun are listed.
+ *
+ * Each ranking is an indexed max-heap: the heap holds (overrun, ID) entries
+ * and a table maps every ID to its heap position, so an item whose overrun
+ * changes is found and moved up or down in O(log n), and removed the same
+ * way. Every activity update re-ranks the activity and its milestone.
+ *
+ * The worst N entries are read without disturbing the heap: a small
+ * frontier heap starts at the root and repeatedly yields its largest entry
+ * and takes in that entry's two children, O(N log N) however many items
+ * are listed.
+ *
+ * Alerts fire when an item's overrun crosses its threshold (a share of the
+ * item's planned cost or hours), once on the way up and once on the way
+ * back down.
+ */
+
+typedef enum {
+    WATCH_ACTIVITY_COST,
+    WATCH_ACTIVITY_SCHEDULE,
+    WATCH_MILESTONE_COST,
+    WATCH_MILESTONE_SCHEDULE,
+    WATCH_NUM_LISTS
+} watch_list_t;
+
+/**
+ * Ranked item: overrun in dollars or hours
+ */
+typedef struct {
+    float overrun;
+    unsigned short int id;
+} watch_entry_t;
+
+/**
+ * Indexed max-heap of entries by overrun
+ * position[id] is the entry's index in entries, or WATCH_ABSENT.
+ */
+typedef struct {
+    watch_entry_t* entries;
+    int count, capacity;
+    int32_t position[ID_SPACE_SIZE];
+} watch_heap_t;
+
+/**
+ * Threshold crossing
+ *
+ * - share: Overrun as a share of the item's plan (infinite with no plan)
+ * - raised: true when crossing above the threshold, false when back below
+ */
+typedef struct {
+    watch_list_t list;
+    unsigned short int id;
+    float overrun;
+    float share;
+    bool raised;
+} watch_alert_t;
+
+typedef void (*watch_alert_fn)(void* context, const watch_alert_t* alert);
+
+/**
+ * Watchlist Structure
+ *
+ * - heaps: One ranking per watch_list_t
+ * - alerting: Per ID, a bit per list set while the item is over its threshold
+ * - cost_threshold/schedule_threshold: Overrun shares of plan that alert
+ * - alert/alert_context: Called on every crossing (NULL: only counted)
+ * - num_alerts: Crossings above a threshold so far
+ */
+typedef struct watchlist {
+    watch_heap_t heaps[WATCH_NUM_LISTS];
+    uint8_t alerting[ID_SPACE_SIZE];
+    float cost_threshold, schedule_threshold;
+    watch_alert_fn alert;
+    void* alert_context;
+    long num_alerts;
+} watchlist_t;
+
+/**
+ * Build a watchlist from the current state of a project
+ * Items already over their threshold are marked without alerting.
+ * @return New watchlist, exits on allocation failure
+ */
+watchlist_t* watchlist_create(const project_t* project, float cost_threshold, float schedule_threshold);
+
+/**
+ * Set the function called on threshold crossings
+ */
+void watchlist_set_alert(watchlist_t* watchlist, watch_alert_fn alert, void* context);
+
+/**
+ * Re-rank an activity after its values changed (NULL watchlist is ignored)
+ */
+void watch_activity(watchlist_t* watchlist, const activity_t* activity);
+
+/**
+ * Re-rank a milestone after its totals changed (NULL watchlist is ignored)
+ */
+void watch_milestone(watchlist_t* watchlist, const milestone_t* milestone);
+
+/**
+ * Drop a removed activity or milestone from every list (NULL is ignored)
+ */
+void watch_remove(watchlist_t* watchlist, unsigned short int id);
+
+/**
+ * Read the worst entries of a list, worst first
+ * @param out Receives up to max_entries entries
+ * @return Number of entries written
+ */
+int watchlist_worst(const watchlist_t* watchlist, watch_list_t list, watch_entry_t* out, int max_entries);
+
+/**
+ * Check every list against the project: each item listed exactly when over
+ * plan, with its current overrun, and every heap ordered
+ * @return true if consistent (problems are printed to stderr)
+ */
+bool watchlist_verify(const watchlist_t* watchlist, const project_t* project);
+
+/**
+ * Print the worst entries of every list
+ */
+void print_watchlist(project_t* project, const watchlist_t* watchlist, int max_entries);
+
+/**
+ * Print a threshold crossing; an alert function whose context is the project
+ */
+void print_watch_alert(void* project, const watch_alert_t* alert);
+
+/**
+ * Free a watchlist (NULL is ignored)
+ */
+void watchlist_free(watchlist_t* watchlist);
+
+#endif
@@ -0,0 +1,68 @@
+/* workload.c */
+#include "workload.h"
+#include "a1_functions.h"
+#include "bench_util.h"
+#include <string.h>
+
+#define MAX_WORKLOAD_IDS 65535
+
+bool workload_parse_shape(const char* text, workload_shape_t* shape) {
+    char* end;
+    long milestones = strtol(text, &end, 10);
+    if (end == text || (*end != 'x' && *end != 'X')) {
+        return false;
+    }
+
+    const char* rest = end + 1;
+    long activities = strtol(rest, &end, 10);
+    if (end == rest || *end != '\0' || milestones < 1 || activities < 0 ||
+        milestones * (activities + 1) > MAX_WORKLOAD_IDS) {
+        return false;
+    }
+
+    shape->num_milestones = (int)milestones;
+    shape->activities_per_milestone = (int)activities;
+    return true;
+}
+
+project_t* generate_project(const workload_shape_t* shape) {
+    uint32_t random = shape->seed ? shape->seed : 1;
+    char name[NAME_INPUT_SIZE];
+    project_t* project = create_project();
+
+    snprintf(project->name, sizeof(project->name), "Synthetic %dx%d",
+             shape->num_milestones, shape->activities_per_milestone);
+    project->num_milestones = shape->num_milestones;
+    project->milestone_list = create_milestone_array(project->arena, shape->num_milestones);
+
+    for (int i = 0; i < shape->num_milestones; i++) {
+        milestone_t* milestone = &project->milestone_list[i];
+        milestone->id = allocate_id(project->id_manager);
+        set_id_location(project->id_manager, milestone->id, i, NO_INDEX);
+        snprintf(name, sizeof(name), "Milestone %d", i);
+        set_milestone_name(project, milestone, name);
+        milestone->num_activities = shape->activities_per_milestone;
+        milestone->activity_list = create_activity_array(project->arena, milestone->num_activities);
+
+        for (int j = 0; j < milestone->num_activities; j++) {
+            activity_t* activity = &milestone->activity_list[j];
+            activity->id = allocate_id(project->id_manager);
+            set_id_location(project->id_manager, activity->id, i, j);
+            snprintf(name, sizeof(name), "Activity %d.%d", i, j);
+            set_activity_name(project, activity, name);
+
+            activity->planned_duration = (unsigned short int)(4 + next_random(&random) % 37);
+            activity->planned_cost = money_from_dollars(50 + next_random(&random) % 951);
+            if ((int)(next_random(&random) % 100) < shape->completed_percent) {
+                int scale = 75 + (int)(next_random(&random) % 51);  // 75%..125% of plan
+                activity->actual_duration = (unsigned short int)(activity->planned_duration * scale / 100);
+                activity->actual_cost = money_from_dollars(money_to_float(activity->planned_cost) * (float)scale / 100);
+                activity->completed = true;
+            }
+        }
+        build_activity_columns(project->arena, milestone);
+        update_milestone(milestone);
+    }
+    update_project(project);
+    return project;
+}
@@ -0,0 +1,45 @@
+/* workload.h */
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "a1_data_structures.h"
+
+/**
+ * SYNTHETIC WORKLOADS
+ *
+ * Builds projects of arbitrary shape without prompts or input files, for
+ * benchmarks and load tests. Every project holds at most 65,535 IDs, so
+ * milestones * (activities_per_milestone + 1) must not exceed that.
+ */
+
+/**
+ * Workload Shape
+ *
+ * - num_milestones/activities_per_milestone: Size of the hierarchy
+ * - completed_percent: Share of activities generated as completed (0-100)
+ * - seed: Seed for planned/actual values; equal seeds give equal projects
+ */
+typedef struct {
+    int num_milestones;
+    int activities_per_milestone;
+    int completed_percent;
+    uint32_t seed;
+} workload_shape_t;
+
+/**
+ * Parse a shape written as <milestones>x<activities> (e.g. "10x6000")
+ * Completed share and seed are left untouched.
+ * @return true if the text is well formed and the shape fits the ID space
+ */
+bool workload_parse_shape(const char* text, workload_shape_t* shape);
+
+/**
+ * Build a project of the given shape with established rollups
+ * IDs are auto-assigned; names are "Milestone <m>" and "Activity <m>.<a>".
+ * Completed activities get actuals within +-25% of their plan.
+ * @param shape Shape to build (must fit the ID space)
+ * @return New project, free with free_project
+ */
+project_t* generate_project(const workload_shape_t* shape);
+
+#endif